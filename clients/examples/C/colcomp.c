@@ -0,0 +1,296 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2017 MonetDB B.V.
+ */
+
+/* Fetch the result of a query over protocol 10 twice, once with plain
+ * columns and once with COLUMN_COMPRESSION_AUTO, decode the encoded
+ * columns with mapi_decode_column, and compare them with the plain
+ * ones. */
+
+#include "monetdb_config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_SOCKET_H
+# include <sys/socket.h>
+#endif
+#ifdef NATIVE_WIN32
+# include <winsock.h>
+#endif
+#ifdef HAVE_NETDB_H
+# include <netdb.h>
+#endif
+#ifdef HAVE_NETINET_IN_H
+# include <netinet/in.h>
+#endif
+#include <mapi.h>
+#include "stream.h"
+#include "stream_socket.h"
+#include "mcrypt.h"
+
+#define BUFLEN		(1 << 20)
+#define ALIGN8(n)	(((n) + 7) & ~(size_t) 7)
+
+struct column {
+	char *name;
+	size_t width;		/* 0 for zero terminated strings */
+	char *data;		/* the plain values */
+	size_t len, size;
+};
+
+struct result {
+	size_t wire;		/* bytes in the result messages */
+	size_t nrows;
+	size_t ncols;
+	struct column *cols;
+};
+
+static char *msg;
+static size_t msgsize;
+
+static void
+die(const char *m)
+{
+	fprintf(stderr, "colcomp: %s\n", m);
+	exit(1);
+}
+
+static lng
+getlng(const char *p)
+{
+	lng v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static int
+getint(const char *p)
+{
+	int v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/* read one message, that is up to and including the block with the
+ * last bit set */
+static size_t
+getmsg(stream *in)
+{
+	size_t len = 0;
+	ssize_t n;
+
+	for (;;) {
+		if (len == msgsize) {
+			msgsize = msgsize ? 2 * msgsize : BUFLEN;
+			if ((msg = realloc(msg, msgsize + 1)) == NULL)
+				die("out of memory");
+		}
+		if ((n = mnstr_read(in, msg + len, 1, msgsize - len)) < 0)
+			die("read error");
+		if (n == 0)
+			break;
+		len += (size_t) n;
+	}
+	msg[len] = 0;
+	if (msg[0] == '!')
+		die(msg);
+	return len;
+}
+
+static void
+append(struct column *c, const char *p, size_t len)
+{
+	if (c->len + len > c->size) {
+		c->size = 2 * (c->len + len);
+		if ((c->data = realloc(c->data, c->size)) == NULL)
+			die("out of memory");
+	}
+	memcpy(c->data + c->len, p, len);
+	c->len += len;
+}
+
+static void
+connect_db(int port, const char *dbname, int colcomp, stream **in, stream **out)
+{
+	struct addrinfo hints, *res, *rp;
+	char sport[16], chal[1024], *salt, *pwhash, *hash;
+	SOCKET s = INVALID_SOCKET;
+	stream *from, *to;
+	ssize_t len;
+
+	snprintf(sport, sizeof(sport), "%d", port);
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	if (getaddrinfo("localhost", sport, &hints, &res) != 0)
+		die("getaddrinfo failed");
+	for (rp = res; rp; rp = rp->ai_next) {
+		s = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+		if (s == INVALID_SOCKET)
+			continue;
+		if (connect(s, rp->ai_addr, (socklen_t) rp->ai_addrlen) != SOCKET_ERROR)
+			break;
+		closesocket(s);
+	}
+	freeaddrinfo(res);
+	if (rp == NULL)
+		die("cannot connect");
+
+	/* the challenge and the response go over protocol 9 blocks */
+	from = block_stream(socket_rastream(s, "colcomp read"));
+	to = block_stream(socket_wastream(s, "colcomp write"));
+	if (from == NULL || to == NULL)
+		die("cannot create streams");
+	if ((len = mnstr_read_block(from, chal, 1, sizeof(chal) - 1)) < 0)
+		die("cannot read challenge");
+	chal[len] = 0;
+	if ((salt = strtok(chal, ":")) == NULL)
+		die("bad challenge");
+	pwhash = mcrypt_SHA512Sum("monetdb", strlen("monetdb"));
+	hash = mcrypt_hashPassword("SHA1", pwhash, salt);
+	if (pwhash == NULL || hash == NULL)
+		die("cannot hash password");
+	mnstr_printf(to, "LIT:monetdb:{SHA1}%s:sql:%s:PROT10:COMPRESSION_NONE:%d:%s",
+		     hash, dbname, BUFLEN,
+		     colcomp ? "COLUMN_COMPRESSION_AUTO:" : "");
+	mnstr_flush(to);
+	free(pwhash);
+	free(hash);
+
+	/* and from here on everything goes over protocol 10 blocks */
+	*in = bs_stealstream(from);
+	*out = bs_stealstream(to);
+	close_stream(from);
+	close_stream(to);
+	*in = block_stream2(*in, BUFLEN, COMPRESSION_NONE, COLUMN_COMPRESSION_NONE);
+	*out = block_stream2(*out, BUFLEN, COMPRESSION_NONE, COLUMN_COMPRESSION_NONE);
+	if (*in == NULL || *out == NULL)
+		die("cannot create streams");
+	getmsg(*in);		/* the prompt */
+	mnstr_printf(*out, "Xreply_size -1\n");
+	mnstr_flush(*out);
+	getmsg(*in);
+}
+
+static void
+fetch(int port, const char *dbname, const char *query, int colcomp, struct result *r)
+{
+	stream *in, *out;
+	size_t len, pos, i, n;
+	char *end;
+
+	connect_db(port, dbname, colcomp, &in, &out);
+	mnstr_printf(out, "s%s\n;", query);
+	mnstr_flush(out);
+
+	/* [*\n][tableid][queryid][rowcount][colcount][timezone] and then
+	 * for each column
+	 * [table]\0[name]\0[type]\0[typelen][digits][scale][nil_len][nil][width] */
+	len = getmsg(in);
+	if (len < 34 || strncmp(msg, "*\n", 2) != 0)
+		die("no result set");
+	r->nrows = (size_t) getlng(msg + 14);
+	r->ncols = (size_t) getlng(msg + 22);
+	if ((r->cols = calloc(r->ncols, sizeof(struct column))) == NULL)
+		die("out of memory");
+	pos = 34;
+	for (i = 0; i < r->ncols; i++) {
+		int typelen;
+
+		pos += strlen(msg + pos) + 1;
+		r->cols[i].name = strdup(msg + pos);
+		pos += strlen(msg + pos) + 1;
+		pos += strlen(msg + pos) + 1;
+		typelen = getint(msg + pos);
+		r->cols[i].width = typelen < 0 ? 0 : (size_t) typelen;
+		pos += 3 * sizeof(int);
+		pos += sizeof(int) + getint(msg + pos) + sizeof(lng);
+		if (pos > len)
+			die("bad result header");
+	}
+	r->wire = len;
+
+	/* [+\n or -\n][nrows] and the columns, each eight byte aligned */
+	for (n = 0; n < r->nrows; ) {
+		size_t nrows;
+
+		len = getmsg(in);
+		r->wire += len;
+		if (len < 10 || (msg[0] != '+' && msg[0] != '-'))
+			die("bad result block");
+		nrows = (size_t) getlng(msg + 2);
+		end = msg + len;
+		pos = 10;
+		for (i = 0; i < r->ncols; i++) {
+			struct column *c = &r->cols[i];
+			size_t size;
+
+			pos = ALIGN8(pos);
+			if (colcomp) {
+				const char *p;
+
+				/* a decoded column is never longer than the
+				 * plain block */
+				size = msgsize;
+				if (c->len + size > c->size) {
+					c->size = 2 * (c->len + size);
+					if ((c->data = realloc(c->data, c->size)) == NULL)
+						die("out of memory");
+				}
+				if ((p = mapi_decode_column(msg + pos, end, nrows, c->width, c->data + c->len, &size)) == NULL)
+					die("cannot decode column");
+				c->len += size;
+				pos = (size_t) (p - msg);
+			} else {
+				if (c->width == 0) {
+					size = (size_t) getlng(msg + pos);
+					pos += sizeof(lng);
+				} else {
+					size = nrows * c->width;
+				}
+				if (pos + size > len)
+					die("bad result block");
+				append(c, msg + pos, size);
+				pos += size;
+			}
+		}
+		n += nrows;
+	}
+	close_stream(in);
+	close_stream(out);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct result plain, encoded;
+	size_t i;
+
+	if (argc != 4) {
+		fprintf(stderr, "usage: colcomp <port> <dbname> <query>\n");
+		exit(1);
+	}
+	memset(&plain, 0, sizeof(plain));
+	memset(&encoded, 0, sizeof(encoded));
+	fetch(atoi(argv[1]), argv[2], argv[3], 0, &plain);
+	fetch(atoi(argv[1]), argv[2], argv[3], 1, &encoded);
+	if (plain.nrows != encoded.nrows || plain.ncols != encoded.ncols)
+		die("results differ");
+	printf("rows: %zu\n", plain.nrows);
+	for (i = 0; i < plain.ncols; i++)
+		printf("column %s: %s\n", plain.cols[i].name,
+		       plain.cols[i].len == encoded.cols[i].len &&
+		       memcmp(plain.cols[i].data, encoded.cols[i].data, plain.cols[i].len) == 0 ?
+		       "identical" : "differs");
+	printf("plain: %zu bytes\nencoded: %zu bytes\n", plain.wire, encoded.wire);
+	return 0;
+}
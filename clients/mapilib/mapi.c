@@ -5348,3 +5348,163 @@ mapi_get_active(Mapi mid)
 	return mid->active;
 }
 
+/* Protocol 10 result blocks may carry their columns encoded (see the
+ * MAPI_COLUMN_* tags); mapi_decode_column turns one such column back
+ * into its plain representation.  src points at the eight byte tag of
+ * the column and end at the end of the block, nrows is the number of
+ * rows in the block and width the size of a value, or 0 for columns
+ * that are sent as zero terminated strings.  The plain values are
+ * written to dst, which can hold *dstlen bytes; *dstlen is set to the
+ * number of bytes written.  For strings the plain representation is
+ * the concatenation of the zero terminated strings.  The return value
+ * is the end of the column in the block (the next column starts at the
+ * next multiple of eight), or NULL if the column is malformed or does
+ * not fit in dst. */
+
+static unsigned long long
+mapi_getle(const unsigned char *p, size_t w)
+{
+	unsigned long long v = 0;
+	size_t i;
+
+	for (i = 0; i < w; i++)
+		v |= (unsigned long long) p[i] << (8 * i);
+	return v;
+}
+
+static void
+mapi_putle(unsigned char *p, size_t w, unsigned long long v)
+{
+	size_t i;
+
+	for (i = 0; i < w; i++)
+		p[i] = (unsigned char) (v >> (8 * i));
+}
+
+#define ALIGN8(n)	(((n) + 7) & ~(size_t) 7)
+
+const char *
+mapi_decode_column(const char *src, const char *end, size_t nrows, size_t width, char *dst, size_t *dstlen)
+{
+	const unsigned char *p = (const unsigned char *) src;
+	const unsigned char *e = (const unsigned char *) end;
+	unsigned char *o = (unsigned char *) dst;
+	size_t cap = *dstlen, i, len;
+	unsigned long long v;
+
+	*dstlen = 0;
+	if (e - p < 8)
+		return NULL;
+	switch (mapi_getle(p, 8)) {
+	case MAPI_COLUMN_NONE:
+		p += 8;
+		if (width == 0) {
+			if (e - p < 8)
+				return NULL;
+			len = (size_t) mapi_getle(p, 8);
+			p += 8;
+		} else {
+			len = nrows * width;
+		}
+		if ((size_t) (e - p) < len || cap < len)
+			return NULL;
+		memcpy(o, p, len);
+		*dstlen = len;
+		return (const char *) (p + len);
+	case MAPI_COLUMN_RLE: {
+		const unsigned char *vals, *lens;
+		size_t nruns, r, n = 0;
+
+		if (width == 0 || e - p < 16)
+			return NULL;
+		nruns = (size_t) mapi_getle(p + 8, 8);
+		vals = p + 16;
+		lens = vals + ALIGN8(nruns * width);
+		if (nruns > nrows || lens + nruns * 4 > e || cap < nrows * width)
+			return NULL;
+		for (r = 0; r < nruns; r++) {
+			len = (size_t) mapi_getle(lens + r * 4, 4);
+			if (n + len > nrows)
+				return NULL;
+			for (i = 0; i < len; i++, n++)
+				memcpy(o + n * width, vals + r * width, width);
+		}
+		if (n != nrows)
+			return NULL;
+		*dstlen = nrows * width;
+		return (const char *) (lens + nruns * 4);
+	}
+	case MAPI_COLUMN_FOR:
+	case MAPI_COLUMN_DELTA: {
+		int delta = mapi_getle(p, 8) == MAPI_COLUMN_DELTA;
+		size_t w, n;
+
+		if (width == 0 || width > 8 || e - p < 24)
+			return NULL;
+		v = mapi_getle(p + 8, 8);
+		w = (size_t) mapi_getle(p + 16, 8);
+		p += 24;
+		n = delta && nrows > 0 ? nrows - 1 : nrows;
+		if (w == 0 || w > 8 || (size_t) (e - p) < n * w || cap < nrows * width)
+			return NULL;
+		if (delta) {
+			if (nrows > 0)
+				mapi_putle(o, width, v);
+			for (i = 1; i < nrows; i++) {
+				v += mapi_getle(p + (i - 1) * w, w);
+				mapi_putle(o + i * width, width, v);
+			}
+		} else {
+			for (i = 0; i < nrows; i++)
+				mapi_putle(o + i * width, width, v + mapi_getle(p + i * w, w));
+		}
+		*dstlen = nrows * width;
+		return (const char *) (p + n * w);
+	}
+	case MAPI_COLUMN_DICT: {
+		const unsigned char *dict, *codes;
+		const char **entries;
+		size_t ndict, dictlen, cw, n = 0;
+
+		if (width != 0 || e - p < 24)
+			return NULL;
+		ndict = (size_t) mapi_getle(p + 8, 8);
+		dictlen = (size_t) mapi_getle(p + 16, 8);
+		dict = p + 24;
+		cw = ndict <= 0xFF ? 1 : ndict <= 0xFFFF ? 2 : 4;
+		if (ndict > dictlen || dictlen > (size_t) (e - dict) ||
+		    ALIGN8(dictlen) + nrows * cw > (size_t) (e - dict))
+			return NULL;
+		codes = dict + ALIGN8(dictlen);
+		if ((entries = malloc((ndict + 1) * sizeof(char *))) == NULL)
+			return NULL;
+		/* find the dictionary entries */
+		for (i = 0, len = 0; i < ndict; i++) {
+			const unsigned char *z = memchr(dict + len, 0, dictlen - len);
+
+			if (z == NULL) {
+				free(entries);
+				return NULL;
+			}
+			entries[i] = (const char *) dict + len;
+			len = (size_t) (z - dict) + 1;
+		}
+		for (i = 0; i < nrows; i++) {
+			size_t c = (size_t) mapi_getle(codes + i * cw, cw);
+
+			if (c >= ndict ||
+			    (len = strlen(entries[c]) + 1) > cap - n) {
+				free(entries);
+				return NULL;
+			}
+			memcpy(o + n, entries[c], len);
+			n += len;
+		}
+		free(entries);
+		*dstlen = n;
+		return (const char *) (codes + nrows * cw);
+	}
+	default:
+		return NULL;
+	}
+}
@@ -79,6 +79,14 @@ typedef enum sql_query_t {
 
 typedef struct MapiStatement *MapiHdl;
 
+/* column encodings in protocol 10 result blocks, this definition is a
+ * straight copy of column_compression in common/stream/stream.h */
+#define MAPI_COLUMN_NONE	0
+#define MAPI_COLUMN_DICT	1
+#define MAPI_COLUMN_FOR		2
+#define MAPI_COLUMN_DELTA	3
+#define MAPI_COLUMN_RLE		4
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -226,6 +234,7 @@ mapi_export int mapi_get_tableid(MapiHdl hdl);
 mapi_export char *mapi_quote(const char *msg, int size);
 mapi_export char *mapi_unquote(char *msg);
 mapi_export MapiHdl mapi_get_active(Mapi mid);
+mapi_export const char *mapi_decode_column(const char *src, const char *end, size_t nrows, size_t width, char *dst, size_t *dstlen);
 #ifdef _MSC_VER
 mapi_export const char *wsaerror(int);
 #endif
@@ -1041,7 +1041,16 @@ open_gzstream(const char *filename, const char *flags)
 	{
 		char *fname = cvfilename(filename);
 		if (fname) {
-			fp = gzopen(fname, flags);
+			if (flags[0] == 'w') {
+				/* append mode, so that separately
+				 * compressed members can be added to the
+				 * file (see mnstr_write_member) */
+				int fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666);
+				fp = fd < 0 ? NULL : gzdopen(fd, flags);
+				if (fp == NULL && fd >= 0)
+					close(fd);
+			} else
+				fp = gzopen(fname, flags);
 			free(fname);
 		} else
 			fp = NULL;
@@ -1670,6 +1679,219 @@ open_xzwastream(const char *filename, const char *mode)
 #define open_xzwastream(filename, mode)	NULL
 #endif
 
+/* ------------------------------------------------------------------ */
+/* appending separately compressed members to compressed files */
+
+/* gzip, bzip2 and xz all decompress a concatenation of separately
+ * compressed members into the concatenation of their contents.  This
+ * allows writers to compress independent pieces of output in
+ * parallel with mnstr_compress_member, and to append the results to
+ * a compressed file stream in order with mnstr_write_member. */
+
+int
+isa_member_stream(stream *s)
+{
+	if (s == NULL || s->access != ST_WRITE)
+		return 0;
+#if defined(HAVE_LIBZ) && !defined(HAVE__WFOPEN)
+	if (s->write == stream_gzwrite)
+		return 1;
+#endif
+#ifdef HAVE_LIBBZ2
+	if (s->write == stream_bzwrite)
+		return 1;
+#endif
+#ifdef HAVE_LIBLZMA
+	if (s->write == stream_xzwrite)
+		return 1;
+#endif
+	return 0;
+}
+
+/* Compress len bytes at buf into a complete member in the format of
+ * the compressed file stream s, which is not otherwise used, so this
+ * can be called from multiple threads.  The member is returned in a
+ * malloced *out, its size is the return value, -1 on failure. */
+ssize_t
+mnstr_compress_member(stream *s, const void *buf, size_t len, void **out)
+{
+	*out = NULL;
+	if (!isa_member_stream(s))
+		return -1;
+#ifdef HAVE_LIBZ
+	if (s->write == stream_gzwrite) {
+		z_stream z;
+		size_t bound;
+
+		if (len > (size_t) UINT_MAX / 2)
+			return -1;
+		memset(&z, 0, sizeof(z));
+		/* windowBits + 16 writes a gzip header and trailer */
+		if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			return -1;
+		bound = deflateBound(&z, (uLong) len);
+		if ((*out = malloc(bound)) == NULL) {
+			deflateEnd(&z);
+			return -1;
+		}
+		z.next_in = (Bytef *) buf;
+		z.avail_in = (uInt) len;
+		z.next_out = *out;
+		z.avail_out = (uInt) bound;
+		if (deflate(&z, Z_FINISH) != Z_STREAM_END) {
+			deflateEnd(&z);
+			free(*out);
+			*out = NULL;
+			return -1;
+		}
+		len = z.total_out;
+		deflateEnd(&z);
+		return (ssize_t) len;
+	}
+#endif
+#ifdef HAVE_LIBBZ2
+	if (s->write == stream_bzwrite) {
+		unsigned int outlen;
+
+		if (len > (size_t) UINT_MAX / 2)
+			return -1;
+		outlen = (unsigned int) (len + len / 100 + 600);
+		if ((*out = malloc(outlen)) == NULL)
+			return -1;
+		/* same parameters as open_bzstream */
+		if (BZ2_bzBuffToBuffCompress(*out, &outlen, (char *) buf, (unsigned int) len, 9, 0, 30) != BZ_OK) {
+			free(*out);
+			*out = NULL;
+			return -1;
+		}
+		return (ssize_t) outlen;
+	}
+#endif
+#ifdef HAVE_LIBLZMA
+	if (s->write == stream_xzwrite) {
+		size_t bound = lzma_stream_buffer_bound(len), outlen = 0;
+
+		if ((*out = malloc(bound)) == NULL)
+			return -1;
+		/* same preset as open_xzstream */
+		if (lzma_easy_buffer_encode(0, LZMA_CHECK_CRC64, NULL, buf, len, *out, &outlen, bound) != LZMA_OK) {
+			free(*out);
+			*out = NULL;
+			return -1;
+		}
+		return (ssize_t) outlen;
+	}
+#endif
+	return -1;
+}
+
+/* Finish the member that is being compressed by the compressed file
+ * stream s, and append the member produced by mnstr_compress_member
+ * to the file.  Writing through s afterwards starts a new member. */
+int
+mnstr_write_member(stream *s, const void *buf, size_t len)
+{
+	if (!isa_member_stream(s) || s->errnr)
+		return -1;
+#if defined(HAVE_LIBZ) && !defined(HAVE__WFOPEN)
+	if (s->write == stream_gzwrite) {
+		char *fname;
+		int fd;
+		const char *p = buf;
+
+		/* the file was opened in append mode by
+		 * open_gzstream, so after the flush our write ends up
+		 * at the end of the file, as will those of s */
+		if (gzflush((gzFile) s->stream_data.p, Z_FINISH) != Z_OK ||
+		    (fname = cvfilename(s->name)) == NULL) {
+			s->errnr = MNSTR_WRITE_ERROR;
+			return -1;
+		}
+		fd = open(fname, O_WRONLY | O_APPEND);
+		free(fname);
+		if (fd < 0) {
+			s->errnr = MNSTR_WRITE_ERROR;
+			return -1;
+		}
+		while (len > 0) {
+			ssize_t n = write(fd, p, len);
+
+			if (n <= 0) {
+				close(fd);
+				s->errnr = MNSTR_WRITE_ERROR;
+				return -1;
+			}
+			p += n;
+			len -= (size_t) n;
+		}
+		if (close(fd) < 0) {
+			s->errnr = MNSTR_WRITE_ERROR;
+			return -1;
+		}
+		return 0;
+	}
+#endif
+#ifdef HAVE_LIBBZ2
+	if (s->write == stream_bzwrite) {
+		struct bz *bzp = s->stream_data.p;
+		int err = BZ_OK;
+
+		BZ2_bzWriteClose(&err, bzp->b, 0, NULL, NULL);
+		bzp->b = NULL;
+		if (err != BZ_OK ||
+		    fwrite(buf, 1, len, bzp->f) != len ||
+		    (bzp->b = BZ2_bzWriteOpen(&err, bzp->f, 9, 0, 30)) == NULL ||
+		    err != BZ_OK) {
+			s->errnr = MNSTR_WRITE_ERROR;
+			return -1;
+		}
+		return 0;
+	}
+#endif
+#ifdef HAVE_LIBLZMA
+	if (s->write == stream_xzwrite) {
+		xz_stream *xz = s->stream_data.p;
+
+		if (xz->strm.total_in > 0) {
+			/* finish the current stream */
+			lzma_ret ret;
+
+			do {
+				size_t sz;
+
+				xz->strm.next_in = NULL;
+				xz->strm.avail_in = 0;
+				xz->strm.next_out = xz->buf;
+				xz->strm.avail_out = XZBUFSIZ;
+				ret = lzma_code(&xz->strm, LZMA_FINISH);
+				sz = XZBUFSIZ - xz->strm.avail_out;
+				if ((ret != LZMA_OK && ret != LZMA_STREAM_END) ||
+				    fwrite(xz->buf, 1, sz, xz->fp) != sz) {
+					s->errnr = MNSTR_WRITE_ERROR;
+					return -1;
+				}
+			} while (ret != LZMA_STREAM_END);
+			lzma_end(&xz->strm);
+			memset(&xz->strm, 0, sizeof(xz->strm));
+			if (lzma_easy_encoder(&xz->strm, 0, LZMA_CHECK_CRC64) != LZMA_OK) {
+				s->errnr = MNSTR_WRITE_ERROR;
+				return -1;
+			}
+			xz->strm.next_out = xz->buf;
+			xz->strm.avail_out = XZBUFSIZ;
+		}
+		if (fwrite(buf, 1, len, xz->fp) != len) {
+			s->errnr = MNSTR_WRITE_ERROR;
+			return -1;
+		}
+		return 0;
+	}
+#endif
+	(void) buf;
+	(void) len;
+	return -1;
+}
+
 /* ------------------------------------------------------------------ */
 /* streams working on a disk file, compressed or not */
 
@@ -222,6 +222,9 @@ stream_export buffer *mnstr_get_buffer(stream *s);
 stream_export stream *block_stream(stream *s);
 stream_export int isa_block_stream(stream *s);
 stream_export int isa_fixed_block_stream(stream *s);
+stream_export int isa_member_stream(stream *s);
+stream_export ssize_t mnstr_compress_member(stream *s, const void *buf, size_t len, void **out);
+stream_export int mnstr_write_member(stream *s, const void *buf, size_t len);
 stream_export stream *bs_stream(stream *s);
 stream_export stream *bs_stealstream(stream *s);
 
@@ -239,8 +242,15 @@ typedef enum {
 	COMPRESSION_AUTO = 255
 } compression_method;
 
+/* Column compression is negotiated with COLUMN_COMPRESSION_AUTO; the
+ * other values tag the encoding of a column in a protocol 10 result
+ * block. */
 typedef enum {
 	COLUMN_COMPRESSION_NONE = 0,
+	COLUMN_COMPRESSION_DICT = 1,	/* dictionary of strings and codes */
+	COLUMN_COMPRESSION_FOR = 2,	/* frame of reference */
+	COLUMN_COMPRESSION_DELTA = 3,	/* differences of sorted values */
+	COLUMN_COMPRESSION_RLE = 4,	/* run length encoding */
 	COLUMN_COMPRESSION_AUTO = 255
 } column_compression;
 
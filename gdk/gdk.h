@@ -641,6 +641,7 @@ typedef struct {
 	storage_t newstorage;	/* new desired storage mode at re-allocation. */
 	bte dirty;		/* specific heap dirty marker */
 	bte farmid;		/* id of farm where heap is located */
+	lng acct;		/* memory account charged for the heap */
 	bat parentid;		/* cache id of VIEW parent bat */
 } Heap;
 
@@ -776,6 +777,8 @@ gdk_export int VALisnil(const ValRecord *v);
  *           Hash   *thash;           // linear chained hash table on tail
  *           Imprints *timprints;     // column imprints index on tail
  *           orderidx torderidx;      // order oid index on tail
+ *           Heap   *tzonemap;        // per block min/max of tail
+ *           Heap   *tcompress;       // encoded copy of tail
  *  } BAT;
  * @end verbatim
  *
@@ -843,6 +846,8 @@ typedef struct {
 	Hash *hash;		/* hash table */
 	Imprints *imprints;	/* column imprints index */
 	Heap *orderidx;		/* order oid index */
+	Heap *zonemap;		/* per block min and max values */
+	Heap *compress;		/* encoded copy of the values */
 
 	PROPrec *props;		/* list of dynamic properties stored in the bat descriptor */
 } COLrec;
@@ -859,7 +864,8 @@ typedef struct {
 #define GDKLIBRARY_NOKEY	061034	/* nokey values can't be trusted */
 #define GDKLIBRARY_BADEMPTY	061035	/* possibility of duplicate empty str */
 #define GDKLIBRARY_TALIGN	061036	/* talign field in BBP.dir */
-#define GDKLIBRARY		061037
+#define GDKLIBRARY_NOINC	061037	/* no BBP.inc next to BBP.dir */
+#define GDKLIBRARY		061040
 
 typedef struct BAT {
 	/* static bat properties */
@@ -913,6 +919,8 @@ typedef struct BATiter {
 #define tvheap		T.vheap
 #define thash		T.hash
 #define timprints	T.imprints
+#define tzonemap	T.zonemap
+#define tcompress	T.compress
 #define tprops		T.props
 
 
@@ -1646,7 +1654,7 @@ typedef struct {
 	BAT *desc;		/* the BAT descriptor */
 	str physical;		/* dir + basename for storage */
 	str options;		/* A string list of options */
-	int refs;		/* in-memory references on which the loaded status of a BAT relies */
+	volatile ATOMIC_TYPE refs; /* in-memory references on which the loaded status of a BAT relies */
 	int lrefs;		/* logical references on which the existence of a BAT relies */
 	volatile int status;	/* status mask used for spin locking */
 	/* MT_Id pid;           non-zero thread-id if this BAT is private */
@@ -1938,6 +1946,17 @@ gdk_export lng IMPSimprintsize(BAT *b);
 gdk_export gdk_return BATorderidx(BAT *b, int stable);
 gdk_export gdk_return GDKmergeidx(BAT *b, BAT**a, int n_ar);
 
+/* The zone map: minimum and maximum value of each block of
+ * ZMAP_BLOCK values, maintained on append */
+
+gdk_export gdk_return BATzonemap(BAT *b);
+
+/* Lightweight compression: an encoded (frame of reference,
+ * dictionary or run length) copy of the tail of read-only integer
+ * columns that select, project and aggregates can use */
+
+gdk_export gdk_return BATcompress(BAT *b);
+
 /*
  * @- Multilevel Storage Modes
  *
@@ -1988,6 +2007,15 @@ gdk_export int	GDK_vm_trim;		/* allow trimming */
 gdk_export size_t GDKmem_cursize(void);	/* RAM/swapmem that MonetDB has claimed from OS */
 gdk_export size_t GDKvm_cursize(void);	/* current MonetDB VM address space usage */
 
+gdk_export size_t GDK_mem_budget;	/* max memory charged to all accounts together */
+gdk_export lng GDKaccount_open(size_t budget);	/* new memory account, 0 if none */
+gdk_export void GDKaccount_close(lng id);
+gdk_export void GDKaccount_set(lng id);	/* charge this thread's memory to id */
+gdk_export lng GDKaccount_get(void);
+gdk_export size_t GDKaccount_cursize(lng id);
+gdk_export size_t GDKaccount_peak(lng id);
+gdk_export size_t GDKaccount_total(void);
+
 gdk_export void *GDKmalloc(size_t size)
 	__attribute__((__malloc__))
 	__attribute__ ((__warn_unused_result__));
@@ -2345,6 +2373,7 @@ gdk_export BUN void_replace_bat(BAT *b, BAT *p, BAT *u, bit force)
 gdk_export gdk_return void_inplace(BAT *b, oid id, const void *val, bit force)
 	__attribute__ ((__warn_unused_result__));
 gdk_export BAT *BATattach(int tt, const char *heapfile, int role);
+gdk_export int BATcolumnfile(const char *path);
 
 #ifdef NATIVE_WIN32
 #ifdef _MSC_VER
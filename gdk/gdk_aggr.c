@@ -144,6 +144,139 @@ BATgroupaggrinit(BAT *b, BAT *g, BAT *e, BAT *s,
 	return NULL;
 }
 
+/* helpers for the parallel versions of the grouped aggregates
+ *
+ * When the input is large and the number of groups is small in
+ * comparison, the rows (or the candidates) are split into a number
+ * of consecutive ranges.  Each range is aggregated by its own thread
+ * into a private table with an entry per group, and the tables are
+ * merged afterwards, in range order, so that ties are broken the same
+ * way as in the sequential code.  The group ids can come from any
+ * (global) BATgroup result.  The worker threads never call GDKerror:
+ * if a range fails (overflow), the caller redoes the work
+ * sequentially so that the error is reported in the usual way. */
+
+#define PARAGGR_MINSIZE		((BUN) 1 << 20) /* min size for parallel aggregate */
+#define PARAGGR_MINCHUNK	((BUN) 1 << 18) /* min size per thread */
+
+struct aggrtask {
+	BAT *b;			/* values */
+	const oid *gids;	/* group ids (NULL: not used) */
+	oid min, max;		/* range of group ids */
+	BUN ngrp;		/* number of groups (entries in res) */
+	BUN start, end;		/* range of rows */
+	const oid *cand, *candend; /* range of candidates */
+	BUN cnt;		/* BATcount(b) (min/max only) */
+	int skip_nils;
+	int tp;			/* type of the entries in res */
+	void *res;		/* partial results, one per group */
+	lng *cnts;		/* partial counts (average only) */
+	BUN (*minmax)(oid *restrict, BAT *, const oid *restrict, BUN,
+		      oid, oid, BUN, BUN, const oid *restrict,
+		      const oid *, BUN, int, int);
+	int ret;		/* 0: ok, -1: failed */
+};
+
+/* Split the input of a grouped aggregate into ranges, one per task.
+ * Returns NULL (and *ntasksp == 0) if it is not worth it to
+ * parallelize, or if there is no memory for the task list.  The
+ * caller fills in the rest of the task structures. */
+static struct aggrtask *
+paraggrinit(BAT *b, const oid *gids, BUN ngrp, oid min, oid max,
+	    BUN start, BUN end, const oid *cand, const oid *candend,
+	    int skip_nils, int *ntasksp)
+{
+	struct aggrtask *tasks;
+	BUN cnt, lo, hi;
+	int n, ntasks;
+
+	*ntasksp = 0;
+	cnt = cand ? (BUN) (candend - cand) : end - start;
+	ntasks = GDKnr_threads;
+	if (ntasks > 1 && (BUN) ntasks > cnt / PARAGGR_MINCHUNK)
+		ntasks = (int) (cnt / PARAGGR_MINCHUNK);
+	/* with dense (or no) groups, every value is its own group
+	 * and there is nothing to gain; also, the private tables
+	 * must be small compared to the work of the scan */
+	if (ntasks <= 1 || cnt < PARAGGR_MINSIZE || gids == NULL ||
+	    ngrp > cnt / 4 / ntasks)
+		return NULL;
+	if ((tasks = GDKzalloc(ntasks * sizeof(struct aggrtask))) == NULL)
+		return NULL;
+	for (n = 0, lo = 0; n < ntasks; n++, lo = hi) {
+		hi = n == ntasks - 1 ? cnt : cnt / ntasks * (n + 1);
+		tasks[n].b = b;
+		tasks[n].gids = gids;
+		tasks[n].min = min;
+		tasks[n].max = max;
+		tasks[n].ngrp = ngrp;
+		tasks[n].skip_nils = skip_nils;
+		if (cand) {
+			tasks[n].start = start;
+			tasks[n].end = end;
+			tasks[n].cand = cand + lo;
+			tasks[n].candend = cand + hi;
+		} else {
+			tasks[n].start = start + lo;
+			tasks[n].end = start + hi;
+		}
+	}
+	*ntasksp = ntasks;
+	ALGODEBUG fprintf(stderr, "#paraggrinit: " BUNFMT " values in "
+			  BUNFMT " groups, %d tasks\n", cnt, ngrp, ntasks);
+	return tasks;
+}
+
+/* allocate the (zeroed) private tables of the tasks; if res (cnts)
+ * is given, the first task works directly on it */
+static int
+paraggralloc(struct aggrtask *tasks, int ntasks, void *res, size_t width,
+	     lng *cnts, int withcnts)
+{
+	int n;
+
+	for (n = 0; n < ntasks; n++) {
+		if (n == 0 && res)
+			tasks[n].res = res;
+		else if ((tasks[n].res = GDKzalloc(tasks[n].ngrp * width)) == NULL)
+			return -1;
+		if (n == 0 && cnts)
+			tasks[n].cnts = cnts;
+		else if (withcnts &&
+			 (tasks[n].cnts = GDKzalloc(tasks[n].ngrp * sizeof(lng))) == NULL)
+			return -1;
+	}
+	return 0;
+}
+
+static void
+paraggrfree(struct aggrtask *tasks, int ntasks, void *res, lng *cnts)
+{
+	int n;
+
+	for (n = 0; n < ntasks; n++) {
+		if (tasks[n].res != res)
+			GDKfree(tasks[n].res);
+		if (tasks[n].cnts != cnts)
+			GDKfree(tasks[n].cnts);
+	}
+	GDKfree(tasks);
+}
+
+/* iterate over the range of a task: set i to the next row */
+#define PARAGGR_NEXT(t)							\
+	if (cand) {							\
+		if (cand == candend)					\
+			break;						\
+		i = *cand++ - (t)->b->hseqbase;				\
+		if (i >= end)						\
+			break;						\
+	} else {							\
+		i = start++;						\
+		if (i == end)						\
+			break;						\
+	}
+
 /* ---------------------------------------------------------------------- */
 /* sum */
 
@@ -469,6 +602,209 @@ dosum(const void *restrict values, int nonil, oid seqb, BUN start, BUN end,
 	return BUN_NONE;
 }
 
+/* parallel version of dosum for skip_nils && abort_on_error on
+ * integer types: an entry in a private table is nil as long as the
+ * group has not been seen in the range of the task */
+
+#define PARSUM(TYPE1, TYPE2)						\
+	do {								\
+		const TYPE1 *restrict vals = (const TYPE1 *) Tloc(t->b, 0); \
+		TYPE2 *restrict sums = (TYPE2 *) t->res;		\
+		for (i = 0; i < t->ngrp; i++)				\
+			sums[i] = TYPE2##_nil;				\
+		for (;;) {						\
+			PARAGGR_NEXT(t);				\
+			if (gids[i] >= min && gids[i] <= max &&		\
+			    vals[i] != TYPE1##_nil) {			\
+				gid = gids[i] - min;			\
+				if (sums[gid] == TYPE2##_nil)		\
+					sums[gid] = 0;			\
+				ADD_WITH_CHECK(TYPE1, vals[i],		\
+					       TYPE2, sums[gid],	\
+					       TYPE2, sums[gid],	\
+					       GDK_##TYPE2##_max,	\
+					       goto overflow);		\
+			}						\
+		}							\
+	} while (0)
+
+#define PARSUM_MERGE(TYPE)						\
+	do {								\
+		TYPE *restrict sums = (TYPE *) tasks[0].res;		\
+		for (n = 1; n < ntasks; n++) {				\
+			const TYPE *restrict part = (const TYPE *) tasks[n].res; \
+			for (i = 0; i < ngrp; i++) {			\
+				if (part[i] == TYPE##_nil)		\
+					continue;			\
+				if (sums[i] == TYPE##_nil)		\
+					sums[i] = part[i];		\
+				else					\
+					ADD_WITH_CHECK(TYPE, part[i],	\
+						       TYPE, sums[i],	\
+						       TYPE, sums[i],	\
+						       GDK_##TYPE##_max, \
+						       goto overflow);	\
+			}						\
+		}							\
+		for (i = 0; i < ngrp; i++)				\
+			nils += sums[i] == TYPE##_nil;			\
+	} while (0)
+
+static void
+parsumchunk(void *arg)
+{
+	struct aggrtask *t = arg;
+	const oid *restrict gids = t->gids;
+	const oid *cand = t->cand, *candend = t->candend;
+	oid min = t->min, max = t->max, gid;
+	BUN start = t->start, end = t->end, i;
+	BUN nils = 0;		/* used by ADD_WITH_CHECK */
+	const int abort_on_error = 1;
+
+	switch (ATOMstorage(t->tp)) {
+	case TYPE_bte:
+		switch (t->b->ttype) {
+		case TYPE_bte:
+			PARSUM(bte, bte);
+			break;
+		default:
+			goto unsupported;
+		}
+		break;
+	case TYPE_sht:
+		switch (t->b->ttype) {
+		case TYPE_bte:
+			PARSUM(bte, sht);
+			break;
+		case TYPE_sht:
+			PARSUM(sht, sht);
+			break;
+		default:
+			goto unsupported;
+		}
+		break;
+	case TYPE_int:
+		switch (t->b->ttype) {
+		case TYPE_bte:
+			PARSUM(bte, int);
+			break;
+		case TYPE_sht:
+			PARSUM(sht, int);
+			break;
+		case TYPE_int:
+			PARSUM(int, int);
+			break;
+		default:
+			goto unsupported;
+		}
+		break;
+	case TYPE_lng:
+		switch (t->b->ttype) {
+		case TYPE_bte:
+			PARSUM(bte, lng);
+			break;
+		case TYPE_sht:
+			PARSUM(sht, lng);
+			break;
+		case TYPE_int:
+			PARSUM(int, lng);
+			break;
+		case TYPE_lng:
+			PARSUM(lng, lng);
+			break;
+		default:
+			goto unsupported;
+		}
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		switch (ATOMstorage(t->b->ttype)) {
+		case TYPE_bte:
+			PARSUM(bte, hge);
+			break;
+		case TYPE_sht:
+			PARSUM(sht, hge);
+			break;
+		case TYPE_int:
+			PARSUM(int, hge);
+			break;
+		case TYPE_lng:
+			PARSUM(lng, hge);
+			break;
+		case TYPE_hge:
+			PARSUM(hge, hge);
+			break;
+		default:
+			goto unsupported;
+		}
+		break;
+#endif
+	default:
+		goto unsupported;
+	}
+	(void) nils;
+	return;
+
+  unsupported:
+  overflow:
+	t->ret = -1;
+}
+
+/* Returns BUN_NONE if the sums were not calculated (in parallel), in
+ * which case the results were not touched. */
+static BUN
+parsum(BAT *b, const oid *restrict gids, void *restrict results, BUN ngrp,
+       int tp, oid min, oid max, BUN start, BUN end,
+       const oid *cand, const oid *candend)
+{
+	struct aggrtask *tasks;
+	int n, ntasks;
+	BUN i, nils = 0;
+	const int abort_on_error = 1;
+
+	if ((tasks = paraggrinit(b, gids, ngrp, min, max, start, end,
+				 cand, candend, 1, &ntasks)) == NULL)
+		return BUN_NONE;
+	if (paraggralloc(tasks, ntasks, NULL, ATOMsize(tp), NULL, 0) < 0)
+		goto bailout;
+	for (n = 0; n < ntasks; n++)
+		tasks[n].tp = tp;
+	GDKparallel(ntasks, parsumchunk, tasks, sizeof(struct aggrtask));
+	for (n = 0; n < ntasks; n++)
+		if (tasks[n].ret < 0)
+			goto bailout;
+	switch (ATOMstorage(tp)) {
+	case TYPE_bte:
+		PARSUM_MERGE(bte);
+		break;
+	case TYPE_sht:
+		PARSUM_MERGE(sht);
+		break;
+	case TYPE_int:
+		PARSUM_MERGE(int);
+		break;
+	case TYPE_lng:
+		PARSUM_MERGE(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		PARSUM_MERGE(hge);
+		break;
+#endif
+	default:
+		goto bailout;
+	}
+	memcpy(results, tasks[0].res, ngrp * ATOMsize(tp));
+	paraggrfree(tasks, ntasks, NULL, NULL);
+	return nils;
+
+  overflow:
+  bailout:
+	ALGODEBUG fprintf(stderr, "#parsum: falling back to sequential sum\n");
+	paraggrfree(tasks, ntasks, NULL, NULL);
+	return BUN_NONE;
+}
+
 /* calculate group sums with optional candidates list */
 BAT *
 BATgroupsum(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on_error)
@@ -516,10 +852,16 @@ BATgroupsum(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on_
 	else
 		gids = (const oid *) Tloc(g, start);
 
-	nils = dosum(Tloc(b, 0), b->tnonil, b->hseqbase, start, end,
-		     Tloc(bn, 0), ngrp, b->ttype, tp,
-		     cand, candend, gids, min, max,
-		     skip_nils, abort_on_error, 1, "BATgroupsum");
+	nils = BUN_NONE;
+	if (skip_nils && abort_on_error && ATOMstorage(tp) != TYPE_flt &&
+	    ATOMstorage(tp) != TYPE_dbl)
+		nils = parsum(b, gids, Tloc(bn, 0), ngrp, tp, min, max,
+			      start, end, cand, candend);
+	if (nils == BUN_NONE)
+		nils = dosum(Tloc(b, 0), b->tnonil, b->hseqbase, start, end,
+			     Tloc(bn, 0), ngrp, b->ttype, tp,
+			     cand, candend, gids, min, max,
+			     skip_nils, abort_on_error, 1, "BATgroupsum");
 
 	if (nils < BUN_NONE) {
 		BATsetcount(bn, ngrp);
@@ -542,7 +884,9 @@ BATsum(void *res, int tp, BAT *b, BAT *s, int skip_nils, int abort_on_error, int
 	oid min, max;
 	BUN ngrp;
 	BUN nils;
-	BUN start, end;
+	BUN start, end, off;
+	BAT *pb;
+	lng sum;
 	const oid *cand = NULL, *candend = NULL;
 	const char *err;
 
@@ -644,6 +988,30 @@ BATsum(void *res, int tp, BAT *b, BAT *s, int skip_nils, int abort_on_error, int
 	}
 	if (BATcount(b) == 0)
 		return GDK_SUCCEED;
+	if (cand == NULL &&
+	    (tp == TYPE_lng
+#ifdef HAVE_HGE
+	     || tp == TYPE_hge
+#endif
+		    ) &&
+	    (b->ttype == TYPE_sht || b->ttype == TYPE_int ||
+	     b->ttype == TYPE_lng) &&
+	    (pb = CMPRbat(b, &off)) != NULL &&
+	    CMPRsum(b, pb, off + start, off + end, &sum, &nils) == GDK_SUCCEED) {
+		/* summed the encoded copy; on overflow we fall
+		 * through so that it gets reported below */
+		if (nils > 0 && !skip_nils)
+			sum = lng_nil;
+		else if (nils == end - start)
+			return GDK_SUCCEED; /* no values: keep initial */
+#ifdef HAVE_HGE
+		if (tp == TYPE_hge)
+			* (hge *) res = sum == lng_nil ? hge_nil : (hge) sum;
+		else
+#endif
+			* (lng *) res = sum;
+		return GDK_SUCCEED;
+	}
 	nils = dosum(Tloc(b, 0), b->tnonil, b->hseqbase, start, end,
 		     res, 1, b->ttype, tp, cand, candend, &min, min, max,
 		     skip_nils, abort_on_error, nil_if_empty, "BATsum");
@@ -1343,6 +1711,157 @@ BATprod(void *res, int tp, BAT *b, BAT *s, int skip_nils, int abort_on_error, in
 		}							\
 	} while (0)
 
+/* parallel version of AGGR_AVG: the tasks calculate exact sums in a
+ * wider type, after the merge the average and remainder are derived
+ * from the total sum, so that the results are identical to the ones
+ * of AGGR_AVG */
+
+#define PARAVG(TYPE, STYPE)						\
+	do {								\
+		const TYPE *restrict vals = (const TYPE *) Tloc(t->b, 0); \
+		STYPE *restrict sums = (STYPE *) t->res;		\
+		for (;;) {						\
+			PARAGGR_NEXT(t);				\
+			if (gids[i] >= min && gids[i] <= max) {		\
+				gid = gids[i] - min;			\
+				if (vals[i] == TYPE##_nil) {		\
+					if (!t->skip_nils)		\
+						cnts[gid] = lng_nil;	\
+				} else if (cnts[gid] != lng_nil) {	\
+					sums[gid] += vals[i];		\
+					cnts[gid]++;			\
+				}					\
+			}						\
+		}							\
+	} while (0)
+
+#define PARAVG_MERGE(STYPE)						\
+	do {								\
+		STYPE *restrict sums = (STYPE *) tasks[0].res;		\
+		STYPE a, r;						\
+		for (n = 1; n < ntasks; n++) {				\
+			const STYPE *restrict psums = (const STYPE *) tasks[n].res; \
+			const lng *restrict pcnts = tasks[n].cnts;	\
+			for (i = 0; i < ngrp; i++) {			\
+				if (cnts[i] == lng_nil)			\
+					continue;			\
+				if (pcnts[i] == lng_nil) {		\
+					cnts[i] = lng_nil;		\
+				} else {				\
+					sums[i] += psums[i];		\
+					cnts[i] += pcnts[i];		\
+				}					\
+			}						\
+		}							\
+		for (i = 0; i < ngrp; i++) {				\
+			if (cnts[i] == 0 || cnts[i] == lng_nil) {	\
+				dbls[i] = dbl_nil;			\
+				cnts[i] = 0;				\
+				nils++;					\
+			} else {					\
+				/* a = sum / cnt rounded down, */	\
+				/* 0 <= r < cnt */			\
+				a = sums[i] / cnts[i];			\
+				r = sums[i] - a * cnts[i];		\
+				if (r < 0) {				\
+					a--;				\
+					r += cnts[i];			\
+				}					\
+				dbls[i] = a + (dbl) r / cnts[i];	\
+			}						\
+		}							\
+	} while (0)
+
+static void
+paravgchunk(void *arg)
+{
+	struct aggrtask *t = arg;
+	const oid *restrict gids = t->gids;
+	const oid *cand = t->cand, *candend = t->candend;
+	oid min = t->min, max = t->max, gid;
+	BUN start = t->start, end = t->end, i;
+	lng *restrict cnts = t->cnts;
+
+	switch (t->b->ttype) {
+	case TYPE_bte:
+		PARAVG(bte, lng);
+		break;
+	case TYPE_sht:
+		PARAVG(sht, lng);
+		break;
+	case TYPE_int:
+		PARAVG(int, lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_lng:
+		PARAVG(lng, hge);
+		break;
+#endif
+	default:
+		assert(0);
+		break;
+	}
+}
+
+/* Returns BUN_NONE if the averages were not calculated in parallel. */
+static BUN
+paravg(dbl *restrict dbls, lng *restrict cnts, BAT *b,
+       const oid *restrict gids, BUN ngrp, oid min, oid max,
+       BUN start, BUN end, const oid *cand, const oid *candend,
+       int skip_nils)
+{
+	struct aggrtask *tasks;
+	int n, ntasks;
+	BUN i, nils = 0;
+	size_t width;
+
+	switch (b->ttype) {
+	case TYPE_bte:
+	case TYPE_sht:
+		width = sizeof(lng);
+		break;
+	case TYPE_int:
+		/* the sums fit in a lng if there are fewer than 2^32
+		 * values */
+		if (BATcount(b) > (BUN) 0xFFFFFFFF)
+			return BUN_NONE;
+		width = sizeof(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_lng:
+		width = sizeof(hge);
+		break;
+#endif
+	default:
+		return BUN_NONE;
+	}
+	if ((tasks = paraggrinit(b, gids, ngrp, min, max, start, end,
+				 cand, candend, skip_nils, &ntasks)) == NULL)
+		return BUN_NONE;
+	if (paraggralloc(tasks, ntasks, NULL, width, cnts, 1) < 0) {
+		paraggrfree(tasks, ntasks, NULL, cnts);
+		return BUN_NONE;
+	}
+	GDKparallel(ntasks, paravgchunk, tasks, sizeof(struct aggrtask));
+	switch (b->ttype) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+		PARAVG_MERGE(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_lng:
+		PARAVG_MERGE(hge);
+		break;
+#endif
+	default:
+		assert(0);
+		break;
+	}
+	paraggrfree(tasks, ntasks, NULL, cnts);
+	return nils;
+}
+
 /* calculate group averages with optional candidates list */
 gdk_return
 BATgroupavg(BAT **bnp, BAT **cntsp, BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on_error)
@@ -1452,6 +1971,10 @@ BATgroupavg(BAT **bnp, BAT **cntsp, BAT *b, BAT *g, BAT *e, BAT *s, int tp, int
 	else
 		gids = (const oid *) Tloc(g, start);
 
+	if ((nils = paravg(dbls, cnts, b, gids, ngrp, min, max, start, end,
+			   cand, candend, skip_nils)) != BUN_NONE)
+		goto done;
+	nils = 0;
 	switch (b->ttype) {
 	case TYPE_bte:
 		AGGR_AVG(bte);
@@ -1487,6 +2010,7 @@ BATgroupavg(BAT **bnp, BAT **cntsp, BAT *b, BAT *g, BAT *e, BAT *s, int tp, int
 			 ATOMname(b->ttype));
 		return GDK_FAIL;
 	}
+  done:
 	GDKfree(rems);
 	if (cn == NULL)
 		GDKfree(cnts);
@@ -1716,55 +2240,17 @@ BATcalcavg(BAT *b, BAT *s, dbl *avg, BUN *vals)
 		}							\
 	} while (0)
 
-/* calculate group counts with optional candidates list */
-BAT *
-BATgroupcount(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on_error)
+static void
+docount(lng *restrict cnts, BAT *b, const oid *restrict gids,
+	oid min, oid max, BUN start, BUN end,
+	const oid *restrict cand, const oid *candend, int skip_nils)
 {
-	const oid *restrict gids;
 	oid gid;
-	oid min, max;
-	BUN i, ngrp;
-	lng *restrict cnts;
-	BAT *bn = NULL;
+	BUN i;
 	int t;
 	const void *nil;
 	int (*atomcmp)(const void *, const void *);
 	BATiter bi;
-	BUN start, end;
-	const oid *cand = NULL, *candend = NULL;
-	const char *err;
-
-	assert(tp == TYPE_lng);
-	(void) tp;		/* compatibility (with other BATgroup* */
-	(void) abort_on_error;	/* functions) argument */
-
-	if ((err = BATgroupaggrinit(b, g, e, s, &min, &max, &ngrp, &start, &end,
-				    &cand, &candend)) != NULL) {
-		GDKerror("BATgroupcount: %s\n", err);
-		return NULL;
-	}
-	if (g == NULL) {
-		GDKerror("BATgroupcount: b and g must be aligned\n");
-		return NULL;
-	}
-
-	if (BATcount(b) == 0 || ngrp == 0) {
-		/* trivial: no products, so return bat aligned with g
-		 * with zero in the tail */
-		lng zero = 0;
-		return BATconstant(ngrp == 0 ? 0 : min, TYPE_lng, &zero, ngrp, TRANSIENT);
-	}
-
-	bn = COLnew(min, TYPE_lng, ngrp, TRANSIENT);
-	if (bn == NULL)
-		return NULL;
-	cnts = (lng *) Tloc(bn, 0);
-	memset(cnts, 0, ngrp * sizeof(lng));
-
-	if (BATtdense(g))
-		gids = NULL;
-	else
-		gids = (const oid *) Tloc(g, start);
 
 	t = b->ttype;
 	nil = ATOMnilptr(t);
@@ -1823,6 +2309,95 @@ BATgroupcount(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_o
 		}
 		break;
 	}
+}
+
+static void
+parcountchunk(void *arg)
+{
+	struct aggrtask *t = arg;
+
+	docount(t->res, t->b, t->gids, t->min, t->max, t->start, t->end,
+		t->cand, t->candend, t->skip_nils);
+}
+
+/* Returns non-zero if the counts were calculated in parallel. */
+static int
+parcount(lng *restrict cnts, BAT *b, const oid *restrict gids, BUN ngrp,
+	 oid min, oid max, BUN start, BUN end,
+	 const oid *cand, const oid *candend, int skip_nils)
+{
+	struct aggrtask *tasks;
+	int n, ntasks;
+	BUN i;
+
+	if ((tasks = paraggrinit(b, gids, ngrp, min, max, start, end,
+				 cand, candend, skip_nils, &ntasks)) == NULL)
+		return 0;
+	if (paraggralloc(tasks, ntasks, cnts, sizeof(lng), NULL, 0) < 0) {
+		paraggrfree(tasks, ntasks, cnts, NULL);
+		return 0;
+	}
+	GDKparallel(ntasks, parcountchunk, tasks, sizeof(struct aggrtask));
+	for (n = 1; n < ntasks; n++) {
+		const lng *restrict part = tasks[n].res;
+
+		for (i = 0; i < ngrp; i++)
+			cnts[i] += part[i];
+	}
+	paraggrfree(tasks, ntasks, cnts, NULL);
+	return 1;
+}
+
+/* calculate group counts with optional candidates list */
+BAT *
+BATgroupcount(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils, int abort_on_error)
+{
+	const oid *restrict gids;
+	oid min, max;
+	BUN ngrp;
+	lng *restrict cnts;
+	BAT *bn = NULL;
+	BUN start, end;
+	const oid *cand = NULL, *candend = NULL;
+	const char *err;
+
+	assert(tp == TYPE_lng);
+	(void) tp;		/* compatibility (with other BATgroup* */
+	(void) abort_on_error;	/* functions) argument */
+
+	if ((err = BATgroupaggrinit(b, g, e, s, &min, &max, &ngrp, &start, &end,
+				    &cand, &candend)) != NULL) {
+		GDKerror("BATgroupcount: %s\n", err);
+		return NULL;
+	}
+	if (g == NULL) {
+		GDKerror("BATgroupcount: b and g must be aligned\n");
+		return NULL;
+	}
+
+	if (BATcount(b) == 0 || ngrp == 0) {
+		/* trivial: no products, so return bat aligned with g
+		 * with zero in the tail */
+		lng zero = 0;
+		return BATconstant(ngrp == 0 ? 0 : min, TYPE_lng, &zero, ngrp, TRANSIENT);
+	}
+
+	bn = COLnew(min, TYPE_lng, ngrp, TRANSIENT);
+	if (bn == NULL)
+		return NULL;
+	cnts = (lng *) Tloc(bn, 0);
+	memset(cnts, 0, ngrp * sizeof(lng));
+
+	if (BATtdense(g))
+		gids = NULL;
+	else
+		gids = (const oid *) Tloc(g, start);
+
+	if (!parcount(cnts, b, gids, ngrp, min, max, start, end,
+		      cand, candend, skip_nils))
+		docount(cnts, b, gids, min, max, start, end,
+			cand, candend, skip_nils);
+
 	BATsetcount(bn, ngrp);
 	bn->tkey = BATcount(bn) <= 1;
 	bn->tsorted = BATcount(bn) <= 1;
@@ -2221,6 +2796,77 @@ do_groupmax(oid *restrict oids, BAT *b, const oid *restrict gids, BUN ngrp,
 	return nils;
 }
 
+static void
+parminmaxchunk(void *arg)
+{
+	struct aggrtask *t = arg;
+
+	(void) (*t->minmax)(t->res, t->b, t->gids, t->ngrp, t->min, t->max,
+			    t->start, t->end, t->cand, t->candend, t->cnt,
+			    t->skip_nils, 0);
+}
+
+/* Returns BUN_NONE if the minimums/maximums were not calculated in
+ * parallel.  The partial results are positions, so they are merged
+ * by comparing the values they refer to, in the same way (and with
+ * the same tie breaking) as do_groupmin and do_groupmax. */
+static BUN
+parminmax(oid *restrict oids, BAT *b, const oid *restrict gids, BUN ngrp,
+	  oid min, oid max, BUN start, BUN end,
+	  const oid *cand, const oid *candend, int skip_nils,
+	  BUN (*minmax)(oid *restrict, BAT *, const oid *restrict, BUN,
+			oid, oid, BUN, BUN, const oid *restrict,
+			const oid *, BUN, int, int))
+{
+	struct aggrtask *tasks;
+	int n, ntasks, c;
+	BUN i, nils = 0;
+	BATiter bi;
+	const void *nil = ATOMnilptr(b->ttype);
+	int (*atomcmp)(const void *, const void *) = ATOMcompare(b->ttype);
+
+	if (b->ttype == TYPE_void ||
+	    (tasks = paraggrinit(b, gids, ngrp, min, max, start, end,
+				 cand, candend, skip_nils, &ntasks)) == NULL)
+		return BUN_NONE;
+	if (paraggralloc(tasks, ntasks, oids, sizeof(oid), NULL, 0) < 0) {
+		paraggrfree(tasks, ntasks, oids, NULL);
+		return BUN_NONE;
+	}
+	for (n = 0; n < ntasks; n++) {
+		tasks[n].cnt = BATcount(b);
+		tasks[n].minmax = minmax;
+	}
+	GDKparallel(ntasks, parminmaxchunk, tasks, sizeof(struct aggrtask));
+	bi = bat_iterator(b);
+	for (n = 1; n < ntasks; n++) {
+		const oid *restrict part = tasks[n].res;
+
+		for (i = 0; i < ngrp; i++) {
+			const void *v, *w;
+
+			if (part[i] == oid_nil)
+				continue;
+			if (oids[i] == oid_nil) {
+				oids[i] = part[i];
+				continue;
+			}
+			v = BUNtail(bi, (BUN) (part[i] - b->hseqbase));
+			w = BUNtail(bi, (BUN) (oids[i] - b->hseqbase));
+			if ((*atomcmp)(w, nil) == 0)
+				continue;
+			c = (*atomcmp)(v, w);
+			if ((*atomcmp)(v, nil) == 0 ||
+			    (minmax == do_groupmin ? c < 0 : c > 0))
+				oids[i] = part[i];
+		}
+	}
+	for (i = 0; i < ngrp; i++)
+		nils += oids[i] == oid_nil;
+	paraggrfree(tasks, ntasks, oids, NULL);
+	return nils;
+}
+
 static BAT *
 BATgroupminmax(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils,
 	       int abort_on_error,
@@ -2271,9 +2917,12 @@ BATgroupminmax(BAT *b, BAT *g, BAT *e, BAT *s, int tp, int skip_nils,
 	else
 		gids = (const oid *) Tloc(g, start);
 
-	nils = (*minmax)(oids, b, gids, ngrp, min, max, start, end,
-			 cand, candend, BATcount(b), skip_nils,
-			 g && BATtdense(g));
+	nils = parminmax(oids, b, gids, ngrp, min, max, start, end,
+			 cand, candend, skip_nils, minmax);
+	if (nils == BUN_NONE)
+		nils = (*minmax)(oids, b, gids, ngrp, min, max, start, end,
+				 cand, candend, BATcount(b), skip_nils,
+				 g && BATtdense(g));
 
 	BATsetcount(bn, ngrp);
 
@@ -2295,40 +2944,44 @@ BATminmax(BAT *b, void *aggr,
 	const void *res;
 	size_t s;
 	BATiter bi;
-
-	if ((VIEWtparent(b) == 0 ||
-	     BATcount(b) == BATcount(BBPdescriptor(VIEWtparent(b)))) &&
-	    BATcheckimprints(b)) {
-		Imprints *imprints = VIEWtparent(b) ? BBPdescriptor(VIEWtparent(b))->timprints : b->timprints;
-		int i;
-
-		pos = oid_nil;
-		if (minmax == do_groupmin) {
-			/* find first non-empty bin */
-			for (i = 0; i < imprints->bits; i++) {
-				if (imprints->stats[i + 128]) {
-					pos = imprints->stats[i] + b->hseqbase;
-					break;
+	lng buf;
+
+	/* the encoded copy, if any, knows the answer */
+	if ((res = CMPRminmax(b, minmax == do_groupmax, &buf)) == NULL) {
+		if ((VIEWtparent(b) == 0 ||
+		     BATcount(b) == BATcount(BBPdescriptor(VIEWtparent(b)))) &&
+		    BATcheckimprints(b)) {
+			Imprints *imprints = VIEWtparent(b) ? BBPdescriptor(VIEWtparent(b))->timprints : b->timprints;
+			int i;
+
+			pos = oid_nil;
+			if (minmax == do_groupmin) {
+				/* find first non-empty bin */
+				for (i = 0; i < imprints->bits; i++) {
+					if (imprints->stats[i + 128]) {
+						pos = imprints->stats[i] + b->hseqbase;
+						break;
+					}
 				}
-			}
-		} else {
-			/* find last non-empty bin */
-			for (i = imprints->bits - 1; i >= 0; i--) {
-				if (imprints->stats[i + 128]) {
-					pos = imprints->stats[i + 64] + b->hseqbase;
-					break;
+			} else {
+				/* find last non-empty bin */
+				for (i = imprints->bits - 1; i >= 0; i--) {
+					if (imprints->stats[i + 128]) {
+						pos = imprints->stats[i + 64] + b->hseqbase;
+						break;
+					}
 				}
 			}
+		} else {
+			(void) (*minmax)(&pos, b, NULL, 1, 0, 0, 0, BATcount(b),
+					 NULL, NULL, BATcount(b), 1, 0);
+		}
+		if (pos == oid_nil) {
+			res = ATOMnilptr(b->ttype);
+		} else {
+			bi = bat_iterator(b);
+			res = BUNtail(bi, pos - b->hseqbase);
 		}
-	} else {
-		(void) (*minmax)(&pos, b, NULL, 1, 0, 0, 0, BATcount(b),
-				 NULL, NULL, BATcount(b), 1, 0);
-	}
-	if (pos == oid_nil) {
-		res = ATOMnilptr(b->ttype);
-	} else {
-		bi = bat_iterator(b);
-		res = BUNtail(bi, pos - b->hseqbase);
 	}
 	if (aggr == NULL) {
 		s = ATOMlen(b->ttype, res);
@@ -177,12 +177,16 @@ VIEWcreate_(oid seq, BAT *b, int slice_view)
 	/* slices are unequal to their parents; cannot use accs */
 	if (slice_view || !tp || isVIEW(b))
 		bn->thash = NULL;
-	else
+	else if (BATcheckhash(b))	/* loads a saved hash table */
 		bn->thash = b->thash;
+	else
+		bn->thash = NULL;
 	/* imprints are shared, but the check is dynamic */
 	bn->timprints = NULL;
 	/* Order OID index */
 	bn->torderidx = NULL;
+	bn->tzonemap = NULL;
+	bn->tcompress = NULL;
 	if (BBPcacheit(bn, 1) != GDK_SUCCEED) {	/* enter in BBP */
 		if (tp)
 			BBPunshare(tp);
@@ -235,6 +239,8 @@ BATmaterialize(BAT *b)
 	HASHdestroy(b);
 	IMPSdestroy(b);
 	OIDXdestroy(b);
+	CMPRdestroy(b);
+	ZMAPdestroy(b);
 
 	b->theap.filename = NULL;
 	if (HEAPalloc(&b->theap, cnt, sizeof(oid)) != GDK_SUCCEED) {
@@ -490,6 +496,8 @@ VIEWdestroy(BAT *b)
 	HASHdestroy(b);
 	IMPSdestroy(b);
 	OIDXdestroy(b);
+	CMPRdestroy(b);
+	ZMAPdestroy(b);
 	VIEWunlink(b);
 
 	if (b->ttype && !b->theap.parentid) {
@@ -109,6 +109,8 @@ BATcreatedesc(oid hseq, int tt, int heapnames, int role)
  	* Default zero for order oid index
  	*/
 	bn->torderidx = 0;
+	bn->tzonemap = NULL;
+	bn->tcompress = NULL;
 	/*
 	 * fill in heap names, so HEAPallocs can resort to disk for
 	 * very large writes.
@@ -253,6 +255,257 @@ BATdense(oid hseq, oid tseq, BUN cnt)
 	return bn;
 }
 
+/*
+ * A column file is a self-describing binary representation of a single
+ * column, meant for bulk loading data produced by other programs.  It
+ * starts with a header of COLFHDRWORDS 8-byte words in host byte
+ * order:
+ *  0:     magic "MonetCol"
+ *  1:     byte order mark 0x0102030405060708
+ *  2:     format version (COLFVERSION)
+ *  3-4:   name of the atom type, NUL padded (e.g. "int", "str")
+ *  5:     number of values
+ *  6:     width in bytes of the values in the tail section (for
+ *         strings: the width of the offsets, 4 or 8)
+ *  7:     1 if words 8-9 hold the representation of nil, 0 if nil is
+ *         represented by MonetDB's nil value
+ *  8-9:   representation of nil (the first width bytes are used)
+ *  10-11: offset and length of the tail section
+ *  12-13: offset and length of the string heap section
+ *  14:    number of reserved bytes at the start of the string heap
+ * For strings, the tail section contains byte offsets into the string
+ * heap section, where the NUL-terminated UTF-8 strings are found; nil
+ * is represented by str_nil.
+ *
+ * The values are bulk loaded: the tail section of a fixed-size type is
+ * read straight into the tail of the BAT (after which a foreign nil
+ * is translated), and so are both sections of a string column if
+ * their layout is the layout of the BAT heaps, i.e. if the first
+ * GDK_STRHASHTABLE * sizeof(stridx_t) bytes of the string heap are
+ * reserved (and zero).  Otherwise the strings are appended one by
+ * one.
+ */
+#define COLFMAGIC	"MonetCol"
+#define COLFBOM		LL_CONSTANT(0x0102030405060708)
+#define COLFVERSION	1
+#define COLFHDRWORDS	15
+
+int
+BATcolumnfile(const char *path)
+{
+	char magic[8];
+	FILE *f;
+	int ret = 0;
+
+	if ((f = fopen(path, "rb")) != NULL) {
+		ret = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+			memcmp(magic, COLFMAGIC, sizeof(magic)) == 0;
+		fclose(f);
+	}
+	return ret;
+}
+
+static gdk_return
+COLFread(FILE *f, size_t off, char *p, size_t n)
+{
+	size_t m;
+	int res;
+
+#ifdef WIN32
+	res = _fseeki64(f, (__int64) off, SEEK_SET);
+#else
+#ifdef HAVE_FSEEKO
+	res = fseeko(f, (off_t) off, SEEK_SET);
+#else
+	res = fseek(f, (long) off, SEEK_SET);
+#endif
+#endif
+	if (res < 0) {
+		GDKsyserror("BATattach: cannot seek\n");
+		return GDK_FAIL;
+	}
+	while (n > 0 && (m = fread(p, 1, MIN(1024 * 1024, n), f)) > 0) {
+		p += m;
+		n -= m;
+	}
+	if (n > 0) {
+		GDKerror("BATattach: couldn't read the complete file\n");
+		return GDK_FAIL;
+	}
+	return GDK_SUCCEED;
+}
+
+/* check that the string offsets point into the string heap */
+static gdk_return
+COLFcheckstr(const char *tail, size_t width, BUN cnt, const char *vheap, size_t vres, size_t vlen)
+{
+	BUN i;
+	size_t o;
+
+	if (vlen <= vres || vheap[vlen - 1] != 0) {
+		GDKerror("BATattach: last string is not null-terminated\n");
+		return GDK_FAIL;
+	}
+	for (i = 0; i < cnt; i++) {
+		o = width == 4 ? (size_t) ((const unsigned int *) tail)[i] :
+			(size_t) ((const ulng *) tail)[i];
+		if (o < vres || o >= vlen) {
+			GDKerror("BATattach: string offset out of range\n");
+			return GDK_FAIL;
+		}
+	}
+	return GDK_SUCCEED;
+}
+
+static BAT *
+BATattachcolumn(int tt, const char *heapfile, FILE *f, int role)
+{
+	lng hdr[COLFHDRWORDS];
+	char tpe[2 * sizeof(lng) + 1];
+	struct stat st;
+	size_t fsize, width, toff, tlen, voff = 0, vlen = 0, vres = 0;
+	const void *nil = ATOMnilptr(tt);
+	const char *nilrep = NULL;
+	char *tail = NULL, *vheap = NULL;
+	int ct, direct = 1;
+	BUN cnt, i;
+	BAT *bn;
+
+	if (fread(hdr, sizeof(lng), COLFHDRWORDS, f) != COLFHDRWORDS) {
+		GDKerror("BATattach: %s: incomplete header\n", heapfile);
+		return NULL;
+	}
+	if (fstat(fileno(f), &st) < 0) {
+		GDKsyserror("BATattach: cannot stat %s\n", heapfile);
+		return NULL;
+	}
+	fsize = (size_t) st.st_size;
+	if (hdr[1] != COLFBOM) {
+		GDKerror("BATattach: %s: wrong byte order\n", heapfile);
+		return NULL;
+	}
+	if (hdr[2] != COLFVERSION) {
+		GDKerror("BATattach: %s: unsupported version " LLFMT "\n", heapfile, hdr[2]);
+		return NULL;
+	}
+	memcpy(tpe, &hdr[3], 2 * sizeof(lng));
+	tpe[2 * sizeof(lng)] = 0;
+	if ((ct = ATOMindex(tpe)) < 0 || ATOMstorage(ct) != ATOMstorage(tt)) {
+		GDKerror("BATattach: %s: type %s does not match %s\n", heapfile, tpe, ATOMname(tt));
+		return NULL;
+	}
+	width = (size_t) hdr[6];
+	toff = (size_t) hdr[10];
+	tlen = (size_t) hdr[11];
+	if (hdr[5] < 0 || hdr[5] > (lng) BUN_MAX ||
+	    hdr[10] < 0 || hdr[11] < 0 ||
+	    toff > fsize || tlen > fsize - toff ||
+	    (ATOMstorage(tt) == TYPE_str ?
+	     width != 4 && width != 8 :
+	     width != (size_t) ATOMsize(tt)) ||
+	    tlen / width < (size_t) hdr[5]) {
+		GDKerror("BATattach: %s: bad tail section\n", heapfile);
+		return NULL;
+	}
+	cnt = (BUN) hdr[5];
+	tlen = cnt * width;
+	if (hdr[7]) {
+		if (ATOMstorage(tt) == TYPE_str) {
+			GDKerror("BATattach: %s: strings cannot specify nil\n", heapfile);
+			return NULL;
+		}
+		if (memcmp(&hdr[8], nil, width) != 0)
+			nilrep = (const char *) &hdr[8];
+	}
+	if (ATOMstorage(tt) == TYPE_str) {
+		voff = (size_t) hdr[12];
+		vlen = (size_t) hdr[13];
+		vres = (size_t) hdr[14];
+		if (hdr[12] < 0 || hdr[13] < 0 || hdr[14] < 0 ||
+		    voff > fsize || vlen > fsize - voff) {
+			GDKerror("BATattach: %s: bad string heap section\n", heapfile);
+			return NULL;
+		}
+		direct = vres == GDK_STRHASHTABLE * sizeof(stridx_t) &&
+			(width == 4 || width == SIZEOF_VAR_T);
+	}
+
+	if ((bn = COLnew(0, tt, direct ? cnt : 0, role)) == NULL)
+		return NULL;
+	if (cnt == 0)
+		return bn;
+
+	if (direct && ATOMstorage(tt) == TYPE_str) {
+		ALGODEBUG fprintf(stderr, "#BATattach: read %s\n", heapfile);
+		bn->twidth = (unsigned short) width;
+		bn->tshift = ATOMelmshift(width);
+		if (HEAPextend(&bn->theap, tlen, FALSE) != GDK_SUCCEED ||
+		    HEAPextend(bn->tvheap, vlen, FALSE) != GDK_SUCCEED ||
+		    COLFread(f, toff, bn->theap.base, tlen) != GDK_SUCCEED ||
+		    COLFread(f, voff, bn->tvheap->base, vlen) != GDK_SUCCEED)
+			goto bailout;
+		for (i = 0; i < vres; i++) {
+			if (bn->tvheap->base[i] != 0) {
+				GDKerror("BATattach: %s: reserved string heap space not empty\n", heapfile);
+				goto bailout;
+			}
+		}
+		if (COLFcheckstr(bn->theap.base, width, cnt, bn->tvheap->base, vres, vlen) != GDK_SUCCEED)
+			goto bailout;
+		bn->tvheap->free = vlen;
+		bn->tvheap->hashash = 0;
+		bn->batCapacity = (BUN) (bn->theap.size >> bn->tshift);
+	} else if (ATOMstorage(tt) == TYPE_str) {
+		ALGODEBUG fprintf(stderr, "#BATattach: copy %s\n", heapfile);
+		if ((tail = GDKmalloc(tlen)) == NULL ||
+		    (vheap = GDKmalloc(vlen)) == NULL ||
+		    COLFread(f, toff, tail, tlen) != GDK_SUCCEED ||
+		    COLFread(f, voff, vheap, vlen) != GDK_SUCCEED ||
+		    COLFcheckstr(tail, width, cnt, vheap, vres, vlen) != GDK_SUCCEED)
+			goto bailout;
+		for (i = 0; i < cnt; i++) {
+			size_t o = width == 4 ? (size_t) ((unsigned int *) tail)[i] :
+				(size_t) ((ulng *) tail)[i];
+			if (BUNappend(bn, vheap + o, FALSE) != GDK_SUCCEED)
+				goto bailout;
+		}
+		GDKfree(tail);
+		GDKfree(vheap);
+		return bn;
+	} else {
+		ALGODEBUG fprintf(stderr, "#BATattach: read %s\n", heapfile);
+		if (COLFread(f, toff, Tloc(bn, 0), tlen) != GDK_SUCCEED)
+			goto bailout;
+		if (nilrep) {
+			char *p = Tloc(bn, 0);
+
+			for (i = 0; i < cnt; i++, p += width)
+				if (memcmp(p, nilrep, width) == 0)
+					memcpy(p, nil, width);
+		}
+	}
+	BATsetcount(bn, cnt);
+	bn->tnonil = cnt == 0;
+	bn->tnil = 0;
+	bn->tdense = 0;
+	if (cnt > 1) {
+		bn->tsorted = 0;
+		bn->trevsorted = 0;
+		bn->tkey = 0;
+	} else {
+		bn->tsorted = 1;
+		bn->trevsorted = 1;
+		bn->tkey = 1;
+	}
+	return bn;
+
+  bailout:
+	GDKfree(tail);
+	GDKfree(vheap);
+	BBPreclaim(bn);
+	return NULL;
+}
+
 BAT *
 BATattach(int tt, const char *heapfile, int role)
 {
@@ -270,6 +523,11 @@ BATattach(int tt, const char *heapfile, int role)
 		GDKsyserror("BATattach: cannot open %s\n", heapfile);
 		return NULL;
 	}
+	if (BATcolumnfile(heapfile)) {
+		bn = BATattachcolumn(tt, heapfile, f, role);
+		fclose(f);
+		return bn;
+	}
 	if (ATOMstorage(tt) == TYPE_str) {
 		size_t n;
 		char *s;
@@ -450,6 +708,7 @@ BATextend(BAT *b, BUN newcap)
 
 	assert(newcap <= BUN_MAX);
 	BATcheck(b, "BATextend", GDK_FAIL);
+	HASHwaitbackground(b);
 	/*
 	 * The main issue is to properly predict the new BAT size.
 	 * storage overflow. The assumption taken is that capacity
@@ -474,6 +733,7 @@ BATextend(BAT *b, BUN newcap)
 	HASHdestroy(b);
 	IMPSdestroy(b);
 	OIDXdestroy(b);
+	CMPRdestroy(b);
 	return GDK_SUCCEED;
 }
 
@@ -495,6 +755,7 @@ BATclear(BAT *b, int force)
 	BUN p, q;
 
 	BATcheck(b, "BATclear", GDK_FAIL);
+	HASHwaitbackground(b);
 
 	if (!force && b->batInserted > 0) {
 		GDKerror("BATclear: cannot clear committed BAT\n");
@@ -505,6 +766,8 @@ BATclear(BAT *b, int force)
 	HASHdestroy(b);
 	IMPSdestroy(b);
 	OIDXdestroy(b);
+	CMPRdestroy(b);
+	ZMAPdestroy(b);
 	PROPdestroy(b->tprops);
 	b->tprops = NULL;
 
@@ -571,6 +834,8 @@ BATfree(BAT *b)
 	HASHfree(b);
 	IMPSfree(b);
 	OIDXfree(b);
+	ZMAPfree(b);
+	CMPRfree(b);
 	if (b->ttype)
 		HEAPfree(&b->theap, 0);
 	else
@@ -1016,6 +1281,7 @@ BUNappend(BAT *b, const void *t, bit force)
 	BATcheck(b, "BUNappend", GDK_FAIL);
 
 	assert(!isVIEW(b));
+	HASHwaitbackground(b);
 	if (b->tunique && BUNfnd(b, t) != BUN_NONE) {
 		return GDK_SUCCEED;
 	}
@@ -1056,6 +1322,8 @@ BUNappend(BAT *b, const void *t, bit force)
 
 	IMPSdestroy(b); /* no support for inserts in imprints yet */
 	OIDXdestroy(b);
+	CMPRdestroy(b);
+	ZMAPappend(b);
 	PROPdestroy(b->tprops);
 	b->tprops = NULL;
 	if (b->thash == (Hash *) 1) {
@@ -1090,6 +1358,7 @@ BUNdelete(BAT *b, oid o)
 		return GDK_FAIL;
 	}
 	b->batDirty = 1;
+	HASHwaitbackground(b);
 	ATOMunfix(b->ttype, BUNtail(bi, p));
 	ATOMdel(b->ttype, b->tvheap, (var_t *) BUNtloc(bi, p));
 	if (p != BUNlast(b) - 1 &&
@@ -1120,6 +1389,8 @@ BUNdelete(BAT *b, oid o)
 	}
 	IMPSdestroy(b);
 	OIDXdestroy(b);
+	CMPRdestroy(b);
+	ZMAPdestroy(b);
 	HASHdestroy(b);
 	PROPdestroy(b->tprops);
 	b->tprops = NULL;
@@ -1151,6 +1422,7 @@ BUNinplace(BAT *b, BUN p, const void *t, bit force)
 	/* uncommitted BUN elements */
 
 	ALIGNinp(b, "BUNinplace", force, GDK_FAIL);	/* zap alignment info */
+	HASHwaitbackground(b);
 	if (b->tnil &&
 	    atom_CMP(BUNtail(bi, p), ATOMnilptr(b->ttype), b->ttype) == 0 &&
 	    atom_CMP(t, ATOMnilptr(b->ttype), b->ttype) != 0) {
@@ -1160,9 +1432,13 @@ BUNinplace(BAT *b, BUN p, const void *t, bit force)
 		b->tnil = 0;
 	}
 	HASHdestroy(b);
+	IMPSdestroy(b);		/* imprints do not support updates yet */
+	OIDXdestroy(b);
 	PROPdestroy(b->tprops);
 	b->tprops = NULL;
 	Treplacevalue(b, BUNtloc(bi, p), t);
+	ZMAPinplace(b, p, t);
+	CMPRdestroy(b);
 
 	tt = b->ttype;
 	prv = p > 0 ? p - 1 : BUN_NONE;
@@ -422,6 +422,7 @@ BATappend(BAT *b, BAT *n, BAT *s, bit force)
 	       (b->tvheap == NULL || b->tvheap->parentid == b->batCacheid || b->ttype == TYPE_str));
 
 	ALIGNapp(b, "BATappend", force, GDK_FAIL);
+	HASHwaitbackground(b);
 	BATcompatible(b, n, GDK_FAIL, "BATappend");
 
 	if (BATcount(b) == 0)
@@ -490,6 +491,7 @@ BATappend(BAT *b, BAT *n, BAT *s, bit force)
 
 	IMPSdestroy(b);		/* imprints do not support updates yet */
 	OIDXdestroy(b);
+	CMPRdestroy(b);
 	PROPdestroy(b->tprops);
 	b->tprops = NULL;
 	if (b->thash == (Hash *) 1 || BATcount(b) == 0) {
@@ -634,6 +636,7 @@ BATappend(BAT *b, BAT *n, BAT *s, bit force)
 			}
 		}
 	}
+	ZMAPappend(b);
 	if (b->tunique)
 		BBPunfix(s->batCacheid);
 	return GDK_SUCCEED;
@@ -655,6 +658,7 @@ BATdel(BAT *b, BAT *d)
 	assert(d->tkey);
 	if (BATcount(d) == 0)
 		return GDK_SUCCEED;
+	HASHwaitbackground(b);
 	if (BATtdense(d)) {
 		oid o = d->tseqbase;
 		BUN c = BATcount(d);
@@ -753,6 +757,8 @@ BATdel(BAT *b, BAT *d)
 	b->tnokey[0] = b->tnokey[1] = 0;
 	PROPdestroy(b->tprops);
 	b->tprops = NULL;
+	ZMAPdestroy(b);
+	CMPRdestroy(b);
 
 	return GDK_SUCCEED;
 }
@@ -821,7 +827,9 @@ BATslice(BAT *b, BUN l, BUN h)
 	/* If the source BAT is readonly, then we can obtain a VIEW
 	 * that just reuses the memory of the source. */
 	if (BAThrestricted(b) == BAT_READ && BATtrestricted(b) == BAT_READ) {
-		bn = VIEWcreate_(b->hseqbase + low, b, TRUE);
+		/* a slice covering all of b can share b's hash */
+		bn = VIEWcreate_(b->hseqbase + low, b,
+				 l > 0 || h < BATcount(b));
 		if (bn == NULL)
 			return NULL;
 		VIEWbounds(b, bn, l, h);
@@ -1212,6 +1220,237 @@ do_sort(void *h, void *t, const void *base, size_t n, int hs, int ts, int tpe,
 	return GDK_SUCCEED;
 }
 
+/* Sorting large BATs in parallel.  The input is cut into chunks that
+ * are sorted concurrently with do_sort, after which the sorted runs
+ * are merged pairwise.  Each pairwise merge is itself split into
+ * independent pieces by finding through binary search how many
+ * values of each run end up before a given output position (the
+ * "merge path"), so that all threads have work in every round.  Equal
+ * values are taken from the left run first, which keeps the sort
+ * stable if the chunks were sorted stably. */
+#define PARSORT_MINSIZE		((size_t) 1 << 20) /* min size for parallel sort */
+#define PARSORT_MINCHUNK	((size_t) 1 << 16) /* min size per thread */
+
+struct sortctx {
+	int (*cmp)(const void *, const void *);
+	const char *base;	/* var heap of var-sized types */
+	int hs;			/* width of values in h */
+	int tpe;		/* base type */
+	int reverse;
+};
+
+static inline int
+sortcmp(const struct sortctx *ctx, const char *x, size_t i, const char *y, size_t j)
+{
+	int c;
+
+	switch (ctx->tpe) {
+	case TYPE_int:
+		c = (((const int *) x)[i] > ((const int *) y)[j]) -
+			(((const int *) x)[i] < ((const int *) y)[j]);
+		break;
+	case TYPE_lng:
+		c = (((const lng *) x)[i] > ((const lng *) y)[j]) -
+			(((const lng *) x)[i] < ((const lng *) y)[j]);
+		break;
+	default:
+		if (ctx->base)
+			c = (*ctx->cmp)(ctx->base + VarHeapVal(x, i, ctx->hs),
+					ctx->base + VarHeapVal(y, j, ctx->hs));
+		else
+			c = (*ctx->cmp)(x + i * ctx->hs, y + j * ctx->hs);
+		break;
+	}
+	return ctx->reverse ? -c : c;
+}
+
+struct sorttask {
+	const struct sortctx *ctx;
+	/* sorting a chunk */
+	char *h;
+	oid *t;
+	size_t n;
+	int stable;
+	gdk_return ret;
+	/* merging two adjacent runs a and b into dst */
+	const char *a, *b;
+	const oid *at, *bt;
+	size_t na, nb;
+	char *dst;
+	oid *dstt;
+	size_t lo, hi;		/* part of the output to produce */
+};
+
+static void
+sortchunk(void *arg)
+{
+	struct sorttask *s = arg;
+
+	s->ret = do_sort(s->h, s->t, s->ctx->base, s->n, s->ctx->hs,
+			 s->t ? sizeof(oid) : 0, s->ctx->tpe,
+			 s->ctx->reverse, s->stable);
+}
+
+/* return how many of the first i values of the merged output come
+ * from run a */
+static size_t
+mergepath(const struct sorttask *m, size_t i)
+{
+	size_t lo = i > m->nb ? i - m->nb : 0;
+	size_t hi = i < m->na ? i : m->na;
+	size_t mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		/* a[mid] is among the first i values if it is not
+		 * larger than b[i-mid-1] */
+		if (sortcmp(m->ctx, m->a, mid, m->b, i - mid - 1) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static void
+mergechunk(void *arg)
+{
+	struct sorttask *m = arg;
+	size_t hs = (size_t) m->ctx->hs;
+	size_t ia = mergepath(m, m->lo), ib = m->lo - ia;
+	size_t ea = mergepath(m, m->hi), eb = m->hi - ea;
+	size_t k;
+
+	for (k = m->lo; k < m->hi; k++) {
+		if (ia < ea &&
+		    (ib == eb || sortcmp(m->ctx, m->a, ia, m->b, ib) <= 0)) {
+			memcpy(m->dst + k * hs, m->a + ia * hs, hs);
+			if (m->dstt)
+				m->dstt[k] = m->at[ia];
+			ia++;
+		} else {
+			memcpy(m->dst + k * hs, m->b + ib * hs, hs);
+			if (m->dstt)
+				m->dstt[k] = m->bt[ib];
+			ib++;
+		}
+	}
+}
+
+static gdk_return
+do_parsort(void *h, void *t, const void *base, size_t n, int hs, int ts,
+	   int tpe, int reverse, int stable)
+{
+	struct sortctx ctx;
+	struct sorttask *tasks;
+	size_t *bounds, piece, len, p;
+	char *src = h, *dst, *tmph, *swph;
+	oid *srct = t, *dstt, *tmpt = NULL, *swpt;
+	int nthreads, nchunks, nruns, ntasks, i;
+
+	nthreads = GDKnr_threads;
+	if (nthreads > 1 && (size_t) nthreads > n / PARSORT_MINCHUNK)
+		nthreads = (int) (n / PARSORT_MINCHUNK);
+	if (nthreads <= 1 || n < PARSORT_MINSIZE)
+		return do_sort(h, t, base, n, hs, ts, tpe, reverse, stable);
+	assert(t == NULL || ts == sizeof(oid));
+
+	nchunks = nthreads;
+	tasks = GDKmalloc((nchunks + nthreads + 1) * sizeof(struct sorttask));
+	bounds = GDKmalloc((nchunks + 1) * sizeof(size_t));
+	tmph = GDKmalloc(n * hs);
+	if (t)
+		tmpt = GDKmalloc(n * sizeof(oid));
+	if (tasks == NULL || bounds == NULL || tmph == NULL ||
+	    (t && tmpt == NULL)) {
+		GDKfree(tasks);
+		GDKfree(bounds);
+		GDKfree(tmph);
+		GDKfree(tmpt);
+		return do_sort(h, t, base, n, hs, ts, tpe, reverse, stable);
+	}
+	ALGODEBUG fprintf(stderr, "#do_parsort: sorting " SZFMT " values "
+			  "in %d chunks\n", n, nchunks);
+	ctx.cmp = ATOMcompare(tpe);
+	ctx.base = base;
+	ctx.hs = hs;
+	ctx.tpe = base ? tpe : ATOMbasetype(tpe);
+	ctx.reverse = reverse;
+
+	for (i = 0; i <= nchunks; i++)
+		bounds[i] = n / nchunks * i;
+	bounds[nchunks] = n;
+	for (i = 0; i < nchunks; i++) {
+		tasks[i].ctx = &ctx;
+		tasks[i].h = src + bounds[i] * hs;
+		tasks[i].t = srct ? srct + bounds[i] : NULL;
+		tasks[i].n = bounds[i + 1] - bounds[i];
+		tasks[i].stable = stable;
+		tasks[i].ret = GDK_SUCCEED;
+	}
+	GDKparallel(nchunks, sortchunk, tasks, sizeof(struct sorttask));
+	for (i = 0; i < nchunks; i++) {
+		if (tasks[i].ret != GDK_SUCCEED) {
+			GDKfree(tasks);
+			GDKfree(bounds);
+			GDKfree(tmph);
+			GDKfree(tmpt);
+			return GDK_FAIL;
+		}
+	}
+
+	/* merge pairs of runs until there is only one left */
+	piece = n / nthreads;
+	dst = tmph;
+	dstt = tmpt;
+	for (nruns = nchunks; nruns > 1; nruns = (nruns + 1) / 2) {
+		ntasks = 0;
+		for (i = 0; i < nruns; i += 2) {
+			/* an odd run at the end is merged with nothing */
+			size_t lo = bounds[i];
+			size_t mid = bounds[i + 1];
+			size_t hi = i + 1 < nruns ? bounds[i + 2] : mid;
+
+			len = hi - lo;
+			for (p = 0; p < len; p += piece) {
+				struct sorttask *m = &tasks[ntasks++];
+
+				m->ctx = &ctx;
+				m->a = src + lo * hs;
+				m->at = srct ? srct + lo : NULL;
+				m->na = mid - lo;
+				m->b = src + mid * hs;
+				m->bt = srct ? srct + mid : NULL;
+				m->nb = hi - mid;
+				m->dst = dst + lo * hs;
+				m->dstt = dstt ? dstt + lo : NULL;
+				m->lo = p;
+				m->hi = len - p > piece ? p + piece : len;
+			}
+			bounds[i / 2] = lo;
+		}
+		bounds[(nruns + 1) / 2] = n;
+		GDKparallel(ntasks, mergechunk, tasks, sizeof(struct sorttask));
+		/* the output of this round is the input of the next */
+		swph = src;
+		src = dst;
+		dst = swph;
+		swpt = srct;
+		srct = dstt;
+		dstt = swpt;
+	}
+	if (src != h) {
+		memcpy(h, src, n * hs);
+		if (t)
+			memcpy(t, srct, n * sizeof(oid));
+	}
+	GDKfree(tmph);
+	GDKfree(tmpt);
+	GDKfree(tasks);
+	GDKfree(bounds);
+	return GDK_SUCCEED;
+}
+
 /* Sort the bat b according to both o and g.  The stable and reverse
  * parameters indicate whether the sort should be stable or descending
  * respectively.  The parameter b is required, o and g are optional
@@ -1515,11 +1754,11 @@ BATsort(BAT **sorted, BAT **order, BAT **groups,
 		}
 		if (!(reverse ? bn->trevsorted : bn->tsorted) &&
 		    (BATmaterialize(bn) != GDK_SUCCEED ||
-		     do_sort(Tloc(bn, 0),
-			     ords,
-			     bn->tvheap ? bn->tvheap->base : NULL,
-			     BATcount(bn), Tsize(bn), ords ? sizeof(oid) : 0,
-			     bn->ttype, reverse, stable) != GDK_SUCCEED))
+		     do_parsort(Tloc(bn, 0),
+				ords,
+				bn->tvheap ? bn->tvheap->base : NULL,
+				BATcount(bn), Tsize(bn), ords ? sizeof(oid) : 0,
+				bn->ttype, reverse, stable) != GDK_SUCCEED))
 			goto error;
 		bn->tsorted = !reverse;
 		bn->trevsorted = reverse;
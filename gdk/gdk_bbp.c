@@ -24,7 +24,12 @@
  *
  * @item persistence
  * The BBP is made persistent by saving it to the dictionary file
- * called @emph{BBP.dir} in the database.
+ * called @emph{BBP.dir} in the database.  Subcommits do not rewrite
+ * that file, but the much smaller @emph{BBP.inc} next to it, which
+ * holds the entries that changed since BBP.dir was written (a line
+ * with only a BAT id records that the BAT is gone).  Entries in
+ * BBP.inc replace those in BBP.dir, and once BBP.inc grows to a
+ * sizeable fraction of BBP.dir, the two are merged into a new BBP.dir.
  *
  * When the number of BATs rises, having all files in one directory
  * becomes a bottleneck.  The BBP therefore implements a scheme that
@@ -98,6 +103,24 @@ bat BBPlimit = 0;		/* current committed VM BBP array */
 static MT_Lock BBPsizeLock MT_LOCK_INITIALIZER("BBPsizeLock");
 #endif
 static volatile ATOMIC_TYPE BBPsize = 0; /* current used size of BBP array */
+static int bbpdir_entries = 0;	/* number of entries in BBP.dir */
+static int bbpinc_entries = 0;	/* number of entries in BBP.inc */
+#define BBPINC_RATIO	4	/* merge once BBP.inc is a quarter of BBP.dir */
+
+/* subcommits do not read the committed directory: it is kept in
+ * memory as a hash of each entry of BBP.dir and a copy of the entries
+ * of BBP.inc */
+struct bbpinc {
+	bat bid;
+	char *entry;		/* NULL if the BAT is gone */
+};
+static ulng *bbpdir_hash = NULL; /* hash of the BBP.dir entry, 0 if none */
+static bat bbpdir_hashsize = 0;
+static struct bbpinc *bbpinc = NULL; /* the entries of BBP.inc, by bid */
+static struct bbpinc *bbpinc_new = NULL; /* BBP.inc being committed */
+static int bbpinc_newentries = 0;
+static int bbpinc_pending = 0;	/* BBPsync must install bbpinc_new */
+static int bbpinc_valid = 0;	/* the above match the files */
 
 struct BBPfarm_t BBPfarms[MAXFARMS];
 
@@ -119,6 +142,7 @@ static gdk_return BBPprepare(bit subcommit);
 static BAT *getBBPdescriptor(bat i, int lock);
 static gdk_return BBPbackup(BAT *b, bit subcommit);
 static gdk_return BBPdir(int cnt, bat *subcommit);
+static int file_exists(int farmid, const char *dir, const char *name, const char *ext);
 
 #ifdef HAVE_HGE
 /* start out by saying we have no hge, but as soon as we've seen one,
@@ -409,6 +433,22 @@ recover_dir(int farmid, int direxists)
 	return GDKmove(farmid, BAKDIR, "BBP", "dir", BATDIR, "BBP", "dir");
 }
 
+/* BBP.inc is only valid with the BBP.dir it was written against: if
+ * there is a saved BBP.inc it must be moved back, and if the saved
+ * BBP.dir has none, the one in BATDIR is newer than BBP.dir */
+static gdk_return
+recover_inc(int farmid, int incexists, int direxists)
+{
+	if (incexists) {
+		if (GDKunlink(farmid, BATDIR, "BBP", "inc") != GDK_SUCCEED)
+			return GDK_FAIL;
+		return GDKmove(farmid, BAKDIR, "BBP", "inc", BATDIR, "BBP", "inc");
+	}
+	if (direxists)
+		return GDKunlink(farmid, BATDIR, "BBP", "inc");
+	return GDK_SUCCEED;
+}
+
 static gdk_return BBPrecover(int farmid);
 static gdk_return BBPrecover_subdir(void);
 static int BBPdiskscan(const char *, size_t);
@@ -978,7 +1018,7 @@ heapinit(BAT *b, const char *buf, int *hashash, const char *HT, int bbpversion,
 	lng nokey1;
 	lng nosorted;
 	lng norevsorted;
-	lng base;
+	ulng base;
 	lng align;
 	lng free;
 	lng size;
@@ -990,14 +1030,14 @@ heapinit(BAT *b, const char *buf, int *hashash, const char *HT, int bbpversion,
 	norevsorted = 0; /* default for first case */
 	if (bbpversion <= GDKLIBRARY_TALIGN ?
 	    sscanf(buf,
-		   " %10s %hu %hu %hu "LLFMT" "LLFMT" "LLFMT" "LLFMT" "LLFMT" "LLFMT" "LLFMT" "LLFMT" %hu"
+		   " %10s %hu %hu %hu "LLFMT" "LLFMT" "LLFMT" "LLFMT" "ULLFMT" "LLFMT" "LLFMT" "LLFMT" %hu"
 		   "%n",
 		   type, &width, &var, &properties, &nokey0,
 		   &nokey1, &nosorted, &norevsorted, &base,
 		   &align, &free, &size, &storage,
 		   &n) < 13 :
 		sscanf(buf,
-		   " %10s %hu %hu %hu "LLFMT" "LLFMT" "LLFMT" "LLFMT" "LLFMT" "LLFMT" "LLFMT" %hu"
+		   " %10s %hu %hu %hu "LLFMT" "LLFMT" "LLFMT" "LLFMT" "ULLFMT" "LLFMT" "LLFMT" %hu"
 		   "%n",
 		   type, &width, &var, &properties, &nokey0,
 		   &nokey1, &nosorted, &norevsorted, &base,
@@ -1042,7 +1082,9 @@ heapinit(BAT *b, const char *buf, int *hashash, const char *HT, int bbpversion,
 	b->tnil = (properties & 0x0800) != 0;
 	b->tnosorted = (BUN) nosorted;
 	b->tnorevsorted = (BUN) norevsorted;
-	b->tseqbase = base < 0 ? oid_nil : (oid) base;
+	/* oid_nil does not fit in a lng, so base is read unsigned (and
+	 * any negative value becomes nil as well) */
+	b->tseqbase = base >= (ulng) oid_nil ? oid_nil : (oid) base;
 	b->theap.free = (size_t) free;
 	b->theap.size = (size_t) size;
 	b->theap.base = NULL;
@@ -1092,11 +1134,95 @@ vheapinit(BAT *b, const char *buf, int hashash, bat bid)
 }
 
 static void
-BBPreadEntries(FILE *fp, int bbpversion)
+BBPclearentry(bat bid)
+{
+	GDKfree(BBP_desc(bid)->tvheap);
+	GDKfree(BBP_desc(bid));
+	GDKfree(BBP_logical(bid));
+	GDKfree(BBP_physical(bid));
+	GDKfree(BBP_options(bid));
+	BBP_desc(bid) = NULL;
+	BBP_logical(bid) = NULL;
+	BBP_physical(bid) = NULL;
+	BBP_options(bid) = NULL;
+	BBP_status(bid) = 0;
+	BBP_lrefs(bid) = 0;
+}
+
+static ulng
+BBPdir_hash(const char *s)
+{
+	ulng h = (ulng) LL_CONSTANT(0xcbf29ce484222325);
+
+	/* FNV-1a */
+	while (*s)
+		h = (h ^ (unsigned char) *s++) * (ulng) LL_CONSTANT(0x100000001b3);
+	return h ? h : 1;
+}
+
+static inline ulng
+BBPdir_gethash(bat i)
+{
+	return i < bbpdir_hashsize ? bbpdir_hash[i] : 0;
+}
+
+static gdk_return
+BBPdir_sethash(bat i, ulng h)
+{
+	if (i >= bbpdir_hashsize) {
+		bat n = (i | (BBPINIT - 1)) + 1;
+		ulng *p = GDKrealloc(bbpdir_hash, n * sizeof(ulng));
+
+		if (p == NULL)
+			return GDK_FAIL;
+		memset(p + bbpdir_hashsize, 0, (n - bbpdir_hashsize) * sizeof(ulng));
+		bbpdir_hash = p;
+		bbpdir_hashsize = n;
+	}
+	bbpdir_hash[i] = h;
+	return GDK_SUCCEED;
+}
+
+static void
+BBPinc_free(struct bbpinc *inc, int n)
+{
+	while (n > 0)
+		GDKfree(inc[--n].entry);
+	GDKfree(inc);
+}
+
+/* called by BBPsync: the directory written by BBPdir is committed
+ * (ok) or not; in the latter case the next subcommit rebuilds the
+ * in-memory copy from the files */
+static void
+BBPinc_install(int ok)
+{
+	if (bbpinc_pending && ok) {
+		BBPinc_free(bbpinc, bbpinc_entries);
+		bbpinc = bbpinc_new;
+		bbpinc_entries = bbpinc_newentries;
+		bbpinc_valid = 1;
+	} else {
+		if (bbpinc_pending)
+			BBPinc_free(bbpinc_new, bbpinc_newentries);
+		if (!ok)
+			bbpinc_valid = 0;
+	}
+	bbpinc_new = NULL;
+	bbpinc_newentries = 0;
+	bbpinc_pending = 0;
+}
+
+/* read the entries of BBP.dir, or of BBP.inc if inc is set, in which
+ * case they replace the ones that were read from BBP.dir; return the
+ * number of entries */
+static int
+BBPreadEntries(FILE *fp, int bbpversion, int inc)
 {
 	bat bid = 0;
 	char buf[4096];
 	BAT *bn;
+	int entries = 0;
 
 	/* read the BBP.dir and insert the BATs into the BBP */
 	while (fgets(buf, sizeof(buf), fp) != NULL) {
@@ -1124,6 +1250,27 @@ BBPreadEntries(FILE *fp, int bbpversion)
 			*s++ = '\n';
 			*s = 0;
 		}
+		entries++;
+
+		if (inc) {
+			batid = strtol(buf, &s, 10);
+			if (batid <= 0 || (*s != ' ' && *s != '\n') ||
+			    (entries > 1 && (bat) batid <= bbpinc[entries - 2].bid))
+				GDKfatal("BBPinit: invalid format for BBP.inc\n%s", buf);
+			bid = (bat) batid;
+			if ((entries & (entries - 1)) == 0 &&
+			    (bbpinc = GDKrealloc(bbpinc, 2 * entries * sizeof(*bbpinc))) == NULL)
+				GDKfatal("BBPinit: cannot allocate memory for BBP.inc.");
+			bbpinc[entries - 1].bid = bid;
+			bbpinc[entries - 1].entry = NULL;
+			if (bid < (bat) ATOMIC_GET(BBPsize, BBPsizeLock) &&
+			    BBP_desc(bid) != NULL)
+				BBPclearentry(bid);
+			if (*s == '\n')
+				continue; /* the BAT is gone */
+			if ((bbpinc[entries - 1].entry = GDKstrdup(buf)) == NULL)
+				GDKfatal("BBPinit: cannot allocate memory for BBP.inc.");
+		}
 
 		if (bbpversion <= GDKLIBRARY_INSERTED ?
 		    sscanf(buf,
@@ -1168,6 +1315,8 @@ BBPreadEntries(FILE *fp, int bbpversion)
 			GDKfatal("BBPinit: first != 0 (ID = "LLFMT").", batid);
 
 		bid = (bat) batid;
+		if (!inc && BBPdir_sethash(bid, BBPdir_hash(buf)) != GDK_SUCCEED)
+			GDKfatal("BBPinit: cannot allocate memory for BBP.dir.");
 		if (batid >= (lng) ATOMIC_GET(BBPsize, BBPsizeLock)) {
 			ATOMIC_SET(BBPsize, (ATOMIC_TYPE) (batid + 1), BBPsizeLock);
 			if ((bat) ATOMIC_GET(BBPsize, BBPsizeLock) >= BBPlimit)
@@ -1232,6 +1381,7 @@ BBPreadEntries(FILE *fp, int bbpversion)
 		BBP_refs(bid) = 0;
 		BBP_lrefs(bid) = 1;	/* any BAT we encounter here is persistent, so has a logical reference */
 	}
+	return entries;
 }
 
 #ifdef HAVE_HGE
@@ -1257,6 +1407,7 @@ BBPheader(FILE *fp)
 		exit(1);
 	}
 	if (bbpversion != GDKLIBRARY &&
+	    bbpversion != GDKLIBRARY_NOINC &&
 	    bbpversion != GDKLIBRARY_BADEMPTY &&
 	    bbpversion != GDKLIBRARY_NOKEY &&
 	    bbpversion != GDKLIBRARY_SORTEDPOS &&
@@ -1373,11 +1524,12 @@ BBPresetfarms(void)
 void
 BBPinit(void)
 {
-	FILE *fp = NULL;
+	FILE *fp = NULL, *incfp;
 	struct stat st;
-	int bbpversion;
+	int bbpversion, incversion = 0;
 	str bbpdirstr = GDKfilepath(0, BATDIR, "BBP", "dir");
 	str backupbbpdirstr = GDKfilepath(0, BAKDIR, "BBP", "dir");
+	str backupbbpincstr = GDKfilepath(0, BAKDIR, "BBP", "inc");
 	int i;
 
 #ifdef NEED_MT_LOCK_INIT
@@ -1397,6 +1549,10 @@ BBPinit(void)
 	if (BBPrecover_subdir() != GDK_SUCCEED)
 		GDKfatal("BBPinit: cannot properly recover_subdir process %s. Please check whether your disk is full or write-protected", SUBDIR);
 
+	/* a saved BBP.inc also *must* be used */
+	if (recover_inc(0, stat(backupbbpincstr, &st) == 0, stat(backupbbpdirstr, &st) == 0) != GDK_SUCCEED)
+		goto bailout;
+
 	/* try to obtain a BBP.dir from bakdir */
 	if (stat(backupbbpdirstr, &st) == 0) {
 		/* backup exists; *must* use it */
@@ -1428,12 +1584,22 @@ BBPinit(void)
 	BBPdirty(1);
 
 	bbpversion = BBPheader(fp);
+	if ((incfp = GDKfileopen(0, BATDIR, "BBP", "inc", "r")) != NULL)
+		incversion = BBPheader(incfp);
 
 	BBPextend(0, FALSE);		/* allocate BBP records */
 	ATOMIC_SET(BBPsize, 1, BBPsizeLock);
 
-	BBPreadEntries(fp, bbpversion);
+	/* BBPdir may have been called above */
+	BBPinc_install(0);
+	bbpdir_entries = BBPreadEntries(fp, bbpversion, 0);
 	fclose(fp);
+	bbpinc_entries = 0;
+	if (incfp) {
+		bbpinc_entries = BBPreadEntries(incfp, incversion, 1);
+		fclose(incfp);
+	}
+	bbpinc_valid = 1;
 
 	if (BBPinithash(0) != GDK_SUCCEED)
 		GDKfatal("BBPinit: BBPinithash failed");
@@ -1477,6 +1643,7 @@ BBPinit(void)
 		TMcommit();
 	GDKfree(bbpdirstr);
 	GDKfree(backupbbpdirstr);
+	GDKfree(backupbbpincstr);
 	return;
 
       bailout:
@@ -1493,6 +1660,7 @@ BBPinit(void)
  */
 
 static int backup_files = 0, backup_dir = 0, backup_subdir = 0;
+static int backup_inc = 0;	/* only BBP.inc was moved, BBP.dir was not */
 
 void
 BBPexit(void)
@@ -1558,7 +1726,14 @@ BBPexit(void)
 	backup_files = 0;
 	backup_dir = 0;
 	backup_subdir = 0;
-
+	backup_inc = 0;
+	BBPinc_install(0);
+	BBPinc_free(bbpinc, bbpinc_entries);
+	bbpinc = NULL;
+	bbpinc_entries = 0;
+	GDKfree(bbpdir_hash);
+	bbpdir_hash = NULL;
+	bbpdir_hashsize = 0;
 }
 
 /*
@@ -1570,41 +1745,48 @@ BBPexit(void)
  * reclaimed as well.
  */
 static inline int
-heap_entry(FILE *fp, BAT *b)
-{
-	return fprintf(fp, " %s %d %d %d " BUNFMT " " BUNFMT " " BUNFMT " "
-		       BUNFMT " " OIDFMT " " SZFMT " " SZFMT " %d",
-		       b->ttype >= 0 ? BATatoms[b->ttype].name : ATOMunknown_name(b->ttype),
-		       b->twidth,
-		       b->tvarsized | (b->tvheap ? b->tvheap->hashash << 1 : 0),
-		       (unsigned short) b->tsorted |
-			   ((unsigned short) b->trevsorted << 7) |
-			   (((unsigned short) b->tkey & 0x01) << 8) |
-			   ((unsigned short) b->tdense << 9) |
-			   ((unsigned short) b->tnonil << 10) |
-			   ((unsigned short) b->tnil << 11),
-		       b->tnokey[0],
-		       b->tnokey[1],
-		       b->tnosorted,
-		       b->tnorevsorted,
-		       b->tseqbase,
-		       b->theap.free,
-		       b->theap.size,
-		       (int) b->theap.newstorage);
+heap_entry(char *buf, size_t len, BAT *b)
+{
+	return snprintf(buf, len, " %s %d %d %d " BUNFMT " " BUNFMT " " BUNFMT " "
+			BUNFMT " " OIDFMT " " SZFMT " " SZFMT " %d",
+			b->ttype >= 0 ? BATatoms[b->ttype].name : ATOMunknown_name(b->ttype),
+			b->twidth,
+			b->tvarsized | (b->tvheap ? b->tvheap->hashash << 1 : 0),
+			(unsigned short) b->tsorted |
+			    ((unsigned short) b->trevsorted << 7) |
+			    (((unsigned short) b->tkey & 0x01) << 8) |
+			    ((unsigned short) b->tdense << 9) |
+			    ((unsigned short) b->tnonil << 10) |
+			    ((unsigned short) b->tnil << 11),
+			b->tnokey[0],
+			b->tnokey[1],
+			b->tnosorted,
+			b->tnorevsorted,
+			b->tseqbase,
+			b->theap.free,
+			b->theap.size,
+			(int) b->theap.newstorage);
 }
 
 static inline int
-vheap_entry(FILE *fp, Heap *h)
+vheap_entry(char *buf, size_t len, Heap *h)
 {
-	if (h == NULL)
+	if (h == NULL) {
+		*buf = 0;
 		return 0;
-	return fprintf(fp, " " SZFMT " " SZFMT " %d",
-		       h->free, h->size, (int) h->newstorage);
+	}
+	return snprintf(buf, len, " " SZFMT " " SZFMT " %d",
+			h->free, h->size, (int) h->newstorage);
 }
 
-static gdk_return
-new_bbpentry(FILE *fp, bat i, const char *prefix)
+/* format the BBP.dir entry of bat i into buf; the return value is
+ * the length of the complete entry, which may be larger than what
+ * fitted, or -1 on error */
+static int
+bbpentry(char *buf, size_t len, bat i)
 {
+	char hbuf[512], vbuf[128];
+
 #ifndef NDEBUG
 	assert(i > 0);
 	assert(i < (bat) ATOMIC_GET(BBPsize, BBPsizeLock));
@@ -1619,27 +1801,67 @@ new_bbpentry(FILE *fp, bat i, const char *prefix)
 	}
 #endif
 
-	if (fprintf(fp, "%s" SSZFMT " %d %s %s %d " BUNFMT " "
-		    BUNFMT " " OIDFMT, prefix,
-		    /* BAT info */
-		    (ssize_t) i,
-		    BBP_status(i) & BBPPERSISTENT,
-		    BBP_logical(i),
-		    BBP_physical(i),
-		    BBP_desc(i)->batRestricted << 1,
-		    BBP_desc(i)->batCount,
-		    BBP_desc(i)->batCapacity,
-		    BBP_desc(i)->hseqbase) < 0 ||
-	    heap_entry(fp, BBP_desc(i)) < 0 ||
-	    vheap_entry(fp, BBP_desc(i)->tvheap) < 0 ||
-	    (BBP_options(i) &&
-	     fprintf(fp, " %s", BBP_options(i)) < 0) ||
-	    fprintf(fp, "\n") < 0) {
-		GDKsyserror("new_bbpentry: Writing BBP.dir entry failed\n");
-		return GDK_FAIL;
+	if (heap_entry(hbuf, sizeof(hbuf), BBP_desc(i)) < 0 ||
+	    vheap_entry(vbuf, sizeof(vbuf), BBP_desc(i)->tvheap) < 0)
+		return -1;
+	return snprintf(buf, len, SSZFMT " %d %s %s %d " BUNFMT " "
+			BUNFMT " " OIDFMT "%s%s%s%s\n",
+			/* BAT info */
+			(ssize_t) i,
+			BBP_status(i) & BBPPERSISTENT,
+			BBP_logical(i),
+			BBP_physical(i),
+			BBP_desc(i)->batRestricted << 1,
+			BBP_desc(i)->batCount,
+			BBP_desc(i)->batCapacity,
+			BBP_desc(i)->hseqbase,
+			/* column info */
+			hbuf,
+			vbuf,
+			BBP_options(i) ? " " : "",
+			BBP_options(i) ? BBP_options(i) : "");
+}
+
+/* format the entry of bat i into buf, or into allocated memory if it
+ * does not fit */
+static char *
+format_bbpentry(char *buf, size_t size, bat i)
+{
+	char *s = buf;
+	int len;
+
+	if ((len = bbpentry(buf, size, i)) >= (int) size) {
+		if ((s = GDKmalloc((size_t) len + 1)) == NULL)
+			return NULL;
+		len = bbpentry(s, (size_t) len + 1, i);
+	}
+	if (len < 0) {
+		GDKsyserror("format_bbpentry: Formatting BBP.dir entry failed\n");
+		if (s != buf)
+			GDKfree(s);
+		return NULL;
 	}
+	return s;
+}
 
-	return GDK_SUCCEED;
+/* write the entry of bat i, and remember its hash if hash is set */
+static gdk_return
+new_bbpentry(FILE *fp, bat i, const char *prefix, int hash)
+{
+	char buf[3000], *s;
+	gdk_return ret = GDK_SUCCEED;
+
+	if ((s = format_bbpentry(buf, sizeof(buf), i)) == NULL)
+		return GDK_FAIL;
+	if (fprintf(fp, "%s%s", prefix, s) < 0) {
+		GDKsyserror("new_bbpentry: Writing BBP.dir entry failed\n");
+		ret = GDK_FAIL;
+	} else if (hash) {
+		ret = BBPdir_sethash(i, BBPdir_hash(s));
+	}
+	if (s != buf)
+		GDKfree(s);
+	return ret;
 }
 
 static gdk_return
@@ -1659,116 +1881,332 @@ BBPdir_header(FILE *f, int n)
 }
 
 static gdk_return
-BBPdir_subcommit(int cnt, bat *subcommit)
+BBPdir_close(FILE *fp, const char *func)
+{
+	if (fflush(fp) == EOF ||
+	    (!(GDKdebug & FORCEMITOMASK) &&
+#ifdef NATIVE_WIN32
+	     _commit(_fileno(fp)) < 0
+#else
+#ifdef HAVE_FDATASYNC
+	     fdatasync(fileno(fp)) < 0
+#else
+#ifdef HAVE_FSYNC
+	     fsync(fileno(fp)) < 0
+#endif
+#endif
+#endif
+		    )) {
+		GDKsyserror("%s: Syncing BBP.dir file failed\n", func);
+		fclose(fp);
+		return GDK_FAIL;
+	}
+	if (fclose(fp) == EOF) {
+		GDKsyserror("%s: Closing BBP.dir file failed\n", func);
+		return GDK_FAIL;
+	}
+	return GDK_SUCCEED;
+}
+
+/* write a BBP.inc without entries, to go with a freshly written
+ * BBP.dir */
+static gdk_return
+BBPdir_emptyinc(int n)
+{
+	FILE *fp;
+
+	if ((fp = GDKfilelocate(0, "BBP", "w", "inc")) == NULL)
+		return GDK_FAIL;
+	if (BBPdir_header(fp, n) != GDK_SUCCEED) {
+		fclose(fp);
+		return GDK_FAIL;
+	}
+	if (BBPdir_close(fp, "BBPdir") != GDK_SUCCEED)
+		return GDK_FAIL;
+	bbpinc_pending = 1;
+	return GDK_SUCCEED;
+}
+
+/* skip the header of an existing BBP.dir or BBP.inc, keeping the
+ * largest BBPsize seen in *n */
+static FILE *
+BBPdir_skipheader(FILE *fp, const char *ext, int *n)
 {
-	FILE *obbpf, *nbbpf;
-	bat j = 1;
 	char buf[3000];
+	int sz;
+
+	/* read first three lines */
+	if (fgets(buf, sizeof(buf), fp) == NULL || /* BBP.dir, GDKversion %d */
+	    fgets(buf, sizeof(buf), fp) == NULL || /* SIZEOF_SIZE_T SIZEOF_OID SIZEOF_MAX_INT */
+	    fgets(buf, sizeof(buf), fp) == NULL) /* BBPsize=%d */
+		GDKfatal("BBPdir: subcommit attempted with invalid BBP.%s.", ext);
+	/* third line contains BBPsize */
+	if (sscanf(buf, "BBPsize=%d", &sz) == 1 && sz > *n)
+		*n = sz;
+	return fp;
+}
+
+/* open the saved copy of BBP.dir or BBP.inc and skip its header */
+static FILE *
+BBPdir_openbackup(const char *ext, int *n)
+{
+	FILE *fp;
+
+	if ((fp = GDKfileopen(0, SUBDIR, "BBP", ext, "r")) == NULL &&
+	    (fp = GDKfileopen(0, BAKDIR, "BBP", ext, "r")) == NULL)
+		return NULL;
+	return BBPdir_skipheader(fp, ext, n);
+}
+
+/* read the next entry from a saved BBP.dir or BBP.inc, return its BAT
+ * id, or 0 at the end (and then close the file) */
+static bat
+BBPdir_nextentry(FILE **fp, char *buf, int len)
+{
 	int n;
 
+	if (*fp == NULL)
+		return 0;
+	if (fgets(buf, len, *fp) == NULL) {
+		fclose(*fp);
+		*fp = NULL;
+		return 0;
+	}
+	if (sscanf(buf, "%d", &n) != 1 || n <= 0)
+		GDKfatal("BBPdir: subcommit attempted with invalid backup BBP.dir.");
+	return (bat) n;
+}
+
+/* is this an entry of BBP.inc that records that the BAT is gone? */
+static int
+BBPdir_gone(const char *buf)
+{
+	char *s;
+
+	(void) strtol(buf, &s, 10);
+	return *s == '\n';
+}
+
+/*
+ * A subcommit keeps the committed entries of all bats that are not
+ * subcommitted.  Usually only BBP.inc was saved (see BBPprepare), and
+ * then only BBP.inc is rewritten, from its copy in memory: it receives
+ * the entries of the subcommitted bats that differ from those in
+ * BBP.dir, which is not read, since the hash of each of its entries is
+ * kept.  BBP.inc is as large as the set of bats changed since BBP.dir
+ * was last written, not as large as the subcommit list (the logger
+ * subcommits its whole catalog).
+ */
+static gdk_return
+BBPdir_subcommit_inc(int cnt, bat *subcommit)
+{
+	FILE *fp;
+	struct bbpinc *inc;
+	bat i;
+	char buf[3000], *s;
+	int j = 1, k = 0, n = 0;
+
+	assert(bbpinc_valid);
+	/* the new BBP.inc has at most the entries of the committed
+	 * one and those of the subcommitted bats */
+	if ((inc = GDKmalloc((bbpinc_entries + cnt) * sizeof(*inc))) == NULL)
+		return GDK_FAIL;
+	while (k < bbpinc_entries || j < cnt) {
+		if (j == cnt || (k < bbpinc_entries && bbpinc[k].bid < subcommit[j])) {
+			/* not subcommitted: keep the committed entry */
+			inc[n].bid = bbpinc[k].bid;
+			inc[n].entry = NULL;
+			if (bbpinc[k].entry &&
+			    (inc[n].entry = GDKstrdup(bbpinc[k].entry)) == NULL)
+				goto bailout;
+			n++;
+			k++;
+			continue;
+		}
+		i = subcommit[j];
+		if (k < bbpinc_entries && bbpinc[k].bid == i)
+			k++;	/* replaced */
+		do
+			/* go to next, skipping duplicates */
+			j++;
+		while (j < cnt && subcommit[j] == i);
+		if (BBP_status(i) & BBPPERSISTENT) {
+			if ((s = format_bbpentry(buf, sizeof(buf), i)) == NULL)
+				goto bailout;
+			if (BBPdir_hash(s) == BBPdir_gethash(i)) {
+				/* unchanged, BBP.dir has it */
+				if (s != buf)
+					GDKfree(s);
+				continue;
+			}
+			if (s == buf && (s = GDKstrdup(buf)) == NULL)
+				goto bailout;
+			inc[n].entry = s;
+		} else if (BBPdir_gethash(i) != 0) {
+			/* BBP.dir has it, so record that it is gone */
+			inc[n].entry = NULL;
+		} else {
+			continue;
+		}
+		inc[n++].bid = i;
+	}
+
+	if ((fp = GDKfilelocate(0, "BBP", "w", "inc")) == NULL)
+		goto bailout;
+	if (GDKdebug & (IOMASK | THRDMASK))
+		fprintf(stderr, "#BBPdir: writing BBP.inc (%d entries).\n", n);
+	if (BBPdir_header(fp, (bat) ATOMIC_GET(BBPsize, BBPsizeLock)) != GDK_SUCCEED) {
+		fclose(fp);
+		goto bailout;
+	}
+	for (k = 0; k < n; k++) {
+		if ((inc[k].entry ?
+		     fputs(inc[k].entry, fp) :
+		     fprintf(fp, "%d\n", (int) inc[k].bid)) < 0) {
+			GDKsyserror("BBPdir_subcommit: Writing BBP.inc entry failed\n");
+			fclose(fp);
+			goto bailout;
+		}
+		IODEBUG {
+			if (inc[k].entry)
+				fprintf(stderr, "#%s", inc[k].entry);
+			else
+				fprintf(stderr, "#%d\n", (int) inc[k].bid);
+		}
+	}
+	if (BBPdir_close(fp, "BBPdir_subcommit") != GDK_SUCCEED)
+		goto bailout;
+
+	bbpinc_new = inc;
+	bbpinc_newentries = n;
+	bbpinc_pending = 1;
+
+	IODEBUG fprintf(stderr, "#BBPdir end\n");
+
+	return GDK_SUCCEED;
+
+  bailout:
+	BBPinc_free(inc, n);
+	return GDK_FAIL;
+}
+
+/*
+ * Otherwise BBP.dir, the saved BBP.inc, and the subcommitted bats are
+ * merged into a new BBP.dir, and BBP.inc starts out empty again.
+ * Since BBP.inc is then a sizeable fraction of BBP.dir (or the copy in
+ * memory was lost after a failed commit), this is done from the saved
+ * files.
+ */
+static gdk_return
+BBPdir_subcommit(int cnt, bat *subcommit)
+{
+	FILE *dirf, *incf, *nbbpf;
+	bat j = 1, i;
+	char buf[3000], ibuf[3000], ebuf[3000], *old, *s;
+	int n, size, entries = 0;
+	bat m = 0;
+
 #ifndef NDEBUG
 	assert(subcommit != NULL);
 	for (n = 2; n < cnt; n++)
 		assert(subcommit[n - 1] < subcommit[n]);
 #endif
 
-	if ((nbbpf = GDKfilelocate(0, "BBP", "w", "dir")) == NULL)
-		return GDK_FAIL;
+	if (backup_inc)
+		return BBPdir_subcommit_inc(cnt, subcommit);
 
-	n = (bat) ATOMIC_GET(BBPsize, BBPsizeLock);
+	size = (bat) ATOMIC_GET(BBPsize, BBPsizeLock);
 
-	/* we need to copy the backup BBP.dir to the new, but
-	 * replacing the entries for the subcommitted bats */
-	if ((obbpf = GDKfileopen(0, SUBDIR, "BBP", "dir", "r")) == NULL) {
-		if ((obbpf = GDKfileopen(0, BAKDIR, "BBP", "dir", "r")) == NULL)
-			GDKfatal("BBPdir: subcommit attempted without backup BBP.dir.");
-	}
-	/* read first three lines */
-	if (fgets(buf, sizeof(buf), obbpf) == NULL || /* BBP.dir, GDKversion %d */
-	    fgets(buf, sizeof(buf), obbpf) == NULL || /* SIZEOF_SIZE_T SIZEOF_OID SIZEOF_MAX_INT */
-	    fgets(buf, sizeof(buf), obbpf) == NULL) /* BBPsize=%d */
-		GDKfatal("BBPdir: subcommit attempted with invalid backup BBP.dir.");
-	/* third line contains BBPsize */
-	sscanf(buf, "BBPsize=%d", &n);
-	if (n < (bat) ATOMIC_GET(BBPsize, BBPsizeLock))
-		n = (bat) ATOMIC_GET(BBPsize, BBPsizeLock);
+	/* we need to copy the committed BBP.dir and BBP.inc to the
+	 * new, but replacing the entries for the subcommitted bats;
+	 * the entries of BBP.inc take precedence over those of
+	 * BBP.dir */
+	if ((dirf = BBPdir_openbackup("dir", &size)) == NULL)
+		GDKfatal("BBPdir: subcommit attempted without backup BBP.dir.");
+	incf = BBPdir_openbackup("inc", &size);
+
+	if ((nbbpf = GDKfilelocate(0, "BBP", "w", "dir")) == NULL)
+		goto bailout;
 
 	if (GDKdebug & (IOMASK | THRDMASK))
-		fprintf(stderr, "#BBPdir: writing BBP.dir (%d bats).\n", n);
+		fprintf(stderr, "#BBPdir: writing BBP.dir (%d bats).\n", size);
 
-	if (BBPdir_header(nbbpf, n) != GDK_SUCCEED) {
+	if (BBPdir_header(nbbpf, size) != GDK_SUCCEED) {
 		goto bailout;
 	}
+	if (bbpdir_hashsize > 0)
+		memset(bbpdir_hash, 0, bbpdir_hashsize * sizeof(ulng));
 	n = 0;
 	for (;;) {
 		/* but for subcommits, all except the bats in the list
 		 * retain their existing mode */
-		if (n == 0 && obbpf != NULL) {
-			if (fgets(buf, sizeof(buf), obbpf) == NULL) {
-				fclose(obbpf);
-				obbpf = NULL;
-			} else if (sscanf(buf, "%d", &n) != 1 || n <= 0)
-				GDKfatal("BBPdir: subcommit attempted with invalid backup BBP.dir.");
-			/* at this point, obbpf == NULL, or n > 0 */
-		}
-		if (j == cnt && n == 0) {
-			assert(obbpf == NULL);
+		if (n == 0)
+			n = BBPdir_nextentry(&dirf, buf, (int) sizeof(buf));
+		if (m == 0)
+			m = BBPdir_nextentry(&incf, ibuf, (int) sizeof(ibuf));
+		i = n;
+		if (m != 0 && (i == 0 || m < i))
+			i = m;
+		if (j < cnt && (i == 0 || subcommit[j] < i))
+			i = subcommit[j];
+		if (i == 0) {
+			assert(dirf == NULL && incf == NULL && j == cnt);
 			break;
 		}
-		if (j < cnt && (n == 0 || subcommit[j] <= n || obbpf == NULL)) {
-			bat i = subcommit[j];
+		/* the committed entry, if any */
+		old = m == i ? ibuf : n == i ? buf : NULL;
+		s = NULL;
+		if (j < cnt && subcommit[j] == i) {
 			/* BBP.dir consists of all persistent bats only */
-			if (BBP_status(i) & BBPPERSISTENT) {
-				if (new_bbpentry(nbbpf, i, "") != GDK_SUCCEED) {
-					goto bailout;
-				}
-				IODEBUG new_bbpentry(stderr, i, "#");
-			}
-			if (i == n)
-				n = 0;	/* read new entry (i.e. skip this one from old BBP.dir */
+			if ((BBP_status(i) & BBPPERSISTENT) &&
+			    (s = format_bbpentry(ebuf, sizeof(ebuf), i)) == NULL)
+				goto bailout;
 			do
 				/* go to next, skipping duplicates */
 				j++;
 			while (j < cnt && subcommit[j] == i);
-		} else {
-			if (fprintf(nbbpf, "%s", buf) < 0) {
-				GDKsyserror("BBPdir_subcommit: Copying BBP.dir entry failed\n");
-				goto bailout;
+		} else if (old != NULL && !BBPdir_gone(old)) {
+			s = old;
+		}
+		if (s != NULL) {
+			gdk_return ret = GDK_SUCCEED;
+
+			if (fputs(s, nbbpf) == EOF) {
+				GDKsyserror("BBPdir_subcommit: Writing BBP.dir entry failed\n");
+				ret = GDK_FAIL;
+			} else {
+				ret = BBPdir_sethash(i, BBPdir_hash(s));
+				IODEBUG fprintf(stderr, "#%s", s);
+				entries++;
 			}
-			IODEBUG fprintf(stderr, "#%s", buf);
-			n = 0;
+			if (s != ebuf && s != old)
+				GDKfree(s);
+			if (ret != GDK_SUCCEED)
+				goto bailout;
 		}
+		/* skip entries that were replaced */
+		if (n == i)
+			n = 0;
+		if (m == i)
+			m = 0;
 	}
 
-	if (fflush(nbbpf) == EOF ||
-	    (!(GDKdebug & FORCEMITOMASK) &&
-#ifdef NATIVE_WIN32
-	     _commit(_fileno(nbbpf)) < 0
-#else
-#ifdef HAVE_FDATASYNC
-	     fdatasync(fileno(nbbpf)) < 0
-#else
-#ifdef HAVE_FSYNC
-	     fsync(fileno(nbbpf)) < 0
-#endif
-#endif
-#endif
-		    )) {
-		GDKsyserror("BBPdir_subcommit: Syncing BBP.dir file failed\n");
-		goto bailout;
-	}
-	if (fclose(nbbpf) == EOF) {
-		GDKsyserror("BBPdir_subcommit: Closing BBP.dir file failed\n");
-		goto bailout;
-	}
+	if (BBPdir_close(nbbpf, "BBPdir_subcommit") != GDK_SUCCEED)
+		return GDK_FAIL;
+
+	bbpdir_entries = entries;
+	if (BBPdir_emptyinc(size) != GDK_SUCCEED)
+		return GDK_FAIL;
 
 	IODEBUG fprintf(stderr, "#BBPdir end\n");
 
 	return GDK_SUCCEED;
 
       bailout:
-	if (obbpf != NULL)
-		fclose(obbpf);
+	if (dirf != NULL)
+		fclose(dirf);
+	if (incf != NULL)
+		fclose(incf);
 	if (nbbpf != NULL)
 		fclose(nbbpf);
 	return GDK_FAIL;
@@ -1777,12 +2215,21 @@ BBPdir_subcommit(int cnt, bat *subcommit)
 gdk_return
 BBPdir(int cnt, bat *subcommit)
 {
-	FILE *fp;
+	FILE *fp = NULL;
 	bat i;
+	int entries = 0;
 
 	if (subcommit)
 		return BBPdir_subcommit(cnt, subcommit);
 
+	if (backup_inc) {
+		/* only BBP.inc was saved, but BBP.dir is going to be
+		 * replaced as well */
+		if (GDKmove(0, BATDIR, "BBP", "dir", backup_dir == 2 ? SUBDIR : BAKDIR, "BBP", "dir") != GDK_SUCCEED)
+			goto bailout;
+		backup_inc = 0;
+	}
+
 	if (GDKdebug & (IOMASK | THRDMASK))
 		fprintf(stderr, "#BBPdir: writing BBP.dir (%d bats).\n", (int) (bat) ATOMIC_GET(BBPsize, BBPsizeLock));
 	if ((fp = GDKfilelocate(0, "BBP", "w", "dir")) == NULL) {
@@ -1793,14 +2240,17 @@ BBPdir(int cnt, bat *subcommit)
 		goto bailout;
 	}
 
+	if (bbpdir_hashsize > 0)
+		memset(bbpdir_hash, 0, bbpdir_hashsize * sizeof(ulng));
 	for (i = 1; i < (bat) ATOMIC_GET(BBPsize, BBPsizeLock); i++) {
 		/* write the entry
 		 * BBP.dir consists of all persistent bats */
 		if (BBP_status(i) & BBPPERSISTENT) {
-			if (new_bbpentry(fp, i, "") != GDK_SUCCEED) {
+			if (new_bbpentry(fp, i, "", 1) != GDK_SUCCEED) {
 				goto bailout;
 			}
-			IODEBUG new_bbpentry(stderr, i, "#");
+			IODEBUG new_bbpentry(stderr, i, "#", 0);
+			entries++;
 		}
 	}
 
@@ -1830,7 +2280,8 @@ BBPdir(int cnt, bat *subcommit)
 	if (i < (bat) ATOMIC_GET(BBPsize, BBPsizeLock))
 		return GDK_FAIL;
 
-	return GDK_SUCCEED;
+	bbpdir_entries = entries;
+	return BBPdir_emptyinc((bat) ATOMIC_GET(BBPsize, BBPsizeLock));
 
       bailout:
 	if (fp != NULL)
@@ -1857,7 +2308,7 @@ BBPdump(void)
 			i,
 			ATOMname(b->ttype),
 			BBP_logical(i) ? BBP_logical(i) : "<NULL>",
-			BBP_refs(i),
+			(int) BBP_refs(i),
 			BBP_lrefs(i),
 			BBP_status(i),
 			b->batCount);
@@ -2422,6 +2873,43 @@ BBPspin(bat i, const char *s, int event)
 	}
 }
 
+/*
+ * Physical references are counted atomically.  As long as a BAT has
+ * at least one fix, adding another fix or dropping one that is not
+ * the last does not involve loading or unloading anything, so that
+ * can be done with a compare-and-swap without taking GDKswapLock.
+ * The transitions from and to zero, which do the loading and
+ * unloading, are only made while holding the lock, and since the
+ * fast path never touches a zero count, they do not race with it.
+ */
+#ifdef ATOMIC_LOCK
+#define BBP_refs_inc(i)		(++BBP_refs(i))
+#define BBP_refs_dec(i)		(--BBP_refs(i))
+#else
+#define BBP_refs_inc(i)		((int) ATOMIC_INC(BBP_refs(i), GDKswapLock(i)))
+#define BBP_refs_dec(i)		((int) ATOMIC_DEC(BBP_refs(i), GDKswapLock(i)))
+#endif
+
+static inline int
+fastref(bat i, int delta)
+{
+#ifdef ATOMIC_LOCK
+	/* atomic operations would need a lock anyway */
+	(void) i;
+	(void) delta;
+#else
+	ATOMIC_TYPE refs;
+
+	/* an increment needs an existing fix, a decrement may not
+	 * drop the last one */
+	while ((refs = ATOMIC_GET(BBP_refs(i), GDKswapLock(i))) > (delta < 0)) {
+		if (ATOMIC_CAS(BBP_refs(i), refs, refs + delta, GDKswapLock(i)))
+			return (int) (refs + delta);
+	}
+#endif
+	return 0;
+}
+
 static inline int
 incref(bat i, int logical, int lock)
 {
@@ -2440,6 +2928,13 @@ incref(bat i, int logical, int lock)
 	if (!BBPcheck(i, logical ? "BBPretain" : "BBPfix"))
 		return 0;
 
+	if (!logical && (refs = fastref(i, 1)) > 0) {
+		/* the thread that made the first fix may still be
+		 * loading (the parents of) the BAT */
+		BBPspin(i, "BBPfix", BBPUNSTABLE | BBPLOADING);
+		return refs;
+	}
+
 	if (lock) {
 		for (;;) {
 			MT_lock_set(&GDKswapLock(i));
@@ -2470,16 +2965,18 @@ incref(bat i, int logical, int lock)
 		tp = b->theap.parentid;
 		assert(tp >= 0);
 		tvp = b->tvheap == 0 || b->tvheap->parentid == i ? 0 : b->tvheap->parentid;
-		refs = ++BBP_refs(i);
-		if (refs == 1 && (tp || tvp)) {
+		if (BBP_refs(i) == 0 && (tp || tvp)) {
 			/* If this is a view, we must load the parent
 			 * BATs, but we must do that outside of the
 			 * lock.  Set the BBPLOADING flag so that
 			 * other threads will wait until we're
-			 * done. */
+			 * done.  The flag must be visible before the
+			 * count is, since the count is what lets
+			 * other threads in without the lock. */
 			BBP_status_on(i, BBPLOADING, "BBPfix");
 			load = 1;
 		}
+		refs = BBP_refs_inc(i);
 	}
 	if (lock)
 		MT_lock_unset(&GDKswapLock(i));
@@ -2550,6 +3047,8 @@ decref(bat i, int logical, int releaseShare, int lock, const char *func)
 	BAT *b;
 
 	assert(i > 0);
+	if (!logical && !releaseShare && (refs = fastref(i, -1)) > 0)
+		return refs;
 	if (lock)
 		MT_lock_set(&GDKswapLock(i));
 	if (releaseShare) {
@@ -2584,7 +3083,7 @@ decref(bat i, int logical, int releaseShare, int lock, const char *func)
 		} else {
 			assert(b == NULL || b->theap.parentid == 0 || BBP_refs(b->theap.parentid) > 0);
 			assert(b == NULL || b->tvheap == NULL || b->tvheap->parentid == 0 || BBP_refs(b->tvheap->parentid) > 0);
-			refs = --BBP_refs(i);
+			refs = BBP_refs_dec(i);
 			if (b && refs == 0) {
 				if ((tp = b->theap.parentid) != 0)
 					b->theap.base = (char *) (b->theap.base - BBP_cache(tp)->theap.base);
@@ -3097,6 +3596,19 @@ heap_move(Heap *hp, const char *srcdir, const char *dstdir, const char *nme, con
  * backup_dir == 2 => BBP.dir saved in SUBCOMMIT/
  */
 
+/* move the BAT directory from srcdir to dstdir: BBP.inc if there is
+ * one, and BBP.dir unless only BBP.inc is being saved */
+static gdk_return
+BBPdir_move(const char *srcdir, const char *dstdir)
+{
+	if (file_exists(0, srcdir, "BBP", "inc") &&
+	    GDKmove(0, srcdir, "BBP", "inc", dstdir, "BBP", "inc") != GDK_SUCCEED)
+		return GDK_FAIL;
+	if (backup_inc)
+		return GDK_SUCCEED;
+	return GDKmove(0, srcdir, "BBP", "dir", dstdir, "BBP", "dir");
+}
+
 static gdk_return
 BBPprepare(bit subcommit)
 {
@@ -3137,8 +3649,14 @@ BBPprepare(bit subcommit)
 		IODEBUG fprintf(stderr, "#mkdir %s = %d\n", subdirpath, (int) ret);
 	}
 	if (ret == GDK_SUCCEED && backup_dir != set) {
-		/* a valid backup dir *must* at least contain BBP.dir */
-		if ((ret = GDKmove(0, backup_dir ? BAKDIR : BATDIR, "BBP", "dir", subcommit ? SUBDIR : BAKDIR, "BBP", "dir")) == GDK_SUCCEED) {
+		/* a valid backup dir *must* at least contain BBP.dir,
+		 * or BBP.inc if BBP.dir is left alone (see
+		 * BBPdir_subcommit) */
+		if (backup_dir == 0)
+			backup_inc = bbpinc_valid &&
+				bbpinc_entries * BBPINC_RATIO < bbpdir_entries &&
+				file_exists(0, BATDIR, "BBP", "inc");
+		if ((ret = BBPdir_move(backup_dir ? BAKDIR : BATDIR, subcommit ? SUBDIR : BAKDIR)) == GDK_SUCCEED) {
 			backup_dir = set;
 		}
 	}
@@ -3229,12 +3747,58 @@ do_backup(const char *srcdir, const char *nme, const char *ext,
 	return ret;
 }
 
+/* The saved encoded copy of a read-only bat may replace its tail file
+ * (see gdk_compress.c).  If such a bat was changed, the encoded copy
+ * holds the committed state of the tail: back it up instead of the
+ * tail, together with a tail.kill file, so that a recovery removes the
+ * tail that is about to be saved and decodes the encoded copy again.
+ * Returns 1 if the encoded copy is (or was) backed up, 0 if the tail
+ * must be backed up as usual, and -1 on failure. */
+static int
+cmpr_backup(BAT *b, const char *srcdir, const char *nme, bit subcommit)
+{
+	int farmid = BBPselectfarm(b->batRole, b->ttype, compressheap);
+	const char *dstdir = subcommit ? SUBDIR : BAKDIR;
+	char *path;
+	FILE *fp;
+
+	if (subcommit && file_exists(farmid, BAKDIR, nme, "tcompress")) {
+		/* backed up before, move it to the subcommit backup */
+		if (file_move(farmid, BAKDIR, SUBDIR, nme, "tcompress") != GDK_SUCCEED ||
+		    (file_exists(b->theap.farmid, BAKDIR, nme, "tail.kill") &&
+		     file_move(b->theap.farmid, BAKDIR, SUBDIR, nme, "tail.kill") != GDK_SUCCEED))
+			return -1;
+	}
+	if (file_exists(farmid, dstdir, nme, "tcompress"))
+		return 1;
+	if (!(b->batDirty || b->theap.dirty) ||
+	    file_exists(b->theap.farmid, srcdir, nme, "tail") ||
+	    file_exists(b->theap.farmid, srcdir, nme, "tail.new") ||
+	    !file_exists(farmid, srcdir, nme, "tcompress"))
+		return 0;
+	path = GDKfilepath(b->theap.farmid, dstdir, nme, "tail.kill");
+	if (path == NULL)
+		return -1;
+	fp = fopen(path, "w");
+	if (fp == NULL)
+		GDKsyserror("cmpr_backup: cannot open file %s\n", path);
+	IODEBUG fprintf(stderr, "#open %s = %d\n", path, fp ? 0 : -1);
+	GDKfree(path);
+	if (fp == NULL)
+		return -1;
+	fclose(fp);
+	if (file_move(farmid, srcdir, dstdir, nme, "tcompress") != GDK_SUCCEED)
+		return -1;
+	return 1;
+}
+
 static gdk_return
 BBPbackup(BAT *b, bit subcommit)
 {
 	char *srcdir;
 	long_str nme;
 	const char *s = BBP_physical(b->batCacheid);
+	int cmpr;
 
 	if (BBPprepare(subcommit) != GDK_SUCCEED) {
 		return GDK_FAIL;
@@ -3252,8 +3816,10 @@ BBPbackup(BAT *b, bit subcommit)
 	srcdir[s - srcdir] = 0;
 
 	if (b->ttype != TYPE_void &&
-	    do_backup(srcdir, nme, "tail", &b->theap,
-		      b->batDirty || b->theap.dirty, subcommit) != GDK_SUCCEED)
+	    ((cmpr = cmpr_backup(b, srcdir, nme, subcommit)) < 0 ||
+	     (cmpr == 0 &&
+	      do_backup(srcdir, nme, "tail", &b->theap,
+			b->batDirty || b->theap.dirty, subcommit) != GDK_SUCCEED)))
 		goto fail;
 	if (b->tvheap &&
 	    do_backup(srcdir, nme, "theap", b->tvheap,
@@ -3277,6 +3843,19 @@ BBPbackup(BAT *b, bit subcommit)
  *
  * The BBP.dir is also moved into the BAKDIR.
  */
+struct syncsave {
+	BAT *b;
+	gdk_return ret;
+};
+
+static void
+BBPsync_save(void *arg)
+{
+	struct syncsave *s = arg;
+
+	s->ret = BATsave(s->b);
+}
+
 gdk_return
 BBPsync(int cnt, bat *subcommit)
 {
@@ -3325,21 +3904,43 @@ BBPsync(int cnt, bat *subcommit)
 
 	/* PHASE 2: save the repository */
 	if (ret == GDK_SUCCEED) {
-		int idx = 0;
+		int idx = 0, n = 0;
+		struct syncsave *saves;
 
-		while (++idx < cnt) {
+		if ((saves = GDKmalloc(cnt * sizeof(*saves))) == NULL)
+			ret = GDK_FAIL;
+		while (ret == GDK_SUCCEED && ++idx < cnt) {
 			bat i = subcommit ? subcommit[idx] : idx;
 
 			if (BBP_status(i) & BBPPERSISTENT) {
 				BAT *b = dirty_bat(&i, subcommit != NULL);
 				if (i <= 0)
 					break;
-				if (b != NULL && BATsave(b) != GDK_SUCCEED)
-					break;	/* write error */
+				if (b != NULL) {
+					saves[n].b = b;
+					saves[n].ret = GDK_SUCCEED;
+					n++;
+				}
 			}
 		}
-		if (idx < cnt)
+		if (ret == GDK_SUCCEED && idx < cnt)
 			ret = GDK_FAIL;
+		if (ret == GDK_SUCCEED) {
+			/* the bats are saved to separate files, so
+			 * they can be written in parallel, but not if
+			 * we hold the BBP locks, since helper threads
+			 * might need them */
+			if (locked_by == 0) {
+				GDKparallel(n, BBPsync_save, saves, sizeof(*saves));
+			} else {
+				for (idx = 0; idx < n; idx++)
+					BBPsync_save(&saves[idx]);
+			}
+			for (idx = 0; idx < n; idx++)
+				if (saves[idx].ret != GDK_SUCCEED)
+					ret = GDK_FAIL;	/* write error */
+		}
+		GDKfree(saves);
 	}
 
 	PERFDEBUG fprintf(stderr, "#BBPsync (write time %d)\n", (t0 = GDKms()) - t1);
@@ -3347,7 +3948,7 @@ BBPsync(int cnt, bat *subcommit)
 	if (ret == GDK_SUCCEED) {
 		if (bbpdirty) {
 			ret = BBPdir(cnt, subcommit);
-		} else if (backup_dir && GDKmove(0, (backup_dir == 1) ? BAKDIR : SUBDIR, "BBP", "dir", BATDIR, "BBP", "dir") != GDK_SUCCEED) {
+		} else if (backup_dir && BBPdir_move((backup_dir == 1) ? BAKDIR : SUBDIR, BATDIR) != GDK_SUCCEED) {
 			ret = GDK_FAIL;	/* tried a cheap way to get BBP.dir; but it failed */
 		} else {
 			/* commit might still fail; we must remember
@@ -3382,7 +3983,7 @@ BBPsync(int cnt, bat *subcommit)
 		if (ret == GDK_SUCCEED) {
 			BBP_dirty = 0;
 			backup_files = subcommit ? (backup_files - backup_subdir) : 0;
-			backup_dir = backup_subdir = 0;
+			backup_dir = backup_subdir = backup_inc = 0;
 			if (GDKremovedir(0, DELDIR) != GDK_SUCCEED)
 				fprintf(stderr, "#BBPsync: cannot remove directory %s\n", DELDIR);
 			(void) BBPprepare(0);	/* (try to) remove DELDIR and set up new BAKDIR */
@@ -3392,6 +3993,7 @@ BBPsync(int cnt, bat *subcommit)
 			}
 		}
 	}
+	BBPinc_install(ret == GDK_SUCCEED);
 	PERFDEBUG fprintf(stderr, "#BBPsync (ready time %d)\n", (t0 = GDKms()) - t1);
 	GDKfree(bakdir);
 	GDKfree(deldir);
@@ -3475,7 +4077,7 @@ BBPrecover(int farmid)
 	bat i;
 	size_t j = strlen(BATDIR);
 	gdk_return ret = GDK_SUCCEED;
-	int dirseen = FALSE;
+	int dirseen = FALSE, incseen = FALSE;
 	str dstdir;
 
 	bakdirpath = GDKfilepath(farmid, NULL, BAKDIR, NULL);
@@ -3526,6 +4128,9 @@ BBPrecover(int farmid)
 		} else if (strcmp(dent->d_name, "BBP.dir") == 0) {
 			dirseen = TRUE;
 			continue;
+		} else if (strcmp(dent->d_name, "BBP.inc") == 0) {
+			incseen = TRUE;
+			continue;
 		}
 		if (q == NULL)
 			q = dent->d_name + strlen(dent->d_name);
@@ -3559,6 +4164,8 @@ BBPrecover(int farmid)
 		ret = recover_dir(farmid, stat(fn, &st) == 0);
 		GDKfree(fn);
 	}
+	if ((dirseen || incseen) && ret == GDK_SUCCEED)
+		ret = recover_inc(farmid, incseen, dirseen);
 
 	if (ret == GDK_SUCCEED) {
 		if (rmdir(bakdirpath) < 0) {
@@ -3604,7 +4211,9 @@ BBPrecover_subdir(void)
 		if (dent->d_name[0] == '.')
 			continue;
 		ret = GDKmove(0, SUBDIR, dent->d_name, NULL, BAKDIR, dent->d_name, NULL);
-		if (ret == GDK_SUCCEED && strcmp(dent->d_name, "BBP.dir") == 0)
+		if (ret == GDK_SUCCEED &&
+		    (strcmp(dent->d_name, "BBP.dir") == 0 ||
+		     strcmp(dent->d_name, "BBP.inc") == 0))
 			backup_dir = 1;
 		if (ret != GDK_SUCCEED)
 			break;
@@ -3754,6 +4363,16 @@ BBPdiskscan(const char *parent, size_t baseoff)
 #else
 				delete = TRUE;
 #endif
+			} else if (strncmp(p + 1, "tzonemap", 8) == 0) {
+				BAT *b = getdesc(bid);
+				delete = b == NULL;
+				if (!delete)
+					b->tzonemap = (Heap *) 1;
+			} else if (strncmp(p + 1, "tcompress", 9) == 0) {
+				BAT *b = getdesc(bid);
+				delete = b == NULL;
+				if (!delete)
+					b->tcompress = (Heap *) 1;
 			} else if (strncmp(p + 1, "priv", 4) != 0 &&
 				   strncmp(p + 1, "new", 3) != 0 &&
 				   strncmp(p + 1, "head", 4) != 0 &&
@@ -3816,4 +4435,5 @@ gdk_bbp_reset(void)
 	backup_files = 0;
 	backup_dir = 0;
 	backup_subdir = 0;
+	backup_inc = 0;
 }
@@ -0,0 +1,1139 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2017 MonetDB B.V.
+ */
+
+/*
+ * Lightweight compression of integer columns.
+ *
+ * When a large persistent BAT is saved while it is read-only, an
+ * encoded copy of its tail is made with one of three encodings,
+ * whichever is smallest (gdk_compress=no switches this off,
+ * bat.setCompress makes one on request):
+ *
+ * CMPR_FOR	frame of reference: each value is stored as the
+ *		difference with a base value, bit packed;
+ * CMPR_DICT	dictionary: each value is stored as the bit packed
+ *		index in a sorted dictionary of the distinct values;
+ * CMPR_RLE	run length: each run of equal values is stored as the
+ *		value and the position where the run ends.
+ *
+ * If neither encoding is at least twice as small as the tail, no
+ * encoded copy is made.  The codes of FOR and DICT preserve the order
+ * of the values, so range selects are translated to a range of codes
+ * and evaluated on the packed codes.  Select, project, sum, min and max
+ * read the encoded copy instead of the tail when it exists.
+ *
+ * On disk, the encoded copy of a persistent read-only BAT replaces its
+ * tail: once the encoded copy is saved, the tail file is removed (when
+ * the BAT is unloaded if the tail is memory mapped), and when the BAT
+ * is loaded again, the tail is decoded into memory (see CMPRload).  Any
+ * change to the BAT destroys the encoded copy in memory, but leaves the
+ * file, which then holds the committed state of the tail: BBPbackup
+ * moves it to the backup directory before the changed tail is saved.
+ * A tail file found next to an encoded copy when the BAT is loaded
+ * means that a save was interrupted, or that the BAT was changed, and
+ * the encoded copy, which may not match the tail, is removed.
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "gdk_private.h"
+
+#define CMPR_VERSION	((lng) 1)
+
+/* encodings */
+#define CMPR_FOR	1
+#define CMPR_DICT	2
+#define CMPR_RLE	3
+
+/* The heap starts with CMPROFF lng values: version, number of values,
+ * encoding, bits per code (FOR and DICT), number of dictionary
+ * entries (DICT) or runs (RLE), base value (FOR), smallest and
+ * largest non-nil value (nil if there are none), and number of nils.
+ * All values are widened to lng, nil to the widened nil of the column
+ * type, which is smaller than all other values.
+ * FOR:  the packed codes; code 0 is nil if there are nils, otherwise
+ *       a code is the difference with the base value.
+ * DICT: the sorted dictionary followed by the packed codes.
+ * RLE:  the values of the runs followed by the (exclusive) end
+ *       positions of the runs. */
+#define CMPROFF		9
+#define CMPRhdr(hp)	((const lng *) (hp)->base)
+#define CMPRcount(hp)	((BUN) CMPRhdr(hp)[1])
+#define CMPRenc(hp)	((int) CMPRhdr(hp)[2])
+#define CMPRbits(hp)	((int) CMPRhdr(hp)[3])
+#define CMPRn(hp)	((BUN) CMPRhdr(hp)[4])
+#define CMPRbase(hp)	(CMPRhdr(hp)[5])
+#define CMPRmin(hp)	(CMPRhdr(hp)[6])
+#define CMPRmax(hp)	(CMPRhdr(hp)[7])
+#define CMPRnils(hp)	((BUN) CMPRhdr(hp)[8])
+#define CMPRdata(hp)	(CMPRhdr(hp) + CMPROFF)
+
+/* number of lng words needed for n codes of the given number of bits */
+#define CMPRwords(n, bits)	(((size_t) (n) * (bits) + 63) / 64)
+
+/* only columns with at least this many values are encoded */
+#define CMPR_MINCOUNT	((BUN) 1 << 16)
+/* maximum number of dictionary entries */
+#define CMPR_MAXDICT	4096
+#define CMPR_HASHBITS	13	/* hash table of 2 * CMPR_MAXDICT slots */
+
+/* return whether we can encode columns of type tpe */
+int
+CMPRtype(int tpe)
+{
+	switch (ATOMbasetype(tpe)) {
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static lng
+CMPRnil(int tpe)
+{
+	switch (ATOMbasetype(tpe)) {
+	case TYPE_sht:
+		return (lng) sht_nil;
+	case TYPE_int:
+		return (lng) int_nil;
+	default:
+		return lng_nil;
+	}
+}
+
+static lng
+CMPRwiden(int tpe, const void *v)
+{
+	switch (ATOMbasetype(tpe)) {
+	case TYPE_sht:
+		return (lng) * (const sht *) v;
+	case TYPE_int:
+		return (lng) * (const int *) v;
+	default:
+		return * (const lng *) v;
+	}
+}
+
+static inline ulng
+getcode(const ulng *w, BUN i, int bits, ulng mask)
+{
+	size_t pos = (size_t) i * bits;
+	size_t k = pos >> 6;
+	int sh = (int) (pos & 63);
+	ulng c = w[k] >> sh;
+
+	if (sh + bits > 64)
+		c |= w[k + 1] << (64 - sh);
+	return c & mask;
+}
+
+static inline void
+putcode(ulng *w, BUN i, int bits, ulng c)
+{
+	size_t pos = (size_t) i * bits;
+	size_t k = pos >> 6;
+	int sh = (int) (pos & 63);
+
+	w[k] |= c << sh;
+	if (sh + bits > 64)
+		w[k + 1] |= c >> (64 - sh);
+}
+
+static int
+nbits(ulng v)
+{
+	int n = 1;
+
+	while (n < 64 && (v >> n) != 0)
+		n++;
+	return n;
+}
+
+/* loop over the values of b widened to lng, executing STMT for each */
+#define CMPR_LOOP(TYPE, STMT)						\
+	do {								\
+		const TYPE *restrict vals = (const TYPE *) Tloc(b, 0);	\
+		for (i = 0; i < n; i++) {				\
+			lng val = (lng) vals[i];			\
+			STMT;						\
+		}							\
+	} while (0)
+#define CMPR_LOOPALL(STMT)						\
+	do {								\
+		switch (ATOMbasetype(b->ttype)) {			\
+		case TYPE_sht:						\
+			CMPR_LOOP(sht, STMT);				\
+			break;						\
+		case TYPE_int:						\
+			CMPR_LOOP(int, STMT);				\
+			break;						\
+		default:						\
+			CMPR_LOOP(lng, STMT);				\
+			break;						\
+		}							\
+	} while (0)
+
+struct stats {
+	lng nil, min, max, prev;
+	BUN nils, runs;
+};
+
+static inline void
+stats_add(struct stats *st, BUN i, lng val)
+{
+	if (val == st->nil) {
+		st->nils++;
+	} else if (st->min == st->nil) {
+		st->min = st->max = val;
+	} else if (val < st->min) {
+		st->min = val;
+	} else if (val > st->max) {
+		st->max = val;
+	}
+	if (i == 0 || val != st->prev)
+		st->runs++;
+	st->prev = val;
+}
+
+struct dict {
+	lng *keys;
+	int *codes;		/* -1 for empty slots */
+	lng *vals;		/* the distinct values */
+	int n;
+};
+
+#define dict_hash(v)	((size_t) (((ulng) (v) * 0x9E3779B97F4A7C15ULL) >> (64 - CMPR_HASHBITS)))
+
+/* return the slot of v in the hash table, inserting it if it is not
+ * there yet; returns -1 if there are too many distinct values */
+static inline int
+dict_slot(struct dict *d, lng val)
+{
+	size_t h = dict_hash(val);
+	size_t m = ((size_t) 1 << CMPR_HASHBITS) - 1;
+
+	while (d->codes[h] >= 0) {
+		if (d->keys[h] == val)
+			return (int) h;
+		h = (h + 1) & m;
+	}
+	if (d->n == CMPR_MAXDICT)
+		return -1;
+	d->keys[h] = val;
+	d->codes[h] = d->n;
+	d->vals[d->n++] = val;
+	return (int) h;
+}
+
+static int
+lngcmp(const void *a, const void *b)
+{
+	lng x = * (const lng *) a, y = * (const lng *) b;
+
+	return (x > y) - (x < y);
+}
+
+static inline void
+dict_put(struct dict *d, ulng *w, BUN i, int bits, lng val)
+{
+	putcode(w, i, bits, (ulng) d->codes[dict_slot(d, val)]);
+}
+
+static inline void
+for_put(ulng *w, BUN i, int bits, lng val, lng nil, lng base)
+{
+	putcode(w, i, bits, val == nil ? 0 : (ulng) (val - base));
+}
+
+static inline void
+rle_put(lng *vals, oid *ends, BUN *r, BUN i, lng val)
+{
+	if (i > 0 && vals[*r] != val) {
+		ends[*r] = (oid) i;
+		++*r;
+	}
+	vals[*r] = val;
+}
+
+/* create the encoded copy of the tail of b, if it is worth it; the
+ * caller must hold GDKhashLock(b->batCacheid) */
+static gdk_return
+CMPRcreate(BAT *b, Heap **hpp)
+{
+	BUN n = BATcount(b), i, r;
+	struct stats st;
+	struct dict d;
+	int enc = 0, bits = 0, forbits = 0, dictbits = 0;
+	size_t sz, best, forsz, dictsz = 0, rlesz;
+	lng base = 0, *h;
+	ulng *w;
+	Heap *hp;
+	const char *nme;
+	size_t nmelen;
+
+	*hpp = NULL;
+	st.nil = st.min = st.max = CMPRnil(b->ttype);
+	st.prev = 0;
+	st.nils = st.runs = 0;
+	CMPR_LOOPALL(stats_add(&st, i, val));
+
+	/* sizes in bytes of the three encodings (excluding header) */
+	rlesz = (size_t) st.runs * (sizeof(lng) + sizeof(oid));
+	forsz = (size_t) -1;
+	if (st.min != st.nil) {
+		base = st.min - (st.nils > 0);
+		forbits = nbits((ulng) st.max - (ulng) base);
+		if (forbits <= 32)
+			forsz = CMPRwords(n, forbits) * sizeof(lng);
+	}
+	d.keys = NULL;
+	d.codes = NULL;
+	d.vals = NULL;
+	d.n = 0;
+	if (forbits > 8 || forsz == (size_t) -1) {
+		/* range too large for FOR to be really effective: see
+		 * whether there are few distinct values */
+		d.keys = GDKmalloc(sizeof(lng) << CMPR_HASHBITS);
+		d.codes = GDKmalloc(sizeof(int) << CMPR_HASHBITS);
+		d.vals = GDKmalloc(sizeof(lng) * CMPR_MAXDICT);
+		if (d.keys == NULL || d.codes == NULL || d.vals == NULL)
+			goto bailout;
+		memset(d.codes, 0xFF, sizeof(int) << CMPR_HASHBITS);
+		for (i = 0; i < n; i++) {
+			int ok = 1;
+			switch (ATOMbasetype(b->ttype)) {
+			case TYPE_sht:
+				ok = dict_slot(&d, (lng) ((const sht *) Tloc(b, 0))[i]) >= 0;
+				break;
+			case TYPE_int:
+				ok = dict_slot(&d, (lng) ((const int *) Tloc(b, 0))[i]) >= 0;
+				break;
+			default:
+				ok = dict_slot(&d, ((const lng *) Tloc(b, 0))[i]) >= 0;
+				break;
+			}
+			if (!ok) {
+				d.n = 0;
+				break;
+			}
+		}
+		if (d.n > 0) {
+			dictbits = nbits((ulng) d.n - 1);
+			dictsz = d.n * sizeof(lng) +
+				CMPRwords(n, dictbits) * sizeof(lng);
+		}
+	}
+
+	best = (size_t) n * b->twidth / 2;
+	if (rlesz <= best) {
+		enc = CMPR_RLE;
+		best = rlesz;
+	}
+	if (forsz < best) {
+		enc = CMPR_FOR;
+		bits = forbits;
+		best = forsz;
+	}
+	if (d.n > 0 && dictsz < best) {
+		enc = CMPR_DICT;
+		bits = dictbits;
+		best = dictsz;
+	}
+	if (enc == 0) {
+		/* not worth it */
+		ALGODEBUG fprintf(stderr, "#BATcompress(%s#" BUNFMT "): "
+				  "no effective encoding\n",
+				  BATgetId(b), BATcount(b));
+		GDKfree(d.keys);
+		GDKfree(d.codes);
+		GDKfree(d.vals);
+		return GDK_SUCCEED;
+	}
+
+	sz = CMPROFF * sizeof(lng) + best;
+	nme = BBP_physical(b->batCacheid);
+	nmelen = strlen(nme) + 12;
+	if ((hp = GDKzalloc(sizeof(Heap))) == NULL ||
+	    (hp->farmid = BBPselectfarm(b->batRole, b->ttype, compressheap)) < 0 ||
+	    (hp->filename = GDKmalloc(nmelen)) == NULL ||
+	    snprintf(hp->filename, nmelen, "%s.tcompress", nme) < 0 ||
+	    HEAPalloc(hp, sz, 1) != GDK_SUCCEED) {
+		if (hp)
+			GDKfree(hp->filename);
+		GDKfree(hp);
+		goto bailout;
+	}
+	memset(hp->base, 0, sz);
+	hp->free = sz;
+	h = (lng *) hp->base;
+	h[0] = CMPR_VERSION;
+	h[1] = (lng) n;
+	h[2] = enc;
+	h[3] = bits;
+	h[5] = base;
+	h[6] = st.min;
+	h[7] = st.max;
+	h[8] = (lng) st.nils;
+	switch (enc) {
+	case CMPR_FOR:
+		w = (ulng *) (h + CMPROFF);
+		CMPR_LOOPALL(for_put(w, i, bits, val, st.nil, base));
+		break;
+	case CMPR_DICT: {
+		lng *dv = h + CMPROFF;
+		int c;
+
+		/* renumber the dictionary in sorted order */
+		qsort(d.vals, d.n, sizeof(lng), lngcmp);
+		for (c = 0; c < d.n; c++)
+			d.codes[dict_slot(&d, d.vals[c])] = c;
+		memcpy(dv, d.vals, d.n * sizeof(lng));
+		h[4] = d.n;
+		w = (ulng *) (dv + d.n);
+		CMPR_LOOPALL(dict_put(&d, w, i, bits, val));
+		break;
+	}
+	case CMPR_RLE: {
+		lng *rv = h + CMPROFF;
+		oid *ends = (oid *) (rv + st.runs);
+
+		r = 0;
+		CMPR_LOOPALL(rle_put(rv, ends, &r, i, val));
+		ends[r] = (oid) n;
+		assert(r + 1 == st.runs);
+		h[4] = (lng) st.runs;
+		break;
+	}
+	}
+	hp->dirty = 1;
+	GDKfree(d.keys);
+	GDKfree(d.codes);
+	GDKfree(d.vals);
+	*hpp = hp;
+	return GDK_SUCCEED;
+
+  bailout:
+	GDKfree(d.keys);
+	GDKfree(d.codes);
+	GDKfree(d.vals);
+	return GDK_FAIL;
+}
+
+/* return whether the tail of b has a file of its own */
+static int
+CMPRtailfile(BAT *b)
+{
+	const char *nme = BBP_physical(b->batCacheid);
+	char *path;
+	struct stat st;
+	int ret = 0;
+
+	if ((path = GDKfilepath(b->theap.farmid, BATDIR, nme, "tail")) != NULL) {
+		ret = stat(path, &st) == 0;
+		GDKfree(path);
+	}
+	if (!ret &&
+	    (path = GDKfilepath(b->theap.farmid, BATDIR, nme, "tail.new")) != NULL) {
+		ret = stat(path, &st) == 0;
+		GDKfree(path);
+	}
+	return ret;
+}
+
+/* whether the encoded copy of b replaces its tail on disk */
+#define CMPRreplaces(b)							\
+	((b)->batRole == PERSISTENT &&					\
+	 (b)->batPersistence == PERSISTENT &&				\
+	 (b)->batRestricted == BAT_READ &&				\
+	 !isVIEW(b))
+
+/* Remove the tail file of b, which is replaced by the saved encoded
+ * copy.  HEAPsave has synced the encoded copy to disk, and the
+ * committed tail, if it is different, was moved to the backup
+ * directory by BBPbackup. */
+static int
+CMPRdroptail(BAT *b)
+{
+	const char *nme = BBP_physical(b->batCacheid);
+
+	if (GDKunlink(b->theap.farmid, BATDIR, nme, "tail") != GDK_SUCCEED ||
+	    GDKunlink(b->theap.farmid, BATDIR, nme, "tail.new") != GDK_SUCCEED) {
+		GDKclrerr();
+		return 0;
+	}
+	IODEBUG fprintf(stderr, "#CMPRdroptail(%s): tail replaced by encoded copy\n", BATgetId(b));
+	return 1;
+}
+
+/* Save the encoded copy hp of b, which replaces the tail file; the
+ * caller must hold GDKhashLock(b->batCacheid).  Returns whether the
+ * tail file was removed. */
+static int
+CMPRstore(BAT *b, Heap *hp)
+{
+	const char *nme = BBP_physical(b->batCacheid);
+
+	assert(CMPRreplaces(b));
+	if (hp->dirty) {
+		if (HEAPsave(hp, nme, "tcompress") != GDK_SUCCEED) {
+			GDKunlink(hp->farmid, BATDIR, nme, "tcompress");
+			GDKclrerr();	/* the tail is saved instead */
+			return 0;
+		}
+		hp->dirty = 0;
+	}
+	/* a memory mapped tail may be extended through its file, so
+	 * that is only removed when the bat is unloaded (see CMPRfree) */
+	if (b->theap.storage != STORE_MEM)
+		return 0;
+	return CMPRdroptail(b);
+}
+
+/* return TRUE if we have an encoded copy of the tail, even if we need
+ * to read one from disk */
+int
+BATcheckcompress(BAT *b)
+{
+	int ret;
+
+	if (b == NULL)
+		return 0;
+	assert(b->batCacheid > 0);
+	/* we don't need the lock just to read the value b->tcompress */
+	if (b->tcompress == NULL)
+		return 0;
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if (b->tcompress == (Heap *) 1) {
+		Heap *hp;
+		const char *nme = BBP_physical(b->batCacheid);
+		int fd;
+
+		b->tcompress = NULL;
+		if ((hp = GDKzalloc(sizeof(*hp))) != NULL &&
+		    (hp->farmid = BBPselectfarm(b->batRole, b->ttype, compressheap)) >= 0 &&
+		    (hp->filename = GDKmalloc(strlen(nme) + 12)) != NULL) {
+			sprintf(hp->filename, "%s.tcompress", nme);
+
+			/* check whether a persisted encoding can be found */
+			if ((fd = GDKfdlocate(hp->farmid, nme, "rb", "tcompress")) >= 0) {
+				struct stat st;
+				lng hdata[CMPROFF];
+				int ok;
+
+				ok = read(fd, hdata, sizeof(hdata)) == sizeof(hdata) &&
+					hdata[0] == CMPR_VERSION &&
+					hdata[1] == (lng) BATcount(b) &&
+					fstat(fd, &st) == 0 &&
+					st.st_size >= (off_t) sizeof(hdata);
+				close(fd);
+				if (ok) {
+					hp->size = hp->free = (size_t) st.st_size;
+					if (HEAPload(hp, nme, "tcompress", 0) == GDK_SUCCEED) {
+						b->tcompress = hp;
+						ALGODEBUG fprintf(stderr, "#BATcheckcompress: reusing persisted encoding %d\n", b->batCacheid);
+						MT_lock_unset(&GDKhashLock(b->batCacheid));
+						return 1;
+					}
+				}
+				/* unlink unusable file */
+				GDKunlink(hp->farmid, BATDIR, nme, "tcompress");
+			}
+			GDKfree(hp->filename);
+		}
+		GDKfree(hp);
+		GDKclrerr();	/* we're not currently interested in errors */
+	}
+	ret = b->tcompress != NULL;
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+	return ret;
+}
+
+/* create an encoded copy of the tail of b (or of its parent if b is a
+ * view) if there is an encoding that is at least twice as small */
+gdk_return
+BATcompress(BAT *b)
+{
+	Heap *hp;
+	lng t0 = 0;
+	static const char *encname[] = {"", "FOR", "DICT", "RLE"};
+
+	BATcheck(b, "BATcompress", GDK_FAIL);
+	if (VIEWtparent(b)) {
+		b = BBPdescriptor(VIEWtparent(b));
+		assert(b);
+	}
+	if (!CMPRtype(b->ttype)) {
+		GDKerror("BATcompress: unsupported type\n");
+		return GDK_FAIL;
+	}
+	if (BATcheckcompress(b))
+		return GDK_SUCCEED;
+	ALGODEBUG t0 = GDKusec();
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if (b->tcompress != NULL) {
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		return GDK_SUCCEED;
+	}
+	if (CMPRcreate(b, &hp) != GDK_SUCCEED) {
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		return GDK_FAIL;
+	}
+	if (hp != NULL) {
+		b->tcompress = hp;
+		ALGODEBUG fprintf(stderr, "#BATcompress(%s#" BUNFMT "): "
+				  "%s encoding, " SZFMT " bytes "
+				  "(" LLFMT " usec)\n",
+				  BATgetId(b), BATcount(b),
+				  encname[CMPRenc(hp)], hp->free,
+				  GDKusec() - t0);
+		/* a dirty bat saves its encoding when it is saved
+		 * itself, a writable one keeps it in memory only */
+		if (CMPRreplaces(b) &&
+		    (BBP_status(b->batCacheid) & BBPEXISTING) &&
+		    !BATdirty(b))
+			(void) CMPRstore(b, hp);
+	}
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+	return GDK_SUCCEED;
+}
+
+/* Save the encoded copy of a bat that is being saved, creating it
+ * first if so configured and the bat is large, persistent and
+ * read-only.  Returns whether the encoded copy replaces the tail, which
+ * then need not be saved.  The encoded copy of a writable bat is only
+ * kept in memory. */
+int
+CMPRsave(BAT *b)
+{
+	Heap *hp;
+	int ret = 0;
+
+	if (GDK_compress &&
+	    b->tcompress == NULL &&
+	    CMPRreplaces(b) &&
+	    CMPRtype(b->ttype) &&
+	    BATcount(b) >= CMPR_MINCOUNT &&
+	    BATcompress(b) != GDK_SUCCEED)
+		GDKclrerr();	/* not interested in errors */
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if ((hp = b->tcompress) != NULL && hp != (Heap *) 1 &&
+	    CMPRreplaces(b))
+		ret = CMPRstore(b, hp);
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+	return ret;
+}
+
+void
+CMPRfree(BAT *b)
+{
+	if (b) {
+		Heap *hp;
+
+		MT_lock_set(&GDKhashLock(b->batCacheid));
+		if ((hp = b->tcompress) != NULL && hp != (Heap *) 1) {
+			if (hp->dirty) {
+				/* not saved (yet) */
+				b->tcompress = NULL;
+				HEAPdelete(hp, BBP_physical(b->batCacheid), "tcompress");
+			} else {
+				b->tcompress = (Heap *) 1;
+				HEAPfree(hp, 0);
+				/* a mapped tail, of which CMPRstore kept
+				 * the file, is released next */
+				if (CMPRreplaces(b) && !BATdirty(b) &&
+				    b->theap.storage != STORE_MEM)
+					(void) CMPRdroptail(b);
+			}
+			GDKfree(hp);
+		}
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+	}
+}
+
+void
+CMPRdestroy(BAT *b)
+{
+	if (b && b->tcompress) {
+		Heap *hp;
+
+		int keep;
+
+		MT_lock_set(&GDKhashLock(b->batCacheid));
+		hp = b->tcompress;
+		b->tcompress = NULL;
+		/* if the encoded copy replaces the tail on disk, it
+		 * is the only saved copy of the values until the tail
+		 * is saved (see BBPbackup and CMPRload) */
+		keep = hp != NULL && (hp == (Heap *) 1 || !hp->dirty) &&
+			!CMPRtailfile(b);
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		if (hp == (Heap *) 1) {
+			if (!keep)
+				GDKunlink(BBPselectfarm(b->batRole, b->ttype, compressheap),
+					  BATDIR,
+					  BBP_physical(b->batCacheid),
+					  "tcompress");
+		} else if (hp != NULL) {
+			if (keep)
+				HEAPfree(hp, 0);
+			else
+				HEAPdelete(hp, BBP_physical(b->batCacheid), "tcompress");
+			GDKfree(hp);
+		}
+	}
+}
+
+/* Return the BAT (b or its parent) whose encoded copy covers all
+ * values of b, or NULL if there is none.  *offp is set to the
+ * position of the first value of b in the returned BAT. */
+BAT *
+CMPRbat(BAT *b, BUN *offp)
+{
+	BAT *pb = b;
+
+	if (!CMPRtype(b->ttype))
+		return NULL;
+	if (VIEWtparent(b) &&
+	    (pb = BBPquickdesc(VIEWtparent(b), 0)) == NULL)
+		return NULL;
+	if (!BATcheckcompress(pb) || CMPRcount(pb->tcompress) != BATcount(pb))
+		return NULL;
+	*offp = (BUN) ((const char *) Tloc(b, 0) -
+		       (const char *) Tloc(pb, 0)) >> b->tshift;
+	assert(*offp + BATcount(b) <= BATcount(pb));
+	return pb;
+}
+
+/* index of the run containing position p */
+static BUN
+rle_find(const oid *ends, BUN nruns, BUN p)
+{
+	BUN lo = 0, hi = nruns - 1, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (ends[mid] <= (oid) p)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* make room for at least one more value in bn */
+static gdk_return
+growcand(BAT *bn, BUN cnt, BUN need, BUN maximum)
+{
+	BUN ncap = MIN(MAX(cnt + need, 2 * BATcapacity(bn)), maximum);
+
+	BATsetcount(bn, cnt);
+	return BATextend(bn, MAX(ncap, cnt + 1));
+}
+
+/* Scan select on positions p..q of b using the encoded copy in pb,
+ * with b starting at position pr_off of pb.  The bounds tl and th are
+ * inclusive (see NORMALIZE in gdk_select.c); if th is nil, only nils
+ * are selected. */
+BUN
+CMPRselect(BAT *b, BAT *pb, BUN pr_off, BAT *bn, const void *tl,
+	   const void *th, BUN p, BUN q, BUN cnt, lng off, BUN maximum)
+{
+	const Heap *hp = pb->tcompress;
+	lng lo = CMPRwiden(b->ttype, tl), hi = CMPRwiden(b->ttype, th);
+	lng nil = CMPRnil(b->ttype);
+	oid *restrict dst;
+	BUN i;
+
+	assert(hp != NULL && hp != (Heap *) 1);
+	/* from here on, p and q are positions in the parent */
+	p += pr_off;
+	q += pr_off;
+	dst = (oid *) Tloc(bn, 0);
+	if (CMPRenc(hp) == CMPR_RLE) {
+		BUN nruns = CMPRn(hp), r, e;
+		const lng *rv = CMPRdata(hp);
+		const oid *ends = (const oid *) (rv + nruns);
+
+		if (p >= q)
+			return cnt;
+		for (r = rle_find(ends, nruns, p); r < nruns && p < q; r++, p = e) {
+			e = MIN((BUN) ends[r], q);
+			if (rv[r] < lo || rv[r] > hi)
+				continue;
+			if (cnt + e - p > BATcapacity(bn)) {
+				if (growcand(bn, cnt, e - p, maximum) != GDK_SUCCEED) {
+					BBPreclaim(bn);
+					return BUN_NONE;
+				}
+				dst = (oid *) Tloc(bn, 0);
+			}
+			for (i = p; i < e; i++)
+				dst[cnt++] = (oid) (i - pr_off + off);
+		}
+	} else {
+		int bits = CMPRbits(hp);
+		ulng mask = ((ulng) 1 << bits) - 1;
+		ulng cl, ch, c;
+		const ulng *w;
+
+		if (CMPRenc(hp) == CMPR_FOR) {
+			lng base = CMPRbase(hp), mn = CMPRmin(hp), mx = CMPRmax(hp);
+			int hasnil = CMPRnils(hp) > 0;
+
+			w = (const ulng *) CMPRdata(hp);
+			/* translate the bounds to a range of codes */
+			if (hasnil && lo == nil)
+				cl = 0;
+			else if (mn == nil || lo > mx)
+				return cnt;
+			else
+				cl = (ulng) (MAX(lo, mn) - base);
+			if (hi == nil)
+				ch = hasnil ? 0 : (ulng) -1;
+			else if (mn != nil && hi >= mn)
+				ch = (ulng) (MIN(hi, mx) - base);
+			else
+				ch = hasnil ? 0 : (ulng) -1;
+			if (ch == (ulng) -1 || cl > ch)
+				return cnt;
+		} else {
+			const lng *dv = CMPRdata(hp);
+			BUN nd = CMPRn(hp), l, h, m;
+
+			assert(CMPRenc(hp) == CMPR_DICT);
+			w = (const ulng *) (dv + nd);
+			/* first entry >= lo */
+			for (l = 0, h = nd; l < h; ) {
+				m = (l + h) / 2;
+				if (dv[m] < lo)
+					l = m + 1;
+				else
+					h = m;
+			}
+			cl = l;
+			/* first entry > hi */
+			for (h = nd; l < h; ) {
+				m = (l + h) / 2;
+				if (dv[m] <= hi)
+					l = m + 1;
+				else
+					h = m;
+			}
+			if (l == cl)
+				return cnt;
+			ch = l - 1;
+		}
+		ch -= cl;
+		for (i = p; i < q; i++) {
+			c = getcode(w, i, bits, mask);
+			if (c - cl <= ch) {
+				if (cnt == BATcapacity(bn)) {
+					if (growcand(bn, cnt, q - i, maximum) != GDK_SUCCEED) {
+						BBPreclaim(bn);
+						return BUN_NONE;
+					}
+					dst = (oid *) Tloc(bn, 0);
+				}
+				dst[cnt++] = (oid) (i - pr_off + off);
+			}
+		}
+	}
+	ALGODEBUG fprintf(stderr,
+			  "#BATselect(b=%s#" BUNFMT ",anti=0): "
+			  "compressed select\n",
+			  BATgetId(b), BATcount(b));
+	return cnt;
+}
+
+/* value at position p (in the parent) of an encoded copy; *rp is the
+ * run to start looking in for RLE */
+static inline lng
+CMPRvalue(const Heap *hp, BUN p, BUN *rp, lng nil)
+{
+	int bits = CMPRbits(hp);
+	ulng mask = ((ulng) 1 << bits) - 1;
+	ulng c;
+
+	switch (CMPRenc(hp)) {
+	case CMPR_FOR:
+		c = getcode((const ulng *) CMPRdata(hp), p, bits, mask);
+		if (c == 0 && CMPRnils(hp) > 0)
+			return nil;
+		return CMPRbase(hp) + (lng) c;
+	case CMPR_DICT:
+		c = getcode((const ulng *) (CMPRdata(hp) + CMPRn(hp)),
+			    p, bits, mask);
+		return CMPRdata(hp)[c];
+	default: {
+		BUN nruns = CMPRn(hp), r = *rp;
+		const oid *ends = (const oid *) (CMPRdata(hp) + nruns);
+
+		if (r >= nruns || (BUN) ends[r] <= p ||
+		    (r > 0 && (BUN) ends[r - 1] > p))
+			*rp = r = rle_find(ends, nruns, p);
+		return CMPRdata(hp)[r];
+	}
+	}
+}
+
+#define project_loop(TYPE)						\
+	do {								\
+		TYPE *restrict bt = (TYPE *) Tloc(bn, 0);		\
+		for (lo = 0; lo < hi; lo++) {				\
+			if (o[lo] < rseq || o[lo] >= rend) {		\
+				if (o[lo] == oid_nil) {			\
+					bt[lo] = TYPE##_nil;		\
+					bn->tnonil = 0;			\
+					bn->tnil = 1;			\
+					bn->tsorted = 0;		\
+					bn->trevsorted = 0;		\
+					bn->tkey = 0;			\
+				} else {				\
+					GDKerror("BATproject: does not match always\n"); \
+					return GDK_FAIL;		\
+				}					\
+			} else {					\
+				v = CMPRvalue(hp, o[lo] - rseq + pr_off, &rn, nil); \
+				bt[lo] = (TYPE) v;			\
+				if (nilcheck && v == nil) {		\
+					bn->tnonil = 0;			\
+					bn->tnil = 1;			\
+				}					\
+			}						\
+		}							\
+	} while (0)
+
+/* BATproject of r using the encoded copy in pr (see CMPRbat) */
+gdk_return
+CMPRproject(BAT *bn, BAT *l, BAT *r, BAT *pr, BUN pr_off, int nilcheck)
+{
+	const Heap *hp = pr->tcompress;
+	const oid *o = (const oid *) Tloc(l, 0);
+	oid rseq = r->hseqbase, rend = rseq + BATcount(r);
+	BUN lo, hi = BATcount(l), rn = 0;
+	lng v, nil = CMPRnil(r->ttype);
+
+	assert(hp != NULL && hp != (Heap *) 1);
+	switch (ATOMbasetype(r->ttype)) {
+	case TYPE_sht:
+		project_loop(sht);
+		break;
+	case TYPE_int:
+		project_loop(int);
+		break;
+	default:
+		project_loop(lng);
+		break;
+	}
+	BATsetcount(bn, hi);
+	ALGODEBUG fprintf(stderr, "#BATproject(l=%s,r=%s): compressed\n",
+			  BATgetId(l), BATgetId(r));
+	return GDK_SUCCEED;
+}
+
+#define decode_loop(TYPE)						\
+	do {								\
+		TYPE *restrict dst = (TYPE *) base;			\
+		for (i = 0; i < n; i++)					\
+			dst[i] = (TYPE) CMPRvalue(hp, i, &r, nil);	\
+	} while (0)
+
+/* Load the tail of b, which is being loaded, by decoding its encoded
+ * copy if that replaces the tail on disk.  Returns 1 if the tail was
+ * decoded, 0 if it has a file of its own that must be loaded instead,
+ * and -1 on error. */
+int
+CMPRload(BAT *b)
+{
+	const Heap *hp;
+	BUN i, n = BATcount(b), r = 0;
+	lng nil, t0 = 0;
+	size_t size;
+	char *base;
+	const char *nme = BBP_physical(b->batCacheid);
+
+	if (b->tcompress == NULL || !CMPRtype(b->ttype))
+		return 0;
+	if (CMPRtailfile(b)) {
+		/* left over from an interrupted save */
+		CMPRdestroy(b);
+		return 0;
+	}
+	ALGODEBUG t0 = GDKusec();
+	if (!BATcheckcompress(b) || CMPRcount(b->tcompress) != n) {
+		GDKerror("BATload: cannot decode the tail of %s\n",
+			 BBP_logical(b->batCacheid));
+		return -1;
+	}
+	hp = b->tcompress;
+	size = MAX(b->theap.size, (size_t) n << b->tshift);
+	if (size == 0)
+		size = (size_t) 1 << b->tshift;
+	if (b->theap.filename == NULL &&
+	    (b->theap.filename = GDKmalloc(strlen(nme) + 6)) == NULL)
+		return -1;
+	sprintf(b->theap.filename, "%s.tail", nme);
+	if ((base = GDKmalloc(size)) == NULL)
+		return -1;
+	nil = CMPRnil(b->ttype);
+	switch (ATOMbasetype(b->ttype)) {
+	case TYPE_sht:
+		decode_loop(sht);
+		break;
+	case TYPE_int:
+		decode_loop(int);
+		break;
+	default:
+		decode_loop(lng);
+		break;
+	}
+	b->theap.base = base;
+	b->theap.size = size;
+	b->theap.storage = b->theap.newstorage = STORE_MEM;
+	b->theap.dirty = 0;
+	ALGODEBUG fprintf(stderr, "#BATload(%s#" BUNFMT "): "
+			  "decoded tail (" LLFMT " usec)\n",
+			  BBP_logical(b->batCacheid), n, GDKusec() - t0);
+	return 1;
+}
+
+/* Sum of the values at positions p..q of the encoded copy in pb into
+ * *sum, and number of nils into *nils.  Returns GDK_FAIL on overflow,
+ * without setting an error. */
+gdk_return
+CMPRsum(BAT *b, BAT *pb, BUN p, BUN q, lng *sum, BUN *nils)
+{
+	const Heap *hp = pb->tcompress;
+	BUN i;
+	lng nil = CMPRnil(b->ttype), s = 0, v;
+
+	*nils = 0;
+	switch (CMPRenc(hp)) {
+	case CMPR_RLE: {
+		BUN nruns = CMPRn(hp), r, e;
+		const lng *rv = CMPRdata(hp);
+		const oid *ends = (const oid *) (rv + nruns);
+		lng n;
+
+		if (p >= q)
+			break;
+		for (r = rle_find(ends, nruns, p); r < nruns && p < q; r++, p = e) {
+			e = MIN((BUN) ends[r], q);
+			n = (lng) (e - p);
+			if ((v = rv[r]) == nil) {
+				*nils += e - p;
+				continue;
+			}
+			if (v > 0 ? v > GDK_lng_max / n : v < -GDK_lng_max / n)
+				return GDK_FAIL;
+			v *= n;
+			if (v > 0 ? s > GDK_lng_max - v : s < -GDK_lng_max - v)
+				return GDK_FAIL;
+			s += v;
+		}
+		break;
+	}
+	case CMPR_DICT: {
+		BUN nd = CMPRn(hp), *counts;
+		const lng *dv = CMPRdata(hp);
+		const ulng *w = (const ulng *) (dv + nd);
+		int bits = CMPRbits(hp);
+		ulng mask = ((ulng) 1 << bits) - 1;
+		lng n;
+
+		/* count the occurrences of each dictionary entry */
+		if ((counts = GDKzalloc(nd * sizeof(BUN))) == NULL) {
+			GDKclrerr();
+			return GDK_FAIL;
+		}
+		for (i = p; i < q; i++)
+			counts[getcode(w, i, bits, mask)]++;
+		for (i = 0; i < nd; i++) {
+			if (counts[i] == 0)
+				continue;
+			if ((v = dv[i]) == nil) {
+				*nils += counts[i];
+				continue;
+			}
+			n = (lng) counts[i];
+			if (v > 0 ? v > GDK_lng_max / n : v < -GDK_lng_max / n) {
+				GDKfree(counts);
+				return GDK_FAIL;
+			}
+			v *= n;
+			if (v > 0 ? s > GDK_lng_max - v : s < -GDK_lng_max - v) {
+				GDKfree(counts);
+				return GDK_FAIL;
+			}
+			s += v;
+		}
+		GDKfree(counts);
+		break;
+	}
+	case CMPR_FOR: {
+		const ulng *w = (const ulng *) CMPRdata(hp);
+		int bits = CMPRbits(hp), hasnil = CMPRnils(hp) > 0;
+		ulng mask = ((ulng) 1 << bits) - 1, c, cs = 0;
+		lng base = CMPRbase(hp), n;
+
+		/* sum of the codes fits in an ulng as long as there
+		 * are fewer than 2^32 values */
+		if (q - p >= ((BUN) 1 << 31))
+			return GDK_FAIL;
+		for (i = p; i < q; i++) {
+			c = getcode(w, i, bits, mask);
+			if (hasnil && c == 0)
+				++*nils;
+			cs += c;
+		}
+		/* sum = (number of non-nils) * base + sum of codes */
+		n = (lng) (q - p - *nils);
+		if (n > 0 && (base > 0 ? base > GDK_lng_max / n :
+			      base < -GDK_lng_max / n))
+			return GDK_FAIL;
+		s = n * base;
+		if (cs > (ulng) GDK_lng_max || s > GDK_lng_max - (lng) cs)
+			return GDK_FAIL;
+		s += (lng) cs;
+		break;
+	}
+	}
+	*sum = s;
+	return GDK_SUCCEED;
+}
+
+/* smallest or largest non-nil value of b, if the encoded copy of b
+ * itself (or of its parent, if b covers all of it) is available; the
+ * value is written in buf, which must be large enough for a lng */
+const void *
+CMPRminmax(BAT *b, int max, void *buf)
+{
+	BAT *pb;
+	BUN off;
+	lng v;
+
+	if ((pb = CMPRbat(b, &off)) == NULL ||
+	    BATcount(b) != BATcount(pb))
+		return NULL;
+	v = max ? CMPRmax(pb->tcompress) : CMPRmin(pb->tcompress);
+	switch (ATOMbasetype(b->ttype)) {
+	case TYPE_sht:
+		* (sht *) buf = (sht) v;
+		break;
+	case TYPE_int:
+		* (int *) buf = (int) v;
+		break;
+	default:
+		* (lng *) buf = v;
+		break;
+	}
+	return buf;
+}
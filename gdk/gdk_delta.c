@@ -114,6 +114,10 @@ BATundo(BAT *b)
 			}
 		}
 	}
+	if (bunlast >= b->batInserted) {
+		ZMAPdestroy(b);
+		CMPRdestroy(b);
+	}
 	b->theap.free = tailsize(b, b->batInserted);
 
 	BATsetcount(b, b->batInserted);
@@ -58,6 +58,10 @@
  *
  * If a hash table already exists on b, we can make use of it.
  *
+ * If the hash table and the group administration would not fit in the
+ * memory the query may still use, we hash-partition the input and
+ * group one partition at a time (see GRPspill).
+ *
  * Otherwise we build a partial hash table on the fly.
  *
  * A decision should be made on the order in which grouping occurs.
@@ -522,6 +526,279 @@ pop(oid x)
 	/* COMP   */	cmp(v, BUNtail(bi, hb)) == 0		\
 	)
 
+/* maximum number of bits used to select a spill partition */
+#define GRPSPILLBITS	8
+#define GRPSPILLMULT	((ulng) LL_CONSTANT(0x9E3779B97F4A7C15))
+
+/* Return the number of bits of the hash value to use for
+ * partitioning the input so that the hash table and group
+ * administration needed for each partition fit in the memory the
+ * query can still use, or 0 if the input fits as a whole. */
+static int
+GRPspillbits(BAT *b, BUN cnt, int extents, int histo)
+{
+	size_t need, avail;
+	int bits = 0;
+
+	/* hash table, groups, and (at most one entry per value)
+	 * extents and histo */
+	need = (size_t) (HASHmask(cnt) + BATcount(b)) * SIZEOF_BUN +
+		(size_t) cnt * sizeof(oid) * (1 + (extents != 0) + (histo != 0));
+	avail = GDKaccount_avail(GDKaccount_get());
+	while (bits < GRPSPILLBITS && (need >> bits) > avail / 2)
+		bits++;
+	return bits;
+}
+
+/* Group the input a partition at a time.
+ *
+ * In a first pass we determine the partition (the top bits of a hash
+ * over the value and its old group) of each input row.  In a second
+ * pass the oids of the rows in b, their position in the output, and
+ * their old group are scattered over temporary BATs, partition after
+ * partition.  These BATs are large and are memory mapped when there is
+ * little memory left, but they are written and read sequentially.
+ * Each partition is then projected out of b and grouped on its own,
+ * and its group ids are shifted beyond those of the partitions before
+ * it.  Finally, if the extents are requested, the groups are
+ * renumbered so that the extents are sorted like they are for the
+ * other grouping methods.
+ *
+ * Returns 1 if the grouping was done, 0 if partitioning does not help
+ * (all rows land in the same partition), and -1 on error. */
+static int
+GRPspill(BAT *gn, BAT *en, BAT *hn, oid *ngrpp, BAT *b, BUN start, BUN cnt,
+	 const oid *cand, const oid *grps, oid maxgrp, int bits)
+{
+	BUN (*hash)(const void *) = BATatoms[b->ttype].atomHash;
+	BATiter bi = bat_iterator(b);
+	BUN nparts = (BUN) 1 << bits;
+	BUN *pcnt, *pnxt;
+	BAT *po = NULL, *pr = NULL, *pg = NULL;
+	BAT *sk = NULL, *bk = NULL, *gk = NULL;
+	BAT *g2 = NULL, *e2 = NULL, *h2 = NULL;
+	oid *restrict ngrps = (oid *) Tloc(gn, 0);
+	oid *restrict o, *restrict rw, *restrict og = NULL;
+	oid ngrp = 0;
+	BUN k, r, p, i, lo, n, nk;
+	ulng v;
+
+#define GRPpartition(r, p)						\
+	(v = (ulng) (*hash)(BUNtail(bi, (p))),				\
+	 grps ? (v ^= (ulng) grps[r] * GRPSPILLMULT) : 0,		\
+	 (BUN) ((v * GRPSPILLMULT) >> (64 - bits)))
+
+	if ((pcnt = GDKzalloc(2 * nparts * sizeof(BUN))) == NULL)
+		return -1;
+	pnxt = pcnt + nparts;
+	for (r = 0; r < cnt; r++) {
+		p = cand ? cand[r] - b->hseqbase : start + r;
+		pcnt[GRPpartition(r, p)]++;
+	}
+	for (k = 0; k < nparts; k++) {
+		if (pcnt[k] == cnt) {
+			/* a single partition: no point */
+			GDKfree(pcnt);
+			return 0;
+		}
+	}
+	ALGODEBUG fprintf(stderr, "#BATgroup(b=%s#" BUNFMT "[%s]): "
+			  "partitioned spill into " BUNFMT " partitions\n",
+			  BATgetId(b), BATcount(b), ATOMname(b->ttype),
+			  nparts);
+
+	if ((po = COLnew(0, TYPE_oid, cnt, TRANSIENT)) == NULL ||
+	    (pr = COLnew(0, TYPE_oid, cnt, TRANSIENT)) == NULL ||
+	    (grps && (pg = COLnew(0, TYPE_oid, cnt, TRANSIENT)) == NULL))
+		goto bailout;
+	o = (oid *) Tloc(po, 0);
+	rw = (oid *) Tloc(pr, 0);
+	if (pg)
+		og = (oid *) Tloc(pg, 0);
+	for (k = 0, lo = 0; k < nparts; k++) {
+		pnxt[k] = lo;
+		lo += pcnt[k];
+	}
+	for (r = 0; r < cnt; r++) {
+		p = cand ? cand[r] - b->hseqbase : start + r;
+		k = GRPpartition(r, p);
+		i = pnxt[k]++;
+		o[i] = b->hseqbase + p;
+		rw[i] = r;
+		if (og)
+			og[i] = grps[r];
+	}
+#undef GRPpartition
+
+	for (k = 0, lo = 0; k < nparts; lo += pcnt[k], k++) {
+		if ((n = pcnt[k]) == 0)
+			continue;
+		if ((sk = COLnew(0, TYPE_oid, n, TRANSIENT)) == NULL)
+			goto bailout;
+		memcpy(Tloc(sk, 0), o + lo, n * sizeof(oid));
+		BATsetcount(sk, n);
+		sk->tsorted = 1;
+		sk->trevsorted = n <= 1;
+		sk->tkey = 1;
+		sk->tdense = 0;
+		sk->tnil = 0;
+		sk->tnonil = 1;
+		if ((bk = BATproject(sk, b)) == NULL)
+			goto bailout;
+		if (og) {
+			if ((gk = COLnew(0, TYPE_oid, n, TRANSIENT)) == NULL)
+				goto bailout;
+			memcpy(Tloc(gk, 0), og + lo, n * sizeof(oid));
+			BATsetcount(gk, n);
+			gk->tsorted = gk->trevsorted = gk->tkey = n <= 1;
+			gk->tdense = 0;
+			gk->tnil = 0;
+			gk->tnonil = 1;
+			if (maxgrp != oid_nil)
+				BATsetprop(gk, GDK_MAX_VALUE, TYPE_oid, &maxgrp);
+		}
+		if (BATgroup_internal(&g2, &e2, hn ? &h2 : NULL,
+				      bk, NULL, gk, NULL, NULL, 0) != GDK_SUCCEED)
+			goto bailout;
+		BBPunfix(bk->batCacheid);
+		bk = NULL;
+		if (gk) {
+			BBPunfix(gk->batCacheid);
+			gk = NULL;
+		}
+
+		/* new group ids follow those of earlier partitions */
+		if (BATtdense(g2)) {
+			for (i = 0; i < n; i++)
+				ngrps[rw[lo + i]] = ngrp + g2->tseqbase + i;
+		} else {
+			const oid *gv = (const oid *) Tloc(g2, 0);
+			for (i = 0; i < n; i++)
+				ngrps[rw[lo + i]] = ngrp + gv[i];
+		}
+		nk = BATcount(e2);
+		if (en) {
+			const oid *sv = (const oid *) Tloc(sk, 0);
+			oid *restrict exts;
+
+			/* only the first BATcount entries survive
+			 * a move of the heap */
+			BATsetcount(en, (BUN) ngrp);
+			if (ngrp + nk > BATcapacity(en) &&
+			    BATextend(en, ngrp + nk) != GDK_SUCCEED)
+				goto bailout;
+			exts = (oid *) Tloc(en, 0);
+			if (BATtdense(e2)) {
+				for (i = 0; i < nk; i++)
+					exts[ngrp + i] = sv[e2->tseqbase + i];
+			} else {
+				const oid *ev = (const oid *) Tloc(e2, 0);
+				for (i = 0; i < nk; i++)
+					exts[ngrp + i] = sv[ev[i]];
+			}
+		}
+		if (hn) {
+			BATsetcount(hn, (BUN) ngrp);
+			if (ngrp + nk > BATcapacity(hn) &&
+			    BATextend(hn, ngrp + nk) != GDK_SUCCEED)
+				goto bailout;
+			memcpy((lng *) Tloc(hn, 0) + ngrp, Tloc(h2, 0),
+			       nk * sizeof(lng));
+			BBPunfix(h2->batCacheid);
+			h2 = NULL;
+		}
+		ngrp += nk;
+		BBPunfix(sk->batCacheid);
+		BBPunfix(g2->batCacheid);
+		BBPunfix(e2->batCacheid);
+		sk = g2 = e2 = NULL;
+	}
+	BBPunfix(po->batCacheid);
+	BBPunfix(pr->batCacheid);
+	if (pg)
+		BBPunfix(pg->batCacheid);
+	po = pr = pg = NULL;
+	GDKfree(pcnt);
+	pcnt = NULL;
+
+	if (en && ngrp > 1) {
+		/* renumber the groups in order of their first
+		 * occurrence, so that the extents are sorted */
+		BAT *ord, *srt;
+		oid *restrict map;
+		const oid *ov;
+
+		BATsetcount(en, (BUN) ngrp);
+		en->tsorted = en->trevsorted = 0;
+		en->tkey = 1;
+		en->tnil = 0;
+		en->tnonil = 1;
+		if (BATsort(&srt, &ord, NULL, en, NULL, NULL, 0, 0) != GDK_SUCCEED)
+			goto bailout;
+		if (!BATtdense(ord)) {
+			ov = (const oid *) Tloc(ord, 0);
+			if ((map = GDKmalloc(ngrp * sizeof(oid))) == NULL) {
+				BBPunfix(srt->batCacheid);
+				BBPunfix(ord->batCacheid);
+				goto bailout;
+			}
+			for (i = 0; i < ngrp; i++)
+				map[ov[i]] = i;
+			for (r = 0; r < cnt; r++)
+				ngrps[r] = map[ngrps[r]];
+			GDKfree(map);
+			if (BATtdense(srt)) {
+				oid *restrict exts = (oid *) Tloc(en, 0);
+
+				for (i = 0; i < ngrp; i++)
+					exts[i] = srt->tseqbase + i;
+			} else {
+				memcpy(Tloc(en, 0), Tloc(srt, 0), ngrp * sizeof(oid));
+			}
+			if (hn) {
+				lng *restrict cnts = (lng *) Tloc(hn, 0);
+				lng *restrict tmp = GDKmalloc(ngrp * sizeof(lng));
+
+				if (tmp == NULL) {
+					BBPunfix(srt->batCacheid);
+					BBPunfix(ord->batCacheid);
+					goto bailout;
+				}
+				for (i = 0; i < ngrp; i++)
+					tmp[i] = cnts[ov[i]];
+				memcpy(cnts, tmp, ngrp * sizeof(lng));
+				GDKfree(tmp);
+			}
+		}
+		BBPunfix(srt->batCacheid);
+		BBPunfix(ord->batCacheid);
+	}
+	gn->tsorted = ngrp <= 1;
+	*ngrpp = ngrp;
+	return 1;
+
+  bailout:
+	GDKfree(pcnt);
+	if (po)
+		BBPunfix(po->batCacheid);
+	if (pr)
+		BBPunfix(pr->batCacheid);
+	if (pg)
+		BBPunfix(pg->batCacheid);
+	if (sk)
+		BBPunfix(sk->batCacheid);
+	if (bk)
+		BBPunfix(bk->batCacheid);
+	if (gk)
+		BBPunfix(gk->batCacheid);
+	if (g2)
+		BBPunfix(g2->batCacheid);
+	if (e2)
+		BBPunfix(e2->batCacheid);
+	if (h2)
+		BBPunfix(h2->batCacheid);
+	return -1;
+}
 
 gdk_return
 BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
@@ -541,6 +818,7 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 	Hash *hs = NULL;
 	BUN hb;
 	BUN maxgrps;
+	int spill, spillbits;
 #ifndef DISABLE_PARENT_HASH
 	bat parent;
 #endif
@@ -1070,6 +1348,14 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 			GRP_use_existing_hash_table_any();
 			break;
 		}
+	} else if (cnt > GROUPBATINCR &&
+		   (spillbits = GRPspillbits(b, cnt, extents != NULL, histo != NULL)) > 0 &&
+		   (spill = GRPspill(gn, extents ? en : NULL, histo ? hn : NULL,
+				     &ngrp, b, start, cnt, cand, grps, maxgrp,
+				     spillbits)) != 0) {
+		/* grouped partition by partition */
+		if (spill < 0)
+			goto error;
 	} else {
 		bit gc = g && (BATordered(g) || BATordered_rev(g));
 		const char *nme;
@@ -1082,6 +1368,10 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 
 		GDKclrerr();	/* not interested in BAThash errors */
 
+		/* if b is a persistent column, have a hash table
+		 * built for the groupings that follow */
+		BAThashbackground(b);
+
 		/* not sorted, and no pre-existing hash table: we'll
 		 * build an incomplete hash table on the fly--also see
 		 * BATassertProps for similar code; we also exploit if
@@ -157,6 +157,168 @@ HASHnew(Heap *hp, int tpe, BUN size, BUN mask, BUN count)
 		}						\
 	} while (0)
 
+/* Hash tables on at least this many values are finished in
+ * parallel.  The BUNs are split into one chunk per thread, and the
+ * buckets into as many ranges.  First each thread computes the hash
+ * values of its chunk and counts how many fall into each range.
+ * Then each thread places the positions of its chunk in a list
+ * ordered by range, and within a range by position.  Finally each
+ * thread links the BUNs of its own range of buckets.  Since those are
+ * visited in order, the collision lists come out exactly as they do
+ * in the serial build. */
+#define HASH_PAR_MINSIZE	((BUN) 1 << 20)
+
+struct hashtask {
+	BAT *b;
+	Hash *h;		/* hash table being built */
+	Hash *hv;		/* hash values of BUNs [p, q) */
+	int tpe;
+	int i, n;		/* this is chunk and range i of n */
+	BUN p;			/* first BUN to be entered */
+	BUN start, end;		/* chunk of BUNs */
+	BUN per;		/* buckets per range (the last takes the rest) */
+	BUN *cnt;		/* per chunk and range: count, then position */
+	BUN *idx;		/* BUNs ordered by range */
+	BUN lo, hi;		/* part of idx of this range */
+};
+
+#define hashrange(t, c)	((c) / (t)->per < (BUN) (t)->n ? (int) ((c) / (t)->per) : (t)->n - 1)
+
+#define computehash(TYPE)						\
+	do {								\
+		const TYPE *v = (const TYPE *) Tloc(t->b, 0);		\
+		for (i = t->start; i < t->end; i++)			\
+			HASHputlink(t->hv, i - t->p, hash_##TYPE(t->h, v + i)); \
+	} while (0)
+
+static void
+HASHcompute(void *arg)
+{
+	struct hashtask *t = arg;
+	BATiter bi = bat_iterator(t->b);
+	BUN i, *cnt = t->cnt + (size_t) t->i * t->n;
+
+	switch (t->tpe) {
+	case TYPE_bte:
+		computehash(bte);
+		break;
+	case TYPE_sht:
+		computehash(sht);
+		break;
+	case TYPE_int:
+		computehash(int);
+		break;
+	case TYPE_flt:
+		computehash(flt);
+		break;
+	case TYPE_dbl:
+		computehash(dbl);
+		break;
+	case TYPE_lng:
+		computehash(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		computehash(hge);
+		break;
+#endif
+	default:
+		for (i = t->start; i < t->end; i++) {
+			ptr v = BUNtail(bi, i);
+			HASHputlink(t->hv, i - t->p, heap_hash_any(t->b->tvheap, t->h, v));
+		}
+		break;
+	}
+	for (i = t->start; i < t->end; i++)
+		cnt[hashrange(t, HASHgetlink(t->hv, i - t->p))]++;
+}
+
+static void
+HASHscatter(void *arg)
+{
+	struct hashtask *t = arg;
+	BUN i, *pos = t->cnt + (size_t) t->i * t->n;
+
+	for (i = t->start; i < t->end; i++)
+		t->idx[pos[hashrange(t, HASHgetlink(t->hv, i - t->p))]++] = i;
+}
+
+static void
+HASHlinkrange(void *arg)
+{
+	struct hashtask *t = arg;
+	BUN k, i;
+
+	for (k = t->lo; k < t->hi; k++) {
+		i = t->idx[k];
+		HASHputall(t->h, i, HASHgetlink(t->hv, i - t->p));
+	}
+}
+
+/* Enter BUNs [p, q) of b into the hash table h using multiple
+ * threads.  The bucket numbers are kept in a temporary array of the
+ * same width as the hash table's link array; they fit since they
+ * never exceed the mask. */
+static gdk_return
+HASHfinishparallel(BAT *b, Hash *h, int tpe, BUN p, BUN q)
+{
+	struct hashtask *tasks;
+	Hash hv;
+	BUN *cnt, *idx, c, tot;
+	int i, r, n = GDKnr_threads;
+	BUN nbuckets = h->mask + 1;
+
+	assert(n > 1);
+	assert(tpe != TYPE_void);
+	hv.width = h->width;
+	hv.Link = GDKmalloc((size_t) (q - p) * h->width);
+	idx = GDKmalloc((size_t) (q - p) * sizeof(BUN));
+	cnt = GDKzalloc((size_t) n * n * sizeof(BUN));
+	tasks = GDKmalloc(n * sizeof(struct hashtask));
+	if (hv.Link == NULL || idx == NULL || cnt == NULL || tasks == NULL) {
+		GDKfree(hv.Link);
+		GDKfree(idx);
+		GDKfree(cnt);
+		GDKfree(tasks);
+		return GDK_FAIL;
+	}
+	for (i = 0; i < n; i++) {
+		tasks[i].b = b;
+		tasks[i].h = h;
+		tasks[i].hv = &hv;
+		tasks[i].tpe = tpe;
+		tasks[i].i = i;
+		tasks[i].n = n;
+		tasks[i].p = p;
+		tasks[i].start = p + (q - p) / n * i;
+		tasks[i].end = i == n - 1 ? q : p + (q - p) / n * (i + 1);
+		tasks[i].per = nbuckets / n > 0 ? nbuckets / n : 1;
+		tasks[i].cnt = cnt;
+		tasks[i].idx = idx;
+	}
+	GDKparallel(n, HASHcompute, tasks, sizeof(struct hashtask));
+	/* turn the counts into positions: range by range, and within
+	 * a range chunk by chunk */
+	for (r = 0, tot = 0; r < n; r++) {
+		tasks[r].lo = tot;
+		for (i = 0; i < n; i++) {
+			c = cnt[(size_t) i * n + r];
+			cnt[(size_t) i * n + r] = tot;
+			tot += c;
+		}
+		tasks[r].hi = tot;
+	}
+	assert(tot == q - p);
+	GDKparallel(n, HASHscatter, tasks, sizeof(struct hashtask));
+	GDKparallel(n, HASHlinkrange, tasks, sizeof(struct hashtask));
+	GDKfree(hv.Link);
+	GDKfree(idx);
+	GDKfree(cnt);
+	GDKfree(tasks);
+	ALGODEBUG fprintf(stderr, "#BAThash: parallel construction of " BUNFMT " entries using %d threads\n", q - p, n);
+	return GDK_SUCCEED;
+}
+
 /* collect HASH statistics for analysis */
 static void
 HASHcollisions(BAT *b, Hash *h)
@@ -461,6 +623,13 @@ BAThash(BAT *b, BUN masksize)
 
 		/* finish the hashtable with the current mask */
 		p = r;
+		if (q - p >= HASH_PAR_MINSIZE && GDKnr_threads > 1 &&
+		    tpe != TYPE_void) {
+			if (HASHfinishparallel(b, h, tpe, p, q) == GDK_SUCCEED)
+				p = q;
+			else
+				GDKclrerr(); /* fall back to serial build */
+		}
 		switch (tpe) {
 		case TYPE_bte:
 			finishhash(bte);
@@ -529,6 +698,123 @@ BAThash(BAT *b, BUN masksize)
 	return GDK_SUCCEED;
 }
 
+/*
+ * A hash table on a persistent column pays off over many queries,
+ * but an operator that can do without one should not have to wait
+ * for it.  BAThashbackground starts building the hash table in a
+ * separate thread; later operators find it through BATcheckhash, or
+ * inherit it when they create a view on the column.  If b is a view
+ * that covers all of a persistent parent, the hash is built on the
+ * parent.  At most HASHBG_MAX builds are in progress at any time,
+ * and a BAT that is already being built for is skipped.
+ *
+ * The builder is a registered GDK thread, and like the other
+ * detached threads it is joined when the server shuts down.  A BAT
+ * must not be modified while its hash is being built, so the
+ * functions that change a BAT first call HASHwaitbackground, which
+ * returns as soon as no build on that BAT is in progress.
+ */
+#define HASHBG_MAX	8
+
+static MT_Lock hashbglock MT_LOCK_INITIALIZER("hashbglock");
+static bat hashbgbats[HASHBG_MAX];
+static volatile int hashbgcount; /* protected by hashbglock */
+
+static void
+BAThashbuilder(void *arg)
+{
+	bat *slot = arg;
+	bat bid = *slot;
+	BAT *b;
+	Thread thr;
+	lng t0 = 0;
+
+	thr = THRnew("BAThashbuilder");
+	ALGODEBUG t0 = GDKusec();
+	if (!GDKexiting() &&
+	    (b = BBP_cache(bid)) != NULL && BAThash(b, 0) != GDK_SUCCEED)
+		GDKclrerr();
+	ALGODEBUG fprintf(stderr, "#BAThashbackground: built hash on %d (" LLFMT " usec)\n", bid, GDKusec() - t0);
+	MT_lock_set(&hashbglock);
+	*slot = 0;
+	hashbgcount--;
+	MT_lock_unset(&hashbglock);
+	BBPunfix(bid);
+	if (thr)
+		THRdel(thr);
+}
+
+void
+BAThashbackground(BAT *b)
+{
+	MT_Id tid;
+	int i, slot = -1;
+
+	if (b->batPersistence != PERSISTENT) {
+		BAT *pb;
+
+		if (VIEWtparent(b) == 0 ||
+		    (pb = BBP_cache(VIEWtparent(b))) == NULL ||
+		    pb->batPersistence != PERSISTENT ||
+		    pb->theap.base != b->theap.base ||
+		    BATcount(pb) != BATcount(b))
+			return;
+		b = pb;
+	}
+	if (GDKnr_threads <= 1 || b->thash != NULL || BATtvoid(b) ||
+	    BATcount(b) < HASH_PAR_MINSIZE ||
+	    (BBP_status(b->batCacheid) & BBPEXISTING) == 0 ||
+	    GDKexiting())
+		return;
+	MT_lock_set(&hashbglock);
+	for (i = 0; i < HASHBG_MAX; i++) {
+		if (hashbgbats[i] == b->batCacheid) {
+			MT_lock_unset(&hashbglock);
+			return;
+		}
+		if (hashbgbats[i] == 0 && slot < 0)
+			slot = i;
+	}
+	if (slot < 0) {
+		MT_lock_unset(&hashbglock);
+		return;
+	}
+	hashbgbats[slot] = b->batCacheid;
+	hashbgcount++;
+	MT_lock_unset(&hashbglock);
+	BBPfix(b->batCacheid);
+	ALGODEBUG fprintf(stderr, "#BAThashbackground: start building hash on %s#" BUNFMT "\n", BATgetId(b), BATcount(b));
+	if (MT_create_thread(&tid, BAThashbuilder, &hashbgbats[slot],
+			     MT_THR_DETACHED) < 0) {
+		/* couldn't start thread: clean up */
+		MT_lock_set(&hashbglock);
+		hashbgbats[slot] = 0;
+		hashbgcount--;
+		MT_lock_unset(&hashbglock);
+		BBPunfix(b->batCacheid);
+	}
+}
+
+void
+HASHwaitbackground(BAT *b)
+{
+	int i, busy;
+
+	if (hashbgcount == 0)
+		return;
+	for (;;) {
+		busy = 0;
+		MT_lock_set(&hashbglock);
+		for (i = 0; i < HASHBG_MAX; i++)
+			if (hashbgbats[i] == b->batCacheid)
+				busy = 1;
+		MT_lock_unset(&hashbglock);
+		if (!busy)
+			return;
+		MT_sleep_ms(1);
+	}
+}
+
 /*
  * The entry on which a value hashes can be calculated with the
  * routine HASHprobe.
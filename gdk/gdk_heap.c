@@ -87,6 +87,8 @@ decompose_filename(str nme)
 gdk_return
 HEAPalloc(Heap *h, size_t nitems, size_t itemsize)
 {
+	int spill;
+
 	h->base = NULL;
 	h->size = 1;
 	h->copied = 0;
@@ -94,18 +96,27 @@ HEAPalloc(Heap *h, size_t nitems, size_t itemsize)
 		h->size = MAX(1, nitems) * itemsize;
 	h->free = 0;
 	h->cleanhash = 0;
+	h->acct = GDKaccount_get();
 
 	/* check for overflow */
 	if (itemsize && nitems > (h->size / itemsize)) {
 		GDKerror("HEAPalloc: allocating more than heap can accomodate\n");
 		return GDK_FAIL;
 	}
+	/* a query over its memory budget spills to memory mapped
+	 * files */
+	spill = GDKaccount_check(h->acct, h->size);
 	if (h->filename == NULL ||
 	    h->size < 4 * GDK_mmap_pagesize ||
-	    (GDKmem_cursize() + h->size < GDK_mem_maxsize &&
+	    (!spill &&
+	     GDKmem_cursize() + h->size < GDK_mem_maxsize &&
 	     h->size < (h->farmid == 0 ? GDK_mmap_minsize_persistent : GDK_mmap_minsize_transient))) {
 		h->storage = STORE_MEM;
+		/* the heap as a whole is charged to its account below,
+		 * not by GDKmalloc */
+		GDKaccount_set(0);
 		h->base = (char *) GDKmalloc(h->size);
+		GDKaccount_set(h->acct);
 		HEAPDEBUG fprintf(stderr, "#HEAPalloc " SZFMT " " PTRFMT "\n", h->size, PTRFMTCAST h->base);
 	}
 	if (h->filename && h->base == NULL) {
@@ -142,6 +153,7 @@ HEAPalloc(Heap *h, size_t nitems, size_t itemsize)
 		return GDK_FAIL;
 	}
 	h->newstorage = h->storage;
+	GDKaccount_charge(h->acct, (ssize_t) h->size);
 	return GDK_SUCCEED;
 }
 
@@ -199,6 +211,7 @@ HEAPextend(Heap *h, size_t size, int mayshare)
 			      h->base, h->size, &size);
 		GDKfree(path);
 		if (p) {
+			GDKaccount_charge(h->acct, (ssize_t) (size - h->size));
 			h->size = size;
 			h->base = p;
  			return GDK_SUCCEED; /* success */
@@ -209,7 +222,8 @@ HEAPextend(Heap *h, size_t size, int mayshare)
 		 * file-mapped storage */
 		Heap bak = *h;
 		int exceeds_swap = size >= 4 * GDK_mmap_pagesize && size + GDKmem_cursize() >= GDK_mem_maxsize;
-		int must_mmap = h->filename != NULL && (exceeds_swap || h->newstorage != STORE_MEM || size >= (h->farmid == 0 ? GDK_mmap_minsize_persistent : GDK_mmap_minsize_transient));
+		int spill = GDKaccount_check(h->acct, size - h->size);
+		int must_mmap = h->filename != NULL && (exceeds_swap || spill || h->newstorage != STORE_MEM || size >= (h->farmid == 0 ? GDK_mmap_minsize_persistent : GDK_mmap_minsize_transient));
 
 		h->size = size;
 
@@ -220,8 +234,10 @@ HEAPextend(Heap *h, size_t size, int mayshare)
 			h->base = GDKrealloc(h->base, size);
 			HEAPDEBUG fprintf(stderr, "#HEAPextend: extending malloced heap " SZFMT " " SZFMT " " PTRFMT " " PTRFMT "\n", size, h->size, PTRFMTCAST bak.base, PTRFMTCAST h->base);
 			h->size = size;
-			if (h->base)
+			if (h->base) {
+				GDKaccount_charge(h->acct, (ssize_t) (size - bak.size));
 				return GDK_SUCCEED; /* success */
+			}
 			/* bak.base is still valid and may get restored */
 			failure = "h->storage == STORE_MEM && !must_map && !h->base";
 		}
@@ -256,6 +272,7 @@ HEAPextend(Heap *h, size_t size, int mayshare)
 					h->newstorage = h->storage = STORE_MMAP;
 					memcpy(h->base, bak.base, bak.free);
 					HEAPfree(&bak, 0);
+					GDKaccount_charge(h->acct, (ssize_t) h->size);
 					return GDK_SUCCEED;
 				}
 			}
@@ -278,6 +295,7 @@ HEAPextend(Heap *h, size_t size, int mayshare)
 					 * old memory */
 					memcpy(h->base, bak.base, bak.free);
 					HEAPfree(&bak, 0);
+					GDKaccount_charge(h->acct, (ssize_t) h->size);
 					return GDK_SUCCEED;
 				}
 				failure = "h->storage == STORE_MEM && can_map && fd >= 0 && HEAPload() != GDK_SUCCEED";
@@ -294,6 +312,7 @@ HEAPextend(Heap *h, size_t size, int mayshare)
 				if (HEAPload_intern(h, nme, ext, ".tmp", FALSE) == GDK_SUCCEED) {
 					/* success! */
 					GDKclrerr();	/* don't leak errors from e.g. HEAPload */
+					GDKaccount_charge(h->acct, (ssize_t) h->size);
 					return GDK_SUCCEED;
 				}
 				failure = "h->storage == STORE_MEM && can_map && fd >= 0 && HEAPload_intern() != GDK_SUCCEED";
@@ -359,6 +378,7 @@ HEAPshrink(Heap *h, size_t size)
 				  PTRFMTCAST h->base, PTRFMTCAST p);
 	}
 	if (p) {
+		GDKaccount_charge(h->acct, -(ssize_t) (h->size - size));
 		h->size = size;
 		h->base = p;
 		return GDK_SUCCEED;
@@ -601,6 +621,9 @@ HEAPfree(Heap *h, int remove)
 		h->filename = NULL;
 	}
 #endif
+	if (h->base)
+		GDKaccount_charge(h->acct, -(ssize_t) h->size);
+	h->acct = 0;
 	h->base = NULL;
 	if (h->filename) {
 		if (remove) {
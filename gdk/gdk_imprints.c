@@ -41,14 +41,32 @@ do {					\
 } while (0)
 
 
-#define IMPS_CREATE(TYPE,B)						\
+/* Strings are binned on an order-preserving integer key made from
+ * their first eight bytes: if IMPSstrkey(x) < IMPSstrkey(y) then x <
+ * y.  The sign bit is flipped so that the keys can be handled as
+ * lng.  Nil (and the empty string) map onto the smallest key. */
+static inline lng
+IMPSstrkey(const char *v)
+{
+	ulng k = 0;
+	int i;
+
+	if (GDK_STRNIL(v))
+		return lng_nil;
+	for (i = 0; i < 8 && v[i]; i++)
+		k |= (ulng) (unsigned char) v[i] << (56 - 8 * i);
+	return (lng) (k ^ ((ulng) 1 << 63));
+}
+
+/* VAL(i) is the value that is binned for BUN i, ISNIL(i) tells
+ * whether BUN i is nil, and LT(i,j) whether BUN i is smaller than BUN
+ * j (used for the per bin min/max statistics) */
+#define IMPS_CREATE_LOOP(TYPE,B,PAGE,VAL,ISNIL,LT)			\
 do {									\
 	uint##B##_t mask, prvmask;					\
 	uint##B##_t *restrict im = (uint##B##_t *) imps;		\
-	const TYPE *restrict col = (TYPE *) Tloc(b, 0);			\
 	const TYPE *restrict bins = (TYPE *) inbins;			\
-	const TYPE nil = TYPE##_nil;					\
-	const BUN page = IMPS_PAGE / sizeof(TYPE);			\
+	const BUN page = (PAGE);					\
 	prvmask = 0;							\
 	for (i = 0; i < b->batCount; ) {				\
 		const BUN lim = MIN(i + page, b->batCount);		\
@@ -56,16 +74,16 @@ do {									\
 		mask = 0;						\
 		/* build mask for all BUNs in one PAGE */		\
 		for ( ; i < lim; i++) {					\
-			register const TYPE val = col[i];		\
+			register const TYPE val = VAL(i);		\
 			GETBIN(bin,val,B);				\
 			mask = IMPSsetBit(B,mask,bin);			\
-			if (val != nil) { /* do not count nils */	\
+			if (!ISNIL(i)) { /* do not count nils */	\
 				if (!cnt_bins[bin]++) {			\
 					min_bins[bin] = max_bins[bin] = i;\
 				} else {				\
-					if (val < col[min_bins[bin]])	\
+					if (LT(i, min_bins[bin]))	\
 						min_bins[bin] = i;	\
-					if (val > col[max_bins[bin]])	\
+					if (LT(max_bins[bin], i))	\
 						max_bins[bin] = i;	\
 				}					\
 			}						\
@@ -106,6 +124,27 @@ do {									\
 	}								\
 } while (0)
 
+#define COLVAL(i)	col[i]
+#define COLNIL(i)	(col[i] == nil)
+#define COLLT(i, j)	(col[i] < col[j])
+#define IMPS_CREATE(TYPE,B)						\
+do {									\
+	const TYPE *restrict col = (TYPE *) Tloc(b, 0);			\
+	const TYPE nil = TYPE##_nil;					\
+	IMPS_CREATE_LOOP(TYPE, B, IMPS_PAGE / sizeof(TYPE),		\
+			 COLVAL, COLNIL, COLLT);			\
+} while (0)
+
+#define STRVAL(i)	IMPSstrkey(BUNtvar(bi, i))
+#define STRNIL(i)	GDK_STRNIL(BUNtvar(bi, i))
+#define STRLT(i, j)	(GDK_STRCMP(BUNtvar(bi, i), BUNtvar(bi, j)) < 0)
+#define IMPS_CREATE_STR(TYPE,B)						\
+do {									\
+	BATiter bi = bat_iterator(b);					\
+	IMPS_CREATE_LOOP(TYPE, B, IMPS_PAGE >> b->tshift,		\
+			 STRVAL, STRNIL, STRLT);			\
+} while (0)
+
 static void
 imprints_create(BAT *b, void *inbins, BUN *stats, bte bits,
 		void *imps, BUN *impcnt, cchdc_t *dict, BUN *dictcnt)
@@ -147,6 +186,9 @@ imprints_create(BAT *b, void *inbins, BUN *stats, bte bits,
 	case TYPE_dbl:
 		BINSIZE(bits, IMPS_CREATE, dbl);
 		break;
+	case TYPE_str:
+		BINSIZE(bits, IMPS_CREATE_STR, lng);
+		break;
 	default:
 		/* should never reach here */
 		assert(0);
@@ -183,6 +225,37 @@ do {									\
 	}								\
 } while (0)
 
+/* Return a BAT with the keys (see IMPSstrkey) of the strings of b
+ * at the positions listed in candidate list s. */
+static BAT *
+IMPSstrkeys(BAT *b, BAT *s)
+{
+	BAT *bn;
+	BATiter bi = bat_iterator(b);
+	const oid *restrict cand = NULL;
+	lng *restrict keys;
+	BUN i, n = BATcount(s);
+	oid o = s->tseqbase;
+
+	if (!BATtdense(s))
+		cand = (const oid *) Tloc(s, 0);
+	if ((bn = COLnew(0, TYPE_lng, n, TRANSIENT)) == NULL)
+		return NULL;
+	keys = (lng *) Tloc(bn, 0);
+	for (i = 0; i < n; i++) {
+		if (cand)
+			o = cand[i];
+		keys[i] = IMPSstrkey(BUNtvar(bi, o - b->hseqbase));
+		o++;
+	}
+	BATsetcount(bn, n);
+	bn->tsorted = bn->trevsorted = n <= 1;
+	bn->tkey = n <= 1;
+	bn->tnonil = 0;
+	bn->tnil = 0;
+	return bn;
+}
+
 /* Check whether we have imprints on b (and return true if we do).  It
  * may be that the imprints were made persistent, but we hadn't seen
  * that yet, so check the file system.  This also returns true if b is
@@ -232,7 +305,7 @@ BATcheckimprints(BAT *b)
 				    fstat(fd, &st) == 0 &&
 				    st.st_size >= (off_t) (hp->size =
 							   hp->free =
-							   64 * b->twidth +
+							   64 * IMPSbinwidth(b) +
 							   64 * 2 * SIZEOF_OID +
 							   64 * SIZEOF_BUN +
 							   pages * ((bte) hdata[0] / 8) +
@@ -246,7 +319,7 @@ BATcheckimprints(BAT *b)
 					imprints->impcnt = (BUN) hdata[1];
 					imprints->dictcnt = (BUN) hdata[2];
 					imprints->bins = hp->base + 4 * SIZEOF_SIZE_T;
-					imprints->stats = (BUN *) ((char *) imprints->bins + 64 * b->twidth);
+					imprints->stats = (BUN *) ((char *) imprints->bins + 64 * IMPSbinwidth(b));
 					imprints->imps = (void *) (imprints->stats + 64 * 3);
 					imprints->dict = (void *) ((uintptr_t) ((char *) imprints->imps + pages * (imprints->bits / 8) + sizeof(uint64_t)) & ~(sizeof(uint64_t) - 1));
 					close(fd);
@@ -292,6 +365,12 @@ BATimprints(BAT *b)
 	case TYPE_flt:
 	case TYPE_dbl:
 		break;
+	case TYPE_str:
+		/* only plain strings: other types stored as strings
+		 * have their own ordering */
+		if (b->ttype == TYPE_str)
+			break;
+		/* fall through */
 	default:		/* type not supported */
 		/* doesn't look enough like base type: do nothing */
 		GDKerror("BATimprints: unsupported type\n");
@@ -346,6 +425,13 @@ BATimprints(BAT *b)
 
 #define SMP_SIZE 2048
 		s1 = BATsample(b, SMP_SIZE);
+		if (s1 != NULL && b->ttype == TYPE_str) {
+			/* continue with the keys of the sampled
+			 * strings rather than with the strings */
+			BAT *k = IMPSstrkeys(b, s1);
+			BBPunfix(s1->batCacheid);
+			s1 = k;
+		}
 		if (s1 == NULL) {
 			MT_lock_unset(&GDKimprintsLock(b->batCacheid));
 			GDKfree(imprints->imprints->filename);
@@ -353,7 +439,7 @@ BATimprints(BAT *b)
 			GDKfree(imprints);
 			return GDK_FAIL;
 		}
-		s2 = BATunique(b, s1);
+		s2 = b->ttype == TYPE_str ? BATunique(s1, NULL) : BATunique(b, s1);
 		if (s2 == NULL) {
 			MT_lock_unset(&GDKimprintsLock(b->batCacheid));
 			BBPunfix(s1->batCacheid);
@@ -362,7 +448,7 @@ BATimprints(BAT *b)
 			GDKfree(imprints);
 			return GDK_FAIL;
 		}
-		s3 = BATproject(s2, b);
+		s3 = BATproject(s2, b->ttype == TYPE_str ? s1 : b);
 		if (s3 == NULL) {
 			MT_lock_unset(&GDKimprintsLock(b->batCacheid));
 			BBPunfix(s1->batCacheid);
@@ -405,7 +491,7 @@ BATimprints(BAT *b)
 		 * a version number -- CURRENT VERSION is 2). */
 		if (HEAPalloc(imprints->imprints,
 			      IMPRINTS_HEADER_SIZE * SIZEOF_SIZE_T + /* extra info */
-			      64 * b->twidth + /* bins */
+			      64 * IMPSbinwidth(b) + /* bins */
 			      64 * 2 * SIZEOF_OID + /* {min,max}_bins */
 			      64 * SIZEOF_BUN +	    /* cnt_bins */
 			      pages * (imprints->bits / 8) + /* imps */
@@ -424,7 +510,7 @@ BATimprints(BAT *b)
 			return GDK_FAIL;
 		}
 		imprints->bins = imprints->imprints->base + IMPRINTS_HEADER_SIZE * SIZEOF_SIZE_T;
-		imprints->stats = (BUN *) ((char *) imprints->bins + 64 * b->twidth);
+		imprints->stats = (BUN *) ((char *) imprints->bins + 64 * IMPSbinwidth(b));
 		imprints->imps = (void *) (imprints->stats + 64 * 3);
 		imprints->dict = (void *) ((uintptr_t) ((char *) imprints->imps + pages * (imprints->bits / 8) + sizeof(uint64_t)) & ~(sizeof(uint64_t) - 1));
 
@@ -452,6 +538,9 @@ BATimprints(BAT *b)
 		case TYPE_dbl:
 			FILL_HISTOGRAM(dbl);
 			break;
+		case TYPE_str:
+			FILL_HISTOGRAM(lng);
+			break;
 		default:
 			/* should never reach here */
 			assert(0);
@@ -522,6 +611,8 @@ do {						\
 	GETBIN(ret,val,B);			\
 } while (0)
 
+#define getbinkey(TYPE,B)	GETBIN(ret,key,B)
+
 int
 IMPSgetbin(int tpe, bte bits, const char *restrict inbins, const void *restrict v)
 {
@@ -572,6 +663,13 @@ IMPSgetbin(int tpe, bte bits, const char *restrict inbins, const void *restrict
 		BINSIZE(bits, getbin, dbl);
 	}
 		break;
+	case TYPE_str:
+	{
+		const lng *restrict bins = (lng *) inbins;
+		const lng key = IMPSstrkey(v);
+		BINSIZE(bits, getbinkey, lng);
+	}
+		break;
 	default:
 		assert(0);
 		(void) inbins;
@@ -22,6 +22,9 @@ typedef struct {
 #define IMPS_MAX_CNT	((1 << 24) - 1)		/* 24 one bits */
 #define IMPS_PAGE	64
 
+/* width of the bin boundaries: string imprints bin on lng keys */
+#define IMPSbinwidth(b)	((b)->ttype == TYPE_str ? (int) sizeof(lng) : (b)->twidth)
+
 /* auxiliary macros */
 #define IMPSsetBit(B, X, Y)	((X) | ((uint##B##_t) 1 << (Y)))
 #define IMPSunsetBit(B, X, Y)	((X) & ~((uint##B##_t) 1 << (Y)))
@@ -2866,6 +2866,551 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int nil_matches,
 	return GDK_FAIL;
 }
 
+/* Radix-partitioned hash join.
+ *
+ * Once the right (inner) input of a hash join is much larger than the
+ * CPU caches, practically every probe into a hash table that covers
+ * the whole of it is a cache miss.  Instead, we copy both inputs into
+ * partitions based on the top bits of a hash of the values, choosing
+ * the number of partitions such that the right part of a partition
+ * (and the small hash table we build over it) fits in the cache.  The
+ * partitions are then joined independently and in parallel.  In the
+ * end the results are scattered into the output in the order of the
+ * left input, so the result looks just like what hashjoin produces.
+ *
+ * This is only done for fixed-sized integer types since for those we
+ * can hash and compare the bit patterns of the values. */
+
+#define RADIX_PART_SIZE	((size_t) 1 << 18) /* target size of a right partition */
+#define RADIX_MIN_SIZE	((size_t) 1 << 23) /* minimum size of right input */
+#define RADIX_MAX_BITS	12		   /* at most 4096 partitions */
+#define RADIX_MIN_CHUNK	((BUN) 1 << 16)	   /* minimum chunk per thread */
+
+#define RADIX_MULT	((ulng) LL_CONSTANT(0x9E3779B97F4A7C15))
+#define RADIXHASH4(v)	((ulng) (v) * RADIX_MULT)
+#define RADIXHASH8(v)	((ulng) (v) * RADIX_MULT)
+#ifdef HAVE_HGE
+#define RADIXHASH16(v)	((ulng) ((v) ^ ((v) >> 64)) * RADIX_MULT)
+#endif
+#define RADIXPART(h, bits)	((BUN) ((h) >> (64 - (bits))))
+
+/* a chunk of one of the inputs that is to be partitioned */
+struct radixchunk {
+	const void *vals;	/* values of the input BAT */
+	const oid *cand;	/* candidate list (or NULL) */
+	BUN off;		/* first BUN if there is no candidate list */
+	oid seq;		/* hseqbase of the input BAT */
+	BUN lo, hi;		/* range of the chunk (index into cand) */
+	int width;		/* width of the values */
+	int bits;		/* number of radix bits */
+	int keepnil;		/* whether nil values take part */
+	int storeoid;		/* store oid (right) or index (left) */
+	const void *nil;
+	BUN *hist;		/* counts, later offsets per partition */
+	void *pvals;		/* partitioned values */
+	oid *poids;		/* partitioned oids/indexes */
+	int scatter;		/* 0: count, 1: scatter */
+};
+
+#define RADIXCHUNK(TYPE, WIDTH)						\
+	do {								\
+		const TYPE *restrict vals = c->vals;			\
+		const TYPE nil = *(const TYPE *) c->nil;		\
+		TYPE *restrict pvals = c->pvals;			\
+		BUN *restrict hist = c->hist;				\
+		BUN i, p;						\
+		oid o;							\
+		TYPE v;							\
+									\
+		for (i = c->lo; i < c->hi; i++) {			\
+			if (c->cand) {					\
+				o = c->cand[i];				\
+				v = vals[o - c->seq];			\
+			} else {					\
+				o = c->seq + c->off + i;		\
+				v = vals[c->off + i];			\
+			}						\
+			if (!c->keepnil && v == nil)			\
+				continue;				\
+			p = RADIXPART(RADIXHASH##WIDTH(v), c->bits);	\
+			if (c->scatter) {				\
+				pvals[hist[p]] = v;			\
+				c->poids[hist[p]] = c->storeoid ? o : (oid) i; \
+			}						\
+			hist[p]++;					\
+		}							\
+	} while (0)
+
+static void
+radixchunk(void *arg)
+{
+	struct radixchunk *c = arg;
+
+	switch (c->width) {
+	case 4:
+		RADIXCHUNK(unsigned int, 4);
+		break;
+	case 8:
+		RADIXCHUNK(ulng, 8);
+		break;
+#ifdef HAVE_HGE
+	case 16:
+		RADIXCHUNK(uhge, 16);
+		break;
+#endif
+	}
+}
+
+/* Partition cnt values of b (subject to the candidate list cand, or
+ * starting at off if there is none) into 1<<bits partitions.  The
+ * values and oids (or indexes into the candidate list) are written
+ * into pvals and poids, the start of partition p is stored in
+ * bounds[p], and bounds[1<<bits] is the total number of values
+ * written. */
+static gdk_return
+radixpartition(BAT *b, const oid *cand, BUN off, BUN cnt, int keepnil,
+	       int storeoid, int bits, void *pvals, oid *poids, BUN *bounds)
+{
+	struct radixchunk *chunks;
+	BUN *hist, tot, tmp;
+	BUN nparts = (BUN) 1 << bits, p;
+	int nchunks, i;
+
+	nchunks = GDKnr_threads > 1 ? GDKnr_threads : 1;
+	if ((BUN) nchunks > cnt / RADIX_MIN_CHUNK)
+		nchunks = (int) (cnt / RADIX_MIN_CHUNK);
+	if (nchunks < 1)
+		nchunks = 1;
+	chunks = GDKmalloc(nchunks * sizeof(struct radixchunk));
+	hist = GDKzalloc(nchunks * nparts * sizeof(BUN));
+	if (chunks == NULL || hist == NULL) {
+		GDKfree(chunks);
+		GDKfree(hist);
+		return GDK_FAIL;
+	}
+	for (i = 0; i < nchunks; i++) {
+		chunks[i].vals = Tloc(b, 0);
+		chunks[i].cand = cand;
+		chunks[i].off = off;
+		chunks[i].seq = b->hseqbase;
+		chunks[i].lo = cnt / nchunks * i;
+		chunks[i].hi = i == nchunks - 1 ? cnt : cnt / nchunks * (i + 1);
+		chunks[i].width = b->twidth;
+		chunks[i].bits = bits;
+		chunks[i].keepnil = keepnil;
+		chunks[i].storeoid = storeoid;
+		chunks[i].nil = ATOMnilptr(b->ttype);
+		chunks[i].hist = hist + i * nparts;
+		chunks[i].pvals = pvals;
+		chunks[i].poids = poids;
+		chunks[i].scatter = 0;
+	}
+	GDKparallel(nchunks, radixchunk, chunks, sizeof(struct radixchunk));
+	/* turn the counts into offsets: partition by partition, and
+	 * within a partition chunk by chunk, so that the order of the
+	 * input is kept within each partition */
+	tot = 0;
+	for (p = 0; p < nparts; p++) {
+		bounds[p] = tot;
+		for (i = 0; i < nchunks; i++) {
+			tmp = hist[i * nparts + p];
+			hist[i * nparts + p] = tot;
+			tot += tmp;
+		}
+	}
+	bounds[nparts] = tot;
+	for (i = 0; i < nchunks; i++)
+		chunks[i].scatter = 1;
+	GDKparallel(nchunks, radixchunk, chunks, sizeof(struct radixchunk));
+	GDKfree(chunks);
+	GDKfree(hist);
+	return GDK_SUCCEED;
+}
+
+/* the join of a single partition */
+struct radixjoin {
+	const void *lvals, *rvals; /* partitioned values */
+	const oid *lidx, *roids;   /* left indexes and right oids */
+	BUN llo, lhi, rlo, rhi;	   /* extent of the partition */
+	int width;
+	int semi, only_misses, nil_on_miss;
+	BUN *cnt;		/* number of results per left index */
+	oid *res;		/* pairs of left index and right oid */
+	BUN nres, sres;
+	int nils;		/* whether nil was added to the right result */
+	int failed;
+	/* for scattering the results into the output */
+	BUN *pos;
+	const oid *lcand;
+	oid lbase;
+	oid *o1, *o2;
+};
+
+static inline gdk_return
+radixresult(struct radixjoin *j, oid li, oid ro)
+{
+	if (j->nres == j->sres) {
+		BUN s = j->sres < 1024 ? 1024 : j->sres * 2;
+		oid *res = GDKrealloc(j->res, 2 * s * sizeof(oid));
+
+		if (res == NULL) {
+			j->failed = 1;
+			return GDK_FAIL;
+		}
+		j->res = res;
+		j->sres = s;
+	}
+	j->res[2 * j->nres] = li;
+	j->res[2 * j->nres + 1] = ro;
+	j->nres++;
+	return GDK_SUCCEED;
+}
+
+#define RADIXJOIN(TYPE, WIDTH)						\
+	do {								\
+		const TYPE *restrict lvals = j->lvals;			\
+		const TYPE *restrict rvals = (const TYPE *) j->rvals + j->rlo; \
+		const oid *restrict roids = j->roids + j->rlo;		\
+		TYPE v;							\
+									\
+		for (i = 0; i < rn; i++) {				\
+			b = (BUN) (RADIXHASH##WIDTH(rvals[i]) >> shift) & mask; \
+			next[i] = bkt[b];				\
+			bkt[b] = i;					\
+		}							\
+		for (i = j->llo; i < j->lhi; i++) {			\
+			v = lvals[i];					\
+			b = (BUN) (RADIXHASH##WIDTH(v) >> shift) & mask; \
+			nr = 0;						\
+			for (k = bkt[b]; k != BUN_NONE; k = next[k]) {	\
+				if (rvals[k] != v)			\
+					continue;			\
+				nr++;					\
+				if (j->only_misses)			\
+					break;				\
+				if (radixresult(j, j->lidx[i], roids[k]) != GDK_SUCCEED) \
+					goto bailout;			\
+				if (j->semi)				\
+					break;				\
+			}						\
+			if (nr == 0 && (j->only_misses | j->nil_on_miss)) { \
+				nr = 1;					\
+				j->nils = 1;				\
+				if (radixresult(j, j->lidx[i], oid_nil) != GDK_SUCCEED) \
+					goto bailout;			\
+			} else if (j->only_misses) {			\
+				nr = 0;					\
+			}						\
+			j->cnt[j->lidx[i]] = nr;			\
+		}							\
+	} while (0)
+
+static void
+radixprobe(void *arg)
+{
+	struct radixjoin *j = arg;
+	BUN rn = j->rhi - j->rlo;
+	BUN nb, mask, i, k, b, nr;
+	BUN *bkt, *next;
+	int bbits, shift;
+
+	if (j->llo == j->lhi)
+		return;
+	/* hash table over the right part of the partition, using hash
+	 * bits below the ones that can be used for partitioning */
+	for (bbits = 0, nb = 1; nb < rn; bbits++)
+		nb <<= 1;
+	mask = nb - 1;
+	shift = 64 - RADIX_MAX_BITS - bbits;
+	if (shift < 0)
+		shift = 0;
+	bkt = GDKmalloc(nb * sizeof(BUN));
+	next = GDKmalloc((rn ? rn : 1) * sizeof(BUN));
+	if (bkt == NULL || next == NULL) {
+		j->failed = 1;
+		goto bailout;
+	}
+	for (i = 0; i < nb; i++)
+		bkt[i] = BUN_NONE;
+	switch (j->width) {
+	case 4:
+		RADIXJOIN(unsigned int, 4);
+		break;
+	case 8:
+		RADIXJOIN(ulng, 8);
+		break;
+#ifdef HAVE_HGE
+	case 16:
+		RADIXJOIN(uhge, 16);
+		break;
+#endif
+	}
+  bailout:
+	GDKfree(bkt);
+	GDKfree(next);
+}
+
+static void
+radixscatter(void *arg)
+{
+	struct radixjoin *j = arg;
+	BUN i, p;
+	oid li;
+
+	for (i = 0; i < j->nres; i++) {
+		li = j->res[2 * i];
+		p = j->pos[li]++;
+		j->o1[p] = j->lcand ? j->lcand[li] : j->lbase + li;
+		if (j->o2)
+			j->o2[p] = j->res[2 * i + 1];
+	}
+}
+
+/* Whether radixjoin should be used with r as the inner input. */
+static int
+radixjoin_ok(BAT *l, BAT *r, BUN lcount, BUN rcount)
+{
+#ifndef DISABLE_PARENT_HASH
+	bat rparent;
+#endif
+
+	if (BATtvoid(l) || BATtvoid(r) || l->tvarsized || r->tvarsized)
+		return 0;
+	switch (ATOMbasetype(r->ttype)) {
+	case TYPE_int:
+	case TYPE_lng:
+	case TYPE_oid:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+		break;
+	default:
+		return 0;
+	}
+	if (lcount < 1024 ||
+	    (size_t) rcount * (r->twidth + sizeof(oid)) < RADIX_MIN_SIZE)
+		return 0;
+	/* both inputs are copied into partitions; like the hash
+	 * table alternative, that must not cause thrashing */
+	if (((size_t) lcount + rcount) * (r->twidth + sizeof(oid)) +
+	    (size_t) lcount * sizeof(BUN) >
+	    GDK_mem_maxsize / (GDKnr_threads ? GDKnr_threads : 1))
+		return 0;
+	/* an existing hash table is cheaper than partitioning; the
+	 * partitions are temporary copies, so a persistent inner
+	 * input (the dimension of a fact-to-dimension join) is fine */
+	if (BATcheckhash(r))
+		return 0;
+#ifndef DISABLE_PARENT_HASH
+	if ((rparent = VIEWtparent(r)) != 0 &&
+	    BATcheckhash(BBPdescriptor(rparent)))
+		return 0;
+#endif
+	return 1;
+}
+
+static gdk_return
+radixjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int nil_matches,
+	  int nil_on_miss, int semi, int only_misses, BUN maxsize, lng t0,
+	  int swapped, const char *reason)
+{
+	BUN lstart, lend, lcnt;
+	const oid *lcand = NULL, *lcandend = NULL;
+	BUN rstart, rend, rcnt;
+	const oid *rcand = NULL, *rcandend = NULL;
+	int width = l->twidth;
+	int bits;
+	BUN nparts, p, i, tot, c;
+	BUN *lbounds = NULL, *rbounds = NULL, *cnt = NULL;
+	void *lpvals = NULL, *rpvals = NULL;
+	oid *lpidx = NULL, *rpoids = NULL;
+	struct radixjoin *parts = NULL;
+	int key = 1, all = 1, nils = 0;
+
+	ALGODEBUG fprintf(stderr, "#radixjoin(l=%s#" BUNFMT "[%s]%s%s%s,"
+			  "r=%s#" BUNFMT "[%s]%s%s%s,sl=%s#" BUNFMT "%s%s%s,"
+			  "sr=%s#" BUNFMT "%s%s%s,nil_matches=%d,"
+			  "nil_on_miss=%d,semi=%d)%s%s%s\n",
+			  BATgetId(l), BATcount(l), ATOMname(l->ttype),
+			  l->tsorted ? "-sorted" : "",
+			  l->trevsorted ? "-revsorted" : "",
+			  l->tkey ? "-key" : "",
+			  BATgetId(r), BATcount(r), ATOMname(r->ttype),
+			  r->tsorted ? "-sorted" : "",
+			  r->trevsorted ? "-revsorted" : "",
+			  r->tkey ? "-key" : "",
+			  sl ? BATgetId(sl) : "NULL", sl ? BATcount(sl) : 0,
+			  sl && sl->tsorted ? "-sorted" : "",
+			  sl && sl->trevsorted ? "-revsorted" : "",
+			  sl && sl->tkey ? "-key" : "",
+			  sr ? BATgetId(sr) : "NULL", sr ? BATcount(sr) : 0,
+			  sr && sr->tsorted ? "-sorted" : "",
+			  sr && sr->trevsorted ? "-revsorted" : "",
+			  sr && sr->tkey ? "-key" : "",
+			  nil_matches, nil_on_miss, semi,
+			  swapped ? " swapped" : "",
+			  *reason ? " " : "", reason);
+
+	assert(ATOMtype(l->ttype) == ATOMtype(r->ttype));
+	assert(!BATtvoid(l) && !BATtvoid(r));
+	assert(width == 4 || width == 8 || width == 16);
+
+	/* r does not get a hash table from this join; if it is a
+	 * persistent column, have one built for the joins that
+	 * follow */
+	BAThashbackground(r);
+	assert(sl == NULL || sl->tsorted);
+	assert(sr == NULL || sr->tsorted);
+
+	CANDINIT(l, sl, lstart, lend, lcnt, lcand, lcandend);
+	CANDINIT(r, sr, rstart, rend, rcnt, rcand, rcandend);
+	lcnt = lcand ? (BUN) (lcandend - lcand) : lend - lstart;
+	rcnt = rcand ? (BUN) (rcandend - rcand) : rend - rstart;
+
+	if (lcnt == 0 || rcnt == 0)
+		return nomatch(r1, r2, l, r, lstart, lend, lcand, lcandend,
+			       nil_on_miss, only_misses, "radixjoin", t0);
+
+	for (bits = 1;
+	     bits < RADIX_MAX_BITS &&
+		     ((size_t) rcnt * (width + sizeof(oid)) >> bits) > RADIX_PART_SIZE;
+	     bits++)
+		;
+	nparts = (BUN) 1 << bits;
+
+	lbounds = GDKmalloc((nparts + 1) * sizeof(BUN));
+	rbounds = GDKmalloc((nparts + 1) * sizeof(BUN));
+	lpvals = GDKmalloc(lcnt * width);
+	lpidx = GDKmalloc(lcnt * sizeof(oid));
+	rpvals = GDKmalloc(rcnt * width);
+	rpoids = GDKmalloc(rcnt * sizeof(oid));
+	cnt = GDKmalloc(lcnt * sizeof(BUN));
+	parts = GDKzalloc(nparts * sizeof(struct radixjoin));
+	if (lbounds == NULL || rbounds == NULL || lpvals == NULL ||
+	    lpidx == NULL || rpvals == NULL || rpoids == NULL ||
+	    cnt == NULL || parts == NULL)
+		goto bailout;
+
+	/* nils on the left are kept since they may be needed for the
+	 * output, nils on the right can only match if nil_matches */
+	if (radixpartition(l, lcand, lstart, lcnt, 1, 0, bits,
+			   lpvals, lpidx, lbounds) != GDK_SUCCEED ||
+	    radixpartition(r, rcand, rstart, rcnt, nil_matches, 1, bits,
+			   rpvals, rpoids, rbounds) != GDK_SUCCEED)
+		goto bailout;
+
+	for (p = 0; p < nparts; p++) {
+		/* parts was zero-initialized */
+		parts[p].lvals = lpvals;
+		parts[p].rvals = rpvals;
+		parts[p].lidx = lpidx;
+		parts[p].roids = rpoids;
+		parts[p].llo = lbounds[p];
+		parts[p].lhi = lbounds[p + 1];
+		parts[p].rlo = rbounds[p];
+		parts[p].rhi = rbounds[p + 1];
+		parts[p].width = width;
+		parts[p].semi = semi;
+		parts[p].only_misses = only_misses;
+		parts[p].nil_on_miss = nil_on_miss;
+		parts[p].cnt = cnt;
+	}
+	GDKparallel((int) nparts, radixprobe, parts, sizeof(struct radixjoin));
+	GDKfree(lpvals);
+	GDKfree(lpidx);
+	GDKfree(rpvals);
+	GDKfree(rpoids);
+	lpvals = rpvals = NULL;
+	lpidx = rpoids = NULL;
+	for (p = 0; p < nparts; p++) {
+		if (parts[p].failed) {
+			GDKerror("radixjoin: cannot allocate enough memory.\n");
+			goto bailout;
+		}
+		nils |= parts[p].nils;
+	}
+
+	/* the results for left index i go to position cnt[i] onwards */
+	for (i = 0, tot = 0; i < lcnt; i++) {
+		c = cnt[i];
+		if (c > maxsize - tot) {
+			GDKerror("radixjoin: too many results.\n");
+			goto bailout;
+		}
+		key &= c <= 1;
+		all &= c == 1;
+		cnt[i] = tot;
+		tot += c;
+	}
+	if (BATextend(r1, tot) != GDK_SUCCEED ||
+	    (r2 && BATextend(r2, tot) != GDK_SUCCEED))
+		goto bailout;
+	for (p = 0; p < nparts; p++) {
+		parts[p].pos = cnt;
+		parts[p].lcand = lcand;
+		parts[p].lbase = l->hseqbase + lstart;
+		parts[p].o1 = (oid *) Tloc(r1, 0);
+		parts[p].o2 = r2 ? (oid *) Tloc(r2, 0) : NULL;
+	}
+	GDKparallel((int) nparts, radixscatter, parts, sizeof(struct radixjoin));
+	for (p = 0; p < nparts; p++)
+		GDKfree(parts[p].res);
+	GDKfree(parts);
+	GDKfree(cnt);
+	GDKfree(lbounds);
+	GDKfree(rbounds);
+
+	BATsetcount(r1, tot);
+	r1->tsorted = 1;
+	r1->trevsorted = tot <= 1;
+	r1->tkey = key;
+	r1->tdense = tot <= 1 || (key && all && lcand == NULL);
+	r1->tseqbase = r1->tdense && tot > 0 ? ((oid *) r1->theap.base)[0] : oid_nil;
+	if (r2) {
+		BATsetcount(r2, tot);
+		r2->tkey = (l->tkey != 0 && !nils) || tot <= 1;
+		r2->tsorted = tot <= 1;
+		r2->trevsorted = tot <= 1;
+		r2->tdense = tot <= 1 && !nils;
+		r2->tseqbase = r2->tdense && tot > 0 ? ((oid *) r2->theap.base)[0] : oid_nil;
+		if (nils) {
+			r2->tnil = 1;
+			r2->tnonil = 0;
+		}
+	}
+	ALGODEBUG fprintf(stderr, "#radixjoin(l=%s,r=%s)=(%s#"BUNFMT"%s%s%s%s,%s#"BUNFMT"%s%s%s%s) " LLFMT "us (" BUNFMT " partitions)\n",
+			  BATgetId(l), BATgetId(r),
+			  BATgetId(r1), BATcount(r1),
+			  r1->tsorted ? "-sorted" : "",
+			  r1->trevsorted ? "-revsorted" : "",
+			  r1->tdense ? "-dense" : "",
+			  r1->tkey ? "-key" : "",
+			  r2 ? BATgetId(r2) : "--", r2 ? BATcount(r2) : 0,
+			  r2 && r2->tsorted ? "-sorted" : "",
+			  r2 && r2->trevsorted ? "-revsorted" : "",
+			  r2 && r2->tdense ? "-dense" : "",
+			  r2 && r2->tkey ? "-key" : "",
+			  GDKusec() - t0, nparts);
+	return GDK_SUCCEED;
+
+  bailout:
+	if (parts) {
+		for (p = 0; p < nparts; p++)
+			GDKfree(parts[p].res);
+		GDKfree(parts);
+	}
+	GDKfree(lbounds);
+	GDKfree(rbounds);
+	GDKfree(lpvals);
+	GDKfree(lpidx);
+	GDKfree(rpvals);
+	GDKfree(rpoids);
+	GDKfree(cnt);
+	BBPreclaim(r1);
+	BBPreclaim(r2);
+	return GDK_FAIL;
+}
+
 #define MASK_EQ		1
 #define MASK_LT		2
 #define MASK_GT		4
@@ -3620,6 +4165,10 @@ subleftjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr,
 				 nil_on_miss, semi, only_misses, maxsize, t0, 0);
 	if (BATtdense(l) && BATordered(r) && (rcount * 1024) < lcount && ATOMtype(l->ttype) == TYPE_oid && !sl && !sr && !nil_matches && !only_misses)
 		return fetchjoin(r1, r2, l, r);
+	if (radixjoin_ok(l, r, lcount, rcount))
+		return radixjoin(r1, r2, l, r, sl, sr, nil_matches,
+				 nil_on_miss, semi, only_misses, maxsize, t0, 0,
+				 "leftjoin");
 	return hashjoin(r1, r2, l, r, sl, sr, nil_matches,
 			nil_on_miss, semi, only_misses, maxsize, t0, 0, "leftjoin");
 }
@@ -3874,8 +4423,12 @@ BATjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr, int nil_matches,
 		reason = "left is smaller";
 	}
 	if (swap) {
+		if (radixjoin_ok(r, l, rcount, lcount))
+			return radixjoin(r2, r1, r, l, sr, sl, nil_matches, 0, 0, 0, maxsize, t0, 1, reason);
 		return hashjoin(r2, r1, r, l, sr, sl, nil_matches, 0, 0, 0, maxsize, t0, 1, reason);
 	} else {
+		if (radixjoin_ok(l, r, lcount, rcount))
+			return radixjoin(r1, r2, l, r, sl, sr, nil_matches, 0, 0, 0, maxsize, t0, 0, reason);
 		return hashjoin(r1, r2, l, r, sl, sr, nil_matches, 0, 0, 0, maxsize, t0, 0, reason);
 	}
 }
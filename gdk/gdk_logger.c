@@ -58,6 +58,12 @@
 #include "gdk_private.h"
 #include "gdk_logger.h"
 #include <string.h>
+#ifdef HAVE_LIBLZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 /*
  * The log record encoding is geared at reduced storage space, but at
@@ -74,6 +80,7 @@
 #define LOG_USE		8
 #define LOG_CLEAR	9
 #define LOG_SEQ		10
+#define LOG_PACKED	0x40	/* flag bit: payload in packed blocks */
 
 #ifdef HAVE_EMBEDDED
 #define printf(fmt,...) ((void) 0)
@@ -224,6 +231,240 @@ log_write_string(logger *l, const char *n)
 	return GDK_SUCCEED;
 }
 
+/*
+ * Packed records.  With gdk_log_compress set, the payload of LOG_INSERT
+ * and LOG_UPDATE records (the values written by log_bat and log_delta)
+ * is collected in blocks of about LOG_BLOCK bytes, each of which is
+ * stored compressed (lz4, or else zlib) if that makes it smaller.  The
+ * flag of such a record has the LOG_PACKED bit set.  Its name is
+ * followed by the blocks, each preceded by its raw and stored size,
+ * its compression and a CRC-32 over the record header and all blocks
+ * up to and including this one.  A block with raw size 0 ends the
+ * record.  A torn or truncated record fails its checksum, and the log
+ * file is then replayed as if it ended just before that record.
+ */
+#define LOG_BLOCK	(1 << 20)
+
+#define PACK_RAW	0
+#define PACK_LZ4	1
+#define PACK_ZLIB	2
+
+#ifdef HAVE_LIBZ
+#define log_crc(crc, buf, len)	((unsigned int) crc32((uLong) (crc), (const Bytef *) (buf), (uInt) (len)))
+#else
+static unsigned int
+log_crc(unsigned int crc, const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	int k;
+
+	crc = ~crc;
+	while (len-- > 0) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ (0xEDB88320U & -(crc & 1));
+	}
+	return ~crc;
+}
+#endif
+
+static unsigned int
+log_crc_header(logformat *l, const char *name)
+{
+	unsigned int crc;
+
+	crc = log_crc(0, &l->flag, 1);
+	crc = log_crc(crc, &l->nr, sizeof(l->nr));
+	crc = log_crc(crc, &l->tid, sizeof(l->tid));
+	return log_crc(crc, name, strlen(name));
+}
+
+static gdk_return
+log_zbuf(logger *lg, size_t size)
+{
+	if (size > lg->zbufsize) {
+		char *p = GDKrealloc(lg->zbuf, size);
+
+		if (p == NULL)
+			return GDK_FAIL;
+		lg->zbuf = p;
+		lg->zbufsize = size;
+	}
+	return GDK_SUCCEED;
+}
+
+/* the write stream for the payload of a packed record */
+static stream *
+log_pack_start(logger *lg)
+{
+	if (lg->pack.len < LOG_BLOCK + BUFSIZ) {
+		/* the buffer stream reallocs and frees with the C library */
+		char *p = realloc(lg->pack.buf, LOG_BLOCK + BUFSIZ);
+
+		if (p == NULL)
+			return NULL;
+		lg->pack.buf = p;
+		lg->pack.len = LOG_BLOCK + BUFSIZ;
+	}
+	lg->pack.pos = 0;
+	if (lg->packs == NULL)
+		lg->packs = buffer_wastream(&lg->pack, "logpack");
+	return lg->packs;
+}
+
+/* write the collected payload as a block, a block of size 0 ends the
+ * record */
+static gdk_return
+log_write_block(logger *lg, unsigned int *crc)
+{
+	int rawlen = (int) lg->pack.pos, len = rawlen;
+	char codec = PACK_RAW;
+	const char *data = lg->pack.buf;
+
+	assert(lg->pack.pos <= (size_t) INT_MAX);
+	if (rawlen > 0) {
+#ifdef HAVE_LIBLZ4
+		int bound = LZ4_compressBound(rawlen);
+
+		if (log_zbuf(lg, (size_t) bound) != GDK_SUCCEED)
+			return GDK_FAIL;
+		len = LZ4_compress_default(lg->pack.buf, lg->zbuf, rawlen, bound);
+		codec = PACK_LZ4;
+#elif defined(HAVE_LIBZ)
+		uLongf zlen = compressBound((uLong) rawlen);
+
+		if (log_zbuf(lg, (size_t) zlen) != GDK_SUCCEED)
+			return GDK_FAIL;
+		if (compress2((Bytef *) lg->zbuf, &zlen, (const Bytef *) lg->pack.buf, (uLong) rawlen, Z_BEST_SPEED) == Z_OK)
+			len = (int) zlen;
+		else
+			len = 0;
+		codec = PACK_ZLIB;
+#endif
+		if (len > 0 && len < rawlen) {
+			data = lg->zbuf;
+		} else {
+			len = rawlen;
+			codec = PACK_RAW;
+		}
+	}
+	*crc = log_crc(*crc, &rawlen, sizeof(rawlen));
+	*crc = log_crc(*crc, &len, sizeof(len));
+	*crc = log_crc(*crc, &codec, 1);
+	if (len > 0)
+		*crc = log_crc(*crc, data, len);
+	lg->pack.pos = 0;
+	if (!mnstr_writeInt(lg->log, rawlen) ||
+	    !mnstr_writeInt(lg->log, len) ||
+	    mnstr_write(lg->log, &codec, 1, 1) != 1 ||
+	    !mnstr_writeInt(lg->log, (int) *crc) ||
+	    (len > 0 && mnstr_write(lg->log, data, 1, len) != (ssize_t) len)) {
+		fprintf(stderr, "!ERROR: log_write_block: write failed\n");
+		return GDK_FAIL;
+	}
+	return GDK_SUCCEED;
+}
+
+static gdk_return
+log_pack_end(logger *lg, unsigned int *crc)
+{
+	if (lg->pack.pos > 0 && log_write_block(lg, crc) != GDK_SUCCEED)
+		return GDK_FAIL;
+	return log_write_block(lg, crc);
+}
+
+/* Read the blocks of a packed record into lg->pack, and set *s to a
+ * read stream on the payload.  Returns LOG_EOF if the record is
+ * incomplete or damaged. */
+static log_return
+log_read_packed(logger *lg, logformat *l, const char *name, buffer *rb, stream **s)
+{
+	unsigned int crc = log_crc_header(l, name);
+	size_t pos = 0;
+
+	for (;;) {
+		int rawlen, len, stored;
+		char codec;
+
+		if (mnstr_readInt(lg->log, &rawlen) != 1 ||
+		    mnstr_readInt(lg->log, &len) != 1 ||
+		    mnstr_read(lg->log, &codec, 1, 1) != 1 ||
+		    mnstr_readInt(lg->log, &stored) != 1 ||
+		    rawlen < 0 || len < 0 || len > rawlen)
+			return LOG_EOF;
+		if (log_zbuf(lg, (size_t) len) != GDK_SUCCEED)
+			return LOG_ERR;
+		if (len > 0 && mnstr_read(lg->log, lg->zbuf, 1, len) != (ssize_t) len)
+			return LOG_EOF;
+		crc = log_crc(crc, &rawlen, sizeof(rawlen));
+		crc = log_crc(crc, &len, sizeof(len));
+		crc = log_crc(crc, &codec, 1);
+		if (len > 0)
+			crc = log_crc(crc, lg->zbuf, len);
+		if (crc != (unsigned int) stored) {
+			fprintf(stderr, "!ERROR: log_read_packed: checksum mismatch in %s\n", name);
+			return LOG_EOF;
+		}
+		if (rawlen == 0)
+			break;
+		if (pos + rawlen > lg->pack.len) {
+			char *p = realloc(lg->pack.buf, pos + rawlen);
+
+			if (p == NULL)
+				return LOG_ERR;
+			lg->pack.buf = p;
+			lg->pack.len = pos + rawlen;
+		}
+		switch (codec) {
+		case PACK_RAW:
+			if (len != rawlen)
+				return LOG_EOF;
+			memcpy(lg->pack.buf + pos, lg->zbuf, len);
+			break;
+#ifdef HAVE_LIBLZ4
+		case PACK_LZ4:
+			if (LZ4_decompress_safe(lg->zbuf, lg->pack.buf + pos, len, rawlen) != rawlen)
+				return LOG_EOF;
+			break;
+#endif
+#ifdef HAVE_LIBZ
+		case PACK_ZLIB: {
+			uLongf zlen = (uLongf) rawlen;
+
+			if (uncompress((Bytef *) lg->pack.buf + pos, &zlen, (const Bytef *) lg->zbuf, (uLong) len) != Z_OK ||
+			    zlen != (uLongf) rawlen)
+				return LOG_EOF;
+			break;
+		}
+#endif
+		default:
+			fprintf(stderr, "!ERROR: log_read_packed: unsupported compression %d in %s\n", codec, name);
+			return LOG_ERR;
+		}
+		pos += rawlen;
+	}
+	rb->buf = lg->pack.buf;
+	rb->pos = 0;
+	rb->len = pos;
+	if ((*s = buffer_rastream(rb, name)) == NULL)
+		return LOG_ERR;
+	return LOG_OK;
+}
+
+static void
+log_pack_destroy(logger *lg)
+{
+	if (lg->packs)
+		mnstr_destroy(lg->packs);
+	lg->packs = NULL;
+	free(lg->pack.buf);
+	lg->pack.buf = NULL;
+	lg->pack.pos = lg->pack.len = 0;
+	GDKfree(lg->zbuf);
+	lg->zbuf = NULL;
+	lg->zbufsize = 0;
+}
+
 static log_return
 log_read_clear(logger *lg, trans *tr, char *name)
 {
@@ -254,6 +495,15 @@ avoid_snapshot(logger *lg, log_bid bid)
 	return 0;
 }
 
+static void
+bat_clear(BAT *b)
+{
+	int access = b->batRestricted;
+	b->batRestricted = BAT_WRITE;
+	BATclear(b, TRUE);
+	b->batRestricted = access;
+}
+
 static gdk_return
 la_bat_clear(logger *lg, logaction *la)
 {
@@ -269,10 +519,7 @@ la_bat_clear(logger *lg, logaction *la)
 
 	b = BATdescriptor(bid);
 	if (b) {
-		int access = b->batRestricted;
-		b->batRestricted = BAT_WRITE;
-		BATclear(b, TRUE);
-		b->batRestricted = access;
+		bat_clear(b);
 		logbat_destroy(b);
 	}
 	return GDK_SUCCEED;
@@ -449,27 +696,33 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 	return res;
 }
 
+static log_return
+log_read_packed_updates(logger *lg, trans *tr, logformat *l, char *name)
+{
+	stream *log = lg->log, *s = NULL;
+	buffer rb;
+	log_return res;
+
+	if ((res = log_read_packed(lg, l, name, &rb, &s)) != LOG_OK)
+		return res;
+	/* decode the payload as if it was read from the log */
+	lg->log = s;
+	l->flag &= ~LOG_PACKED;
+	res = log_read_updates(lg, tr, l, name);
+	lg->log = log;
+	mnstr_destroy(s);
+	if (res == LOG_OK && rb.pos != rb.len)
+		res = LOG_EOF;
+	return res;
+}
+
+/* apply the inserts or updates of la to b */
 static gdk_return
-la_bat_updates(logger *lg, logaction *la)
+bat_updates(BAT *b, logaction *la)
 {
-	log_bid bid = logger_find_bat(lg, la->name);
-	BAT *b;
-
-	if (bid == 0)
-		return GDK_SUCCEED; /* ignore bats no longer in the catalog */
-
-	/* do we need to skip these old updates */
-	if (avoid_snapshot(lg, bid))
-		return GDK_SUCCEED;
-
-	b = BATdescriptor(bid);
-	if (b == NULL)
-		return GDK_FAIL;
 	if (la->type == LOG_INSERT) {
-		if (BATappend(b, la->b, NULL, TRUE) != GDK_SUCCEED) {
-			logbat_destroy(b);
+		if (BATappend(b, la->b, NULL, TRUE) != GDK_SUCCEED)
 			return GDK_FAIL;
-		}
 	} else if (la->type == LOG_UPDATE) {
 		BATiter vi = bat_iterator(la->b);
 		BATiter ii = bat_iterator(la->uid);
@@ -489,28 +742,43 @@ la_bat_updates(logger *lg, logaction *la)
 					const void *tv = ATOMnilptr(b->ttype);
 
 					while (b->hseqbase + b->batCount < h) {
-						if (BUNappend(b, tv, TRUE) != GDK_SUCCEED) {
-							logbat_destroy(b);
+						if (BUNappend(b, tv, TRUE) != GDK_SUCCEED)
 							return GDK_FAIL;
-						}
 					}
 				}
-				if (BUNappend(b, t, TRUE) != GDK_SUCCEED) {
-					logbat_destroy(b);
+				if (BUNappend(b, t, TRUE) != GDK_SUCCEED)
 					return GDK_FAIL;
-				}
 			} else {
-				if (BUNreplace(b, h, t, TRUE) != GDK_SUCCEED) {
-					logbat_destroy(b);
+				if (BUNreplace(b, h, t, TRUE) != GDK_SUCCEED)
 					return GDK_FAIL;
-				}
 			}
 		}
 	}
-	logbat_destroy(b);
 	return GDK_SUCCEED;
 }
 
+static gdk_return
+la_bat_updates(logger *lg, logaction *la)
+{
+	log_bid bid = logger_find_bat(lg, la->name);
+	BAT *b;
+	gdk_return ret;
+
+	if (bid == 0)
+		return GDK_SUCCEED; /* ignore bats no longer in the catalog */
+
+	/* do we need to skip these old updates */
+	if (avoid_snapshot(lg, bid))
+		return GDK_SUCCEED;
+
+	b = BATdescriptor(bid);
+	if (b == NULL)
+		return GDK_FAIL;
+	ret = bat_updates(b, la);
+	logbat_destroy(b);
+	return ret;
+}
+
 static log_return
 log_read_destroy(logger *lg, trans *tr, char *name)
 {
@@ -757,6 +1025,11 @@ la_destroy(logaction *c)
 		GDKfree(c->name);
 	if (c->b)
 		logbat_destroy(c->b);
+	if (c->uid)
+		logbat_destroy(c->uid);
+	c->name = NULL;
+	c->b = NULL;
+	c->uid = NULL;
 }
 
 static gdk_return
@@ -773,6 +1046,7 @@ tr_grow(trans *tr)
 	/* cleanup the next */
 	tr->changes[tr->nr].name = NULL;
 	tr->changes[tr->nr].b = NULL;
+	tr->changes[tr->nr].uid = NULL;
 	return GDK_SUCCEED;
 }
 
@@ -799,8 +1073,217 @@ tr_abort(logger *lg, trans *tr)
 	return tr_destroy(tr);
 }
 
+/*
+ * Recovery does not apply the committed inserts, updates and clears
+ * one logaction at a time.  They are collected in a batch, which is
+ * sorted on bat and handed to a separate thread once it holds
+ * REPLAY_BATCH values.  That thread applies the changes with one task
+ * per bat (GDKparallel), while the log reader continues decoding the
+ * next batch.  Consecutive inserts into the same bat grow it once for
+ * their combined size.  Changes to the logger catalog (create, use and
+ * destroy) are applied only after all outstanding changes have been.
+ */
+#define REPLAY_BATCH	((BUN) 1 << 22)
+
+typedef struct replay_action {
+	log_bid bid;
+	int seq;		/* order in the log */
+	logaction la;
+} replay_action;
+
+typedef struct replay_task {
+	replay_action *acts;	/* the changes to one bat, in log order */
+	int nr;
+	gdk_return res;
+} replay_task;
+
+typedef struct replay {
+	replay_action *acts;	/* the batch being collected */
+	int nr, sz;
+	BUN vals;
+	replay_action *busy;	/* the batch being applied */
+	int nbusy;
+	replay_task *tasks;
+	int ntasks;
+	MT_Id tid;
+	int running;
+	lng applied;		/* changes applied so far */
+} replay;
+
+static int
+replay_cmp(const void *p1, const void *p2)
+{
+	const replay_action *a1 = p1, *a2 = p2;
+
+	if (a1->bid != a2->bid)
+		return a1->bid < a2->bid ? -1 : 1;
+	return a1->seq < a2->seq ? -1 : a1->seq > a2->seq;
+}
+
+static void
+replay_worker(void *arg)
+{
+	replay_task *t = arg;
+	BAT *b = BATdescriptor(t->acts[0].bid);
+	int i, j, k;
+
+	t->res = GDK_SUCCEED;
+	for (i = 0; i < t->nr; i = j) {
+		logaction *la = &t->acts[i].la;
+
+		j = i + 1;
+		if (b == NULL) {
+			/* only a bat to be cleared may be missing */
+			if (la->type != LOG_CLEAR)
+				t->res = GDK_FAIL;
+		} else if (t->res != GDK_SUCCEED) {
+			/* only clean up after a failure */
+		} else if (la->type == LOG_CLEAR) {
+			bat_clear(b);
+		} else if (la->type == LOG_INSERT) {
+			BUN cnt = BATcount(b) + BATcount(la->b);
+
+			for (; j < t->nr && t->acts[j].la.type == LOG_INSERT; j++)
+				cnt += BATcount(t->acts[j].la.b);
+			if (j > i + 1 && BATextend(b, cnt) != GDK_SUCCEED)
+				t->res = GDK_FAIL;
+			for (k = i; t->res == GDK_SUCCEED && k < j; k++)
+				t->res = bat_updates(b, &t->acts[k].la);
+		} else {
+			t->res = bat_updates(b, la);
+		}
+		for (k = i; k < j; k++)
+			la_destroy(&t->acts[k].la);
+	}
+	if (b)
+		logbat_destroy(b);
+}
+
+static void
+replay_apply(void *arg)
+{
+	replay *r = arg;
+
+	GDKparallel(r->ntasks, replay_worker, r->tasks, sizeof(replay_task));
+}
+
+/* wait for the batch being applied and clean it up */
+static gdk_return
+replay_join(replay *r)
+{
+	gdk_return res = GDK_SUCCEED;
+	int i;
+
+	if (r->running) {
+		MT_join_thread(r->tid);
+		r->running = 0;
+	}
+	for (i = 0; i < r->ntasks; i++)
+		if (r->tasks[i].res != GDK_SUCCEED)
+			res = GDK_FAIL;
+	/* left over after a failure */
+	for (i = 0; i < r->nbusy; i++)
+		la_destroy(&r->busy[i].la);
+	r->applied += r->nbusy;
+	GDKfree(r->busy);
+	GDKfree(r->tasks);
+	r->busy = NULL;
+	r->tasks = NULL;
+	r->nbusy = r->ntasks = 0;
+	return res;
+}
+
+/* Start applying the collected batch, in a separate thread unless we
+ * need to wait for it anyway.  A previous batch is finished first, so
+ * the changes to a bat are applied in log order. */
+static gdk_return
+replay_flush(replay *r, int wait)
+{
+	int i, n;
+
+	if (replay_join(r) != GDK_SUCCEED)
+		return GDK_FAIL;
+	if (r->nr == 0)
+		return GDK_SUCCEED;
+	qsort(r->acts, r->nr, sizeof(replay_action), replay_cmp);
+	for (i = 0, n = 0; i < r->nr; i++)
+		n += i == 0 || r->acts[i].bid != r->acts[i - 1].bid;
+	if ((r->tasks = GDKmalloc(n * sizeof(replay_task))) == NULL)
+		return GDK_FAIL;
+	for (i = 0, n = 0; i < r->nr; i++) {
+		if (i == 0 || r->acts[i].bid != r->acts[i - 1].bid) {
+			r->tasks[n].acts = &r->acts[i];
+			r->tasks[n].nr = 0;
+			r->tasks[n].res = GDK_SUCCEED;
+			n++;
+		}
+		r->tasks[n - 1].nr++;
+	}
+	r->ntasks = n;
+	r->busy = r->acts;
+	r->nbusy = r->nr;
+	r->acts = NULL;
+	r->nr = r->sz = 0;
+	r->vals = 0;
+	if (!wait &&
+	    MT_create_thread(&r->tid, replay_apply, r, MT_THR_JOINABLE) == 0) {
+		r->running = 1;
+		return GDK_SUCCEED;
+	}
+	replay_apply(r);
+	return replay_join(r);
+}
+
+/* take over a committed insert, update or clear */
+static gdk_return
+replay_add(logger *lg, replay *r, logaction *c)
+{
+	log_bid bid = logger_find_bat(lg, c->name);
+
+	/* ignore bats no longer in the catalog and old updates */
+	if (bid == 0 || avoid_snapshot(lg, bid)) {
+		la_destroy(c);
+		return GDK_SUCCEED;
+	}
+	if (r->nr == r->sz) {
+		int sz = r->sz ? r->sz * 2 : TR_SIZE;
+		replay_action *acts = GDKrealloc(r->acts, sz * sizeof(replay_action));
+
+		if (acts == NULL)
+			return GDK_FAIL;
+		r->acts = acts;
+		r->sz = sz;
+	}
+	GDKfree(c->name);
+	c->name = NULL;
+	r->acts[r->nr].bid = bid;
+	r->acts[r->nr].seq = r->nr;
+	r->acts[r->nr].la = *c;
+	r->nr++;
+	c->b = c->uid = NULL;
+	r->vals += c->type == LOG_CLEAR ? 1 : BATcount(r->acts[r->nr - 1].la.b);
+	lg->changes++;
+	if (r->vals >= REPLAY_BATCH)
+		return replay_flush(r, 0);
+	return GDK_SUCCEED;
+}
+
+/* give up on the collected and outstanding changes */
+static void
+replay_destroy(replay *r)
+{
+	int i;
+
+	(void) replay_join(r);
+	for (i = 0; i < r->nr; i++)
+		la_destroy(&r->acts[i].la);
+	GDKfree(r->acts);
+	r->acts = NULL;
+	r->nr = r->sz = 0;
+}
+
 static trans *
-tr_commit(logger *lg, trans *tr)
+tr_commit(logger *lg, trans *tr, replay *r)
 {
 	int i;
 
@@ -808,13 +1291,21 @@ tr_commit(logger *lg, trans *tr)
 		fprintf(stderr, "#tr_commit\n");
 
 	for (i = 0; i < tr->nr; i++) {
-		if (la_apply(lg, &tr->changes[i]) != GDK_SUCCEED) {
+		logaction *c = &tr->changes[i];
+		gdk_return ret;
+
+		if (c->type == LOG_INSERT || c->type == LOG_UPDATE ||
+		    c->type == LOG_CLEAR)
+			ret = replay_add(lg, r, c);
+		else if ((ret = replay_flush(r, 1)) == GDK_SUCCEED)
+			ret = la_apply(lg, c);
+		if (ret != GDK_SUCCEED) {
 			do {
 				tr = tr_abort(lg, tr);
 			} while (tr != NULL);
 			return (trans *) -1;
 		}
-		la_destroy(&tr->changes[i]);
+		la_destroy(c);
 	}
 	return tr_destroy(tr);
 }
@@ -918,14 +1409,30 @@ logger_open(logger *lg)
 static void
 logger_close(logger *lg)
 {
+	/* make all written transactions durable, keeping other
+	 * threads from syncing the log while it is closed */
+	MT_lock_set(&lg->sync_lock);
+	while (lg->syncing) {
+		lg->waiters++;
+		MT_lock_unset(&lg->sync_lock);
+		MT_sema_down(&lg->sync_wait);
+		MT_lock_set(&lg->sync_lock);
+	}
+	if (lg->log && lg->synced < lg->written && mnstr_fsync(lg->log))
+		fprintf(stderr, "!ERROR: logger_close: sync failed\n");
+	lg->synced = lg->written;
 	close_stream(lg->log);
 	lg->log = NULL;
+	for (; lg->waiters > 0; lg->waiters--)
+		MT_sema_up(&lg->sync_wait);
+	MT_lock_unset(&lg->sync_lock);
 }
 
 static gdk_return
 logger_readlog(logger *lg, char *filename)
 {
 	trans *tr = NULL;
+	replay r;
 	logformat l;
 	log_return err = LOG_OK;
 	time_t t0, t1;
@@ -934,6 +1441,7 @@ logger_readlog(logger *lg, char *filename)
 	int fd;
 
 	GDKdebug &= ~(CHECKMASK|PROPMASK);
+	memset(&r, 0, sizeof(r));
 
 	if (lg->debug & 1) {
 		fprintf(stderr, "#logger_readlog opening %s\n", filename);
@@ -971,7 +1479,7 @@ logger_readlog(logger *lg, char *filename)
 			t0 = t1;
 			/* not more than once every 10 seconds */
 			if (mnstr_fgetpos(lg->log, &fpos) == 0) {
-				printf("# still reading write-ahead log \"%s\" (%d%% done)\n", filename, (int) ((fpos * 100 + 50) / sb.st_size));
+				printf("# still reading write-ahead log \"%s\" (%d%% done, " LLFMT " changes applied)\n", filename, (int) ((fpos * 100 + 50) / sb.st_size), r.applied);
 				fflush(stdout);
 			}
 		}
@@ -988,10 +1496,12 @@ logger_readlog(logger *lg, char *filename)
 			}
 		}
 		if (lg->debug & 1) {
+			int flag = l.flag & ~LOG_PACKED;
+
 			fprintf(stderr, "#logger_readlog: ");
-			if (l.flag > 0 &&
-			    l.flag < (char) (sizeof(log_commands) / sizeof(log_commands[0])))
-				fprintf(stderr, "%s", log_commands[(int) l.flag]);
+			if (flag > 0 &&
+			    flag < (int) (sizeof(log_commands) / sizeof(log_commands[0])))
+				fprintf(stderr, "%s%s", log_commands[flag], l.flag & LOG_PACKED ? " packed" : "");
 			else
 				fprintf(stderr, "%d", l.flag);
 			fprintf(stderr, " %d " LLFMT, l.tid, l.nr);
@@ -1028,7 +1538,7 @@ logger_readlog(logger *lg, char *filename)
 			else if (l.tid != l.nr)	/* abort record */
 				tr = tr_abort(lg, tr);
 			else
-				tr = tr_commit(lg, tr);
+				tr = tr_commit(lg, tr, &r);
 			break;
 		case LOG_SEQ:
 			err = log_read_seq(lg, &l);
@@ -1040,6 +1550,13 @@ logger_readlog(logger *lg, char *filename)
 			else
 				err = log_read_updates(lg, tr, &l, name);
 			break;
+		case LOG_INSERT | LOG_PACKED:
+		case LOG_UPDATE | LOG_PACKED:
+			if (name == NULL || tr == NULL)
+				err = LOG_EOF;
+			else
+				err = log_read_packed_updates(lg, tr, &l, name);
+			break;
 		case LOG_CREATE:
 			if (name == NULL || tr == NULL)
 				err = LOG_EOF;
@@ -1077,12 +1594,17 @@ logger_readlog(logger *lg, char *filename)
 	}
 	logger_close(lg);
 
+	/* apply what is left of the committed changes */
+	if (err != LOG_ERR && replay_flush(&r, 1) != GDK_SUCCEED)
+		err = LOG_ERR;
+	replay_destroy(&r);
+	log_pack_destroy(lg);
 	/* remaining transactions are not committed, ie abort */
 	while (tr)
 		tr = tr_abort(lg, tr);
 	t0 = time(NULL);
 	if (lg->debug & 1) {
-		printf("# Finished reading the write-ahead log '%s'\n", filename);
+		printf("# Finished reading the write-ahead log '%s', " LLFMT " changes applied\n", filename, r.applied);
 		fflush(stdout);
 	}
 	GDKdebug = dbg;
@@ -1814,6 +2336,7 @@ logger_load(int debug, const char *fn, char filename[PATHLENGTH], logger *lg)
 	GDKfree(lg->dir);
 	GDKfree(lg->local_dir);
 	GDKfree(lg->buf);
+	log_pack_destroy(lg);
 	GDKfree(lg);
 	return GDK_FAIL;
 }
@@ -1834,6 +2357,23 @@ logger_new(int debug, const char *fn, const char *logdir, int version, preversio
 
 	lg->debug = debug;
 	lg->shared = shared;
+	MT_lock_init(&lg->sync_lock, "logger_sync");
+	MT_sema_init(&lg->sync_wait, 0, "logger_sync");
+	lg->written = lg->synced = 0;
+	lg->syncing = lg->waiters = 0;
+	lg->group_commit = GDKgetenv_int("gdk_group_commit", 1) != 0;
+	lg->async_commit = GDKgetenv_int("gdk_async_commit", 0);
+	if (lg->async_commit < 0)
+		lg->async_commit = 0;
+	lg->compress = GDKgetenv_int("gdk_log_compress", 0) != 0;
+	lg->pack.buf = NULL;
+	lg->pack.pos = lg->pack.len = 0;
+	lg->packs = NULL;
+	lg->zbuf = NULL;
+	lg->zbufsize = 0;
+	lg->last_sync = GDKusec();
+	lg->nr_commits = lg->nr_syncs = lg->nr_async = 0;
+	lg->max_group = lg->sync_usec = 0;
 	lg->local_dbfarm_role = 0; /* only used if lg->shared */
 
 	lg->changes = 0;
@@ -2015,6 +2555,9 @@ logger_destroy(logger *lg)
 	GDKfree(lg->fn);
 	GDKfree(lg->dir);
 	logger_close(lg);
+	log_pack_destroy(lg);
+	MT_sema_destroy(&lg->sync_wait);
+	MT_lock_destroy(&lg->sync_lock);
 	GDKfree(lg);
 }
 
@@ -2423,20 +2966,32 @@ log_delta(logger *lg, BAT *uid, BAT *uval, const char *name)
 		BATiter vi = bat_iterator(uval);
 		gdk_return (*wh) (const void *, stream *, size_t) = BATatoms[TYPE_oid].atomWrite;
 		gdk_return (*wt) (const void *, stream *, size_t) = BATatoms[uval->ttype].atomWrite;
+		stream *s = lg->log;
+		unsigned int crc = 0;
 
-		l.flag = LOG_UPDATE;
+		l.flag = lg->compress ? LOG_UPDATE | LOG_PACKED : LOG_UPDATE;
 		if (log_write_format(lg, &l) != GDK_SUCCEED ||
 		    log_write_string(lg, name) != GDK_SUCCEED)
 			return GDK_FAIL;
+		if (lg->compress) {
+			if ((s = log_pack_start(lg)) == NULL)
+				return GDK_FAIL;
+			crc = log_crc_header(&l, name);
+		}
 
 		for (p = 0; p < BUNlast(uid) && ok == GDK_SUCCEED; p++) {
 			const void *id = BUNtail(ii, p);
 			const void *val = BUNtail(vi, p);
 
-			ok = wh(id, lg->log, 1);
+			ok = wh(id, s, 1);
 			if (ok == GDK_SUCCEED)
-				ok = wt(val, lg->log, 1);
+				ok = wt(val, s, 1);
+			if (ok == GDK_SUCCEED && lg->compress &&
+			    lg->pack.pos >= LOG_BLOCK)
+				ok = log_write_block(lg, &crc);
 		}
+		if (ok == GDK_SUCCEED && lg->compress)
+			ok = log_pack_end(lg, &crc);
 
 		if (lg->debug & 1)
 			fprintf(stderr, "#Logged %s " LLFMT " inserts\n", name, l.nr);
@@ -2465,25 +3020,50 @@ log_bat(logger *lg, BAT *b, const char *name)
 	if (l.nr) {
 		BATiter bi = bat_iterator(b);
 		gdk_return (*wt) (const void *, stream *, size_t) = BATatoms[b->ttype].atomWrite;
+		stream *s = lg->log;
+		unsigned int crc = 0;
 
-		l.flag = LOG_INSERT;
+		l.flag = lg->compress ? LOG_INSERT | LOG_PACKED : LOG_INSERT;
 		if (log_write_format(lg, &l) != GDK_SUCCEED ||
 		    log_write_string(lg, name) != GDK_SUCCEED)
 			return GDK_FAIL;
+		if (lg->compress) {
+			if ((s = log_pack_start(lg)) == NULL)
+				return GDK_FAIL;
+			crc = log_crc_header(&l, name);
+		}
 
 		if (b->ttype > TYPE_void &&
 		    b->ttype < TYPE_str &&
 		    !isVIEW(b)) {
-			const void *t = BUNtail(bi, b->batInserted);
-
-			ok = wt(t, lg->log, (size_t)l.nr);
+			const char *t = BUNtail(bi, b->batInserted);
+
+			if (lg->compress) {
+				/* one block at a time */
+				size_t n = LOG_BLOCK / Tsize(b), i;
+
+				for (i = 0; ok == GDK_SUCCEED && i < (size_t) l.nr; i += n) {
+					if (n > (size_t) l.nr - i)
+						n = (size_t) l.nr - i;
+					ok = wt(t + i * Tsize(b), s, n);
+					if (ok == GDK_SUCCEED)
+						ok = log_write_block(lg, &crc);
+				}
+			} else {
+				ok = wt(t, s, (size_t)l.nr);
+			}
 		} else {
 			for (p = b->batInserted; p < BUNlast(b) && ok == GDK_SUCCEED; p++) {
 				const void *t = BUNtail(bi, p);
 
-				ok = wt(t, lg->log, 1);
+				ok = wt(t, s, 1);
+				if (ok == GDK_SUCCEED && lg->compress &&
+				    lg->pack.pos >= LOG_BLOCK)
+					ok = log_write_block(lg, &crc);
 			}
 		}
+		if (ok == GDK_SUCCEED && lg->compress)
+			ok = log_pack_end(lg, &crc);
 
 		if (lg->debug & 1)
 			fprintf(stderr, "#Logged %s " LLFMT " inserts\n", name, l.nr);
@@ -2558,8 +3138,61 @@ pre_allocate(logger *lg)
 	return GDK_SUCCEED;
 }
 
+/* Make the log durable up to and including end record ticket.  The
+ * first thread that finds no sync in progress syncs everything that
+ * was written so far; the others wait for it to finish and check
+ * again. */
+static gdk_return
+log_sync_upto(logger *lg, lng ticket)
+{
+	gdk_return res = GDK_SUCCEED;
+
+	MT_lock_set(&lg->sync_lock);
+	while (lg->synced < ticket && res == GDK_SUCCEED) {
+		if (lg->syncing) {
+			lg->waiters++;
+			MT_lock_unset(&lg->sync_lock);
+			MT_sema_down(&lg->sync_wait);
+			MT_lock_set(&lg->sync_lock);
+		} else {
+			lng target = lg->written;
+			stream *log = lg->log;
+			lng t0;
+
+			lg->syncing = 1;
+			MT_lock_unset(&lg->sync_lock);
+			t0 = GDKusec();
+			if (log == NULL || mnstr_fsync(log))
+				res = GDK_FAIL;
+			t0 = GDKusec() - t0;
+			MT_lock_set(&lg->sync_lock);
+			lg->syncing = 0;
+			if (res == GDK_SUCCEED) {
+				if (lg->debug & 1)
+					fprintf(stderr, "#log_sync " LLFMT " transactions in " LLFMT " usec\n", target - lg->synced, t0);
+				if (target - lg->synced > lg->max_group)
+					lg->max_group = target - lg->synced;
+				lg->synced = target;
+				lg->nr_syncs++;
+				lg->sync_usec += t0;
+				lg->last_sync = GDKusec();
+			}
+			for (; lg->waiters > 0; lg->waiters--)
+				MT_sema_up(&lg->sync_wait);
+		}
+	}
+	MT_lock_unset(&lg->sync_lock);
+	if (res != GDK_SUCCEED)
+		fprintf(stderr, "!ERROR: log_sync: sync failed\n");
+	return res;
+}
+
+/* Write the end record of the current transaction without waiting
+ * for it to reach the disk, unless group commit is disabled.  The
+ * returned ticket is to be passed to log_tsync, preferably after
+ * releasing the locks that serialize the transactions. */
 gdk_return
-log_tend(logger *lg)
+log_tend_nosync(logger *lg, lng *ticket)
 {
 	logformat l;
 	gdk_return res = GDK_SUCCEED;
@@ -2600,14 +3233,110 @@ log_tend(logger *lg)
 	if (res != GDK_SUCCEED ||
 	    log_write_format(lg, &l) != GDK_SUCCEED ||
 	    mnstr_flush(lg->log) ||
-	    mnstr_fsync(lg->log) ||
 	    pre_allocate(lg) != GDK_SUCCEED) {
 		fprintf(stderr, "!ERROR: log_tend: write failed\n");
 		return GDK_FAIL;
 	}
+	MT_lock_set(&lg->sync_lock);
+	*ticket = ++lg->written;
+	lg->nr_commits++;
+	MT_lock_unset(&lg->sync_lock);
+	if (!lg->group_commit)
+		return log_sync_upto(lg, *ticket);
 	return GDK_SUCCEED;
 }
 
+gdk_return
+log_tend(logger *lg)
+{
+	lng ticket;
+
+	if (log_tend_nosync(lg, &ticket) != GDK_SUCCEED)
+		return GDK_FAIL;
+	return log_sync_upto(lg, ticket);
+}
+
+static gdk_return
+log_tsync_(logger *lg, lng ticket, int commit)
+{
+	if (lg->async_commit > 0) {
+		int delay;
+
+		MT_lock_set(&lg->sync_lock);
+		delay = lg->synced < ticket &&
+			GDKusec() - lg->last_sync < (lng) lg->async_commit * 1000;
+		if (delay && commit)
+			lg->nr_async++;
+		MT_lock_unset(&lg->sync_lock);
+		if (delay)
+			return GDK_SUCCEED;
+	}
+	return log_sync_upto(lg, ticket);
+}
+
+/* Wait for the end record of log_tend_nosync to reach the disk.
+ * With asynchronous commit, only wait if the log was last synced
+ * longer than async_commit milliseconds ago. */
+gdk_return
+log_tsync(logger *lg, lng ticket)
+{
+	return log_tsync_(lg, ticket, 1);
+}
+
+/* As log_tsync, for a transaction that waits for the commits it can
+ * see (ticket from log_tlast) rather than for its own. */
+gdk_return
+log_twait(logger *lg, lng ticket)
+{
+	return log_tsync_(lg, ticket, 0);
+}
+
+/* Sync the transactions that were not waited for by log_tsync once
+ * they are async_commit milliseconds old.  To be called
+ * periodically. */
+gdk_return
+log_tsync_pending(logger *lg)
+{
+	lng ticket = 0;
+
+	if (lg->async_commit <= 0)
+		return GDK_SUCCEED;
+	MT_lock_set(&lg->sync_lock);
+	if (lg->synced < lg->written && !lg->syncing &&
+	    GDKusec() - lg->last_sync >= (lng) lg->async_commit * 1000)
+		ticket = lg->written;
+	MT_lock_unset(&lg->sync_lock);
+	if (ticket == 0)
+		return GDK_SUCCEED;
+	return log_sync_upto(lg, ticket);
+}
+
+/* The ticket of the last end record written.  A transaction that can
+ * see the changes of other transactions passes it to log_twait, so
+ * that it does not act on changes that are not yet durable. */
+lng
+log_tlast(logger *lg)
+{
+	lng ticket;
+
+	MT_lock_set(&lg->sync_lock);
+	ticket = lg->written;
+	MT_lock_unset(&lg->sync_lock);
+	return ticket;
+}
+
+void
+logger_commit_stats(logger *lg, lng *commits, lng *syncs, lng *async, lng *maxgroup, lng *syncusec)
+{
+	MT_lock_set(&lg->sync_lock);
+	*commits = lg->nr_commits;
+	*syncs = lg->nr_syncs;
+	*async = lg->nr_async;
+	*maxgroup = lg->max_group;
+	*syncusec = lg->sync_usec;
+	MT_lock_unset(&lg->sync_lock);
+}
+
 gdk_return
 log_abort(logger *lg)
 {
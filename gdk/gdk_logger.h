@@ -70,6 +70,33 @@ typedef struct logger {
 				   commit). */
 	void *buf;
 	size_t bufsize;
+
+	/* Packed records: the payload of inserts and updates is
+	 * written in compressed and checksummed blocks. */
+	int compress;		/* gdk_log_compress: write packed records */
+	buffer pack;		/* raw payload of a packed record */
+	stream *packs;		/* write stream on pack */
+	char *zbuf;		/* compressed payload */
+	size_t zbufsize;
+
+	/* Group commit: transactions write their end record under the
+	 * caller's lock, but wait for it to reach the disk after
+	 * releasing that lock, so that a single sync serves all
+	 * transactions that ended in the meantime. */
+	MT_Lock sync_lock;	/* protects the fields below */
+	MT_Sema sync_wait;	/* threads waiting for a sync to finish */
+	lng written;		/* number of end records written */
+	lng synced;		/* number of end records on disk */
+	int syncing;		/* a thread is syncing the log */
+	int waiters;		/* number of threads on sync_wait */
+	int group_commit;	/* gdk_group_commit: sync outside the lock */
+	int async_commit;	/* gdk_async_commit: max ms to delay a sync */
+	lng last_sync;		/* GDKusec() of the last sync */
+	lng nr_commits;		/* statistics */
+	lng nr_syncs;
+	lng nr_async;
+	lng max_group;
+	lng sync_usec;
 } logger;
 
 /* Holds logger settings
@@ -80,6 +107,7 @@ typedef struct logger_settings {
 	char *shared_logdir;	/* shared write-ahead log directory */
 	int	shared_drift_threshold; /* shared write-ahead log drift threshold */
 	int keep_persisted_log_files; 	/* a flag if old WAL files should be preserved */
+	int checkpoint_wait;	/* max ms to hold new transactions for a checkpoint, -1 waits for an idle moment */
 } logger_settings;
 
 #define BATSIZE 0
@@ -123,6 +151,12 @@ gdk_export gdk_return log_delta(logger *lg, BAT *uid, BAT *uval, const char *n);
 
 gdk_export gdk_return log_tstart(logger *lg);	/* TODO return transaction id */
 gdk_export gdk_return log_tend(logger *lg);
+gdk_export gdk_return log_tend_nosync(logger *lg, lng *ticket);
+gdk_export gdk_return log_tsync(logger *lg, lng ticket);
+gdk_export gdk_return log_tsync_pending(logger *lg);
+gdk_export lng log_tlast(logger *lg);
+gdk_export gdk_return log_twait(logger *lg, lng ticket);
+gdk_export void logger_commit_stats(logger *lg, lng *commits, lng *syncs, lng *async, lng *maxgroup, lng *syncusec);
 gdk_export gdk_return log_abort(logger *lg);
 
 gdk_export gdk_return log_sequence(logger *lg, int seq, lng id);
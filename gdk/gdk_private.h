@@ -23,7 +23,9 @@ enum heaptype {
 	varheap,
 	hashheap,
 	imprintsheap,
-	orderidxheap
+	orderidxheap,
+	zonemapheap,
+	compressheap
 };
 
 __hidden gdk_return ATOMheap(int id, Heap *hp, size_t cap)
@@ -36,6 +38,8 @@ __hidden int ATOMunknown_find(const char *nme)
 	__attribute__((__visibility__("hidden")));
 __hidden str ATOMunknown_name(int a)
 	__attribute__((__visibility__("hidden")));
+__hidden int BATcheckcompress(BAT *b)
+	__attribute__((__visibility__("hidden")));
 __hidden int BATcheckhash(BAT *b)
 	__attribute__((__visibility__("hidden")));
 __hidden int BATcheckimprints(BAT *b)
@@ -45,6 +49,8 @@ __hidden gdk_return BATcheckmodes(BAT *b, int persistent)
 	__attribute__((__visibility__("hidden")));
 __hidden int BATcheckorderidx(BAT *b)
 	__attribute__((__visibility__("hidden")));
+__hidden int BATcheckzonemap(BAT *b)
+	__attribute__((__visibility__("hidden")));
 __hidden BAT *BATcreatedesc(oid hseq, int tt, int heapnames, int role)
 	__attribute__((__visibility__("hidden")));
 __hidden void BATdelete(BAT *b)
@@ -56,6 +62,8 @@ __hidden void BATfree(BAT *b)
 __hidden gdk_return BATgroup_internal(BAT **groups, BAT **extents, BAT **histo, BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, int subsorted)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden void BAThashbackground(BAT *b)
+	__attribute__((__visibility__("hidden")));
 __hidden void BATinit_idents(BAT *bn)
 	__attribute__((__visibility__("hidden")));
 __hidden BAT *BATload_intern(bat bid, int lock)
@@ -105,11 +113,38 @@ __hidden BUN binsearch_flt(const oid *restrict indir, oid offset, const flt *res
 	__attribute__((__visibility__("hidden")));
 __hidden BUN binsearch_dbl(const oid *restrict indir, oid offset, const dbl *restrict vals, BUN lo, BUN hi, dbl v, int ordering, int last)
 	__attribute__((__visibility__("hidden")));
+__hidden BAT *CMPRbat(BAT *b, BUN *offp)
+	__attribute__((__visibility__("hidden")));
+__hidden void CMPRdestroy(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden void CMPRfree(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden int CMPRload(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden const void *CMPRminmax(BAT *b, int max, void *buf)
+	__attribute__((__visibility__("hidden")));
+__hidden gdk_return CMPRproject(BAT *bn, BAT *l, BAT *r, BAT *pr, BUN pr_off, int nilcheck)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
+__hidden int CMPRsave(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden BUN CMPRselect(BAT *b, BAT *pb, BUN pr_off, BAT *bn, const void *tl, const void *th, BUN p, BUN q, BUN cnt, lng off, BUN maximum)
+	__attribute__((__visibility__("hidden")));
+__hidden gdk_return CMPRsum(BAT *b, BAT *pb, BUN p, BUN q, lng *sum, BUN *nils)
+	__attribute__((__visibility__("hidden")));
+__hidden int CMPRtype(int tpe)
+	__attribute__((__visibility__("hidden")));
 __hidden Heap *createOIDXheap(BAT *b, int stable)
 	__attribute__((__visibility__("hidden")));
 __hidden gdk_return BUNreplace(BAT *b, oid left, const void *right, bit force)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden void GDKaccount_charge(lng id, ssize_t delta)
+	__attribute__((__visibility__("hidden")));
+__hidden int GDKaccount_check(lng id, size_t size)
+	__attribute__((__visibility__("hidden")));
+__hidden size_t GDKaccount_avail(lng id)
+	__attribute__((__visibility__("hidden")));
 __hidden gdk_return GDKextend(const char *fn, size_t size)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
@@ -135,6 +170,8 @@ __hidden void *GDKmremap(const char *path, int mode, void *old_address, size_t o
 __hidden gdk_return GDKmunmap(void *addr, size_t len)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden void GDKparallel(int nr, void (*func)(void *), void *args, size_t argsize)
+	__attribute__((__visibility__("hidden")));
 __hidden gdk_return GDKremovedir(int farmid, const char *nme)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
@@ -157,6 +194,8 @@ __hidden BUN HASHmask(BUN cnt)
 	__attribute__((__visibility__("hidden")));
 __hidden Hash *HASHnew(Heap *hp, int tpe, BUN size, BUN mask, BUN count)
 	__attribute__((__visibility__("hidden")));
+__hidden void HASHwaitbackground(BAT *b)
+	__attribute__((__visibility__("hidden")));
 __hidden gdk_return HEAPalloc(Heap *h, size_t nitems, size_t itemsize)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
@@ -215,6 +254,18 @@ __hidden gdk_return VIEWreset(BAT *b)
 	__attribute__((__visibility__("hidden")));
 __hidden BAT *virtualize(BAT *bn)
 	__attribute__((__visibility__("hidden")));
+__hidden void ZMAPappend(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden void ZMAPdestroy(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden void ZMAPfree(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden void ZMAPinplace(BAT *b, BUN p, const void *v)
+	__attribute__((__visibility__("hidden")));
+__hidden void ZMAPsave(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden int ZMAPtype(int tpe)
+	__attribute__((__visibility__("hidden")));
 __hidden int binsearchcand(const oid *cand, BUN lo, BUN hi, oid v)
 	__attribute__((__visibility__("hidden")));
 __hidden void gdk_bbp_reset(void)
@@ -242,6 +293,15 @@ struct Imprints {
 	BUN dictcnt;		/* counter for cache dictionary               */
 };
 
+/* The zone map heap starts with ZMAPOFF oids (version and number of
+ * values covered), followed by the minimum and maximum value of each
+ * block of ZMAP_BLOCK values.  Nils are included: they are smaller
+ * than all other values of the supported types. */
+#define ZMAPOFF		2
+#define ZMAP_BLOCK	((BUN) 1 << 12)
+#define ZMAPcount(hp)	((BUN) ((const oid *) (hp)->base)[1])
+#define ZMAPzones(hp)	((hp)->base + ZMAPOFF * SIZEOF_OID)
+
 typedef struct {
 	MT_Lock swap;
 	MT_Lock hash;
@@ -270,6 +330,7 @@ extern bbplock_t GDKbbpLock[BBP_THREADMASK + 1];
 extern size_t GDK_mmap_minsize_persistent; /* size after which we use memory mapped files for persistent heaps */
 extern size_t GDK_mmap_minsize_transient; /* size after which we use memory mapped files for transient heaps */
 extern size_t GDK_mmap_pagesize; /* mmap granularity */
+extern int GDK_compress;	/* gdk_compress: encode read-only columns when saved (default yes) */
 extern MT_Lock GDKnameLock;
 extern MT_Lock GDKthreadLock;
 extern MT_Lock GDKtmLock;
@@ -190,7 +190,8 @@ BATproject(BAT *l, BAT *r)
 	oid lo, hi;
 	gdk_return res;
 	int tpe = ATOMtype(r->ttype), nilcheck = 1, stringtrick = 0;
-	BUN lcount = BATcount(l), rcount = BATcount(r);
+	BUN lcount = BATcount(l), rcount = BATcount(r), pr_off;
+	BAT *pr;
 	lng t0 = 0;
 
 	ALGODEBUG t0 = GDKusec();
@@ -300,44 +301,50 @@ BATproject(BAT *l, BAT *r)
 	}
 	bn->tnil = 0;
 
-	switch (tpe) {
-	case TYPE_bte:
-		res = project_bte(bn, l, r, nilcheck);
-		break;
-	case TYPE_sht:
-		res = project_sht(bn, l, r, nilcheck);
-		break;
-	case TYPE_int:
-		res = project_int(bn, l, r, nilcheck);
-		break;
-	case TYPE_flt:
-		res = project_flt(bn, l, r, nilcheck);
-		break;
-	case TYPE_dbl:
-		res = project_dbl(bn, l, r, nilcheck);
-		break;
-	case TYPE_lng:
-		res = project_lng(bn, l, r, nilcheck);
-		break;
+	if (!stringtrick && (pr = CMPRbat(r, &pr_off)) != NULL) {
+		/* decode from the encoded copy rather than reading
+		 * the tail */
+		res = CMPRproject(bn, l, r, pr, pr_off, nilcheck);
+	} else {
+		switch (tpe) {
+		case TYPE_bte:
+			res = project_bte(bn, l, r, nilcheck);
+			break;
+		case TYPE_sht:
+			res = project_sht(bn, l, r, nilcheck);
+			break;
+		case TYPE_int:
+			res = project_int(bn, l, r, nilcheck);
+			break;
+		case TYPE_flt:
+			res = project_flt(bn, l, r, nilcheck);
+			break;
+		case TYPE_dbl:
+			res = project_dbl(bn, l, r, nilcheck);
+			break;
+		case TYPE_lng:
+			res = project_lng(bn, l, r, nilcheck);
+			break;
 #ifdef HAVE_HGE
-	case TYPE_hge:
-		res = project_hge(bn, l, r, nilcheck);
-		break;
+		case TYPE_hge:
+			res = project_hge(bn, l, r, nilcheck);
+			break;
 #endif
-	case TYPE_oid:
-		if (r->ttype == TYPE_void) {
-			res = project_void(bn, l, r);
-		} else {
+		case TYPE_oid:
+			if (r->ttype == TYPE_void) {
+				res = project_void(bn, l, r);
+			} else {
 #if SIZEOF_OID == SIZEOF_INT
-			res = project_int(bn, l, r, nilcheck);
+				res = project_int(bn, l, r, nilcheck);
 #else
-			res = project_lng(bn, l, r, nilcheck);
+				res = project_lng(bn, l, r, nilcheck);
 #endif
+			}
+			break;
+		default:
+			res = project_any(bn, l, r, nilcheck);
+			break;
 		}
-		break;
-	default:
-		res = project_any(bn, l, r, nilcheck);
-		break;
 	}
 
 	if (res != GDK_SUCCEED)
@@ -738,6 +738,131 @@ fullscan_any(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 	return cnt;
 }
 
+/* return imprint vector i of the imprints, whatever its width */
+static inline ulng
+impsvector(const Imprints *imprints, BUN i)
+{
+	switch (imprints->bits) {
+	case 8:
+		return ((const uint8_t *) imprints->imps)[i];
+	case 16:
+		return ((const uint16_t *) imprints->imps)[i];
+	case 32:
+		return ((const uint32_t *) imprints->imps)[i];
+	default:
+		assert(imprints->bits == 64);
+		return ((const uint64_t *) imprints->imps)[i];
+	}
+}
+
+/* Range select on a string column using its imprints.
+ * The imprints bin the strings on an order-preserving key of their
+ * first bytes (see IMPSstrkey), so a page whose imprint vector has no
+ * bits in common with the bins of the range cannot contain a
+ * qualifying value, and a page whose vector only has bits strictly
+ * between the bins of the bounds contains only qualifying values.
+ * Only the remaining pages are compared value by value.  Equality
+ * selects are not done this way: a hash table, or the scan of a heap
+ * with double elimination, finds the few matching strings faster
+ * than the imprints, whose bins only look at the first bytes. */
+static BUN
+impsscan_str(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
+	     int li, int hi, int lval, int hval,
+	     BUN r, BUN q, BUN cnt, lng off, oid *restrict dst)
+{
+	BAT *pb = b;
+	BATiter bi;
+	Imprints *imprints;
+	const cchdc_t *restrict d;
+	BUN pr_off = 0, vpp, i, j, icnt, dcnt, n, lo, hi_, p = r;
+	ulng mask, inner, im;
+	int lbin, hbin, c;
+	oid o;
+
+	if (VIEWtparent(b)) {
+		pb = BBPdescriptor(VIEWtparent(b));
+		assert(pb);
+		pr_off = (BUN) ((const char *) Tloc(b, 0) -
+				(const char *) Tloc(pb, 0)) >> b->tshift;
+	}
+	imprints = pb->timprints;
+	assert(imprints);
+	ALGODEBUG fprintf(stderr,
+			  "#BATselect(b=%s#"BUNFMT",s=%s%s,anti=0): "
+			  "imprints select str\n", BATgetId(b), BATcount(b),
+			  s ? BATgetId(s) : "NULL",
+			  s && BATtdense(s) ? "(dense)" : "");
+	bi = bat_iterator(pb);
+	d = (const cchdc_t *) imprints->dict;
+	vpp = IMPS_PAGE >> b->tshift;
+
+	lbin = lval ? IMPSgetbin(TYPE_str, imprints->bits, imprints->bins, tl) : 0;
+	hbin = hval ? IMPSgetbin(TYPE_str, imprints->bits, imprints->bins, th) : imprints->bits - 1;
+	/* bits lbin..hbin inclusive */
+	mask = ((((ulng) 1 << hbin) - 1) << 1 | 1) & ~(((ulng) 1 << lbin) - 1);
+	/* bins strictly inside the range, plus the last bin if
+	 * there is no upper bound */
+	inner = mask & ~((ulng) 1 << lbin);
+	if (hval)
+		inner &= ~((ulng) 1 << hbin);
+
+	/* from here on, p and q are positions in the parent */
+	p += pr_off;
+	q += pr_off;
+	for (i = 0, icnt = 0, dcnt = 0;
+	     dcnt < imprints->dictcnt && i < q;
+	     dcnt++) {
+		n = (BUN) d[dcnt].cnt;
+		if (i + n * vpp <= p) {
+			/* dictionary entry completely before range */
+			i += n * vpp;
+			icnt += d[dcnt].repeat ? 1 : n;
+			continue;
+		}
+		/* a repeated vector covers all its pages at once */
+		for (j = 0; j < (d[dcnt].repeat ? 1 : n); j++) {
+			BUN pgsz = d[dcnt].repeat ? n * vpp : vpp;
+			im = impsvector(imprints, icnt + j);
+			lo = MAX(i + j * vpp, p);
+			hi_ = MIN(i + j * vpp + pgsz, q);
+			if (lo >= hi_ || (im & mask) == 0)
+				continue;
+			if ((im & ~inner) == 0) {
+				/* all values on these pages qualify */
+				for (; lo < hi_; lo++) {
+					o = (oid) (lo - pr_off + off);
+					buninsfix(bn, dst, cnt, o,
+						  (BUN) ((dbl) cnt / (dbl) (lo == r + pr_off ? 1 : lo - r - pr_off)
+							 * (dbl) (q-lo) * 1.1 + 1024),
+						  BATcapacity(bn) + q - lo, BUN_NONE);
+					cnt++;
+				}
+				continue;
+			}
+			for (; lo < hi_; lo++) {
+				const char *v = BUNtvar(bi, lo);
+				if (!GDK_STRNIL(v) &&
+				    (!lval ||
+				     (c = GDK_STRCMP(tl, v)) < 0 ||
+				     (li && c == 0)) &&
+				    (!hval ||
+				     (c = GDK_STRCMP(th, v)) > 0 ||
+				     (hi && c == 0))) {
+					o = (oid) (lo - pr_off + off);
+					buninsfix(bn, dst, cnt, o,
+						  (BUN) ((dbl) cnt / (dbl) (lo == r + pr_off ? 1 : lo - r - pr_off)
+							 * (dbl) (q-lo) * 1.1 + 1024),
+						  BATcapacity(bn) + q - lo, BUN_NONE);
+					cnt++;
+				}
+			}
+		}
+		i += n * vpp;
+		icnt += d[dcnt].repeat ? 1 : n;
+	}
+	return cnt;
+}
+
 static BUN
 fullscan_str(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 	     int li, int hi, int equi, int anti, int lval, int hval,
@@ -748,6 +873,11 @@ fullscan_str(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 	BUN p = r;
 	oid o = (oid) (p + off);
 
+	if (use_imprints) {
+		assert(!anti && !equi);
+		return impsscan_str(b, s, bn, tl, th, li, hi, lval, hval,
+				    r, q, cnt, off, dst);
+	}
 	if (!equi || !GDK_ELIMDOUBLES(b->tvheap))
 		return fullscan_any(b, s, bn, tl, th, li, hi, equi, anti,
 				    lval, hval, r, q, cnt, off, dst,
@@ -852,10 +982,387 @@ scan_sel(candscan, o = *candlist++, w = (BUN) ((*(oid *) Tloc(s,q?(q - 1):0)) +
 scan_sel(fullscan, o = (oid) (p+off), w = (BUN) (q+off))
 
 
+/* AVX2 versions of the full scan select for 4 and 8 byte types.  The
+ * kernels are compiled for AVX2 through the target attribute and are
+ * only called if the CPU supports it, so the library keeps working on
+ * older hardware.  A vector of values is compared with the bounds,
+ * the comparison is turned into a bit mask, and a permutation table
+ * indexed by that mask moves the oids of the qualifying values to the
+ * front of a vector that is then stored in its entirety.  The output
+ * position is advanced by the number of matches, so no branches
+ * depend on the data. */
+#if defined(__x86_64__) && SIZEOF_OID == 8 &&				\
+	(defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define HAVE_AVX2_SCANSELECT 1
+#include <immintrin.h>
+
+/* how the predicate is to be evaluated, see scanfunc */
+#define SIMD_EQ		0	/* v == vl */
+#define SIMD_RANGE	1	/* v >= vl && v <= vh */
+#define SIMD_LE		2	/* v <= vh */
+#define SIMD_GE		3	/* v >= vl */
+#define SIMD_ANTI	4	/* v <= vl || v >= vh */
+#define SIMD_ANTINIL	5	/* (v <= vl || v >= vh) && v != nil */
+
+/* for each 4-bit mask, the 32-bit lanes that hold the selected oids */
+static const int simdperm[16][8] = {
+	{0, 0, 0, 0, 0, 0, 0, 0},
+	{0, 1, 0, 0, 0, 0, 0, 0},
+	{2, 3, 0, 0, 0, 0, 0, 0},
+	{0, 1, 2, 3, 0, 0, 0, 0},
+	{4, 5, 0, 0, 0, 0, 0, 0},
+	{0, 1, 4, 5, 0, 0, 0, 0},
+	{2, 3, 4, 5, 0, 0, 0, 0},
+	{0, 1, 2, 3, 4, 5, 0, 0},
+	{6, 7, 0, 0, 0, 0, 0, 0},
+	{0, 1, 6, 7, 0, 0, 0, 0},
+	{2, 3, 6, 7, 0, 0, 0, 0},
+	{0, 1, 2, 3, 6, 7, 0, 0},
+	{4, 5, 6, 7, 0, 0, 0, 0},
+	{0, 1, 4, 5, 6, 7, 0, 0},
+	{2, 3, 4, 5, 6, 7, 0, 0},
+	{0, 1, 2, 3, 4, 5, 6, 7},
+};
+
+#define SIMDVEC_int		__m256i
+#define SIMDLOAD_int(p)		_mm256_loadu_si256((const __m256i *) (p))
+#define SIMDSET1_int(x)		_mm256_set1_epi32(x)
+#define SIMDMASK_int(c)		_mm256_movemask_ps(_mm256_castsi256_ps(c))
+#define SIMDEQ_int(v, x)	SIMDMASK_int(_mm256_cmpeq_epi32(v, x))
+#define SIMDLE_int(v, x)	(~SIMDMASK_int(_mm256_cmpgt_epi32(v, x)) & 0xFF)
+#define SIMDGE_int(v, x)	(~SIMDMASK_int(_mm256_cmpgt_epi32(x, v)) & 0xFF)
+
+#define SIMDVEC_flt		__m256
+#define SIMDLOAD_flt(p)		_mm256_loadu_ps(p)
+#define SIMDSET1_flt(x)		_mm256_set1_ps(x)
+#define SIMDEQ_flt(v, x)	_mm256_movemask_ps(_mm256_cmp_ps(v, x, _CMP_EQ_OQ))
+#define SIMDLE_flt(v, x)	_mm256_movemask_ps(_mm256_cmp_ps(v, x, _CMP_LE_OQ))
+#define SIMDGE_flt(v, x)	_mm256_movemask_ps(_mm256_cmp_ps(v, x, _CMP_GE_OQ))
+
+#define SIMDVEC_lng		__m256i
+#define SIMDLOAD_lng(p)		_mm256_loadu_si256((const __m256i *) (p))
+#define SIMDSET1_lng(x)		_mm256_set1_epi64x(x)
+#define SIMDMASK_lng(c)		_mm256_movemask_pd(_mm256_castsi256_pd(c))
+#define SIMDEQ_lng(v, x)	SIMDMASK_lng(_mm256_cmpeq_epi64(v, x))
+#define SIMDLE_lng(v, x)	(~SIMDMASK_lng(_mm256_cmpgt_epi64(v, x)) & 0xF)
+#define SIMDGE_lng(v, x)	(~SIMDMASK_lng(_mm256_cmpgt_epi64(x, v)) & 0xF)
+
+#define SIMDVEC_dbl		__m256d
+#define SIMDLOAD_dbl(p)		_mm256_loadu_pd(p)
+#define SIMDSET1_dbl(x)		_mm256_set1_pd(x)
+#define SIMDEQ_dbl(v, x)	_mm256_movemask_pd(_mm256_cmp_pd(v, x, _CMP_EQ_OQ))
+#define SIMDLE_dbl(v, x)	_mm256_movemask_pd(_mm256_cmp_pd(v, x, _CMP_LE_OQ))
+#define SIMDGE_dbl(v, x)	_mm256_movemask_pd(_mm256_cmp_pd(v, x, _CMP_GE_OQ))
+
+/* store the oids in vo that are selected by the 4-bit mask M */
+#define simdstore(VO, M)						\
+	do {								\
+		int _m = (M);						\
+		_mm256_storeu_si256(					\
+			(__m256i *) (dst + cnt),			\
+			_mm256_permutevar8x32_epi32(			\
+				(VO),					\
+				_mm256_loadu_si256((const __m256i *) simdperm[_m]))); \
+		cnt += __builtin_popcount(_m);				\
+	} while (0)
+
+#define simdloop4(TYPE, MASK)						\
+	do {								\
+		const __m256i four = _mm256_set1_epi64x(4);		\
+		__m256i vo = _mm256_set_epi64x((lng) o + 3, (lng) o + 2, \
+					       (lng) o + 1, (lng) o);	\
+		for (i = 0; i < n; i += 4) {				\
+			SIMDVEC_##TYPE v = SIMDLOAD_##TYPE(src + i);	\
+			simdstore(vo, MASK);				\
+			vo = _mm256_add_epi64(vo, four);		\
+		}							\
+	} while (0)
+
+#define simdloop8(TYPE, MASK)						\
+	do {								\
+		const __m256i eight = _mm256_set1_epi64x(8);		\
+		__m256i vo = _mm256_set_epi64x((lng) o + 3, (lng) o + 2, \
+					       (lng) o + 1, (lng) o);	\
+		__m256i vo4 = _mm256_add_epi64(vo, _mm256_set1_epi64x(4)); \
+		for (i = 0; i < n; i += 8) {				\
+			SIMDVEC_##TYPE v = SIMDLOAD_##TYPE(src + i);	\
+			int m = (MASK);					\
+			simdstore(vo, m & 0xF);				\
+			simdstore(vo4, m >> 4);				\
+			vo = _mm256_add_epi64(vo, eight);		\
+			vo4 = _mm256_add_epi64(vo4, eight);		\
+		}							\
+	} while (0)
+
+/* Select from the n values starting at src, whose first oid is o,
+ * and append the oids of the qualifying ones to dst[cnt].  n must be
+ * a multiple of LANES and dst must have room for n more oids. */
+#define simdscan(TYPE, LANES)						\
+__attribute__((__target__("avx2")))					\
+static BUN								\
+simdscan_##TYPE(const TYPE *restrict src, BUN n, oid o, int mode,	\
+		TYPE lo, TYPE hi, TYPE nilval, oid *restrict dst, BUN cnt) \
+{									\
+	SIMDVEC_##TYPE vl = SIMDSET1_##TYPE(lo);			\
+	SIMDVEC_##TYPE vh = SIMDSET1_##TYPE(hi);			\
+	SIMDVEC_##TYPE nil = SIMDSET1_##TYPE(nilval);			\
+	BUN i;								\
+									\
+	switch (mode) {							\
+	case SIMD_EQ:							\
+		simdloop##LANES(TYPE, SIMDEQ_##TYPE(v, vl));		\
+		break;							\
+	case SIMD_RANGE:						\
+		simdloop##LANES(TYPE, SIMDGE_##TYPE(v, vl) &		\
+				SIMDLE_##TYPE(v, vh));			\
+		break;							\
+	case SIMD_LE:							\
+		simdloop##LANES(TYPE, SIMDLE_##TYPE(v, vh));		\
+		break;							\
+	case SIMD_GE:							\
+		simdloop##LANES(TYPE, SIMDGE_##TYPE(v, vl));		\
+		break;							\
+	case SIMD_ANTI:							\
+		simdloop##LANES(TYPE, SIMDLE_##TYPE(v, vl) |		\
+				SIMDGE_##TYPE(v, vh));			\
+		break;							\
+	case SIMD_ANTINIL:						\
+		simdloop##LANES(TYPE, (SIMDLE_##TYPE(v, vl) |		\
+				       SIMDGE_##TYPE(v, vh)) &		\
+				~SIMDEQ_##TYPE(v, nil));		\
+		break;							\
+	default:							\
+		assert(0);						\
+	}								\
+	return cnt;							\
+}
+
+simdscan(int, 8)
+simdscan(flt, 8)
+simdscan(lng, 4)
+simdscan(dbl, 4)
+
+#define simdmode(TYPE)							\
+	(equi ? SIMD_EQ :						\
+	 anti ? (b->tnonil ? SIMD_ANTI : SIMD_ANTINIL) :		\
+	 b->tnonil && *(const TYPE *) tl == MINVALUE##TYPE ? SIMD_LE :	\
+	 *(const TYPE *) th == MAXVALUE##TYPE ? SIMD_GE : SIMD_RANGE)
+
+#define simdcall(TYPE)							\
+	simdscan_##TYPE((const TYPE *) Tloc(b, p), n, (oid) (p + off),	\
+			mode, *(const TYPE *) tl, *(const TYPE *) th,	\
+			TYPE##_nil, dst, cnt)
+
+/* Run the AVX2 scan over as much of [*pp, q) as fits in whole
+ * vectors, extending bn as needed.  Returns the new count, and sets
+ * *pp to where the scalar scan has to take over, or returns BUN_NONE
+ * (after reclaiming bn) if bn could not be extended. */
+static BUN
+avx2_scanselect(BAT *b, BAT *bn, const void *tl, const void *th,
+		int equi, int anti, BUN *pp, BUN q, BUN cnt, lng off,
+		BUN maximum)
+{
+	int t = ATOMbasetype(b->ttype);
+	BUN lanes, n, p = *pp, r = *pp;
+	oid *restrict dst;
+	int mode;
+
+	switch (t) {
+	case TYPE_int:
+		mode = simdmode(int);
+		lanes = 8;
+		break;
+	case TYPE_flt:
+		mode = simdmode(flt);
+		lanes = 8;
+		break;
+	case TYPE_lng:
+		mode = simdmode(lng);
+		lanes = 4;
+		break;
+	case TYPE_dbl:
+		mode = simdmode(dbl);
+		lanes = 4;
+		break;
+	default:
+		return cnt;
+	}
+	ALGODEBUG fprintf(stderr, "#BATselect(b=%s#"BUNFMT",anti=%d): "
+			  "avx2 fullscan mode %d\n", BATgetId(b), BATcount(b),
+			  anti, mode);
+	dst = (oid *) Tloc(bn, 0);
+	for (;;) {
+		n = q - p;
+		if (n > BATcapacity(bn) - cnt)
+			n = BATcapacity(bn) - cnt;
+		n -= n % lanes;
+		if (n > 0) {
+			switch (t) {
+			case TYPE_int:
+				cnt = simdcall(int);
+				break;
+			case TYPE_flt:
+				cnt = simdcall(flt);
+				break;
+			case TYPE_lng:
+				cnt = simdcall(lng);
+				break;
+			case TYPE_dbl:
+				cnt = simdcall(dbl);
+				break;
+			}
+			p += n;
+		}
+		if (q - p < lanes || BATcapacity(bn) >= maximum)
+			break;
+		/* out of space: grow like buninsfix does */
+		BATsetcount(bn, cnt);
+		if (BATextend(bn, BATcapacity(bn) +
+			      MIN((BUN) ((dbl) cnt / (dbl) (p == r ? 1 : p - r)
+					 * (dbl) (q - p) * 1.1 + 1024),
+				  q - p)) != GDK_SUCCEED) {
+			BBPreclaim(bn);
+			return BUN_NONE;
+		}
+		dst = (oid *) Tloc(bn, 0);
+	}
+	*pp = p;
+	return cnt;
+}
+#endif
+
+
+/* scan select on positions p..q of b without candidate list */
+static BUN
+fullscan(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
+	 int li, int hi, int equi, int anti, int lval, int hval,
+	 BUN p, BUN q, BUN cnt, lng off, BUN maximum, int use_imprints)
+{
+	oid *restrict dst = (oid *) Tloc(bn, 0);
+	const oid *candlist = NULL;
+
+#ifdef HAVE_AVX2_SCANSELECT
+	if (!use_imprints && __builtin_cpu_supports("avx2")) {
+		cnt = avx2_scanselect(b, bn, tl, th, equi, anti,
+				      &p, q, cnt, off, maximum);
+		if (cnt == BUN_NONE)
+			return BUN_NONE;
+		dst = (oid *) Tloc(bn, 0);
+	}
+#endif
+	/* call type-specific core scan select function */
+	switch (ATOMbasetype(b->ttype)) {
+	case TYPE_bte:
+		return fullscan_bte(scanargs);
+	case TYPE_sht:
+		return fullscan_sht(scanargs);
+	case TYPE_int:
+		return fullscan_int(scanargs);
+	case TYPE_flt:
+		return fullscan_flt(scanargs);
+	case TYPE_dbl:
+		return fullscan_dbl(scanargs);
+	case TYPE_lng:
+		return fullscan_lng(scanargs);
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		return fullscan_hge(scanargs);
+#endif
+	case TYPE_str:
+		return fullscan_str(scanargs);
+	default:
+		return fullscan_any(scanargs);
+	}
+}
+
+/* return the BAT holding the zone map of b (b itself or its parent)
+ * if that zone map covers all values */
+static BAT *
+zonemapbat(BAT *b)
+{
+	BAT *pb = b;
+
+	if (!ZMAPtype(b->ttype))
+		return NULL;
+	if (VIEWtparent(b) &&
+	    (pb = BBPquickdesc(VIEWtparent(b), 0)) == NULL)
+		return NULL;
+	if (!BATcheckzonemap(pb) || ZMAPcount(pb->tzonemap) != BATcount(pb))
+		return NULL;
+	return pb;
+}
+
+/* Scan select on positions p..q of b using the zone map of b (or its
+ * parent): zones whose minimum and maximum show that none of their
+ * values qualify are skipped, zones of which all values qualify are
+ * added without looking at the values, and the remaining zones are
+ * scanned.  The bounds tl and th are inclusive (see NORMALIZE). */
+static BUN
+zonescan(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
+	 int equi, BUN p, BUN q, BUN cnt, lng off, BUN maximum)
+{
+	BAT *pb = b;
+	const Heap *hp;
+	int (*cmp)(const void *, const void *) = ATOMcompare(b->ttype);
+	int w = b->twidth;
+	BUN pr_off = 0, e, ncap, nskip = 0, nfull = 0;
+	const char *z;
+	oid *restrict dst;
+
+	if (VIEWtparent(b)) {
+		pb = BBPdescriptor(VIEWtparent(b));
+		pr_off = (BUN) ((const char *) Tloc(b, 0) -
+				(const char *) Tloc(pb, 0)) >> b->tshift;
+	}
+	hp = pb->tzonemap;
+	assert(hp != NULL && hp != (Heap *) 1);
+	assert(ZMAPcount(hp) >= q + pr_off);
+	/* from here on, p and q are positions in the parent */
+	for (p += pr_off, q += pr_off; p < q; p = e) {
+		e = MIN((p / ZMAP_BLOCK + 1) * ZMAP_BLOCK, q);
+		z = ZMAPzones(hp) + (p / ZMAP_BLOCK) * 2 * w;
+		if ((*cmp)(z + w, tl) < 0 || (*cmp)(z, th) > 0) {
+			nskip++;
+			continue;
+		}
+		if ((*cmp)(z, tl) >= 0 && (*cmp)(z + w, th) <= 0) {
+			/* all values in the zone qualify */
+			nfull++;
+			if (cnt + e - p > BATcapacity(bn)) {
+				ncap = MIN(MAX(cnt + e - p,
+					       2 * BATcapacity(bn)),
+					   maximum);
+				BATsetcount(bn, cnt);
+				if (BATextend(bn, ncap) != GDK_SUCCEED) {
+					BBPreclaim(bn);
+					return BUN_NONE;
+				}
+			}
+			dst = (oid *) Tloc(bn, 0);
+			for (; p < e; p++)
+				dst[cnt++] = (oid) (p - pr_off + off);
+			continue;
+		}
+		cnt = fullscan(b, s, bn, tl, th, 1, 1, equi, 0, 1, 1,
+			       p - pr_off, e - pr_off, cnt, off, maximum, 0);
+		if (cnt == BUN_NONE)
+			return BUN_NONE;
+	}
+	ALGODEBUG fprintf(stderr,
+			  "#BATselect(b=%s#"BUNFMT",s=%s%s,anti=0): "
+			  "zone map select: " BUNFMT " zones skipped, "
+			  BUNFMT " zones fully selected\n",
+			  BATgetId(b), BATcount(b),
+			  s ? BATgetId(s) : "NULL",
+			  s && BATtdense(s) ? "(dense)" : "", nskip, nfull);
+	return cnt;
+}
+
 static BAT *
 BAT_scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 	       int li, int hi, int equi, int anti, int lval, int hval,
-	       BUN maximum, int use_imprints)
+	       BUN maximum, int use_imprints, int use_zonemap,
+	       int use_compress)
 {
 #ifndef NDEBUG
 	int (*cmp)(const void *, const void *);
@@ -953,39 +1460,20 @@ BAT_scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 			p = 0;
 			q = BUNlast(b);
 		}
-		candlist = NULL;
-		/* call type-specific core scan select function */
-		switch (t) {
-		case TYPE_bte:
-			cnt = fullscan_bte(scanargs);
-			break;
-		case TYPE_sht:
-			cnt = fullscan_sht(scanargs);
-			break;
-		case TYPE_int:
-			cnt = fullscan_int(scanargs);
-			break;
-		case TYPE_flt:
-			cnt = fullscan_flt(scanargs);
-			break;
-		case TYPE_dbl:
-			cnt = fullscan_dbl(scanargs);
-			break;
-		case TYPE_lng:
-			cnt = fullscan_lng(scanargs);
-			break;
-#ifdef HAVE_HGE
-		case TYPE_hge:
-			cnt = fullscan_hge(scanargs);
-			break;
-#endif
-		case TYPE_str:
-			cnt = fullscan_str(scanargs);
-			break;
-		default:
-			cnt = fullscan_any(scanargs);
-			break;
-		}
+		if (use_compress) {
+			BUN pr_off;
+			BAT *pb = CMPRbat(b, &pr_off);
+
+			assert(pb != NULL);
+			cnt = CMPRselect(b, pb, pr_off, bn, tl, th, p, q, cnt,
+					 off, maximum);
+		} else if (use_zonemap)
+			cnt = zonescan(b, s, bn, tl, th, equi, p, q, cnt,
+				       off, maximum);
+		else
+			cnt = fullscan(b, s, bn, tl, th, li, hi, equi, anti,
+				       lval, hval, p, q, cnt, off, maximum,
+				       use_imprints);
 	}
 	if (cnt == BUN_NONE) {
 		return NULL;
@@ -1793,9 +2281,13 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 				  s && BATtdense(s) ? "(dense)" : "", anti);
 		bn = BAT_hashselect(b, s, bn, tl, maximum);
 	} else {
-		int use_imprints = 0;
-		if (!equi &&
-		    !b->tvarsized &&
+		int use_imprints = 0, use_zonemap = 0, use_compress = 0;
+		BUN pr_off;
+		if (((!equi && !b->tvarsized) ||
+		     /* string imprints only support range selects
+		      * without candidate list */
+		     (b->ttype == TYPE_str && !equi && !anti &&
+		      (s == NULL || BATtdense(s)))) &&
 		    (b->batPersistence == PERSISTENT ||
 		     (parent != 0 &&
 		      (tmp = BBPquickdesc(parent, 0)) != NULL &&
@@ -1803,12 +2295,39 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 			/* use imprints if
 			 *   i) bat is persistent, or parent is persistent
 			 *  ii) it is not an equi-select, and
-			 * iii) is not var-sized.
+			 * iii) is not var-sized,
+			 * or if it is a string bat (see above).
 			 */
 			use_imprints = 1;
 		}
+		if (!anti && (s == NULL || BATtdense(s)) &&
+		    CMPRbat(b, &pr_off) != NULL) {
+			/* scan the encoded copy, which is much smaller
+			 * than the tail */
+			use_compress = 1;
+			use_imprints = 0;
+		} else if (!anti && (s == NULL || BATtdense(s)) &&
+		    ZMAPtype(b->ttype) &&
+		    (b->batPersistence == PERSISTENT ||
+		     (parent != 0 &&
+		      (tmp = BBPquickdesc(parent, 0)) != NULL &&
+		      tmp->batPersistence == PERSISTENT))) {
+			/* the zone map survives appends, so use it
+			 * rather than rebuilding the imprints, but
+			 * prefer imprints that are still there */
+			if ((tmp = zonemapbat(b)) != NULL) {
+				if (equi || !BATcheckimprints(tmp)) {
+					use_zonemap = 1;
+					use_imprints = 0;
+				}
+			} else if (use_imprints &&
+				   BATzonemap(b) != GDK_SUCCEED) {
+				GDKclrerr(); /* not interested in errors */
+			}
+		}
 		bn = BAT_scanselect(b, s, bn, tl, th, li, hi, equi, anti,
-				    lval, hval, maximum, use_imprints);
+				    lval, hval, maximum, use_imprints,
+				    use_zonemap, use_compress);
 	}
 
 	return virtualize(bn);
@@ -1907,6 +2426,7 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 	int sorted = 0;		/* which column is sorted */
 	BAT *tmp;
 	int use_orderidx = 0;
+	int use_zonemap = 0;
 	oid ll, lh;
 
 	assert(ATOMtype(l->ttype) == ATOMtype(rl->ttype));
@@ -2150,19 +2670,25 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 		}
 		cnt = BATcount(r1);
 		assert(BATcount(r1) == BATcount(r2));
-	} else if ((BATcount(rl) > 2 ||
-		    l->batPersistence == PERSISTENT ||
-		    (VIEWtparent(l) != 0 &&
-		     (tmp = BBPquickdesc(VIEWtparent(l), 0)) != NULL &&
-		     tmp->batPersistence == PERSISTENT) ||
-		    BATcheckimprints(l)) &&
-		   BATimprints(l) == GDK_SUCCEED) {
+	} else if ((use_zonemap = lcand == NULL &&
+		    (tmp = zonemapbat(l)) != NULL &&
+		    !BATcheckimprints(tmp)) != 0 ||
+		   (!l->tvarsized &&
+		    (BATcount(rl) > 2 ||
+		     l->batPersistence == PERSISTENT ||
+		     (VIEWtparent(l) != 0 &&
+		      (tmp = BBPquickdesc(VIEWtparent(l), 0)) != NULL &&
+		      tmp->batPersistence == PERSISTENT) ||
+		     BATcheckimprints(l)) &&
+		    BATimprints(l) == GDK_SUCCEED)) {
 		/* implementation using imprints on left column
 		 *
 		 * we use imprints if we can (the type is right for
 		 * imprints) and either the left bat is persistent or
 		 * already has imprints, or the right bats are long
-		 * enough (for creating imprints being worth it) */
+		 * enough (for creating imprints being worth it);
+		 * without candidate list, an up-to-date zone map is
+		 * used instead of (re)building imprints */
 		BUN maximum;
 
 		sorted = 2;
@@ -2233,6 +2759,10 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 							    lstart, lend, cnt,
 							    off, dst1, lcand,
 							    cnt + maximum, 1);
+				else if (use_zonemap)
+					ncnt = zonescan(l, sl, r1, &vl, &vh, 0,
+							lstart, lend, cnt,
+							off, cnt + maximum);
 				else
 					ncnt = fullscan_bte(l, sl, r1, &vl, &vh,
 							    1, 1, 0, 0, 1, 1,
@@ -2265,6 +2795,10 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 							    lstart, lend, cnt,
 							    off, dst1, lcand,
 							    cnt + maximum, 1);
+				else if (use_zonemap)
+					ncnt = zonescan(l, sl, r1, &vl, &vh, 0,
+							lstart, lend, cnt,
+							off, cnt + maximum);
 				else
 					ncnt = fullscan_sht(l, sl, r1, &vl, &vh,
 							    1, 1, 0, 0, 1, 1,
@@ -2310,6 +2844,10 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 							    lstart, lend, cnt,
 							    off, dst1, lcand,
 							    cnt + maximum, 1);
+				else if (use_zonemap)
+					ncnt = zonescan(l, sl, r1, &vl, &vh, 0,
+							lstart, lend, cnt,
+							off, cnt + maximum);
 				else
 					ncnt = fullscan_int(l, sl, r1, &vl, &vh,
 							    1, 1, 0, 0, 1, 1,
@@ -2355,6 +2893,10 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 							    lstart, lend, cnt,
 							    off, dst1, lcand,
 							    cnt + maximum, 1);
+				else if (use_zonemap)
+					ncnt = zonescan(l, sl, r1, &vl, &vh, 0,
+							lstart, lend, cnt,
+							off, cnt + maximum);
 				else
 					ncnt = fullscan_lng(l, sl, r1, &vl, &vh,
 							    1, 1, 0, 0, 1, 1,
@@ -2388,6 +2930,10 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 							    lstart, lend, cnt,
 							    off, dst1, lcand,
 							    cnt + maximum, 1);
+				else if (use_zonemap)
+					ncnt = zonescan(l, sl, r1, &vl, &vh, 0,
+							lstart, lend, cnt,
+							off, cnt + maximum);
 				else
 					ncnt = fullscan_hge(l, sl, r1, &vl, &vh,
 							    1, 1, 0, 0, 1, 1,
@@ -2421,6 +2967,10 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 							    lstart, lend, cnt,
 							    off, dst1, lcand,
 							    cnt + maximum, 1);
+				else if (use_zonemap)
+					ncnt = zonescan(l, sl, r1, &vl, &vh, 0,
+							lstart, lend, cnt,
+							off, cnt + maximum);
 				else
 					ncnt = fullscan_flt(l, sl, r1, &vl, &vh,
 							    1, 1, 0, 0, 1, 1,
@@ -2453,6 +3003,10 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, int li,
 							    lstart, lend, cnt,
 							    off, dst1, lcand,
 							    cnt + maximum, 1);
+				else if (use_zonemap)
+					ncnt = zonescan(l, sl, r1, &vl, &vh, 0,
+							lstart, lend, cnt,
+							off, cnt + maximum);
 				else
 					ncnt = fullscan_dbl(l, sl, r1, &vl, &vh,
 							    1, 1, 0, 0, 1, 1,
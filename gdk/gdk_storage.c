@@ -614,7 +614,10 @@ DESCload(int i)
 		return NULL;
 	}
 	b->ttype = tt;
-	b->thash = NULL;
+	/* a hash table that was saved when the BAT was unloaded (see
+	 * HASHfree) is picked up again by BATcheckhash */
+	if (b->thash != (Hash *) 1)
+		b->thash = NULL;
 
 	/* reconstruct mode from BBP status (BATmode doesn't flush
 	 * descriptor, so loaded mode may be stale) */
@@ -762,10 +765,12 @@ BATsave(BAT *bd)
 		*b->tvheap = *bd->tvheap;
 	}
 
-	/* start saving data */
+	/* start saving data; a read-only tail may be saved in encoded
+	 * form only */
 	nme = BBP_physical(b->batCacheid);
-	if (b->batCopiedtodisk == 0 || b->batDirty || b->theap.dirty)
-		if (err == GDK_SUCCEED && b->ttype)
+	if (b->ttype && !CMPRsave(bd) &&
+	    (b->batCopiedtodisk == 0 || b->batDirty || b->theap.dirty))
+		if (err == GDK_SUCCEED)
 			err = HEAPsave(&b->theap, nme, "tail");
 	if (b->tvheap && (b->batCopiedtodisk == 0 || b->batDirty || b->tvheap->dirty))
 		if (b->ttype && b->tvarsized) {
@@ -777,6 +782,7 @@ BATsave(BAT *bd)
 		GDKfree(b->tvheap);
 
 	if (err == GDK_SUCCEED) {
+		ZMAPsave(bd);
 		bd->batCopiedtodisk = 1;
 		DESCclean(bd);
 		return GDK_SUCCEED;
@@ -803,9 +809,13 @@ BATload_intern(bat bid, int lock)
 		return NULL;
 	}
 
-	/* LOAD bun heap */
+	/* LOAD bun heap, decoding it if it was saved in encoded form */
 	if (b->ttype != TYPE_void) {
-		if (HEAPload(&b->theap, nme, "tail", b->batRestricted == BAT_READ) != GDK_SUCCEED) {
+		int dec = CMPRload(b);
+
+		if (dec < 0 ||
+		    (dec == 0 &&
+		     HEAPload(&b->theap, nme, "tail", b->batRestricted == BAT_READ) != GDK_SUCCEED)) {
 			HEAPfree(&b->theap, 0);
 			return NULL;
 		}
@@ -869,12 +879,19 @@ BATdelete(BAT *b)
 		HASHdestroy(b);
 		IMPSdestroy(b);
 		OIDXdestroy(b);
+		CMPRdestroy(b);
+		ZMAPdestroy(b);
 	}
 	if (b->batCopiedtodisk || (b->theap.storage != STORE_MEM)) {
 		if (b->ttype != TYPE_void &&
 		    HEAPdelete(&b->theap, o, "tail") &&
 		    b->batCopiedtodisk)
 			IODEBUG fprintf(stderr, "#BATdelete(%s): bun heap\n", BATgetId(b));
+		/* an encoded copy that replaced the tail (see
+		 * CMPRdestroy) */
+		if (b->ttype != TYPE_void)
+			GDKunlink(BBPselectfarm(b->batRole, b->ttype, compressheap),
+				  BATDIR, o, "tcompress");
 	} else if (b->theap.base) {
 		HEAPfree(&b->theap, 1);
 	}
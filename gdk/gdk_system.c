@@ -776,6 +776,55 @@ MT_global_exit(int s)
 	exit(s);
 }
 
+/* per-thread pointer for GDK internal bookkeeping (e.g. the memory
+ * account the thread is working for) */
+#if !defined(HAVE_PTHREAD_H) && defined(_MSC_VER)
+static DWORD threadslot = TLS_OUT_OF_INDEXES;
+
+void
+MT_thread_init(void)
+{
+	if (threadslot == TLS_OUT_OF_INDEXES)
+		threadslot = TlsAlloc();
+}
+
+void
+MT_thread_setdata(void *data)
+{
+	if (threadslot != TLS_OUT_OF_INDEXES)
+		TlsSetValue(threadslot, data);
+}
+
+void *
+MT_thread_getdata(void)
+{
+	return threadslot == TLS_OUT_OF_INDEXES ? NULL : TlsGetValue(threadslot);
+}
+#else
+static pthread_key_t threadkey;
+static int threadkey_init = 0;
+
+void
+MT_thread_init(void)
+{
+	if (!threadkey_init && pthread_key_create(&threadkey, NULL) == 0)
+		threadkey_init = 1;
+}
+
+void
+MT_thread_setdata(void *data)
+{
+	if (threadkey_init)
+		pthread_setspecific(threadkey, data);
+}
+
+void *
+MT_thread_getdata(void)
+{
+	return threadkey_init ? pthread_getspecific(threadkey) : NULL;
+}
+#endif
+
 MT_Id
 MT_getpid(void)
 {
@@ -280,8 +280,10 @@ size_t GDK_mmap_minsize_transient = MMAP_MINSIZE_TRANSIENT;
 size_t GDK_mmap_pagesize = MMAP_PAGESIZE; /* mmap granularity */
 size_t GDK_mem_maxsize = GDK_VM_MAXSIZE;
 size_t GDK_vm_maxsize = GDK_VM_MAXSIZE;
+size_t GDK_mem_budget = 0;	/* no limit on memory accounted to queries */
 
 int GDK_vm_trim = 1;
+int GDK_compress = 1;	/* encode read-only columns when saved */
 
 #define SEG_SIZE(x,y)	((x)+(((x)&((1<<(y))-1))?(1<<(y))-((x)&((1<<(y))-1)):0))
 
@@ -301,6 +303,8 @@ static MT_Lock mbyteslock MT_LOCK_INITIALIZER("mbyteslock");
 static MT_Lock GDKstoppedLock MT_LOCK_INITIALIZER("GDKstoppedLock");
 #endif
 
+static MT_Lock accountlock MT_LOCK_INITIALIZER("accountlock");
+
 size_t _MT_pagesize = 0;	/* variable holding page size */
 size_t _MT_npages = 0;		/* variable holding memory size in pages */
 
@@ -453,6 +457,7 @@ GDKinit(opt *set, int setlen)
 	MT_lock_init(&MT_system_lock,"MT_system_lock");
 	ATOMIC_INIT(GDKstoppedLock);
 	ATOMIC_INIT(mbyteslock);
+	MT_lock_init(&accountlock, "accountlock");
 	MT_lock_init(&GDKnameLock, "GDKnameLock");
 	MT_lock_init(&GDKthreadLock, "GDKthreadLock");
 	MT_lock_init(&GDKtmLock, "GDKtmLock");
@@ -480,6 +485,7 @@ GDKinit(opt *set, int setlen)
 	if (mnstr_init() < 0)
 		return 0;
 	MT_init_posix();
+	MT_thread_init();
 	THRinit();
 #ifndef NATIVE_WIN32
 	BATSIGinit();
@@ -548,6 +554,8 @@ GDKinit(opt *set, int setlen)
 		if (strcmp("gdk_mem_maxsize", n[i].name) == 0) {
 			GDK_mem_maxsize = (size_t) strtoll(n[i].value, NULL, 10);
 			GDK_mem_maxsize = MAX(1 << 26, GDK_mem_maxsize);
+		} else if (strcmp("gdk_mem_budget", n[i].name) == 0) {
+			GDK_mem_budget = (size_t) strtoll(n[i].value, NULL, 10);
 		} else if (strcmp("gdk_vm_maxsize", n[i].name) == 0) {
 			GDK_vm_maxsize = (size_t) strtoll(n[i].value, NULL, 10);
 			GDK_vm_maxsize = MAX(1 << 30, GDK_vm_maxsize);
@@ -590,6 +598,8 @@ GDKinit(opt *set, int setlen)
 	GDKnr_threads = GDKgetenv_int("gdk_nr_threads", 0);
 	if (GDKnr_threads == 0)
 		GDKnr_threads = MT_check_nr_cores();
+	p = GDKgetenv("gdk_compress");
+	GDK_compress = p == NULL || strcasecmp(p, "no") != 0;
 
 	if ((p = GDKgetenv("gdk_dbpath")) != NULL &&
 	    (p = strrchr(p, DIR_SEP)) != NULL) {
@@ -694,6 +704,80 @@ GDKregister(MT_Id pid)
 	MT_lock_unset(&GDKthreadLock);
 }
 
+/* Run func on each of the nr elements of the array args (each argsize
+ * bytes large) using at most GDKnr_threads threads, the calling thread
+ * included.  The function returns when all elements have been done.
+ * If threads cannot be created, the calling thread does all the work
+ * by itself.  The helper threads are counted over all concurrent
+ * calls, so that when many callers run at the same time (e.g. the
+ * dataflow workers), no more than GDKnr_threads - 1 helpers exist;
+ * callers that find none available do the work by themselves. */
+static int GDKparallel_helpers = 0; /* protected by GDKthreadLock */
+
+struct parallel {
+	void (*func)(void *);
+	char *args;
+	size_t argsize;
+	int nr;
+	int next;
+	MT_Lock lock;
+};
+
+static void
+GDKparallel_worker(void *arg)
+{
+	struct parallel *p = arg;
+	int i;
+
+	for (;;) {
+		MT_lock_set(&p->lock);
+		i = p->next++;
+		MT_lock_unset(&p->lock);
+		if (i >= p->nr)
+			break;
+		(*p->func)(p->args + (size_t) i * p->argsize);
+	}
+}
+
+void
+GDKparallel(int nr, void (*func)(void *), void *args, size_t argsize)
+{
+	struct parallel p;
+	MT_Id *tids = NULL;
+	int i, n = 0, nthreads;
+
+	nthreads = GDKnr_threads > 1 ? GDKnr_threads : 1;
+	if (nthreads > nr)
+		nthreads = nr;
+	p.func = func;
+	p.args = args;
+	p.argsize = argsize;
+	p.nr = nr;
+	p.next = 0;
+	MT_lock_init(&p.lock, "GDKparallel");
+	MT_lock_set(&GDKthreadLock);
+	if (nthreads - 1 > GDKnr_threads - 1 - GDKparallel_helpers)
+		nthreads = GDKnr_threads - GDKparallel_helpers;
+	if (nthreads < 1)
+		nthreads = 1;
+	GDKparallel_helpers += nthreads - 1;
+	MT_lock_unset(&GDKthreadLock);
+	if (nthreads > 1 &&
+	    (tids = GDKmalloc((nthreads - 1) * sizeof(MT_Id))) != NULL) {
+		for (i = 0; i < nthreads - 1; i++)
+			if (MT_create_thread(&tids[n], GDKparallel_worker, &p, MT_THR_JOINABLE) == 0)
+				n++;
+	}
+	GDKparallel_worker(&p);
+	for (i = 0; i < n; i++)
+		MT_join_thread(tids[i]);
+	GDKfree(tids);
+	MT_lock_set(&GDKthreadLock);
+	GDKparallel_helpers -= nthreads - 1;
+	MT_lock_unset(&GDKthreadLock);
+	MT_lock_destroy(&p.lock);
+}
+
 /* coverity[+kill] */
 void
 GDKreset(int status, int exit)
@@ -780,6 +864,7 @@ GDKreset(int status, int exit)
 		GDKatomcnt = TYPE_str + 1;
 
 		GDK_vm_trim = 1;
+		GDK_compress = 1;
 
 		if (GDK_mem_maxsize / 16 < GDK_mmap_minsize_transient) {
 			GDK_mmap_minsize_transient = GDK_mem_maxsize / 16;
@@ -815,6 +900,7 @@ GDKreset(int status, int exit)
 	MT_lock_destroy(&GDKstoppedLock);
 	MT_lock_destroy(&mbyteslock);
 #endif
+	MT_lock_destroy(&accountlock);
 	MT_lock_destroy(&GDKnameLock);
 	MT_lock_destroy(&GDKthreadLock);
 	MT_lock_destroy(&GDKtmLock);
@@ -1507,6 +1593,212 @@ GDKvm_cursize(void)
 #define memdec(vmdelta)							\
 	(void) ATOMIC_SUB(GDK_vm_cursize, (ssize_t) SEG_SIZE((vmdelta), MT_VMUNITLOG), mbyteslock)
 
+/* Memory accounting
+ *
+ * Memory can be charged to an account, typically one per running
+ * query.  The account a thread works for is kept in thread-local
+ * storage.  GDKmalloc charges the blocks it hands out to that account
+ * and records the account in front of the block, so that a realloc or
+ * free is charged to the same account, whichever thread performs it.
+ * HEAPalloc likewise records the account in the heap for memory
+ * mapped heaps.  An account id combines a slot number with a
+ * generation count that is never reused, so that memory outliving its
+ * query (e.g. results kept in the SQL catalog) does not discharge a
+ * later user of the slot.
+ *
+ * Each account has an optional budget.  A heap that would push its
+ * account over budget, or all accounts together over GDK_mem_budget,
+ * is created memory mapped instead (spilled).  Queries are queued
+ * while the total is over GDK_mem_budget (see mal_runtime.c). */
+#define MAXACCOUNTS	256
+#define ACCOUNTSLOT(id)	((int) ((id) & (MAXACCOUNTS - 1)))
+
+static struct account {
+	volatile ATOMIC_TYPE used; /* bytes currently charged */
+	volatile ATOMIC_TYPE busy; /* charges in progress */
+	size_t peak;		/* high-water mark of used */
+	size_t budget;		/* 0: no per-account limit */
+	volatile lng id;	/* 0: slot is free, -1: being closed */
+} accounts[MAXACCOUNTS];
+static lng accountgen;
+static volatile ATOMIC_TYPE accounttotal; /* sum of used of all accounts */
+
+lng
+GDKaccount_open(size_t budget)
+{
+	int i;
+
+	MT_lock_set(&accountlock);
+	for (i = 1; i < MAXACCOUNTS; i++) {
+		if (accounts[i].id == 0) {
+			assert(accounts[i].used == 0);
+			accounts[i].id = ++accountgen * MAXACCOUNTS + i;
+			accounts[i].peak = 0;
+			accounts[i].budget = budget;
+			MT_lock_unset(&accountlock);
+			return accounts[i].id;
+		}
+	}
+	MT_lock_unset(&accountlock);
+	/* no slot available: memory of this query is not accounted */
+	return 0;
+}
+
+void
+GDKaccount_close(lng id)
+{
+	struct account *a = &accounts[ACCOUNTSLOT(id)];
+	size_t used;
+
+	if (id <= 0)
+		return;
+	MT_lock_set(&accountlock);
+	if (a->id != id) {
+		MT_lock_unset(&accountlock);
+		return;
+	}
+	a->id = -1;
+	MT_lock_unset(&accountlock);
+	/* wait for charges that saw the id before it was cleared */
+	while (ATOMIC_GET(a->busy, accountlock) != 0)
+		MT_sleep_ms(1);
+	used = (size_t) ATOMIC_GET(a->used, accountlock);
+	(void) ATOMIC_SUB(a->used, (ATOMIC_TYPE) used, accountlock);
+	(void) ATOMIC_SUB(accounttotal, (ATOMIC_TYPE) used, accountlock);
+	MT_lock_set(&accountlock);
+	a->id = 0;
+	MT_lock_unset(&accountlock);
+	if (MT_thread_getdata() == (void *) (intptr_t) id)
+		MT_thread_setdata(NULL);
+}
+
+/* The thread-local storage holds the id (its low bits if a pointer is
+ * smaller than a lng), which is only taken for the account in its
+ * slot if they match. */
+void
+GDKaccount_set(lng id)
+{
+	MT_thread_setdata((void *) (intptr_t) id);
+}
+
+lng
+GDKaccount_get(void)
+{
+	intptr_t v = (intptr_t) MT_thread_getdata();
+	lng id;
+
+	if (v <= 0)
+		return 0;
+	id = accounts[ACCOUNTSLOT(v)].id;
+	return (intptr_t) id == v ? id : 0;
+}
+
+size_t
+GDKaccount_cursize(lng id)
+{
+	struct account *a = &accounts[ACCOUNTSLOT(id)];
+
+	if (id <= 0 || a->id != id)
+		return 0;
+	return (size_t) ATOMIC_GET(a->used, accountlock);
+}
+
+size_t
+GDKaccount_peak(lng id)
+{
+	struct account *a = &accounts[ACCOUNTSLOT(id)];
+	size_t peak = 0;
+
+	MT_lock_set(&accountlock);
+	if (id > 0 && a->id == id)
+		peak = a->peak;
+	MT_lock_unset(&accountlock);
+	return peak;
+}
+
+size_t
+GDKaccount_total(void)
+{
+	return (size_t) ATOMIC_GET(accounttotal, accountlock);
+}
+
+/* charge (delta > 0) or discharge (delta < 0) an account; stale ids
+ * of closed accounts are ignored */
+void
+GDKaccount_charge(lng id, ssize_t delta)
+{
+	struct account *a = &accounts[ACCOUNTSLOT(id)];
+	size_t used;
+
+	if (id <= 0 || delta == 0 || a->id != id)
+		return;
+	(void) ATOMIC_INC(a->busy, accountlock);
+	if (a->id == id) {
+		if (delta > 0) {
+			used = (size_t) ATOMIC_ADD(a->used, (ATOMIC_TYPE) delta, accountlock) + (size_t) delta;
+			(void) ATOMIC_ADD(accounttotal, (ATOMIC_TYPE) delta, accountlock);
+			if (used > a->peak) {
+				MT_lock_set(&accountlock);
+				if (used > a->peak)
+					a->peak = used;
+				MT_lock_unset(&accountlock);
+			}
+		} else {
+			used = (size_t) ATOMIC_SUB(a->used, (ATOMIC_TYPE) -delta, accountlock);
+			(void) ATOMIC_SUB(accounttotal, (ATOMIC_TYPE) -delta, accountlock);
+			/* never more discharged than was charged */
+			assert(used >= (size_t) -delta);
+		}
+	}
+	(void) ATOMIC_DEC(a->busy, accountlock);
+}
+
+/* Check whether size more bytes can be charged to the account.
+ * Returns 0 if they fit in its budget and in GDK_mem_budget, and 1 if
+ * the memory should be spilled to disk. */
+int
+GDKaccount_check(lng id, size_t size)
+{
+	struct account *a = &accounts[ACCOUNTSLOT(id)];
+
+	if (id <= 0 || a->id != id)
+		return 0;
+	if (a->budget > 0 && GDKaccount_cursize(id) + size > a->budget)
+		return 1;
+	if (GDK_mem_budget > 0 && GDKaccount_total() + size > GDK_mem_budget)
+		return 1;
+	return 0;
+}
+
+/* Number of bytes that can still be charged to the account without
+ * exceeding its budget, GDK_mem_budget, or the memory GDK may use in
+ * total. */
+size_t
+GDKaccount_avail(lng id)
+{
+	struct account *a = &accounts[ACCOUNTSLOT(id)];
+	size_t used = GDKmem_cursize();
+	size_t avail = used < GDK_mem_maxsize ? GDK_mem_maxsize - used : 0;
+
+	if (id <= 0 || a->id != id)
+		return avail;
+	if (a->budget > 0) {
+		used = GDKaccount_cursize(id);
+		if (used >= a->budget)
+			return 0;
+		if (a->budget - used < avail)
+			avail = a->budget - used;
+	}
+	if (GDK_mem_budget > 0) {
+		used = GDKaccount_total();
+		if (used >= GDK_mem_budget)
+			return 0;
+		if (GDK_mem_budget - used < avail)
+			avail = GDK_mem_budget - used;
+	}
+	return avail;
+}
+
 #ifndef STATIC_CODE_ANALYSIS
 
 static void
@@ -1547,10 +1839,17 @@ GDKmemfail(const char *s, size_t len)
  * memory is being used.  In debug builds, the size is also used to
  * make sure that we don't write outside of the allocated arena.  This
  * is also where the extra space at the end comes in.
+ *
+ * Memory allocated by a thread working for a memory account is charged
+ * to that account.  Such areas have yet more space in front, holding
+ * the account id, and the lowest bit of the size is set to indicate
+ * this.
  */
 
 /* we allocate extra space and return a pointer offset by this amount */
 #define MALLOC_EXTRA_SPACE	(2 * SIZEOF_VOID_P)
+/* and this much more in front for the account id */
+#define MALLOC_ACCOUNT_SPACE	(2 * SIZEOF_VOID_P)
 
 #ifdef NDEBUG
 #define DEBUG_SPACE	0
@@ -1562,7 +1861,8 @@ static void *
 GDKmalloc_internal(size_t size)
 {
 	void *s;
-	size_t nsize;
+	size_t nsize, front = MALLOC_EXTRA_SPACE;
+	lng acct = GDKaccount_get();
 
 	assert(size != 0);
 #ifndef NDEBUG
@@ -1586,18 +1886,24 @@ GDKmalloc_internal(size_t size)
 	 * write real size in front; when debugging, also allocate
 	 * extra space for check bytes */
 	nsize = (size + 7) & ~7;
-	if ((s = malloc(nsize + MALLOC_EXTRA_SPACE + DEBUG_SPACE)) == NULL) {
+	if (acct)
+		front += MALLOC_ACCOUNT_SPACE;
+	if ((s = malloc(nsize + front + DEBUG_SPACE)) == NULL) {
 		GDKmemfail("GDKmalloc", size);
 		GDKerror("GDKmalloc_internal: failed for " SZFMT " bytes", size);
 		return NULL;
 	}
-	s = (void *) ((char *) s + MALLOC_EXTRA_SPACE);
+	if (acct) {
+		* (lng *) s = acct;
+		GDKaccount_charge(acct, (ssize_t) (nsize + front + DEBUG_SPACE));
+	}
+	s = (void *) ((char *) s + front);
 
-	heapinc(nsize + MALLOC_EXTRA_SPACE + DEBUG_SPACE);
+	heapinc(nsize + front + DEBUG_SPACE);
 
 	/* just before the pointer that we return, write how much we
-	 * asked of malloc */
-	((size_t *) s)[-1] = nsize + MALLOC_EXTRA_SPACE + DEBUG_SPACE;
+	 * asked of malloc, and whether it is charged to an account */
+	((size_t *) s)[-1] = (nsize + front + DEBUG_SPACE) | (acct != 0);
 #ifndef NDEBUG
 	/* just before that, write how much was asked of us */
 	((size_t *) s)[-2] = size;
@@ -1671,19 +1977,24 @@ GDKstrndup(const char *s, size_t size)
 void
 GDKfree(void *s)
 {
-	size_t asize;
+	size_t asize, front = MALLOC_EXTRA_SPACE;
 
 	if (s == NULL)
 		return;
 
 	asize = ((size_t *) s)[-1]; /* how much allocated last */
+	if (asize & 1) {
+		/* charged to an account */
+		asize &= ~(size_t) 1;
+		front += MALLOC_ACCOUNT_SPACE;
+	}
 
 #ifndef NDEBUG
 	assert((asize & 2) == 0);   /* check against duplicate free */
 	/* check for out-of-bounds writes */
 	{
 		size_t i = ((size_t *) s)[-2]; /* how much asked for last */
-		for (; i < asize - MALLOC_EXTRA_SPACE; i++)
+		for (; i < asize - front; i++)
 			assert(((char *) s)[i] == '\xBD');
 	}
 	((size_t *) s)[-1] |= 2; /* indicate area is freed */
@@ -1693,10 +2004,12 @@ GDKfree(void *s)
 	/* overwrite memory that is to be freed with a pattern that
 	 * will help us recognize access to already freed memory in
 	 * the debugger */
-	DEADBEEFCHK memset(s, '\xDB', asize - MALLOC_EXTRA_SPACE);
+	DEADBEEFCHK memset(s, '\xDB', asize - front);
 #endif
 
-	free((char *) s - MALLOC_EXTRA_SPACE);
+	if (front > MALLOC_EXTRA_SPACE)
+		GDKaccount_charge(* (lng *) ((char *) s - front), -(ssize_t) asize);
+	free((char *) s - front);
 	heapdec((ssize_t) asize);
 }
 
@@ -1704,7 +2017,7 @@ GDKfree(void *s)
 void *
 GDKrealloc(void *s, size_t size)
 {
-	size_t nsize, asize;
+	size_t nsize, asize, front = MALLOC_EXTRA_SPACE;
 #ifndef NDEBUG
 	size_t osize;
 	size_t *os;
@@ -1717,6 +2030,11 @@ GDKrealloc(void *s, size_t size)
 
 	nsize = (size + 7) & ~7;
 	asize = ((size_t *) s)[-1]; /* how much allocated last */
+	if (asize & 1) {
+		/* charged to an account, and stays so */
+		asize &= ~(size_t) 1;
+		front += MALLOC_ACCOUNT_SPACE;
+	}
 
 	if (nsize > asize &&
 	    GDKvm_cursize() + nsize - asize >= GDK_vm_maxsize) {
@@ -1729,7 +2047,7 @@ GDKrealloc(void *s, size_t size)
 	osize = ((size_t *) s)[-2]; /* how much asked for last */
 	{
 		size_t i;
-		for (i = osize; i < asize - MALLOC_EXTRA_SPACE; i++)
+		for (i = osize; i < asize - front; i++)
 			assert(((char *) s)[i] == '\xBD');
 	}
 	/* if shrinking, write debug pattern into to-be-freed memory */
@@ -1738,8 +2056,8 @@ GDKrealloc(void *s, size_t size)
 	os = s;
 	os[-1] |= 2;		/* indicate area is freed */
 #endif
-	s = realloc((char *) s - MALLOC_EXTRA_SPACE,
-		    nsize + MALLOC_EXTRA_SPACE + DEBUG_SPACE);
+	s = realloc((char *) s - front,
+		    nsize + front + DEBUG_SPACE);
 	if (s == NULL) {
 #ifndef NDEBUG
 		os[-1] &= ~2;	/* not freed after all */
@@ -1748,10 +2066,12 @@ GDKrealloc(void *s, size_t size)
 		GDKerror("GDKrealloc: failed for " SZFMT " bytes", size);
 		return NULL;
 	}
-	s = (void *) ((char *) s + MALLOC_EXTRA_SPACE);
+	if (front > MALLOC_EXTRA_SPACE)
+		GDKaccount_charge(* (lng *) s, (ssize_t) (nsize + front + DEBUG_SPACE) - (ssize_t) asize);
+	s = (void *) ((char *) s + front);
 	/* just before the pointer that we return, write how much we
 	 * asked of malloc */
-	((size_t *) s)[-1] = nsize + MALLOC_EXTRA_SPACE + DEBUG_SPACE;
+	((size_t *) s)[-1] = (nsize + front + DEBUG_SPACE) | (front > MALLOC_EXTRA_SPACE);
 #ifndef NDEBUG
 	/* just before that, write how much was asked of us */
 	((size_t *) s)[-2] = size;
@@ -1762,7 +2082,7 @@ GDKrealloc(void *s, size_t size)
 	memset((char *) s + size, '\xBD', nsize + DEBUG_SPACE - size);
 #endif
 
-	heapinc(nsize + MALLOC_EXTRA_SPACE + DEBUG_SPACE);
+	heapinc(nsize + front + DEBUG_SPACE);
 	heapdec((ssize_t) asize);
 
 	return s;
@@ -0,0 +1,365 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2017 MonetDB B.V.
+ */
+
+/*
+ * Zone maps keep the minimum and maximum value of each block of
+ * ZMAP_BLOCK consecutive values of a column.  They are much coarser
+ * than imprints, but unlike imprints they are maintained when values
+ * are appended, so that append-mostly columns (e.g. time series) keep
+ * their block level skipping after every load.  An in-place update
+ * widens the zone of the updated value, all other changes destroy the
+ * zone map.
+ *
+ * The zone map of a persistent BAT is saved together with the BAT
+ * (see BATsave).  A saved zone map may cover fewer values than the
+ * BAT when values were appended while it was not loaded; the missing
+ * zones are then computed when it is loaded.
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "gdk_private.h"
+
+#define ZMAP_VERSION	((oid) 1)
+
+/* size in bytes of a zone map covering n values of b */
+#define ZMAPsize(b, n)	((size_t) ZMAPOFF * SIZEOF_OID +		\
+			 (size_t) (((n) + ZMAP_BLOCK - 1) / ZMAP_BLOCK) * 2 * (b)->twidth)
+
+/* return whether we can maintain a zone map for type tpe */
+int
+ZMAPtype(int tpe)
+{
+	switch (ATOMbasetype(tpe)) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+#define zones(TYPE)							\
+	do {								\
+		const TYPE *restrict v = (const TYPE *) Tloc(b, 0);	\
+		TYPE *restrict z = (TYPE *) ZMAPzones(hp);		\
+		TYPE mn, mx;						\
+		BUN e, zn;						\
+									\
+		for (i = from; i < to; ) {				\
+			zn = i / ZMAP_BLOCK;				\
+			e = MIN((zn + 1) * ZMAP_BLOCK, to);		\
+			if (i % ZMAP_BLOCK == 0) {			\
+				/* start of a new zone */		\
+				mn = mx = v[i++];			\
+			} else {					\
+				mn = z[2 * zn];				\
+				mx = z[2 * zn + 1];			\
+			}						\
+			for (; i < e; i++) {				\
+				if (v[i] < mn)				\
+					mn = v[i];			\
+				else if (v[i] > mx)			\
+					mx = v[i];			\
+			}						\
+			z[2 * zn] = mn;					\
+			z[2 * zn + 1] = mx;				\
+		}							\
+	} while (0)
+
+/* update the zone map hp so that it covers all values of b */
+static gdk_return
+ZMAPextend(BAT *b, Heap *hp)
+{
+	BUN from = ZMAPcount(hp), to = BATcount(b), i;
+	size_t size = ZMAPsize(b, to);
+
+	assert(from <= to);
+	if (from == to)
+		return GDK_SUCCEED;
+	if (size > hp->size &&
+	    HEAPextend(hp, size + (size >> 2), 0) != GDK_SUCCEED)
+		return GDK_FAIL;
+	switch (ATOMbasetype(b->ttype)) {
+	case TYPE_bte:
+		zones(bte);
+		break;
+	case TYPE_sht:
+		zones(sht);
+		break;
+	case TYPE_int:
+		zones(int);
+		break;
+	case TYPE_lng:
+		zones(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		zones(hge);
+		break;
+#endif
+	case TYPE_flt:
+		zones(flt);
+		break;
+	case TYPE_dbl:
+		zones(dbl);
+		break;
+	default:
+		assert(0);
+	}
+	((oid *) hp->base)[1] = (oid) to;
+	hp->free = size;
+	hp->dirty = 1;
+	return GDK_SUCCEED;
+}
+
+/* return TRUE if we have a zone map on the tail, even if we need to
+ * read one from disk */
+int
+BATcheckzonemap(BAT *b)
+{
+	int ret;
+
+	if (b == NULL)
+		return 0;
+	assert(b->batCacheid > 0);
+	/* we don't need the lock just to read the value b->tzonemap */
+	if (b->tzonemap == NULL)
+		return 0;
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if (b->tzonemap == (Heap *) 1) {
+		Heap *hp;
+		const char *nme = BBP_physical(b->batCacheid);
+		int fd;
+
+		b->tzonemap = NULL;
+		if ((hp = GDKzalloc(sizeof(*hp))) != NULL &&
+		    (hp->farmid = BBPselectfarm(b->batRole, b->ttype, zonemapheap)) >= 0 &&
+		    (hp->filename = GDKmalloc(strlen(nme) + 10)) != NULL) {
+			sprintf(hp->filename, "%s.tzonemap", nme);
+
+			/* check whether a persisted zone map can be found */
+			if ((fd = GDKfdlocate(hp->farmid, nme, "rb", "tzonemap")) >= 0) {
+				struct stat st;
+				oid hdata[ZMAPOFF];
+				int ok;
+
+				ok = read(fd, hdata, sizeof(hdata)) == sizeof(hdata) &&
+					hdata[0] == ZMAP_VERSION &&
+					hdata[1] <= (oid) BATcount(b) &&
+					fstat(fd, &st) == 0 &&
+					st.st_size >= (off_t) (hp->size = hp->free = ZMAPsize(b, hdata[1]));
+				close(fd);
+				if (ok &&
+				    HEAPload(hp, nme, "tzonemap", 0) == GDK_SUCCEED) {
+					if (ZMAPextend(b, hp) == GDK_SUCCEED) {
+						b->tzonemap = hp;
+						ALGODEBUG fprintf(stderr, "#BATcheckzonemap: reusing persisted zone map %d\n", b->batCacheid);
+						MT_lock_unset(&GDKhashLock(b->batCacheid));
+						return 1;
+					}
+					HEAPfree(hp, 0);
+				}
+				/* unlink unusable file */
+				GDKunlink(hp->farmid, BATDIR, nme, "tzonemap");
+			}
+			GDKfree(hp->filename);
+		}
+		GDKfree(hp);
+		GDKclrerr();	/* we're not currently interested in errors */
+	}
+	ret = b->tzonemap != NULL;
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+	return ret;
+}
+
+/* create the zone map of b (or of its parent if b is a view) */
+gdk_return
+BATzonemap(BAT *b)
+{
+	Heap *hp;
+	const char *nme;
+	size_t nmelen;
+	lng t0 = 0;
+
+	BATcheck(b, "BATzonemap", GDK_FAIL);
+	if (VIEWtparent(b)) {
+		b = BBPdescriptor(VIEWtparent(b));
+		assert(b);
+	}
+	if (!ZMAPtype(b->ttype)) {
+		GDKerror("BATzonemap: unsupported type\n");
+		return GDK_FAIL;
+	}
+	if (BATcheckzonemap(b))
+		return GDK_SUCCEED;
+	ALGODEBUG t0 = GDKusec();
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if (b->tzonemap != NULL) {
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		return GDK_SUCCEED;
+	}
+	nme = BBP_physical(b->batCacheid);
+	nmelen = strlen(nme) + 10;
+	if ((hp = GDKzalloc(sizeof(Heap))) == NULL ||
+	    (hp->farmid = BBPselectfarm(b->batRole, b->ttype, zonemapheap)) < 0 ||
+	    (hp->filename = GDKmalloc(nmelen)) == NULL ||
+	    snprintf(hp->filename, nmelen, "%s.tzonemap", nme) < 0 ||
+	    HEAPalloc(hp, ZMAPsize(b, BATcount(b)), 1) != GDK_SUCCEED) {
+		if (hp)
+			GDKfree(hp->filename);
+		GDKfree(hp);
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		return GDK_FAIL;
+	}
+	((oid *) hp->base)[0] = ZMAP_VERSION;
+	((oid *) hp->base)[1] = 0;
+	hp->free = ZMAPsize(b, 0);
+	if (ZMAPextend(b, hp) != GDK_SUCCEED) {
+		HEAPfree(hp, 1);
+		GDKfree(hp);
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		return GDK_FAIL;
+	}
+	b->tzonemap = hp;
+	ALGODEBUG fprintf(stderr, "#BATzonemap(%s#" BUNFMT "): created zone map (" LLFMT " usec)\n", BATgetId(b), BATcount(b), GDKusec() - t0);
+	/* a dirty bat saves its zone map when it is saved itself */
+	if (b->batRole == PERSISTENT &&
+	    (BBP_status(b->batCacheid) & BBPEXISTING) &&
+	    !BATdirty(b) &&
+	    HEAPsave(hp, nme, "tzonemap") == GDK_SUCCEED)
+		hp->dirty = 0;
+	GDKclrerr();		/* not interested in errors saving the zone map */
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+	return GDK_SUCCEED;
+}
+
+/* extend the zone map (if any) after values were appended to b */
+void
+ZMAPappend(BAT *b)
+{
+	Heap *hp;
+
+	if (b->tzonemap == NULL)
+		return;
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	/* an unloaded zone map is extended when it is loaded */
+	if ((hp = b->tzonemap) != NULL && hp != (Heap *) 1 &&
+	    ZMAPextend(b, hp) != GDK_SUCCEED) {
+		b->tzonemap = NULL;
+		HEAPdelete(hp, BBP_physical(b->batCacheid), "tzonemap");
+		GDKfree(hp);
+		GDKclrerr();	/* not interested in errors */
+	}
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+}
+
+/* value v is written at position p of b: widen its zone */
+void
+ZMAPinplace(BAT *b, BUN p, const void *v)
+{
+	Heap *hp;
+	int (*cmp)(const void *, const void *);
+	int w = b->twidth;
+	char *z;
+
+	if (b->tzonemap == NULL)
+		return;
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if ((hp = b->tzonemap) == (Heap *) 1) {
+		/* not worth loading just to change it */
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		ZMAPdestroy(b);
+		return;
+	}
+	if (hp != NULL && p < ZMAPcount(hp)) {
+		cmp = ATOMcompare(b->ttype);
+		z = ZMAPzones(hp) + (p / ZMAP_BLOCK) * 2 * w;
+		if ((*cmp)(v, z) < 0) {
+			memcpy(z, v, w);
+			hp->dirty = 1;
+		} else if ((*cmp)(v, z + w) > 0) {
+			memcpy(z + w, v, w);
+			hp->dirty = 1;
+		}
+	}
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+}
+
+/* save a changed zone map of a bat that is being saved */
+void
+ZMAPsave(BAT *b)
+{
+	Heap *hp;
+	const char *nme;
+
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if ((hp = b->tzonemap) != NULL && hp != (Heap *) 1 && hp->dirty) {
+		nme = BBP_physical(b->batCacheid);
+		if (HEAPsave(hp, nme, "tzonemap") == GDK_SUCCEED) {
+			hp->dirty = 0;
+		} else {
+			/* don't leave an outdated zone map behind */
+			GDKunlink(hp->farmid, BATDIR, nme, "tzonemap");
+			GDKclrerr();
+		}
+	}
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+}
+
+void
+ZMAPfree(BAT *b)
+{
+	if (b) {
+		Heap *hp;
+
+		MT_lock_set(&GDKhashLock(b->batCacheid));
+		if ((hp = b->tzonemap) != NULL && hp != (Heap *) 1) {
+			if (hp->dirty) {
+				/* the version on disk (if any) is
+				 * outdated */
+				b->tzonemap = NULL;
+				HEAPdelete(hp, BBP_physical(b->batCacheid), "tzonemap");
+			} else {
+				b->tzonemap = (Heap *) 1;
+				HEAPfree(hp, 0);
+			}
+			GDKfree(hp);
+		}
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+	}
+}
+
+void
+ZMAPdestroy(BAT *b)
+{
+	if (b) {
+		Heap *hp;
+
+		MT_lock_set(&GDKhashLock(b->batCacheid));
+		hp = b->tzonemap;
+		b->tzonemap = NULL;
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		if (hp == (Heap *) 1) {
+			GDKunlink(BBPselectfarm(b->batRole, b->ttype, zonemapheap),
+				  BATDIR,
+				  BBP_physical(b->batCacheid),
+				  "tzonemap");
+		} else if (hp != NULL) {
+			HEAPdelete(hp, BBP_physical(b->batCacheid), "tzonemap");
+			GDKfree(hp);
+		}
+	}
+}
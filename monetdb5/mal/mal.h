@@ -223,6 +223,9 @@ typedef struct MALBLK {
 	int calls;				/* number of calls */
 	lng optimize;			/* total optimizer time */
 	int activeClients;		/* load during mitosis optimization */
+	char mitosis[2 * IDLENGTH];	/* schema.table split by mitosis, for feedback */
+	int npipelines;			/* blocks run over morsels by pipeline.run */
+	struct MALBLK **pipelines;
 } *MalBlkPtr, MalBlkRecord;
 
 #define STACKINCR   128
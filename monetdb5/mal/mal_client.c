@@ -229,6 +229,7 @@ MCinitClientRecord(Client c, oid user, bstream *fin, stream *fout)
 	c->session = GDKusec();
 	c->qtimeout = 0;
 	c->stimeout = 0;
+	c->memaccount = 0;
 	c->itrace = 0;
 	c->flags = 0;
 	c->errbuf = 0;
@@ -385,6 +386,7 @@ freeClient(Client c)
 	//c->active = 0;
 	c->qtimeout = 0;
 	c->stimeout = 0;
+	c->memaccount = 0;
 	c->user = oid_nil;
 	if( c->username){
 		GDKfree(c->username);
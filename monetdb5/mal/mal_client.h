@@ -172,6 +172,7 @@ typedef struct CLIENT {
 	 */
 	bit		active;		/* processing a query or not */
 	Workset inprogress[THREADS];
+	lng memaccount;	/* GDK memory account of the running query */
 	/*
 	 * The workload for replication/replay is saved initially as a MAL block.
 	 * It is split into the capturing part (wlc) and the replay part (wlr).
@@ -45,6 +45,7 @@ typedef struct FLOWEVENT {
 	sht state;      /* of execution */
 	lng clk;
 	sht cost;
+	int wrk;        /* worker that executed it, -1 if not yet */
 	lng hotclaim;   /* memory foot print of result variables */
 	lng argclaim;   /* memory foot print of arguments */
 	lng maxclaim;   /* memory foot print of  largest argument, counld be used to indicate result size */
@@ -82,9 +83,11 @@ static struct worker {
 	enum {IDLE, RUNNING, JOINING, EXITED} flag;
 	Client cntxt;				/* client we do work for (NULL -> any) */
 	MT_Sema s;
+	Queue *q;					/* local instructions, others may steal */
 } workers[THREADS];
 
 static Queue *todo = 0;	/* pending instructions */
+static int nrworkers = 0;	/* high water mark of worker slots in use */
 
 #ifdef ATOMIC_LOCK
 static MT_Lock exitingLock MT_LOCK_INITIALIZER("exitingLock");
@@ -92,11 +95,19 @@ static MT_Lock exitingLock MT_LOCK_INITIALIZER("exitingLock");
 static volatile ATOMIC_TYPE exiting = 0;
 static MT_Lock dataflowLock MT_LOCK_INITIALIZER("dataflowLock");
 
+static void q_destroy(Queue *q);
+
 void
 mal_dataflow_reset(void)
 {
+	int i;
+
 	stopMALdataflow();
+	for (i = 0; i < THREADS; i++)
+		if (workers[i].q)
+			q_destroy(workers[i].q);
 	memset((char*) workers, 0,  sizeof(workers));
+	nrworkers = 0;
 	if( todo) {
 		GDKfree(todo->data);
 		MT_lock_destroy(&todo->l);
@@ -221,45 +232,15 @@ q_requeue(Queue *q, FlowEvent d)
 #endif
 
 static FlowEvent
-q_dequeue(Queue *q, Client cntxt)
+q_dequeue(Queue *q)
 {
-	FlowEvent r = NULL, s = NULL;
-	//int i;
+	FlowEvent r = NULL;
 
 	assert(q);
 	MT_sema_down(&q->s);
 	if (ATOMIC_GET(exiting, exitingLock))
 		return NULL;
 	MT_lock_set(&q->l);
-	if (cntxt) {
-		int i, minpc = -1;
-
-		for (i = q->last - 1; i >= 0; i--) {
-			if (q->data[i]->flow->cntxt == cntxt) {
-				if(minpc < 0){
-					minpc = i;
-					s = q->data[i];
-				}
-				r = q->data[i];
-				if( s && r && s->pc > r->pc){
-					minpc = i;
-					s = r;
-				}
-			}
-		}
-		if( minpc >= 0){
-			r = q->data[minpc];
-			i = minpc;
-			q->last--;
-			while (i < q->last) {
-				q->data[i] = q->data[i + 1];
-				i++;
-			}
-		} else r = NULL;
-
-		MT_lock_unset(&q->l);
-		return r;
-	}
 	if (q->exitcount > 0) {
 		q->exitcount--;
 		MT_lock_unset(&q->l);
@@ -299,6 +280,130 @@ q_dequeue(Queue *q, Client cntxt)
 	return r;
 }
 
+/*
+ * Next to the shared todo queue, each worker has a local queue.
+ * Instructions that become eligible are placed in the local queue of
+ * the worker that produced their argument, so that the consumer is
+ * likely to find its input in the cache of that core.  A worker first
+ * looks in its own queue (LIFO), then in the shared one, and finally
+ * steals the oldest instruction from another worker.  This way the
+ * lock on the shared queue is no longer taken for every instruction.
+ * The semaphore of the todo queue counts the instructions in all
+ * queues together.
+ */
+static FlowEvent
+q_take_(Queue *q, Client cntxt, int steal)
+{
+	FlowEvent r = NULL;
+	int i, k = -1;
+
+	if (cntxt) {
+		/* only instructions of our client, lowest pc first */
+		for (i = q->last - 1; i >= 0; i--)
+			if (q->data[i]->flow->cntxt == cntxt &&
+			    (k < 0 || q->data[i]->pc < q->data[k]->pc))
+				k = i;
+	} else if (q->last > 0) {
+		k = steal ? 0 : q->last - 1;
+	}
+	if (k >= 0) {
+		r = q->data[k];
+		q->last--;
+		if (k < q->last)
+			memmove(q->data + k, q->data + k + 1, (q->last - k) * sizeof(FlowEvent));
+		q->data[q->last] = 0;
+	}
+	return r;
+}
+
+static FlowEvent
+q_take(Queue *q, Client cntxt, int steal)
+{
+	FlowEvent r;
+
+	if (q == NULL)
+		return NULL;
+	MT_lock_set(&q->l);
+	r = q_take_(q, cntxt, steal);
+	MT_lock_unset(&q->l);
+	return r;
+}
+
+static void
+q_place(int wrk, FlowEvent fe)
+{
+	Queue *q = todo;
+
+	/* a specific worker only ever runs instructions of its own
+	 * client, so its consumers are always eligible for it */
+	if (wrk >= 0 && workers[wrk].q)
+		q = workers[wrk].q;
+	MT_lock_set(&q->l);
+	q_enqueue_(q, fe);
+	MT_lock_unset(&q->l);
+	MT_sema_up(&todo->s);
+}
+
+/*
+ * Having passed the semaphore, a worker is entitled to one of the
+ * queued instructions, but looking at the queues one at a time it may
+ * miss it while other workers take and place instructions.  If so, it
+ * looks again with all queues locked (the todo queue first, then the
+ * local ones in worker order), which cannot fail.
+ */
+static FlowEvent
+DFLOWdequeue(struct worker *t, Client cntxt)
+{
+	FlowEvent r;
+	int i, n, id = (int) (t - workers);
+
+	MT_sema_down(&todo->s);
+	if (ATOMIC_GET(exiting, exitingLock))
+		return NULL;
+	if (cntxt == NULL) {
+		MT_lock_set(&todo->l);
+		if (todo->exitcount > 0) {
+			todo->exitcount--;
+			MT_lock_unset(&todo->l);
+			return NULL;
+		}
+		MT_lock_unset(&todo->l);
+	}
+	if ((r = q_take(t->q, cntxt, 0)) != NULL ||
+	    (r = q_take(todo, cntxt, 0)) != NULL)
+		return r;
+	MT_lock_set(&dataflowLock);
+	n = nrworkers;
+	MT_lock_unset(&dataflowLock);
+	for (i = 1; i < n; i++) {
+		if ((r = q_take(workers[(id + i) % n].q, cntxt, 1)) != NULL) {
+			PARDEBUG fprintf(stderr, "#worker %d stole pc= %d from %d\n", id, r->pc, (id + i) % n);
+			return r;
+		}
+	}
+	if (cntxt)
+		return NULL;
+	MT_lock_set(&todo->l);
+	for (i = 0; i < n; i++)
+		if (workers[i].q)
+			MT_lock_set(&workers[i].q->l);
+	if (todo->exitcount > 0) {
+		/* our turn was taken by an exit request */
+		todo->exitcount--;
+	} else {
+		r = q_take_(todo, NULL, 0);
+		for (i = 0; i < n && r == NULL; i++)
+			if (workers[i].q)
+				r = q_take_(workers[i].q, NULL, 1);
+		assert(r != NULL);
+	}
+	for (i = n - 1; i >= 0; i--)
+		if (workers[i].q)
+			MT_lock_unset(&workers[i].q->l);
+	MT_lock_unset(&todo->l);
+	return r;
+}
+
 /*
  * We simply move an instruction into the front of the queue.
  * Beware, we assume that variables are assigned a value once, otherwise
@@ -352,7 +457,7 @@ DFLOWworker(void *T)
 			MT_lock_set(&dataflowLock);
 			cntxt = t->cntxt;
 			MT_lock_unset(&dataflowLock);
-			fe = q_dequeue(todo, cntxt);
+			fe = DFLOWdequeue(t, cntxt);
 			if (fe == NULL) {
 				if (cntxt) {
 					/* we're not done yet with work for the current
@@ -408,6 +513,7 @@ DFLOWworker(void *T)
 		MALadmission(-fe->argclaim, -fe->hotclaim);
 #endif
 		/* update the numa information. keep the thread-id producing the value */
+		fe->wrk = id;
 		p= getInstrPtr(flow->mb,fe->pc);
 		for( i = 0; i < p->argc; i++)
 			setVarWorker(flow->mb,getArg(p,i),thr->tid);
@@ -511,6 +617,8 @@ DFLOWinitialize(void)
 	for (i = 0; i < THREADS; i++)
 		MT_sema_init(&workers[i].s, 0, "DFLOWinitialize");
 	limit = GDKnr_threads ? GDKnr_threads - 1 : 0;
+	if (limit > THREADS)
+		limit = THREADS;
 #ifdef NEED_MT_LOCK_INIT
 	ATOMIC_INIT(exitingLock);
 	MT_lock_init(&dataflowLock, "dataflowLock");
@@ -519,11 +627,14 @@ DFLOWinitialize(void)
 	for (i = 0; i < limit; i++) {
 		workers[i].flag = RUNNING;
 		workers[i].cntxt = NULL;
+		if (workers[i].q == NULL)
+			workers[i].q = q_create(256, "worker->q");
 		if (MT_create_thread(&workers[i].id, DFLOWworker, (void *) &workers[i], MT_THR_JOINABLE) < 0)
 			workers[i].flag = IDLE;
 		else
 			created++;
 	}
+	nrworkers = limit;
 	MT_lock_unset(&dataflowLock);
 	if (created == 0) {
 		/* no threads created */
@@ -570,6 +681,7 @@ DFLOWinitBlk(DataFlow flow, MalBlkPtr mb, int size)
 		flow->status[n].pc = pc;
 		flow->status[n].state = DFLOWpending;
 		flow->status[n].cost = -1;
+		flow->status[n].wrk = -1;
 		flow->status[n].flow->error = NULL;
 
 		/* administer flow dependencies */
@@ -749,7 +861,7 @@ DFLOWscheduler(DataFlow flow, struct worker *w)
 	PARDEBUG fprintf(stderr, "#run %d instructions in dataflow block\n", actions);
 
 	while (actions != tasks ) {
-		f = q_dequeue(flow->done, NULL);
+		f = q_dequeue(flow->done);
 		if (ATOMIC_GET(exiting, exitingLock))
 			break;
 		if (f == NULL)
@@ -769,7 +881,7 @@ DFLOWscheduler(DataFlow flow, struct worker *w)
 				if (flow->status[i].blocks == 1 ) {
 					flow->status[i].state = DFLOWrunning;
 					flow->status[i].blocks--;
-					q_enqueue(todo, flow->status + i);
+					q_place(f->wrk, flow->status + i);
 					PARDEBUG fprintf(stderr, "#enqueue pc=%d claim= " LLFMT "\n", flow->status[i].pc, flow->status[i].argclaim);
 				} else {
 					flow->status[i].blocks--;
@@ -885,6 +997,10 @@ runMALdataflow(Client cntxt, MalBlkPtr mb, int startpc, int stoppc, MalStkPtr st
 				workers[i].cntxt = cntxt;
 			}
 			workers[i].flag = RUNNING;
+			if (workers[i].q == NULL)
+				workers[i].q = q_create(256, "worker->q");
+			if (i >= nrworkers)
+				nrworkers = i + 1;
 			if (MT_create_thread(&workers[i].id, DFLOWworker, (void *) &workers[i], MT_THR_JOINABLE) < 0) {
 				/* cannot start new thread, run serially */
 				*ret = TRUE;
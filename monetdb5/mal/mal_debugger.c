@@ -315,7 +315,7 @@ printBATproperties(stream *f, BAT *b)
 	mnstr_printf(f, " count=" BUNFMT " lrefs=%d ",
 			BATcount(b), BBP_lrefs(b->batCacheid));
 	if (BBP_refs(b->batCacheid) - 1)
-		mnstr_printf(f, " refs=%d ", BBP_refs(b->batCacheid));
+		mnstr_printf(f, " refs=%d ", (int) BBP_refs(b->batCacheid));
 	if (b->batSharecnt)
 		mnstr_printf(f, " views=%d", b->batSharecnt);
 	if (b->theap.parentid)
@@ -544,6 +544,10 @@ void printFunction(stream *fd, MalBlkPtr mb, MalStkPtr stk, int flg)
 			for(j= 0; j< p->retc; j++)
 				setVarUsed(mb, getArg(p,j));
 	}
+	// the results of the function are used by its caller
+	if( mb->stop > 0)
+		for(p= getInstrPtr(mb,0), j= 0; j< p->retc; j++)
+			setVarUsed(mb, getArg(p,j));
 	listFunction(fd,mb,stk,flg,0,mb->stop);
 }
 
@@ -562,6 +566,10 @@ void fprintFunction(FILE *fd, MalBlkPtr mb, MalStkPtr stk, int flg)
 			for(j= 0; j< p->retc; j++)
 				setVarUsed(mb, getArg(p,j));
 	}
+	// the results of the function are used by its caller
+	if( mb->stop > 0)
+		for(p= getInstrPtr(mb,0), j= 0; j< p->retc; j++)
+			setVarUsed(mb, getArg(p,j));
 	for (i = 0; i < mb->stop; i++)
 		fprintInstruction(fd, mb, stk, getInstrPtr(mb, i), flg);
 }
@@ -136,6 +136,9 @@ newMalBlk(int elements)
 	mb->optimize = 0;
 	mb->stmt = NULL;
 	mb->activeClients = 1;
+	mb->mitosis[0] = 0;
+	mb->npipelines = 0;
+	mb->pipelines = NULL;
 	if (newMalBlkStmt(mb, elements) < 0) {
 		GDKfree(mb->var);
 		GDKfree(mb->stmt);
@@ -241,6 +244,9 @@ freeMalBlk(MalBlkPtr mb)
 
 	if (mb->history)
 		freeMalBlk(mb->history);
+	for (i = 0; i < mb->npipelines; i++)
+		freeMalBlk(mb->pipelines[i]);
+	GDKfree(mb->pipelines);
 	mb->binding[0] = 0;
 	mb->tag = 0;
 	if (mb->help)
@@ -275,6 +281,7 @@ copyMalBlk(MalBlkPtr old)
 	}
 
 	mb->activeClients = 1;
+	strcpy(mb->mitosis, old->mitosis);
 	mb->vsize = old->vsize;
 	mb->vtop = old->vtop;
 	mb->vid = old->vid;
@@ -340,6 +347,20 @@ copyMalBlk(MalBlkPtr old)
 	mb->inlineProp = old->inlineProp;
 	mb->unsafeProp = old->unsafeProp;
 	mb->sealedProp = old->sealedProp;
+	if (old->npipelines > 0) {
+		mb->pipelines = (MalBlkPtr *) GDKzalloc(sizeof(MalBlkPtr) * old->npipelines);
+		if (mb->pipelines == NULL) {
+			freeMalBlk(mb);
+			return NULL;
+		}
+		for (i = 0; i < old->npipelines; i++) {
+			if ((mb->pipelines[i] = copyMalBlk(old->pipelines[i])) == NULL) {
+				freeMalBlk(mb);
+				return NULL;
+			}
+			mb->npipelines++;
+		}
+	}
 	return mb;
 }
 
@@ -796,7 +817,7 @@ cloneVariable(MalBlkPtr tm, MalBlkPtr mb, int x)
 		setVarUDFtype(tm, res);
 	if (isVarCleanup(mb, x))
 		setVarCleanup(tm, res);
-	getVarSTC(tm,x) = getVarSTC(mb,x);
+	getVarSTC(tm,res) = getVarSTC(mb,x);
 	return res;
 }
 
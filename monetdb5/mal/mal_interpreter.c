@@ -339,6 +339,8 @@ str runMAL(Client cntxt, MalBlkPtr mb, MalBlkPtr mbcaller, MalStkPtr env)
 	if (stk->cmd && env && stk->cmd != 'f')
 		stk->cmd = env->cmd;
 	ret = runMALsequence(cntxt, mb, 1, 0, stk, env, 0);
+	if (ret == MAL_SUCCEED && mito_feedback)
+		MALmitosisFeedback(mb);
 
 	/* pass the new debug mode to the caller */
 	if (stk->cmd && env && stk->cmd != 'f')
@@ -427,6 +429,8 @@ callMAL(Client cntxt, MalBlkPtr mb, MalStkPtr *env, ValPtr argv[], char debug)
 		}
 		stk->cmd = debug;
 		ret = runMALsequence(cntxt, mb, 1, 0, stk, 0, 0);
+		if (ret == MAL_SUCCEED && mito_feedback)
+			MALmitosisFeedback(mb);
 		break;
 	case FACTORYsymbol:
 	case FACcall:
@@ -515,8 +519,10 @@ str runMALsequence(Client cntxt, MalBlkPtr mb, int startpc,
 			if ( garbage != garbages) GDKfree(garbage);
 			throw(MAL, "mal.interpreter", RUNTIME_SESSION_TIMEOUT);
 		}
+		/* wait for memory released by the queries running */
+		ret = runtimeProfileAdmit(cntxt, mb, stk);
 	} 
-	stkpc = startpc;
+	stkpc = ret == MAL_SUCCEED ? startpc : mb->stop;
 	exceptionVar = -1;
 
 	while (stkpc < mb->stop && stkpc != stoppc) {
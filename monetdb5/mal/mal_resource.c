@@ -133,7 +133,12 @@ MALadmission(lng argclaim, lng hotclaim)
 		memorypool = (lng)(MEMORY_THRESHOLD );
 
 	if (argclaim > 0) {
-		if (memoryclaims == 0 || memorypool > argclaim + hotclaim) {
+		/* queue instructions while the queries together are
+		 * over the global memory budget */
+		if (memoryclaims == 0 ||
+		    (memorypool > argclaim + hotclaim &&
+		     (GDK_mem_budget == 0 ||
+		      GDKaccount_total() + (size_t) (argclaim + hotclaim) <= GDK_mem_budget))) {
 			memorypool -= (argclaim + hotclaim);
 			memoryclaims++;
 			PARDEBUG
@@ -222,14 +227,240 @@ MALrunningThreads(void)
 	return ATOMIC_GET(mal_running, mal_runningLock);
 }
 
+/*
+ * The mitosis optimizer decides on the number of pieces at compile
+ * time, using the table size and the number of cores only.  When the
+ * mito_feedback option is set, the optimizer records the table it
+ * splits in the plan, and the interpreter reports the work spent on
+ * each of its pieces once the plan has run.  Pieces that are too cheap
+ * to run in parallel lead to fewer pieces next time, while a straggler leads to a finer split such
+ * that the work is spread more evenly.  The advice is kept per table in
+ * a small direct-mapped cache, which is saved in the database directory
+ * whenever an advice changes and loaded again when the server starts.
+ */
+#define MITOSTATS 256
+#define MITOFILE "mitosis_stats"
+
+typedef struct {
+	char name[2 * IDLENGTH];	/* schema.table */
+	int pieces;					/* advised number of pieces */
+	int samples;
+	lng work;					/* running average of total work (usec) */
+	dbl skew;					/* running average of slowest/average piece */
+} MitoStat;
+
+int mito_feedback = 0;
+static MitoStat mitostats[MITOSTATS];
+static MT_Lock mitoLock MT_LOCK_INITIALIZER("mitoLock");
+
+static MitoStat *
+mitosisStat(const char *name)
+{
+	return &mitostats[strHash(name) & (MITOSTATS - 1)];
+}
+
+/* write the statistics to a new file that replaces the old one;
+ * called with the lock held */
+static void
+mitosisSave(void)
+{
+	char *path, *tmp;
+	FILE *f;
+	int i, ok = 1;
+
+	path = GDKfilepath(0, NULL, MITOFILE, NULL);
+	tmp = GDKfilepath(0, NULL, MITOFILE, "new");
+	if (path == NULL || tmp == NULL || (f = fopen(tmp, "w")) == NULL) {
+		GDKfree(path);
+		GDKfree(tmp);
+		return;
+	}
+	for (i = 0; ok && i < MITOSTATS; i++) {
+		MitoStat *ms = &mitostats[i];
+
+		if (ms->name[0])
+			ok = fprintf(f, "%d %d " LLFMT " %f %s\n", ms->pieces,
+						 ms->samples, ms->work, ms->skew, ms->name) >= 0;
+	}
+	if (fclose(f) != 0 || !ok || rename(tmp, path) != 0) {
+		fprintf(stderr, "#mitosisSave: cannot write %s\n", path);
+		(void) remove(tmp);
+	}
+	GDKfree(path);
+	GDKfree(tmp);
+}
+
+static void
+mitosisLoad(void)
+{
+	char *path, line[4 * IDLENGTH];
+	FILE *f;
+	MitoStat m, *ms;
+	int n;
+	size_t len;
+
+	if ((path = GDKfilepath(0, NULL, MITOFILE, NULL)) == NULL)
+		return;
+	f = fopen(path, "r");
+	GDKfree(path);
+	if (f == NULL)
+		return;
+	while (fgets(line, (int) sizeof(line), f) != NULL) {
+		if (sscanf(line, "%d %d " LLFMT " %lf %n", &m.pieces, &m.samples,
+				   &m.work, &m.skew, &n) != 4 || m.pieces <= 0)
+			continue;
+		len = strlen(line + n);
+		if (len <= 1 || len > sizeof(m.name))
+			continue;
+		memcpy(m.name, line + n, len - 1);
+		m.name[len - 1] = 0;
+		ms = mitosisStat(m.name);
+		*ms = m;
+	}
+	fclose(f);
+}
+
+static void
+mitosisUpdate(const char *name, int pieces, lng work, lng slowest)
+{
+	MitoStat *ms;
+	dbl skew;
+	int advice;
+
+	if (pieces <= 1 || work <= 0)
+		return;
+	skew = (dbl) slowest * pieces / work;
+
+	MT_lock_set(&mitoLock);
+	ms = mitosisStat(name);
+	if (strcmp(ms->name, name) != 0) {
+		strcpy(ms->name, name);
+		ms->samples = 0;
+		ms->work = work;
+		ms->skew = skew;
+		ms->pieces = 0;
+	} else {
+		ms->work = (3 * ms->work + work) / 4;
+		ms->skew = (3 * ms->skew + skew) / 4;
+	}
+	ms->samples++;
+	/* advise on the averages, such that a single odd run does not
+	 * change the split */
+	advice = pieces;
+	if (ms->work / pieces < MITOSIS_MINPIECE)
+		advice = (int) (ms->work / MITOSIS_MINPIECE);
+	else if (ms->skew > MITOSIS_SKEW && ms->work / pieces > 2 * MITOSIS_MINPIECE &&
+			 pieces < ms->skew * GDKnr_threads)
+		/* the expensive pieces do not yet keep all threads busy */
+		advice = 2 * pieces;
+	if (advice < 1)
+		advice = 1;
+	if (ms->pieces != advice) {
+		ms->pieces = advice;
+		mitosisSave();
+	}
+	MT_lock_unset(&mitoLock);
+	PARDEBUG fprintf(stderr, "#mitosis feedback %s pieces %d work " LLFMT " skew %.2f advice %d\n", name, pieces, work, skew, advice);
+}
+
+/*
+ * The work of an executed plan is attributed to the pieces of the
+ * split table.  A partitioned sql.bind/sql.tid starts a piece, and an
+ * instruction whose arguments all come from a single piece belongs to
+ * that piece as well.  Instructions that combine pieces, such as the
+ * packs, end the attribution.
+ */
+void
+MALmitosisFeedback(MalBlkPtr mb)
+{
+	int i, j, k, a, pieces = 0, *piece;
+	lng *work = NULL, total = 0, slowest = 0;
+	InstrPtr p;
+
+	if (mb->mitosis[0] == 0 ||
+		(piece = GDKmalloc(mb->vtop * sizeof(int))) == NULL)
+		return;
+	for (i = 0; i < mb->vtop; i++)
+		piece[i] = -1;
+	for (i = 1; i < mb->stop; i++) {
+		p = getInstrPtr(mb, i);
+		j = -1;
+		if (getModuleId(p) && strcmp(getModuleId(p), "sql") == 0 &&
+			(strcmp(getFunctionId(p), "bind") == 0 ||
+			 strcmp(getFunctionId(p), "bindidx") == 0 ||
+			 strcmp(getFunctionId(p), "tid") == 0) &&
+			p->argc > p->retc + 4 &&
+			isVarConstant(mb, getArg(p, p->argc - 1)) &&
+			isVarConstant(mb, getArg(p, p->argc - 2)) &&
+			getArgType(mb, p, p->argc - 1) == TYPE_int &&
+			getArgType(mb, p, p->argc - 2) == TYPE_int) {
+			/* a partitioned bind ends with the piece number and count */
+			k = getVarConstant(mb, getArg(p, p->argc - 1)).val.ival;
+			if (work == NULL) {
+				if (k <= 1 || (work = GDKzalloc(k * sizeof(lng))) == NULL)
+					break;
+				pieces = k;
+			}
+			if (k == pieces)
+				j = getVarConstant(mb, getArg(p, p->argc - 2)).val.ival;
+		} else {
+			for (k = p->retc; k < p->argc; k++) {
+				a = piece[getArg(p, k)];
+				if (a < 0)
+					continue;
+				if (j >= 0 && a != j) {
+					j = -1;
+					break;
+				}
+				j = a;
+			}
+		}
+		if (j >= pieces)
+			j = -1;
+		if (j >= 0)
+			work[j] += p->ticks;
+		for (k = 0; k < p->retc; k++)
+			piece[getArg(p, k)] = j;
+	}
+	if (work) {
+		for (j = 0; j < pieces; j++) {
+			total += work[j];
+			if (work[j] > slowest)
+				slowest = work[j];
+		}
+		mitosisUpdate(mb->mitosis, pieces, total, slowest);
+	}
+	GDKfree(piece);
+	GDKfree(work);
+}
+
+/* Return the advised number of pieces for a table, 0 if unknown */
+int
+MALmitosisAdvice(const char *name)
+{
+	MitoStat *ms;
+	int pieces = 0;
+
+	MT_lock_set(&mitoLock);
+	ms = mitosisStat(name);
+	if (strcmp(ms->name, name) == 0)
+		pieces = ms->pieces;
+	MT_lock_unset(&mitoLock);
+	return pieces;
+}
+
 void
 initResource(void)
 {
 #ifdef NEED_MT_LOCK_INIT
 	ATOMIC_INIT(mal_runningLock);
+	MT_lock_init(&mitoLock, "mitoLock");
 #ifdef USE_MAL_ADMISSION
 	MT_lock_init(&admissionLock, "admissionLock");
 #endif
 #endif
 	mal_running = (ATOMIC_TYPE) GDKnr_threads;
+	mito_feedback = GDKgetenv_isyes("mito_feedback");
+	if (mito_feedback)
+		mitosisLoad();
 }
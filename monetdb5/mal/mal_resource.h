@@ -31,4 +31,11 @@ mal_export lng getMemoryClaim(MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int i,
 mal_export void MALresourceFairness(lng usec);
 mal_export size_t MALrunningThreads(void);
 
+#define MITOSIS_MINPIECE 2000	/* usec of work below which a piece is not worth scheduling */
+#define MITOSIS_SKEW 1.5		/* slowest over average piece work considered a straggler */
+
+mal_export int mito_feedback;	/* the mito_feedback option is set */
+mal_export void MALmitosisFeedback(MalBlkPtr mb);
+mal_export int MALmitosisAdvice(const char *name);
+
 #endif /*  _MAL_RESOURCE_H*/
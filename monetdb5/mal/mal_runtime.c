@@ -93,12 +93,62 @@ runtimeProfileInit(Client cntxt, MalBlkPtr mb, MalStkPtr stk)
 		QRYqueue[i].query = q? GDKstrdup(q):0;
 		QRYqueue[i].status = "running";
 		QRYqueue[i].cntxt = cntxt;
+		QRYqueue[i].acct = 0;
+		// the outermost invocation charges its heaps to a fresh account
+		if (cntxt->memaccount == 0) {
+			const char *budget = GDKgetenv("query_memory");
+			cntxt->memaccount = GDKaccount_open(budget ? (size_t) strtoll(budget, NULL, 10) : 0);
+			QRYqueue[i].acct = cntxt->memaccount;
+		}
 	}
 	stk->tag = QRYqueue[i].tag;
 	qtop += i == qtop;
 	MT_lock_unset(&mal_delayLock);
 }
 
+/*
+ * A query that starts while the memory charged to the running queries
+ * exceeds gdk_mem_budget is queued until they have released enough of
+ * it.  It is shown as such in sys.queue.  A query is admitted when no
+ * other is running, and rejected when its timeout expires while it is
+ * queued.
+ */
+str
+runtimeProfileAdmit(Client cntxt, MalBlkPtr mb, MalStkPtr stk)
+{
+	int i, j, running;
+
+	if (GDK_mem_budget == 0 || cntxt->memaccount == 0)
+		return MAL_SUCCEED;
+	for (;;) {
+		MT_lock_set(&mal_delayLock);
+		for (i = 0; i < qtop; i++)
+			if (QRYqueue[i].stk == stk)
+				break;
+		/* only the invocation owning the account is queued */
+		if (i == qtop || QRYqueue[i].acct != cntxt->memaccount) {
+			MT_lock_unset(&mal_delayLock);
+			return MAL_SUCCEED;
+		}
+		for (running = 0, j = 0; j < qtop && !running; j++)
+			running = j != i && QRYqueue[j].acct &&
+				QRYqueue[j].status &&
+				strcmp(QRYqueue[j].status, "running") == 0;
+		if (!running || GDKaccount_total() < GDK_mem_budget) {
+			QRYqueue[i].status = "running";
+			MT_lock_unset(&mal_delayLock);
+			return MAL_SUCCEED;
+		}
+		QRYqueue[i].status = "queued";
+		MT_lock_unset(&mal_delayLock);
+		if (cntxt->mode == FINISHCLIENT)
+			throw(MAL, "mal.interpreter", "prematurely stopped client");
+		if (cntxt->qtimeout && GDKusec() - mb->starttime > cntxt->qtimeout)
+			throw(MAL, "mal.interpreter", SQLSTATE(HY001) "Query rejected, memory budget of all queries (" SZFMT " bytes) exceeded", GDK_mem_budget);
+		MT_sleep_ms(DELAYUNIT);
+	}
+}
+
 void
 runtimeProfileFinish(Client cntxt, MalBlkPtr mb, MalStkPtr stk)
 {
@@ -124,6 +174,11 @@ runtimeProfileFinish(Client cntxt, MalBlkPtr mb, MalStkPtr stk)
 		// reset entry
 		if (QRYqueue[i].query)
 			GDKfree(QRYqueue[i].query);
+		if (QRYqueue[i].acct) {
+			GDKaccount_close(QRYqueue[i].acct);
+			cntxt->memaccount = 0;
+		}
+		QRYqueue[i].acct = 0;
 		QRYqueue[i].cntxt = 0;
 		QRYqueue[i].tag = 0;
 		QRYqueue[i].query = 0;
@@ -142,7 +197,7 @@ finishSessionProfiler(Client cntxt)
 {
 	int i,j;
 
-	(void) cntxt;
+	cntxt->memaccount = 0;
 
 	MT_lock_set(&mal_delayLock);
 	for( i=j=0; i< qtop; i++)
@@ -152,6 +207,9 @@ finishSessionProfiler(Client cntxt)
 		//reset entry
 		if (QRYqueue[i].query)
 			GDKfree(QRYqueue[i].query);
+		if (QRYqueue[i].acct)
+			GDKaccount_close(QRYqueue[i].acct);
+		QRYqueue[i].acct = 0;
 		QRYqueue[i].cntxt = 0;
 		QRYqueue[i].tag = 0;
 		QRYqueue[i].query = 0;
@@ -177,6 +235,9 @@ runtimeProfileBegin(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, Run
 		cntxt->inprogress[tid].pci = pci;
 	}
 
+	/* charge heaps created by this thread to the query */
+	GDKaccount_set(cntxt->memaccount);
+
 	/* always collect the MAL instruction execution time */
 	pci->clock = prof->ticks = GDKusec();
 
@@ -205,6 +266,9 @@ runtimeProfileExit(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, Runt
 	if( isaBatType(getArgType(mb, pci, 0)) )
 		(void) ATOMIC_DEC(mal_running, mal_runningLock);
 
+	/* the worker may run another client's instruction next */
+	GDKaccount_set(0);
+
 	assert(prof);
 	/* always collect the MAL instruction execution time */
 	pci->ticks = GDKusec() - prof->ticks;
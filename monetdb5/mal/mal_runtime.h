@@ -33,10 +33,12 @@ typedef struct QRYQUEUE{
 	str status;
 	lng start;
 	lng runtime;
+	lng acct;	/* memory account owned by this invocation */
 } *QueryQueue;
 mal_export int qtop;
 
 mal_export void runtimeProfileInit(Client cntxt, MalBlkPtr mb, MalStkPtr stk);
+mal_export str runtimeProfileAdmit(Client cntxt, MalBlkPtr mb, MalStkPtr stk);
 mal_export void runtimeProfileFinish(Client cntxt, MalBlkPtr mb, MalStkPtr stk);
 mal_export void runtimeProfileBegin(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, RuntimeProfile prof);
 mal_export void runtimeProfileExit(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, RuntimeProfile prof);
@@ -0,0 +1,95 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# A slice covering all of a read-only BAT is a full view that shares
+# the parent's hash table, a partial slice is not.  Updates drop the
+# hash table of the parent, so slices taken afterwards do not inherit
+# a stale one, and the selects give the same counts either way.  The
+# --algorithms trace of the server tells how each select was done.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-hashslice'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+mal = '''
+function hashed(b:bat[:lng]):void;
+	(k, v) := bat.info(b);
+	t := algebra.select(k, "thash->type", "thash->type", true, true, false);
+	c := aggr.count(t);
+	io.print(c);
+end hashed;
+function counts(b:bat[:lng]):void;
+	x := algebra.select(b, 7:lng, 7:lng, true, true, false);
+	n7 := aggr.count(x);
+	y := algebra.select(b, 10:lng, 10:lng, true, true, false);
+	n10 := aggr.count(y);
+	io.print(n7, n10);
+end counts;
+# every value occurs four times
+b := bat.new(:lng);
+u := generator.series(0:lng, 200000:lng);
+u := batcalc.%(u, 50000:lng);
+b := bat.append(b, u);
+b := bat.setAccess(b, "r");
+h := bat.setHash(b);
+# the full slice has the hash table of b, the partial one has none
+s := algebra.slice(b, 0:lng, 199999:lng);
+hashed(s);
+counts(s);
+p := algebra.slice(b, 0:lng, 99999:lng);
+hashed(p);
+counts(p);
+# b has views now, so update a fresh copy: after the append and the
+# replace there are six 7s and three 10s, and no hash table
+w := bat.new(:lng);
+w := bat.append(w, u);
+h := bat.setHash(w);
+w := bat.append(w, 7:lng);
+hashed(w);
+w := bat.replace(w, 10@0, 7:lng);
+w := bat.setAccess(w, "r");
+hashed(w);
+# a full slice of the updated BAT shares the new hash table, while the
+# old slice of b still sees the old values
+h := bat.setHash(w);
+q := algebra.slice(w, 0:lng, 200000:lng);
+hashed(q);
+counts(q);
+counts(s);
+'''
+
+s = process.server(args = ['--algorithms'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+c = process.client('mal',
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+out, err = c.communicate(mal)
+sys.stdout.write(out)
+sys.stderr.write(err)
+out, err = s.communicate()
+
+# the selects on the slices
+for l in err.splitlines():
+    if l.startswith('#BATselect(b=') and ',s=NULL,' in l:
+        n = l.split('#')[2].split(',')[0]
+        if n in ('100000', '200000', '200001'):
+            print n, l.split('): ')[1].split(' v ')[0]
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,94 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# A large BAT is sorted in chunks by several threads, and the chunks are
+# merged.  The result must be sorted and stable, with the same order and
+# groups as the serial sort of a single threaded server, for fixed-width
+# and string values, ascending and descending.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-parsort'
+dbpath = os.path.join(dbfarm, dbname)
+
+mal = '''
+function check(b:bat[:any_1], s:bat[:any_1], o:bat[:oid], g:bat[:oid], rev:bit):void;
+	# the values are sorted and come from b in the order of o
+	up := bat.isSorted(s);
+	down := bat.isSortedReverse(s);
+	sorted := calc.ifthenelse(rev, down, up);
+	p := algebra.projection(o, b);
+	e := batcalc.==(p, s);
+	same := aggr.min(e);
+	# stable: equal values keep the order in which they were in b
+	n := aggr.count(o);
+	l := calc.-(n, 1:lng);
+	m := calc.-(n, 2:lng);
+	s0 := algebra.slice(s, 0:lng, m);
+	s1 := algebra.slice(s, 1:lng, l);
+	o0 := algebra.slice(o, 0:lng, m);
+	o1 := algebra.slice(o, 1:lng, l);
+	ne := batcalc.!=(s0, s1);
+	lt := batcalc.<(o0, o1);
+	e := batcalc.or(ne, lt);
+	stable := aggr.min(e);
+	# and the same order as the serial sort
+	i := generator.series(0:lng, n);
+	x := batcalc.lng(o);
+	x := batcalc.*(x, i);
+	x := batcalc.%(x, 1000003:lng);
+	sum := aggr.sum(x);
+	y := batcalc.lng(g);
+	grp := aggr.sum(y);
+	io.print(n, sorted, same, stable, sum, grp);
+end check;
+
+# values that occur twenty times each, in no particular order
+b := generator.series(0:int, 2000000:int);
+b := batcalc.%(b, 100003:int);
+b := batcalc.*(b, 7919:int);
+b := batcalc.%(b, 100003:int);
+(s, o, g) := algebra.sort(b, false, true);
+check(b, s, o, g, false);
+(s, o, g) := algebra.sort(b, true, true);
+check(b, s, o, g, true);
+t := batcalc.%(b, 1000:int);
+u := batcalc.str(t);
+(su, o, g) := algebra.sort(u, false, true);
+check(u, su, o, g, false);
+(su, o, g) := algebra.sort(u, true, true);
+check(u, su, o, g, true);
+'''
+
+def run(threads):
+    if os.path.exists(dbpath):
+        shutil.rmtree(dbpath)
+    s = process.server(args = ['--algorithms', '--set', 'gdk_nr_threads=%d' % threads],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    c = process.client('mal',
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(mal)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+    srvout, srverr = s.communicate()
+    print 'parallel sorts:', srverr.count('#do_parsort:')
+    shutil.rmtree(dbpath)
+    return [l for l in out.splitlines() if l.startswith('[')]
+
+par = run(4)
+ser = run(1)
+print 'same as serial sort:', par == ser
@@ -0,0 +1,90 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# An inner input that does not fit in the cache is joined by
+# partitioning both inputs on the radix bits of the key.  Once it has a
+# hash table the joins use that instead.  Both ways must give the same
+# results; the --algorithms trace of the server tells which join was
+# used.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-radixjoin'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+joins = '''
+(j1, j2) := algebra.join(l, r, nil:bat, nil:bat, false, nil:lng);
+check(j1, j2);
+(j1, j2) := algebra.leftjoin(l, r, nil:bat, nil:bat, false, nil:lng);
+check(j1, j2);
+(j1, j2) := algebra.outerjoin(l, r, nil:bat, nil:bat, false, nil:lng);
+check(j1, j2);
+(j1, j2) := algebra.semijoin(l, r, nil:bat, nil:bat, false, nil:lng);
+check(j1, j2);
+'''
+
+mal = '''
+function check(j1:bat[:oid], j2:bat[:oid]):void;
+	n := aggr.count(j1);
+	m := aggr.count_no_nil(j2);
+	a := batcalc.lng(j1);
+	b := batcalc.lng(j2);
+	s1 := aggr.sum(a);
+	s2 := aggr.sum(b);
+	io.print(n, m, s1, s2);
+end check;
+
+# fact keys occur two or three times, and a quarter of them have no
+# match; the dimension keys are a permutation
+l := generator.series(0:lng, 4000000:lng);
+l := batcalc.%(l, 1333337:lng);
+r := generator.series(0:lng, 1000003:lng);
+r := batcalc.*(r, 7919:lng);
+r := batcalc.%(r, 1000003:lng);
+''' + joins + '''
+(k1, k2) := algebra.join(l, r, nil:bat, nil:bat, false, nil:lng);
+h := bat.setHash(r);
+io.print(h);
+''' + joins + '''
+# every key of l matches at most once, so both give the same pairs in
+# the same order
+(h1, h2) := algebra.join(l, r, nil:bat, nil:bat, false, nil:lng);
+e1 := batcalc.==(k1, h1);
+e2 := batcalc.==(k2, h2);
+e := batcalc.and(e1, e2);
+ok := aggr.min(e);
+io.print(ok);
+'''
+
+s = process.server(args = ['--algorithms', '--set', 'gdk_nr_threads=4'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+c = process.client('mal',
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+out, err = c.communicate(mal)
+sys.stdout.write(out)
+sys.stderr.write(err)
+out, err = s.communicate()
+
+# the joins with the dimension before and after the hash table
+trace = [l.split('(')[0] for l in err.splitlines()
+         if l.startswith('#') and 'join(l=' in l and '#1000003[' in l]
+print 'joins used:', ' '.join(trace)
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,109 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# Selects without candidate list on int, lng, flt and dbl columns use
+# vector kernels on CPUs that have AVX2.  Selects with a candidate
+# list always use the scalar scan.  Every predicate is run both ways,
+# on a column with and one without nils, and the results must be the
+# same except for the two oids missing from the candidate list.  The
+# number of values is not a multiple of the vector width, so the
+# scalar scan also finishes every full scan.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-simdselect'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+mal = '''
+function check(b:bat[:any_1], c:bat[:oid], lv:any_1, hv:any_1, li:bit, hi:bit, anti:bit):void;
+	f := algebra.select(b, lv, hv, li, hi, anti);
+	g := algebra.select(b, c, lv, hv, li, hi, anti);
+	n := aggr.count(f);
+	fo := batcalc.lng(f);
+	s:lng := aggr.sum(fo);
+	# leave out the oids that are not in c
+	p0 := algebra.select(f, 0@0, 0@0, true, true, true);
+	p7 := algebra.select(f, p0, 7@0, 7@0, true, true, true);
+	f1 := algebra.projection(p7, f);
+	e := batcalc.==(f1, g);
+	ok := aggr.min(e);
+	io.print(n, s, ok);
+end check;
+# values from -500 to 499, in w every 97th is nil
+i := generator.series(0:int, 100003:int);
+v := batcalc.*(i, 7919:int);
+v := batcalc.%(v, 1000:int);
+v := batcalc.-(v, 500:int);
+m := batcalc.%(i, 97:int);
+z := batcalc.==(m, 0:int);
+w := batcalc.ifthenelse(z, nil:int, v);
+# all oids but 0 and 7
+c0 := algebra.select(i, 0:int, 0:int, true, true, true);
+c := algebra.select(i, c0, 7:int, 7:int, true, true, true);
+'''
+
+preds = [
+    # (low, high, li, hi, anti)
+    ('E', 'E', 'true', 'true', 'false'),
+    ('L', 'H', 'true', 'true', 'false'),
+    ('L', 'H', 'false', 'false', 'false'),
+    ('nil', 'Z', 'false', 'true', 'false'),
+    ('H', 'nil', 'true', 'false', 'false'),
+    ('L', 'H', 'true', 'true', 'true'),
+    ('L', 'H', 'false', 'false', 'true'),
+    ('E', 'E', 'true', 'true', 'true'),
+]
+
+for tpe, vals in [('int', {'E': '17', 'L': '-100', 'H': '250', 'Z': '0'}),
+                  ('lng', {'E': '17', 'L': '-100', 'H': '250', 'Z': '0'}),
+                  ('flt', {'E': '2.125', 'L': '-12.5', 'H': '31.25', 'Z': '0'}),
+                  ('dbl', {'E': '2.125', 'L': '-12.5', 'H': '31.25', 'Z': '0'})]:
+    mal += 'io.print("%s");\n' % tpe
+    if tpe == 'int':
+        mal += 'v%s := v;\nw%s := w;\n' % (tpe, tpe)
+    else:
+        mal += 'v%s := batcalc.%s(v);\nw%s := batcalc.%s(w);\n' % (tpe, tpe, tpe, tpe)
+        if tpe in ('flt', 'dbl'):
+            mal += 'v%s := batcalc./(v%s, 8:%s);\nw%s := batcalc./(w%s, 8:%s);\n' % (tpe, tpe, tpe, tpe, tpe, tpe)
+    for b in 'vw':
+        for lo, hi, li, hi_, anti in preds:
+            lo = vals.get(lo, lo)
+            hi = vals.get(hi, hi)
+            mal += 'check(%s%s, c, %s:%s, %s:%s, %s, %s, %s);\n' % (b, tpe, lo, tpe, hi, tpe, li, hi_, anti)
+
+s = process.server(args = ['--algorithms'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+c = process.client('mal',
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+out, err = c.communicate(mal)
+sys.stdout.write(out)
+sys.stderr.write(err)
+out, err = s.communicate()
+
+# the vector kernels must have been used if the CPU has AVX2
+avx2 = False
+if os.path.exists('/proc/cpuinfo'):
+    for l in open('/proc/cpuinfo'):
+        if l.startswith('flags') and ' avx2' in l:
+            avx2 = True
+used = len([l for l in err.splitlines() if 'avx2 fullscan' in l]) > 0
+print 'vector kernels used where available:', used == avx2
+
+shutil.rmtree(dbpath)
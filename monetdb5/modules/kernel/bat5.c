@@ -990,6 +990,19 @@ BKCsetImprints(bit *ret, const bat *bid)
 	return MAL_SUCCEED;
 }
 
+str
+BKCsetCompress(bit *ret, const bat *bid)
+{
+	BAT *b;
+
+	if ((b = BATdescriptor(*bid)) == NULL) {
+		throw(MAL, "bat.setCompress", RUNTIME_OBJECT_MISSING);
+	}
+	*ret = BATcompress(b) == GDK_SUCCEED;
+	BBPunfix(b->batCacheid);
+	return MAL_SUCCEED;
+}
+
 str
 BKCgetSequenceBase(oid *r, const bat *bid)
 {
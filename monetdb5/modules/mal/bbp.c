@@ -303,7 +303,7 @@ CMDbbpRefCount(bat *ret)
 	BBPlock();
 	for (i = 1; i < getBBPsize(); i++)
 		if (i != b->batCacheid && BBP_logical(i) && (BBP_refs(i) || BBP_lrefs(i))) {
-			int refs = BBP_refs(i);
+			int refs = (int) BBP_refs(i);
 
 			if (BUNappend(b, &refs, FALSE) != GDK_SUCCEED) {
 				BBPunlock();
@@ -359,7 +359,7 @@ CMDgetBATrefcnt(int *res, bat *bid)
 	if ((b = BATdescriptor(*bid)) == NULL) {
 		throw(MAL, "bbp.getRefCount", INTERNAL_BAT_ACCESS);
 	}
-	*res = BBP_refs(b->batCacheid);
+	*res = (int) BBP_refs(b->batCacheid);
 	BBPunfix(b->batCacheid);
 	return MAL_SUCCEED;
 }
@@ -407,7 +407,7 @@ str CMDbbp(bat *ID, bat *NS, bat *TT, bat *CNT, bat *REFCNT, bat *LREFCNT, bat *
 				int heat_ = 0;
 				char *loc = BBP_cache(i) ? "load" : "disk";
 				char *mode = "persistent";
-				int refs = BBP_refs(i);
+				int refs = (int) BBP_refs(i);
 				int lrefs = BBP_lrefs(i);
 
 				if ((BBP_status(i) & BBPDELETED) || !(BBP_status(i) & BBPPERSISTENT))
@@ -199,6 +199,9 @@ doChallenge(void *data)
 		if (strstr(buf, "COMPUTECOLWIDTH")) {
 			compute_column_widths = 1;
 		}
+		if (strstr(buf, "COLUMN_COMPRESSION_AUTO")) {
+			colcomp = COLUMN_COMPRESSION_AUTO;
+		}
 
 		if (buflen < BLOCK) {
 			mnstr_printf(fdout, "!buffer size needs to be set and bigger than %d\n", BLOCK);
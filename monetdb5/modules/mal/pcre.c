@@ -131,6 +131,24 @@ re_simple(const char *pat)
 	return nr;
 }
 
+/* If pat is a prefix followed by a single %, without other
+ * wildcards or escapes, return the length of the prefix, else 0. */
+static size_t
+re_prefix(const char *pat, const str esc)
+{
+	size_t len = strcspn(pat, "%_");
+
+	if (len == 0 || pat[len] != '%' || pat[len + 1] != 0)
+		return 0;
+	if (strcmp(esc, str_nil) != 0 && *esc &&
+	    strstr(pat, esc) != NULL)
+		return 0;
+	/* the upper bound would be the nil string */
+	if (pat[0] == '\177' && strspn(pat + 1, "\377") == len - 1)
+		return 0;
+	return len;
+}
+
 static int
 is_strcmpable(const char *pat, const str esc)
 {
@@ -1466,9 +1484,10 @@ PCRElikeselect2(bat *ret, const bat *bid, const bat *sid, const str *pat, const
 {
 	BAT *b, *s = NULL, *bn = NULL;
 	str res;
-	char *ppat = NULL;
+	char *ppat = NULL, *hpat;
 	int use_re = 0;
 	int use_strcmp = 0;
+	size_t len;
 
 	if ((b = BATdescriptor(*bid)) == NULL) {
 		throw(MAL, "algebra.likeselect", RUNTIME_OBJECT_MISSING);
@@ -1482,6 +1501,37 @@ PCRElikeselect2(bat *ret, const bat *bid, const bat *sid, const str *pat, const
 	if (is_strcmpable(*pat, *esc)) {
 		use_re = 1;
 		use_strcmp = 1;
+	} else if (!*caseignore && !*anti &&
+		   (len = re_prefix(*pat, *esc)) > 0) {
+		/* the strings that start with a prefix are those from
+		 * the prefix up to, but not including, the prefix with
+		 * its last byte incremented; as a range select this
+		 * can use the imprints of the column */
+		if ((ppat = GDKstrdup(*pat)) == NULL ||
+		    (hpat = GDKstrdup(*pat)) == NULL) {
+			GDKfree(ppat);
+			BBPunfix(b->batCacheid);
+			if (s)
+				BBPunfix(s->batCacheid);
+			throw(MAL, "algebra.likeselect", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		}
+		ppat[len] = 0;
+		while (len > 0 && (unsigned char) hpat[len - 1] == 0xFF)
+			len--;
+		hpat[len] = 0;
+		if (len > 0)
+			hpat[len - 1]++;
+		bn = BATselect(b, s, ppat, len > 0 ? hpat : str_nil, 1, 0, 0);
+		GDKfree(hpat);
+		GDKfree(ppat);
+		BBPunfix(b->batCacheid);
+		if (s)
+			BBPunfix(s->batCacheid);
+		if (bn == NULL)
+			throw(MAL, "algebra.likeselect", GDK_EXCEPTION);
+		*ret = bn->batCacheid;
+		BBPkeepref(bn->batCacheid);
+		return MAL_SUCCEED;
 	} else if ((strcmp(*esc, str_nil) == 0 || strlen(*esc) == 0) &&
              re_simple(*pat) > 0) {
 		use_re = 1;
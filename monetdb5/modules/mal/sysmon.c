@@ -135,6 +135,58 @@ SYSMONqueue(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	return msg ? msg : createException(MAL, "SYSMONqueue", SQLSTATE(HY001) MAL_MALLOC_FAIL);
 }
 
+str
+SYSMONmemory(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	BAT *tag, *used, *peak, *budget;
+	bat *t = getArgReference_bat(stk,pci,0);
+	bat *u = getArgReference_bat(stk,pci,1);
+	bat *p = getArgReference_bat(stk,pci,2);
+	bat *b = getArgReference_bat(stk,pci,3);
+	const char *qbudget = GDKgetenv("query_memory");
+	lng l, lim = qbudget ? strtoll(qbudget, NULL, 10) : 0;
+	int i;
+
+	(void) mb;
+	MT_lock_set(&mal_delayLock);
+	tag = COLnew(0, TYPE_lng, 256, TRANSIENT);
+	used = COLnew(0, TYPE_lng, 256, TRANSIENT);
+	peak = COLnew(0, TYPE_lng, 256, TRANSIENT);
+	budget = COLnew(0, TYPE_lng, 256, TRANSIENT);
+	if ( tag == NULL || used == NULL || peak == NULL || budget == NULL)
+		goto bailout;
+
+	for ( i = 0; i< qtop; i++)
+	if( QRYqueue[i].acct && (QRYqueue[i].cntxt->idx == 0 || QRYqueue[i].cntxt->user == cntxt->user)) {
+		l = QRYqueue[i].tag;
+		if (BUNappend(tag, &l, FALSE) != GDK_SUCCEED)
+			goto bailout;
+		l = (lng) GDKaccount_cursize(QRYqueue[i].acct);
+		if (BUNappend(used, &l, FALSE) != GDK_SUCCEED)
+			goto bailout;
+		l = (lng) GDKaccount_peak(QRYqueue[i].acct);
+		if (BUNappend(peak, &l, FALSE) != GDK_SUCCEED)
+			goto bailout;
+		l = lim > 0 ? lim : lng_nil;
+		if (BUNappend(budget, &l, FALSE) != GDK_SUCCEED)
+			goto bailout;
+	}
+	MT_lock_unset(&mal_delayLock);
+	BBPkeepref( *t =tag->batCacheid);
+	BBPkeepref( *u =used->batCacheid);
+	BBPkeepref( *p =peak->batCacheid);
+	BBPkeepref( *b =budget->batCacheid);
+	return MAL_SUCCEED;
+
+  bailout:
+	MT_lock_unset(&mal_delayLock);
+	if (tag) BBPunfix(tag->batCacheid);
+	if (used) BBPunfix(used->batCacheid);
+	if (peak) BBPunfix(peak->batCacheid);
+	if (budget) BBPunfix(budget->batCacheid);
+	throw(MAL, "SYSMONmemory", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+}
+
 str
 SYSMONpause(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 {	lng i, tag = 0;
@@ -30,6 +30,8 @@
  * The file reader overlaps IO with updates of the BAT.
  * Also the buffer size of the block stream might be a little small for
  * this task (1MB). It has been increased to 8MB, which indeed improved.
+ * Finding the record boundaries in a large buffer is itself divided
+ * over several threads, each handling a byte range of the buffer.
  *
  * The work divider allocates subtasks to threads based on the
  * observed time spending so far.
@@ -47,6 +49,8 @@
 
 #define MAXWORKERS	64
 #define MAXBUFFERS 2
+/* minimum number of bytes per record splitting thread */
+#define MINSPLITSIZE	(256 * 1024)
 /* We restrict the row length to be 32MB for the time being */
 #define MAXROWSIZE(X) (X > 32*1024*1024 ? X : 32*1024*1024)
 
@@ -552,12 +556,203 @@ output_file_ordered(Tablet *as, BAT *order, stream *fd)
 	return res;
 }
 
+/*
+ * Parallel export
+ * Converting values to text dominates the export of large results.
+ * The rows are therefore cut into chunks of EXPORTCHUNK rows, which
+ * are formatted into private buffers by a number of worker threads,
+ * chunk k being handled by worker k % nr. The calling thread writes
+ * the buffers to the output stream in chunk order, after which it
+ * lets the worker continue with its next chunk.
+ * If the output goes to a compressed file, the workers also compress
+ * their buffer into a separate member, and these members are appended
+ * to the file. Concatenated members decompress into the concatenated
+ * contents, so the result reads as a single compressed file.
+ */
+#define EXPORTCHUNK	(64 * 1024)
+#define MINEXPORT	(4 * EXPORTCHUNK)
+
+#define EXPORT_DEFAULT	0
+#define EXPORT_DENSE	1
+#define EXPORT_ORDERED	2
+
+typedef struct {
+	Tablet *as;
+	BAT *order;
+	int mode;					/* EXPORT_DEFAULT, _DENSE or _ORDERED */
+	int nr;						/* number of workers */
+	stream *out;				/* the output stream */
+	int compress;				/* compress chunks into members of out */
+	int stop;					/* set by the writer on error */
+} EXPORTshared;
+
+typedef struct {
+	int id;
+	MT_Id tid;
+	EXPORTshared *shared;
+	Column *fmt;				/* private copy of the format */
+	buffer *b;
+	stream *fd;					/* writes into b */
+	MT_Sema go, done;
+	int res;					/* result of the last chunk */
+	int last;					/* no more chunks from this worker */
+	void *member;				/* compressed chunk */
+	ssize_t memberlen;
+} EXPORTtask;
+
+static void
+EXPORTworker(void *arg)
+{
+	EXPORTtask *t = arg;
+	EXPORTshared *sh = t->shared;
+	Tablet *as = sh->as;
+	size_t len = BUFSIZ, locallen = BUFSIZ;
+	char *buf = GDKzalloc(len);
+	char *localbuf = GDKzalloc(locallen);
+	BUN lo, hi, r, i;
+	Thread thr;
+
+	thr = THRnew("EXPORTworker");
+	GDKsetbuf(GDKzalloc(GDKMAXERRLEN));	/* where to leave errors */
+	GDKclrerr();
+	for (lo = (BUN) t->id * EXPORTCHUNK;; lo += (BUN) sh->nr * EXPORTCHUNK) {
+		MT_sema_down(&t->go);
+		if (sh->stop || lo >= as->nr) {
+			t->last = 1;
+			MT_sema_up(&t->done);
+			break;
+		}
+		hi = lo + EXPORTCHUNK < as->nr ? lo + EXPORTCHUNK : as->nr;
+		t->b->pos = 0;
+		t->res = buf == NULL || localbuf == NULL ? -1 : 0;
+		if (sh->mode == EXPORT_DENSE)
+			for (i = 0; i < as->nr_attrs; i++)
+				t->fmt[i].p = as->offset + lo;
+		for (r = lo; r < hi && t->res >= 0; r++) {
+			oid id = sh->order->hseqbase + as->offset + r;
+
+			switch (sh->mode) {
+			case EXPORT_DENSE:
+				t->res = output_line_dense(&buf, &len, &localbuf, &locallen, t->fmt, t->fd, as->nr_attrs);
+				break;
+			case EXPORT_ORDERED:
+				t->res = output_line_lookup(&buf, &len, t->fmt, t->fd, as->nr_attrs, id);
+				break;
+			default:
+				t->res = output_line(&buf, &len, &localbuf, &locallen, t->fmt, t->fd, as->nr_attrs, id);
+				break;
+			}
+		}
+		if (t->res >= 0 && sh->compress) {
+			free(t->member);
+			t->memberlen = mnstr_compress_member(sh->out, t->b->buf, t->b->pos, &t->member);
+			if (t->memberlen < 0)
+				t->res = -1;
+		}
+		MT_sema_up(&t->done);
+	}
+	GDKfree(buf);
+	GDKfree(localbuf);
+	GDKfree(GDKerrbuf);
+	GDKsetbuf(0);
+	THRdel(thr);
+}
+
+static int
+output_file_parallel(Tablet *as, BAT *order, stream *s, int mode, int nr)
+{
+	EXPORTshared sh;
+	EXPORTtask *tasks;
+	int i, res = 0;
+	BUN k;
+
+	sh = (EXPORTshared) {
+		.as = as,
+		.order = order,
+		.mode = mode,
+		.nr = nr,
+		.out = s,
+		.compress = isa_member_stream(s),
+	};
+	if ((tasks = GDKzalloc(nr * sizeof(EXPORTtask))) == NULL)
+		return -1;
+	for (i = 0; i < nr; i++) {
+		tasks[i].id = i;
+		tasks[i].shared = &sh;
+		MT_sema_init(&tasks[i].go, 0, "EXPORTgo");
+		MT_sema_init(&tasks[i].done, 0, "EXPORTdone");
+	}
+	for (i = 0; i < nr; i++) {
+		if ((tasks[i].fmt = GDKmalloc(as->nr_attrs * sizeof(Column))) == NULL ||
+			(tasks[i].b = buffer_create(EXPORTCHUNK * 16)) == NULL ||
+			(tasks[i].fd = buffer_wastream(tasks[i].b, "export")) == NULL)
+			break;
+		memcpy(tasks[i].fmt, as->format, as->nr_attrs * sizeof(Column));
+		if (MT_create_thread(&tasks[i].tid, EXPORTworker, &tasks[i], MT_THR_JOINABLE) < 0)
+			break;
+	}
+	if (i < nr) {
+		/* nothing has been written yet: let the threads we
+		 * did start exit and fall back to the serial export */
+		sh.stop = 1;
+		res = 1;
+		nr = i;
+	}
+	for (i = 0; i < nr; i++)
+		MT_sema_up(&tasks[i].go);
+	for (k = 0; res <= 0; k++) {
+		EXPORTtask *t = &tasks[k % nr];
+
+		MT_sema_down(&t->done);
+		if (t->last)
+			break;
+		/* after an error, keep receiving chunks until all
+		 * workers have seen the stop request */
+		if (res == 0) {
+			if (t->res < 0)
+				res = t->res;
+			else if (sh.compress) {
+				if (mnstr_write_member(s, t->member, (size_t) t->memberlen) < 0)
+					res = TABLET_error(s);
+			} else if (t->b->pos > 0 &&
+					   mnstr_write(s, t->b->buf, 1, t->b->pos) != (ssize_t) t->b->pos)
+				res = TABLET_error(s);
+			if (res < 0)
+				sh.stop = 1;
+		}
+		MT_sema_up(&t->go);
+	}
+	for (i = 0; i < nr; i++)
+		MT_join_thread(tasks[i].tid);
+	for (i = 0; i < sh.nr; i++) {
+		if (tasks[i].fd)
+			mnstr_destroy(tasks[i].fd);
+		buffer_destroy(tasks[i].b);
+		GDKfree(tasks[i].fmt);
+		free(tasks[i].member);
+		MT_sema_destroy(&tasks[i].go);
+		MT_sema_destroy(&tasks[i].done);
+	}
+	GDKfree(tasks);
+	if (res > 0) {
+		switch (mode) {
+		case EXPORT_DENSE:
+			return output_file_dense(as, s);
+		case EXPORT_ORDERED:
+			return output_file_ordered(as, order, s);
+		default:
+			return output_file_default(as, order, s);
+		}
+	}
+	return res;
+}
+
 int
 TABLEToutput_file(Tablet *as, BAT *order, stream *s)
 {
 	oid base = oid_nil;
 	BUN maxnr = BATcount(order);
-	int ret = 0;
+	int ret = 0, nr;
 
 	/* only set nr if it is zero or lower (bogus) to the maximum value
 	 * possible (BATcount), if already set within BATcount range,
@@ -567,11 +762,21 @@ TABLEToutput_file(Tablet *as, BAT *order, stream *s)
 	if (as->nr == BUN_NONE || as->nr > maxnr)
 		as->nr = maxnr;
 
+	nr = GDKnr_threads < MAXWORKERS ? GDKnr_threads : MAXWORKERS;
+	if (as->nr < MINEXPORT)
+		nr = 1;
+	else if ((BUN) nr > as->nr / EXPORTCHUNK)
+		nr = (int) (as->nr / EXPORTCHUNK);
+
 	if ((base = check_BATs(as)) != oid_nil) {
-		if (order->hseqbase == base)
+		if (nr > 1)
+			ret = output_file_parallel(as, order, s, order->hseqbase == base ? EXPORT_DENSE : EXPORT_ORDERED, nr);
+		else if (order->hseqbase == base)
 			ret = output_file_dense(as, s);
 		else
 			ret = output_file_ordered(as, order, s);
+	} else if (nr > 1) {
+		ret = output_file_parallel(as, order, s, EXPORT_DEFAULT, nr);
 	} else {
 		ret = output_file_default(as, order, s);
 	}
@@ -619,6 +824,7 @@ typedef struct {
 	int id;						/* for self reference */
 	int state;					/* line break=1 , 2 = update bat */
 	int workers;				/* how many concurrent ones */
+	int producers;				/* threads splitting a buffer into records */
 	int error;					/* error during line break */
 	int next;
 	int limit;
@@ -1213,6 +1419,145 @@ SQLworkdivider(READERtask *task, READERtask *ptask, int nr_attrs, int threads)
 		task->time[i] = 0;
 }
 
+/*
+ * Splitting a buffer into records in parallel.
+ * The buffer is divided into byte ranges which are scanned for record
+ * separators concurrently.  Whether the first byte of a range is
+ * escaped follows from the number of backslashes that precede it, but
+ * whether it lies inside a quoted field depends on everything before
+ * it.  Therefore, each range is scanned for both cases, and afterwards
+ * the ranges are stitched together in order: the quote state at the
+ * end of a range determines which of the two results of the next range
+ * is correct.
+ * A range may report a separator that overlaps with the last one found
+ * in the range before it (only possible for multi-byte separators);
+ * these are skipped by the caller.
+ */
+
+typedef struct {
+	MT_Id tid;
+	const char *start, *end;	/* byte range to scan */
+	const char *rsep;
+	size_t rseplen;
+	char quote;
+	int escaped;				/* first byte is escaped */
+	char **seps[2];				/* separators found (per start state) */
+	size_t nseps[2], maxseps[2];
+	int endquote[2];			/* quote state at end (per start state) */
+	int eos;					/* found a NUL byte */
+	int error;					/* allocation failure */
+} SPLITtask;
+
+static void
+SQLsplitrange(void *arg)
+{
+	SPLITtask *t = arg;
+	const char *rsep = t->rsep;
+	size_t rseplen = t->rseplen;
+	char quote = t->quote;
+	const char *e;
+	int q, st;
+
+	for (st = 0; st < (quote ? 2 : 1); st++) {
+		q = st;
+		for (e = t->start + t->escaped; e < t->end; e++) {
+			if (*e == 0) {
+				t->eos = 1;
+				return;
+			}
+			if (q) {
+				if (*e == quote)
+					q = 0;
+				else if (*e == '\\')
+					e++;
+			} else if (quote && *e == quote) {
+				q = 1;
+			} else if (*e == '\\') {
+				e++;
+			} else if (*e == *rsep &&
+					   (rseplen == 1 || strncmp(e, rsep, rseplen) == 0)) {
+				if (t->nseps[st] == t->maxseps[st]) {
+					size_t n = t->maxseps[st] ? 2 * t->maxseps[st] : 1024;
+					char **p = GDKrealloc(t->seps[st], n * sizeof(char *));
+					if (p == NULL) {
+						t->error = 1;
+						return;
+					}
+					t->seps[st] = p;
+					t->maxseps[st] = n;
+				}
+				t->seps[st][t->nseps[st]++] = (char *) e;
+			}
+		}
+		t->endquote[st] = q;
+	}
+}
+
+/* Find the record separators in s..end using up to task->producers
+ * threads.  Returns a GDKmalloced array with pointers to the
+ * separators (their number in *nseps), or NULL if the buffer must be
+ * scanned sequentially: it is too small, it contains a NUL byte, the
+ * record separator contains a quote or backslash, or we ran out of
+ * memory. */
+static char **
+SQLsplitrecords(READERtask *task, char *s, char *end, size_t *nseps)
+{
+	SPLITtask t[MAXWORKERS];
+	int n, i, j, q;
+	size_t len = (size_t) (end - s), total = 0, k;
+	char **seps = NULL;
+	const char *p;
+
+	n = (int) (len / MINSPLITSIZE);
+	if (n > task->producers)
+		n = task->producers;
+	if (n < 2 ||
+		strchr(task->rsep, '\\') != NULL ||
+		(task->quote && strchr(task->rsep, task->quote) != NULL))
+		return NULL;
+	memset(t, 0, n * sizeof(SPLITtask));
+	for (i = 0; i < n; i++) {
+		t[i].start = s + len / n * i;
+		t[i].end = i == n - 1 ? end : s + len / n * (i + 1);
+		t[i].rsep = task->rsep;
+		t[i].rseplen = task->rseplen;
+		t[i].quote = task->quote;
+		for (p = t[i].start; p > s && p[-1] == '\\'; p--)
+			t[i].escaped = !t[i].escaped;
+	}
+	for (i = 1; i < n; i++)
+		if (MT_create_thread(&t[i].tid, SQLsplitrange, &t[i], MT_THR_JOINABLE) < 0)
+			t[i].tid = 0;
+	SQLsplitrange(&t[0]);
+	for (i = 1; i < n; i++) {
+		if (t[i].tid)
+			MT_join_thread(t[i].tid);
+		else
+			SQLsplitrange(&t[i]);
+	}
+	/* stitch the ranges together */
+	for (i = 0, q = 0; i < n; i++) {
+		if (t[i].eos || t[i].error)
+			goto bailout;
+		total += t[i].nseps[q];
+		q = t[i].endquote[q];
+	}
+	if ((seps = GDKmalloc((total + 1) * sizeof(char *))) == NULL)
+		goto bailout;
+	for (i = 0, q = 0, k = 0; i < n; i++) {
+		if (t[i].nseps[q] > 0)
+			memcpy(seps + k, t[i].seps[q], t[i].nseps[q] * sizeof(char *));
+		k += t[i].nseps[q];
+		q = t[i].endquote[q];
+	}
+	*nseps = total;
+  bailout:
+	for (i = 0; i < n; i++)
+		for (j = 0; j < 2; j++)
+			GDKfree(t[i].seps[j]);
+	return seps;
+}
+
 /*
  * Reading is handled by a separate task as a preparation for more parallelism.
  * A buffer is filled with proper lines.
@@ -1230,9 +1575,9 @@ SQLproducer(void *p)
 	int blocked[MAXBUFFERS] = { 0 };
 	int ateof[MAXBUFFERS] = { 0 };
 	BUN cnt = 0, bufcnt[MAXBUFFERS] = { 0 };
-	char *end, *e, *s, *base;
+	char *end, *e, *s, *base, **seps;
 	const char *rsep = task->rsep;
-	size_t rseplen = strlen(rsep), partial = 0;
+	size_t rseplen = strlen(rsep), partial = 0, nseps, i;
 	char quote = task->quote;
 	Thread thr;
 
@@ -1315,6 +1660,29 @@ SQLproducer(void *p)
 		 * scan ended (we need to back off some since we could be in
 		 * the middle of the record separator).  If this is too
 		 * costly, we have to rethink the matter. */
+		if (cnt < task->maxrow &&
+			(seps = SQLsplitrecords(task, s, end, &nseps)) != NULL) {
+			for (i = 0; i < nseps && cnt < task->maxrow; i++) {
+				e = seps[i];
+				if (e < s)
+					continue;	/* overlaps with previous separator */
+				if (--task->skip < 0 && cnt < task->maxrow) {
+					task->lines[cur][task->top[cur]++] = s;
+					cnt++;
+				}
+				*e = '\0';
+				s = e + rseplen;
+				task->b->pos += (size_t) (s - base);
+				base = s;
+				if (task->top[cur] == task->limit)
+					break;
+			}
+			/* keep the incomplete last record for the next round */
+			if (i == nseps && s < end)
+				partial = end - s;
+			GDKfree(seps);
+			goto reportlackofinput;
+		}
 		for (e = s; *e && e < end && cnt < task->maxrow;) {
 			/* tokenize the record completely the format of the input
 			 * should comply to the following grammar rule [
@@ -1637,6 +2005,7 @@ SQLload_file(Client cntxt, Tablet *as, bstream *b, stream *out, const char *csep
 		task.maxrow = BUN_MAX;
 	else
 		task.maxrow = (BUN) maxrow;
+	task.producers = threads;
 
 	if (task.fields == 0 || task.cols == 0 || task.time == 0) {
 		tablet_error(&task, lng_nil, int_nil, SQLSTATE(HY001) MAL_MALLOC_FAIL, "SQLload_file");
@@ -9,6 +9,7 @@
 #include "monetdb_config.h"
 #include "opt_mitosis.h"
 #include "mal_interpreter.h"
+#include "mal_resource.h"
 #include <gdk_utils.h>
 
 static int
@@ -32,7 +33,7 @@ eligible(MalBlkPtr mb)
 str
 OPTmitosisImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
 {
-	int i, j, limit, slimit, estimate = 0, pieces = 1, mito_parts = 0, mito_size = 0, row_size = 0, mt = -1;
+	int i, j, limit, slimit, estimate = 0, pieces = 1, minpieces = 1, mito_parts = 0, mito_size = 0, row_size = 0, mt = -1;
 	str schema = 0, table = 0;
 	BUN r = 0, rowcnt = 0;    /* table should be sizeable to consider parallel execution*/
 	InstrPtr q, *old, target = 0;
@@ -134,7 +135,7 @@ OPTmitosisImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
 		 * i.e., (rowcnt/pieces <= m/threads),
 		 * i.e., (pieces => rowcnt/(m/threads))
 		 * (assuming that (m > threads*MINPARTCNT)) */
-		pieces = (int) (rowcnt / (m / threads / activeClients)) + 1;
+		pieces = minpieces = (int) (rowcnt / (m / threads / activeClients)) + 1;
 	} else if (rowcnt > MINPARTCNT) {
 	/* exploit parallelism, but ensure minimal partition size to
 	 * limit overhead */
@@ -145,6 +146,28 @@ OPTmitosisImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
 	FORCEMITODEBUG
 	if (pieces < threads)
 		pieces = (int) MIN((BUN) threads, rowcnt);
+	/* In feedback mode, use the number of pieces advised by previous
+	 * runs over the same table, but never fewer than needed to fit
+	 * memory.  When the server is busy with other work, don't create
+	 * more pieces than there are idle threads to pick them up. */
+	if (mito_feedback) {
+		char name[2 * IDLENGTH];
+		int advice, idle;
+		size_t running = MALrunningThreads();
+
+		snprintf(name, sizeof(name), "%s.%s",
+				 getVarConstant(mb, getArg(target, 2)).val.sval,
+				 getVarConstant(mb, getArg(target, 3)).val.sval);
+		advice = MALmitosisAdvice(name);
+		if (advice > 0)
+			pieces = (int) MIN((BUN) MAX(advice, minpieces), rowcnt);
+		/* the running count includes an offset of GDKnr_threads */
+		if (running > (size_t) threads) {
+			idle = running - threads < (size_t) threads ? threads - (int) (running - threads) : 1;
+			if (pieces > idle)
+				pieces = MAX(idle, minpieces);
+		}
+	}
 	/* prevent plan explosion */
 	if (pieces > MAXSLICES)
 		pieces = MAXSLICES;
@@ -178,6 +201,9 @@ OPTmitosisImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
 
 	schema = getVarConstant(mb, getArg(target, 2)).val.sval;
 	table = getVarConstant(mb, getArg(target, 3)).val.sval;
+	/* the work of the pieces is reported back on this table */
+	if (mito_feedback)
+		snprintf(mb->mitosis, sizeof(mb->mitosis), "%s.%s", schema, table);
 	for (i = 0; i < limit; i++) {
 		int upd = 0, qtpe, rtpe = 0, qv, rv;
 		InstrPtr matq, matr = NULL;
@@ -0,0 +1,626 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2017 MonetDB B.V.
+ */
+
+/*
+ * Morsel-driven pipelines
+ * After mitosis and mergetable each piece of a table is run through a
+ * chain of selects, projections and calculations that typically ends
+ * in a few aggregates.  Every step of the chain materializes an
+ * intermediate as large as the piece.  The pipeline optimizer takes
+ * such a chain out of the plan into a MAL block of its own, owned by
+ * the plan, and replaces it by a single pipeline.run call.  At runtime
+ * the block is run over consecutive slices (morsels) of the columns
+ * and candidate lists of the piece, small enough for the slices and
+ * the intermediates derived from them to stay in the cache, and the
+ * aggregates of the morsels are combined (see run_pipeline.c).
+ *
+ * The inputs of a pipeline are the columns (sql.bind) and candidate
+ * lists (sql.tid) of one piece of a table, values aligned with them,
+ * and scalars.  An instruction is fused when its results are only used
+ * by fused instructions of the same pipeline, except for the
+ * aggregates, which are the results of the pipeline.  Aggregates are
+ * limited to those that can be combined across morsels: count, min,
+ * max and sum over integers.  Floating point sums would depend on the
+ * morsel size.
+ *
+ * The remaining instructions keep their order, except that those
+ * waiting for the results of a pipeline are moved after it.
+ */
+#include "monetdb_config.h"
+#include "opt_pipeline.h"
+#include "mal_builder.h"
+
+/* what a variable holds, in terms of the rows of a (piece of a) table */
+#define PL_NONE	0
+#define PL_COL	1	/* a value for each row */
+#define PL_CAND	2	/* a candidate list of rows */
+#define PL_VAL	3	/* a value for each candidate of align[v] */
+#define PL_AGGR	4	/* an aggregate over (a selection of) the rows */
+
+typedef struct {
+	str sch, tbl;		/* the table, and the piece of it */
+	int part, nparts;
+	int fused;			/* instructions fused */
+	int sinks;			/* aggregates among them */
+	int last;			/* pc of the last one */
+	MalBlkPtr pb;		/* the pipeline */
+	InstrPtr run;		/* and its call */
+} Pipeline;
+
+typedef struct {
+	int vtop;			/* variables when we started */
+	char *kind;			/* per variable */
+	int *grp, *align, *def;
+	int *fuse;			/* per instruction, pipeline + 1 */
+	Pipeline *pl;
+	int npl;
+} PipeState;
+
+static int
+PIPEint(MalBlkPtr mb, InstrPtr p, int k)
+{
+	int a = getArg(p, k);
+
+	if (!isVarConstant(mb, a) || getVarType(mb, a) != TYPE_int)
+		return int_nil;
+	return getVarConstant(mb, a).val.ival;
+}
+
+static str
+PIPEstr(MalBlkPtr mb, InstrPtr p, int k)
+{
+	int a = getArg(p, k);
+
+	if (!isVarConstant(mb, a) || getVarType(mb, a) != TYPE_str)
+		return NULL;
+	return getVarConstant(mb, a).val.sval;
+}
+
+/* the pipeline of the base columns and candidates of a table piece */
+static int
+PIPEtable(MalBlkPtr mb, InstrPtr p, PipeState *s)
+{
+	int i, part = -1, nparts = -1;
+	str sch, tbl;
+	Pipeline *pl;
+
+	if (p->retc != 1)
+		return -1;
+	if (getFunctionId(p) == bindRef) {
+		/* only the committed column, not its delta */
+		if ((p->argc != 6 && p->argc != 8) || PIPEint(mb, p, 5) != 0)
+			return -1;
+		if (p->argc == 8) {
+			part = PIPEint(mb, p, 6);
+			nparts = PIPEint(mb, p, 7);
+		}
+	} else {
+		if (p->argc != 4 && p->argc != 6)
+			return -1;
+		if (p->argc == 6) {
+			part = PIPEint(mb, p, 4);
+			nparts = PIPEint(mb, p, 5);
+		}
+	}
+	sch = PIPEstr(mb, p, 2);
+	tbl = PIPEstr(mb, p, 3);
+	if (sch == NULL || tbl == NULL || part == int_nil || nparts == int_nil)
+		return -1;
+	for (i = 0; i < s->npl; i++)
+		if (s->pl[i].part == part && s->pl[i].nparts == nparts &&
+		    strcmp(s->pl[i].sch, sch) == 0 && strcmp(s->pl[i].tbl, tbl) == 0)
+			return i;
+	pl = (Pipeline *) GDKrealloc(s->pl, sizeof(Pipeline) * (s->npl + 1));
+	if (pl == NULL)
+		return -1;
+	s->pl = pl;
+	pl += s->npl;
+	memset(pl, 0, sizeof(Pipeline));
+	pl->sch = sch;
+	pl->tbl = tbl;
+	pl->part = part;
+	pl->nparts = nparts;
+	return s->npl++;
+}
+
+/*
+ * Determine the pipeline an instruction can be fused into, and what its
+ * result holds.  Scalar arguments may not be aggregates of the pipeline
+ * itself, for those are only known once all morsels have been run.
+ */
+static int
+PIPEfusable(MalBlkPtr mb, InstrPtr p, PipeState *s)
+{
+	int k, a, c, g = -1, al = -1, cand = 0, r = getArg(p, 0);
+	str m = getModuleId(p), f = getFunctionId(p);
+
+	if (p->retc != 1 || (p->token != CMDcall && p->token != PATcall))
+		return -1;
+	for (k = 1; k < p->argc; k++)
+		if (!isaBatType(getArgType(mb, p, k)) && s->kind[getArg(p, k)] == PL_AGGR)
+			return -1;
+
+	if (m == algebraRef && (f == thetaselectRef || f == selectRef)) {
+		if (f == thetaselectRef && (p->argc == 4 || p->argc == 5))
+			cand = p->argc == 5;
+		else if (f == selectRef && (p->argc == 7 || p->argc == 8))
+			cand = p->argc == 8;
+		else
+			return -1;
+		a = getArg(p, 1);
+		if (s->kind[a] != PL_COL)
+			return -1;
+		g = s->grp[a];
+		if (cand && (s->kind[c = getArg(p, 2)] != PL_CAND || s->grp[c] != g))
+			return -1;
+		for (k = 2 + cand; k < p->argc; k++)
+			if (isaBatType(getArgType(mb, p, k)))
+				return -1;
+		s->kind[r] = PL_CAND;
+	} else if (m == algebraRef && f == projectionRef) {
+		if (p->argc != 3)
+			return -1;
+		c = getArg(p, 1);
+		a = getArg(p, 2);
+		if (s->kind[c] != PL_CAND || s->kind[a] != PL_COL || s->grp[c] != s->grp[a])
+			return -1;
+		g = s->grp[a];
+		s->kind[r] = PL_VAL;
+		s->align[r] = c;
+	} else if (m == batcalcRef || m == batmmathRef || m == batmtimeRef || m == batstrRef) {
+		if (!isaBatType(getArgType(mb, p, 0)))
+			return -1;
+		for (k = 1; k < p->argc; k++) {
+			if (!isaBatType(getArgType(mb, p, k)))
+				continue;
+			a = getArg(p, k);
+			if (s->kind[a] == PL_COL)
+				c = -1;
+			else if (s->kind[a] == PL_VAL)
+				c = s->align[a];
+			else
+				return -1;
+			if (g < 0) {
+				g = s->grp[a];
+				al = c;
+			} else if (s->grp[a] != g || c != al)
+				return -1;
+		}
+		if (g < 0)
+			return -1;
+		s->kind[r] = al < 0 ? PL_COL : PL_VAL;
+		s->align[r] = al;
+	} else if (m == aggrRef && (f == sumRef || f == minRef || f == maxRef || f == countRef || f == count_no_nilRef)) {
+		if (isaBatType(getArgType(mb, p, 0)))
+			return -1;
+		if (p->argc != 2 && !(p->argc == 3 && f == countRef && !isaBatType(getArgType(mb, p, 2))))
+			return -1;
+		a = getArg(p, 1);
+		if (s->kind[a] != PL_COL && s->kind[a] != PL_VAL &&
+		    !(s->kind[a] == PL_CAND && (f == countRef || f == count_no_nilRef)))
+			return -1;
+		if (f == sumRef) {
+			switch (getArgType(mb, p, 0)) {
+			case TYPE_bte:
+			case TYPE_sht:
+			case TYPE_int:
+			case TYPE_lng:
+#ifdef HAVE_HGE
+			case TYPE_hge:
+#endif
+				break;
+			default:
+				return -1;
+			}
+		}
+		g = s->grp[a];
+		s->kind[r] = PL_AGGR;
+	} else
+		return -1;
+	s->grp[r] = g;
+	return g;
+}
+
+/*
+ * Keep only instructions whose (non aggregate) results are used within
+ * their pipeline, and which get their aligned values from it.  Dropping
+ * one may make others ineligible, so we repeat until nothing changes.
+ */
+static void
+PIPEprune(InstrPtr *old, int limit, PipeState *s, char *used)
+{
+	int i, k, a, changed;
+	InstrPtr p;
+
+	do {
+		changed = 0;
+		memset(used, 0, s->vtop);
+		for (i = limit - 1; i > 0; i--) {
+			p = old[i];
+			if (s->fuse[i]) {
+				a = getArg(p, 0);
+				if (s->kind[a] != PL_AGGR && used[a]) {
+					s->fuse[i] = 0;
+					changed = 1;
+				}
+				for (k = p->retc; s->fuse[i] && k < p->argc; k++) {
+					a = getArg(p, k);
+					if (s->kind[a] == PL_VAL && !s->fuse[s->def[a]]) {
+						s->fuse[i] = 0;
+						changed = 1;
+					}
+				}
+			}
+			if (!s->fuse[i])
+				for (k = p->retc; k < p->argc; k++)
+					used[getArg(p, k)] = 1;
+		}
+	} while (changed);
+}
+
+/*
+ * Create the MAL block of a pipeline and the instruction that runs it.
+ * The inputs of the block are tagged for the runtime, 'c' for columns
+ * sliced by position, 'o' for candidate lists sliced by oid, and 's'
+ * for scalars passed as is.
+ */
+static str
+PIPEbuild(Client cntxt, MalBlkPtr mb, InstrPtr *old, int limit, PipeState *s, int g, int blk, int *map, int *inputs)
+{
+	Pipeline *pl = s->pl + g;
+	int i, k, a, n = 0, width = 0, size, err = 0;
+	char name[IDLENGTH], *kinds;
+	InstrPtr p, q, sig;
+	MalBlkPtr pb;
+
+	for (i = 1; i < limit; i++) {
+		if (s->fuse[i] != g + 1)
+			continue;
+		p = old[i];
+		for (k = p->retc; k < p->argc; k++) {
+			a = getArg(p, k);
+			if (isVarConstant(mb, a) || map[a] == -2 ||
+			    (s->def[a] >= 0 && s->fuse[s->def[a]] == g + 1))
+				continue;
+			map[a] = -2;
+			inputs[n++] = a;
+		}
+	}
+	kinds = GDKmalloc(n + 1);
+	if (kinds == NULL)
+		throw(MAL, "optimizer.pipeline", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	for (k = 0; k < n; k++) {
+		int tpe = getVarType(mb, inputs[k]);
+
+		a = inputs[k];
+		map[a] = -1;
+		if (s->kind[a] == PL_COL) {
+			kinds[k] = 'c';
+			width += ATOMsize(getBatType(tpe)) + (ATOMvarsized(getBatType(tpe)) ? 8 : 0);
+		} else if (s->kind[a] == PL_CAND) {
+			kinds[k] = 'o';
+			width += (int) sizeof(oid);
+		} else if (!isaBatType(tpe))
+			kinds[k] = 's';
+		else {
+			GDKfree(kinds);
+			return MAL_SUCCEED;
+		}
+	}
+	kinds[n] = 0;
+	size = GDKgetenv_int("morsel_size", MORSELSIZE) * 1024 / (width ? width : 1);
+	if (size <= 0)
+		size = 1;
+
+	snprintf(name, IDLENGTH, "%s_%d", getFunctionId(getInstrPtr(mb, 0)), blk);
+	pb = newMalBlk(n + 2 * pl->fused + 8);
+	sig = newInstruction(NULL, pipelineRef, putName(name));
+	if (pb == NULL || sig == NULL) {
+		if (pb)
+			freeMalBlk(pb);
+		GDKfree(kinds);
+		throw(MAL, "optimizer.pipeline", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	/* keep the temporary names apart from those of the plan */
+	pb->vid = mb->vid;
+	sig->token = FUNCTIONsymbol;
+	sig->barrier = 0;
+
+	/* the aggregates are returned, the inputs are the arguments */
+	for (i = 1; i < limit; i++)
+		if (s->fuse[i] == g + 1 && s->kind[a = getArg(old[i], 0)] == PL_AGGR)
+			sig = pushReturn(pb, sig, map[a] = cloneVariable(pb, mb, a));
+	for (k = 0; k < n; k++)
+		sig = pushArgument(pb, sig, map[inputs[k]] = cloneVariable(pb, mb, inputs[k]));
+	pushInstruction(pb, sig);
+	for (i = 1; i < limit && err == 0; i++) {
+		if (s->fuse[i] != g + 1)
+			continue;
+		p = old[i];
+		if ((q = copyInstruction(p)) == NULL) {
+			err = 1;
+			break;
+		}
+		for (k = 0; k < p->argc; k++) {
+			a = getArg(p, k);
+			if (map[a] < 0)
+				map[a] = cloneVariable(pb, mb, a);
+			getArg(q, k) = map[a];
+		}
+		q->pc = pb->stop;
+		if (pb->maxarg < q->maxarg)
+			pb->maxarg = q->maxarg;
+		pushInstruction(pb, q);
+	}
+	/* reset the variable map for the next pipeline */
+	for (i = 1; i < limit; i++)
+		if (s->fuse[i] == g + 1)
+			for (k = 0; k < old[i]->argc; k++)
+				map[getArg(old[i], k)] = -1;
+	if (err == 0)
+		pushEndInstruction(pb);
+	if (err || pb->errors) {
+		freeMalBlk(pb);
+		GDKfree(kinds);
+		throw(MAL, "optimizer.pipeline", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	/* release the intermediates of a morsel once they are used */
+	setVariableScope(pb);
+	for (i = 0; i < pb->vtop; i++)
+		if (isVarCleanup(pb, i) && getEndScope(pb, i) >= 0) {
+			setVarEolife(pb, i, getEndScope(pb, i));
+			pb->stmt[getVarEolife(pb, i)]->gc |= GARBAGECONTROL;
+		}
+
+	q = newInstruction(mb, pipelineRef, runRef);
+	if (q == NULL) {
+		freeMalBlk(pb);
+		GDKfree(kinds);
+		throw(MAL, "optimizer.pipeline", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	for (i = 1; i < limit; i++)
+		if (s->fuse[i] == g + 1 && s->kind[a = getArg(old[i], 0)] == PL_AGGR)
+			q = pushReturn(mb, q, a);
+	q = pushInt(mb, q, blk);
+	q = pushInt(mb, q, size);
+	q = pushStr(mb, q, kinds);
+	for (k = 0; k < n; k++)
+		q = pushArgument(mb, q, inputs[k]);
+	GDKfree(kinds);
+	typeChecker(cntxt->usermodule, mb, q, TRUE);
+	if (q->typechk != TYPE_RESOLVED) {
+		/* the pipeline module is not loaded */
+		freeInstruction(q);
+		freeMalBlk(pb);
+		return MAL_SUCCEED;
+	}
+	pl->pb = pb;
+	pl->run = q;
+	return MAL_SUCCEED;
+}
+
+/*
+ * Emit the instructions queued in plan order as soon as their arguments
+ * are available.  Instructions without side effects may overtake those
+ * waiting for the result of a pipeline, others keep their order.
+ */
+static void
+PIPEdrain(MalBlkPtr mb, InstrPtr *queue, int *first, int n, char *ready)
+{
+	int i, k, progress, pending, se;
+	InstrPtr p;
+
+	do {
+		progress = pending = 0;
+		for (i = *first; i < n; i++) {
+			if ((p = queue[i]) == NULL)
+				continue;
+			se = hasSideEffects(mb, p, TRUE);
+			if (se && pending)
+				break;
+			for (k = p->retc; k < p->argc; k++)
+				if (!ready[getArg(p, k)])
+					break;
+			if (k < p->argc) {
+				if (se)
+					break;
+				pending = 1;
+				continue;
+			}
+			pushInstruction(mb, p);
+			for (k = 0; k < p->retc; k++)
+				ready[getArg(p, k)] = 1;
+			queue[i] = NULL;
+			progress = 1;
+		}
+		while (*first < n && queue[*first] == NULL)
+			(*first)++;
+	} while (progress);
+}
+
+str
+OPTpipelineImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	int i, k, g, stop, limit, slimit, actions = 0, nblk = 0, first = 0, n = 0;
+	InstrPtr p, *old = mb->stmt, *queue = NULL;
+	PipeState s;
+	char *used = NULL, *ready = NULL;
+	int *map = NULL, *inputs = NULL;
+	MalBlkPtr *blks = NULL;
+	char buf[256];
+	lng usec = GDKusec();
+	str msg = MAL_SUCCEED;
+
+	(void) pci;
+	(void) stk;		/* to fool compilers */
+	memset(&s, 0, sizeof(s));
+	stop = limit = mb->stop;
+	slimit = mb->ssize;
+	if (mb->inlineProp)
+		goto wrapup;
+
+	s.vtop = mb->vtop;
+	s.kind = GDKzalloc(s.vtop);
+	used = GDKzalloc(s.vtop);
+	s.grp = GDKmalloc(sizeof(int) * s.vtop);
+	s.align = GDKmalloc(sizeof(int) * s.vtop);
+	s.def = GDKmalloc(sizeof(int) * s.vtop);
+	map = GDKmalloc(sizeof(int) * s.vtop);
+	inputs = GDKmalloc(sizeof(int) * s.vtop);
+	s.fuse = GDKzalloc(sizeof(int) * limit);
+	if (s.kind == NULL || used == NULL || s.grp == NULL || s.align == NULL ||
+	    s.def == NULL || map == NULL || inputs == NULL || s.fuse == NULL) {
+		msg = createException(MAL, "optimizer.pipeline", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+	for (i = 0; i < s.vtop; i++)
+		s.grp[i] = s.align[i] = s.def[i] = map[i] = -1;
+
+	/* the plans we can rearrange are straight-line and assign each
+	 * variable once */
+	for (i = 0; i < limit; i++) {
+		p = old[i];
+		if (p->token == ENDsymbol)
+			break;
+		if (p->barrier)
+			goto wrapup;
+		for (k = 0; k < p->retc; k++) {
+			if (s.def[getArg(p, k)] >= 0)
+				goto wrapup;
+			s.def[getArg(p, k)] = i;
+		}
+	}
+	limit = i;
+
+	for (i = 1; i < limit; i++) {
+		p = old[i];
+		if (getModuleId(p) == sqlRef && (getFunctionId(p) == bindRef || getFunctionId(p) == tidRef)) {
+			if ((g = PIPEtable(mb, p, &s)) >= 0) {
+				s.kind[getArg(p, 0)] = getFunctionId(p) == bindRef ? PL_COL : PL_CAND;
+				s.grp[getArg(p, 0)] = g;
+			}
+		} else if ((g = PIPEfusable(mb, p, &s)) >= 0)
+			s.fuse[i] = g + 1;
+	}
+	if (s.npl == 0)
+		goto wrapup;
+	PIPEprune(old, limit, &s, used);
+
+	/* a pipeline should save intermediates and end in aggregates */
+	for (i = 1; i < limit; i++)
+		if ((g = s.fuse[i] - 1) >= 0) {
+			s.pl[g].fused++;
+			s.pl[g].sinks += s.kind[getArg(old[i], 0)] == PL_AGGR;
+			s.pl[g].last = i;
+		}
+	for (g = 0; g < s.npl; g++) {
+		if (s.pl[g].fused == 0 || s.pl[g].sinks == 0 || s.pl[g].sinks == s.pl[g].fused)
+			continue;
+		msg = PIPEbuild(cntxt, mb, old, limit, &s, g, mb->npipelines + nblk, map, inputs);
+		if (msg)
+			goto wrapup;
+		nblk += s.pl[g].run != NULL;
+	}
+	for (i = 1; i < limit; i++)
+		if ((g = s.fuse[i] - 1) >= 0 && s.pl[g].run == NULL)
+			s.fuse[i] = 0;
+	if (nblk == 0)
+		goto wrapup;
+
+	blks = (MalBlkPtr *) GDKrealloc(mb->pipelines, sizeof(MalBlkPtr) * (mb->npipelines + nblk));
+	queue = (InstrPtr *) GDKmalloc(sizeof(InstrPtr) * (limit + nblk));
+	ready = GDKzalloc(mb->vtop);
+	if (blks == NULL || queue == NULL || ready == NULL) {
+		msg = createException(MAL, "optimizer.pipeline", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+	mb->pipelines = blks;
+	for (i = 0; i < mb->vtop; i++)
+		ready[i] = i >= s.vtop || s.def[i] < 0;
+	if (newMalBlkStmt(mb, slimit) < 0) {
+		mb->stmt = old;
+		msg = createException(MAL, "optimizer.pipeline", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+
+	/* the pipelines are placed where the last instruction fused into
+	 * them used to be, the others wait for them when needed */
+	for (i = 0; i < limit; i++) {
+		p = old[i];
+		if ((g = s.fuse[i] - 1) >= 0) {
+			if (i == s.pl[g].last)
+				queue[n++] = s.pl[g].run;
+		} else
+			queue[n++] = p;
+		PIPEdrain(mb, queue, &first, n, ready);
+	}
+	if (first < n) {
+		/* a pipeline depends on its own results, leave the plan as is */
+		GDKfree(mb->stmt);
+		mb->stmt = old;
+		mb->stop = stop;
+		mb->ssize = slimit;
+		goto wrapup;
+	}
+	for (; i < stop; i++)
+		pushInstruction(mb, old[i]);
+	for (; i < slimit; i++)
+		if (old[i])
+			freeInstruction(old[i]);
+	for (i = 0; i < limit; i++)
+		if (s.fuse[i])
+			freeInstruction(old[i]);
+	for (g = 0; g < s.npl; g++)
+		if (s.pl[g].run) {
+			mb->pipelines[mb->npipelines++] = s.pl[g].pb;
+			s.pl[g].pb = NULL;
+			s.pl[g].run = NULL;
+			actions++;
+		}
+	GDKfree(old);
+
+#ifdef _DEBUG_OPT_PIPELINE_
+	fprintf(stderr, "#pipeline optimizer result\n");
+	fprintFunction(stderr, mb, 0, LIST_MAL_ALL);
+	for (i = 0; i < mb->npipelines; i++)
+		fprintFunction(stderr, mb->pipelines[i], 0, LIST_MAL_ALL);
+#endif
+
+wrapup:
+	for (g = 0; g < s.npl; g++) {
+		if (s.pl[g].pb)
+			freeMalBlk(s.pl[g].pb);
+		if (s.pl[g].run)
+			freeInstruction(s.pl[g].run);
+	}
+	GDKfree(s.pl);
+	GDKfree(s.kind);
+	GDKfree(s.grp);
+	GDKfree(s.align);
+	GDKfree(s.def);
+	GDKfree(s.fuse);
+	GDKfree(used);
+	GDKfree(map);
+	GDKfree(inputs);
+	GDKfree(queue);
+	GDKfree(ready);
+
+	/* Defense line against incorrect plans */
+	if (actions > 0) {
+		chkTypes(cntxt->usermodule, mb, FALSE);
+		chkFlow(mb);
+		chkDeclarations(mb);
+	}
+	/* keep all actions taken as a post block comment */
+	usec = GDKusec() - usec;
+	snprintf(buf, 256, "%-20s actions=%2d time=" LLFMT " usec", "pipeline", actions, usec);
+	newComment(mb, buf);
+	if (actions >= 0)
+		addtoMalBlkHistory(mb);
+	return msg;
+}
@@ -0,0 +1,25 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2017 MonetDB B.V.
+ */
+
+#ifndef _OPT_PIPELINE_
+#define _OPT_PIPELINE_
+#include "opt_prelude.h"
+#include "opt_support.h"
+#include "mal_interpreter.h"
+#include "mal_instruction.h"
+#include "mal_function.h"
+
+/* the size of the input slices (in K) run by a pipeline at a time, so
+ * that they and the intermediates derived from them stay in the cache */
+#define MORSELSIZE 256
+
+mal_export str OPTpipelineImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+
+/* #define _DEBUG_OPT_PIPELINE_ */
+
+#endif
@@ -212,6 +212,40 @@ static struct PIPELINES {
  * development.  Do not use any of these pipelines in production
  * settings!
  */
+/*
+ * The pipeline pipe is the default pipe, except that chains of
+ * selects, projections, calculations and aggregates over the pieces
+ * of a table are fused and run over cache-sized morsels.
+ */
+	{"pipeline_pipe",
+	 "optimizer.inline();"
+	 "optimizer.remap();"
+	 "optimizer.costModel();"
+	 "optimizer.coercions();"
+	 "optimizer.evaluate();"
+	 "optimizer.emptybind();"
+	 "optimizer.pushselect();"
+	 "optimizer.aliases();"
+	 "optimizer.mitosis();"
+	 "optimizer.mergetable();"
+	 "optimizer.deadcode();"
+	 "optimizer.aliases();"
+	 "optimizer.constants();"
+	 "optimizer.commonTerms();"
+	 "optimizer.projectionpath();"
+	 "optimizer.deadcode();"
+	 "optimizer.reorder();"
+	 "optimizer.matpack();"
+	 "optimizer.pipeline();"
+	 "optimizer.dataflow();"
+	 "optimizer.querylog();"
+	 "optimizer.multiplex();"
+	 "optimizer.generator();"
+	 "optimizer.profiler();"
+	 "optimizer.candidates();"
+	 "optimizer.wlc();"
+	 "optimizer.garbageCollector();",
+	 "experimental", NULL, NULL, 1},
 /* sentinel */
 	{NULL, NULL, NULL, NULL, NULL, 0}
 };
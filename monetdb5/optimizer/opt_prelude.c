@@ -197,6 +197,7 @@ str partitionRef;
 str passRef;
 str pcreRef;
 str pinRef;
+str pipelineRef;
 str plusRef;
 str postludeRef;
 str preludeRef;
@@ -236,6 +237,7 @@ str rollbackRef;
 str row_numberRef;
 str rpcRef;
 str rsColumnRef;
+str runRef;
 str sampleRef;
 str schedulerRef;
 str selectNotNilRef;
@@ -489,6 +491,7 @@ void optimizerInit(void)
 	partitionRef = putName("partition");
 	pcreRef = putName("pcre");
 	pinRef = putName("pin");
+	pipelineRef = putName("pipeline");
 	plusRef = putName("+");
 	minusRef = putName("-");
 	mulRef = putName("*");
@@ -533,6 +536,7 @@ void optimizerInit(void)
 	row_numberRef = putName("row_number");
 	rpcRef = putName("rpc");
 	rsColumnRef = putName("rsColumn");
+	runRef = putName("run");
 	schedulerRef = putName("scheduler");
 	selectNotNilRef = putName("selectNotNil");
 	seriesRef = putName("series");
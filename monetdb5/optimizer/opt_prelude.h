@@ -197,6 +197,7 @@ mal_export  str partitionRef;
 mal_export  str passRef;
 mal_export  str pcreRef;
 mal_export  str pinRef;
+mal_export  str pipelineRef;
 mal_export  str plusRef;
 mal_export  str postludeRef;
 mal_export  str preludeRef;
@@ -236,6 +237,7 @@ mal_export  str rollbackRef;
 mal_export  str row_numberRef;
 mal_export  str rpcRef;
 mal_export  str rsColumnRef;
+mal_export  str runRef;
 mal_export  str sampleRef;
 mal_export  str schedulerRef;
 mal_export  str selectNotNilRef;
@@ -38,6 +38,7 @@
 #include "opt_matpack.h"
 #include "opt_json.h"
 #include "opt_oltp.h"
+#include "opt_pipeline.h"
 #include "opt_mergetable.h"
 #include "opt_mitosis.h"
 #include "opt_multiplex.h"
@@ -77,6 +78,7 @@ struct{
 	{"mitosis", &OPTmitosisImplementation,0,0},
 	{"multiplex", &OPTmultiplexImplementation,0,0},
 	{"oltp", &OPToltpImplementation,0,0},
+	{"pipeline", &OPTpipelineImplementation,0,0},
 	{"wlc", &OPTwlcImplementation,0,0},
 	{"profiler", &OPTprofilerImplementation,0,0},
 	{"projectionpath", &OPTprojectionpathImplementation,0,0},
@@ -7,216 +7,246 @@
  */
 
 /*
- * @a M. Kersten
- * @* Scheduler framework
- * A key design decision for this MonetDB  version is to create a clean
- * processing pipeline: compile-, optimize-, schedule- and execute.
- * The MAL scheduler controls the actual execution of a program through a number of
- * techniques described here. It accepts a program with the intend to execute it
- * as soon as possible with the best possible behavior.
- *
- * Note that the scheduler should only work on temporary plans. Keeping an
- * execution schedule in the symbol table calls for a sound administration
- * to invalidate it. This assumed that such decisions are taken by a cooperative
- * front-end compiler, e.g. SQL. For the remainder we assume a volatile MAL
- * program is available.
- *
- * Recall that the MAL optimizer already had an opportunity to massage the program
- * into something that has a better execution behavior. These optimizations
- * necessarily rely on static (or stale) information, such as histograms, indices,
- * and rewrite heuristics. It is the task of the scheduler to achieve this
- * performance objective (or better), while at the same time guaranteeing
- * great throughput.
- *
- * Unlike the optimizer, the scheduler has access to the calling parameters,
- * runtime stack for the about-to-be-executed plan, and system resources,
- * such as globally cached results. Moreover, a scheduler can be called at any time
- * during a MAL interpreter loop to re-consider the actions to be taken.
- * This gives many more opportunities to improve performance.
- * This does not hold for e.g. compiled code.
- *
- * Much like the optimizer framework, there are many aspects you can deal with
- * at scheduling time. The easiest is to simply do nothing and rely on
- * the MAL interpreter, which is the default action when no scheduler directive
- * is found.
- *
- * In most cases, however, you would like a scheduler to take a specific action.
- * It typically rewrites, extends, or reshuffles the query plan as it is being
- * prepared for execution or even during its execution.
- * In this process it can use the optimizer infrastructure, provided the
- * changes are isolated to a private instance. This should be prepared
- * before the interpreter is started and requires care during execution to
- * ensure proper behaviour. The upfront cost attached is to make a complete
- * copy of the program code and to assure that the definitions in the
- * symbol table remain intact.
- *
- * To make its life easy, it is assumed that all scheduler decisions to be
- * taken before the back-end is called reside in the module 'scheduler'.
- * Any action to be taken during execution is kept in module 'rescheduler'.
- *
- * What scheduler operators are provided?
- *
- * The generic scheduler presented here shows a series of techniques that
- * might be useful in construction of your own scheduler.
- *
- * @emph{Run isolation (RUNisolated)}
- * Goal: to isolate changes to the query plan from others
- * Rationale: A scheduler may change the order, and actual function calls.
- * These changes should be confined to a single execution. The next time around
- * there may be a different situation to take care off. This is achieved by
- * replacing the current program with a private copy.
- * Note that this process may involve a deep analysis to identify the pieces
- * needed for isolation, e.g. for SQL we would extract a copy from the SQL query
- * cache using code expansion.
- * Just massaging the call to the cached plan is not effective.
- * Impact: cost of program copying may become an issue.
- *
- * @emph{Run trace (RUNtracing)}
- * Goal: to collect performance data for either direct monitoring or post-analysis
- * Rationale:The performance profiling option in the interpreter is overly expensive,
- * because it is also called for simple statements. One way out of this, is to
- * inject specific performance metric calls at places where it counts.
- * For example, you could wrap calls calls to a specific module or operation.
- *
- * @emph{Run notification (RUNnotification)}
- * Goal: to inject notification calls to awaiting servers
- * Rationale: Operations on the database may require side effects to take place,
- * such as activating a trigger (implemented as a factory)
- *
- * @emph{Update notification (RUNupdateNotification)}
- * Goal: Updates to the Boxes may have to  forwarded to stand-by replicas.
- * Rationale: actually a refinement of the notification scheme, but geared at
- * maintaining a replicated system.
- *
- * @emph{Materialized Execution Scheduler (MEscheduler)}
- * Goal:to transfor the program into fragment-based processing
- * Rationale: to reduce the impact of resource limitations, such
- * as main memory, in the face of materialized intermediate.
- *
- * @emph{Run parallelization (RUNparallel)}
- * Goal: to improve throughput/response time by exploiting parallel hardware
- *
- * @emph{Run stepping RUNstepping}
- * goal: to return to the scheduler at specific points in the program
- * execution. For example to re-consider the scheduling actions.
- * Note that this requires a scheme to 'backtrack' in the scenario
- *
- * @emph{Cache management (RUNbatCaching}
- * Goal: to capture expensive BAT operations and to keep them around for
- * re-use.
- *
- * @emph{JIT compilation}
- * Use the Mcc just in time compilation feature to derive and link
- * a small C-program.
- *
- * What the scheduler could do more?
- * A separete thread of control can be used to administer the
- * information needed by concurrent scheduler calls.
- *
- * One of the areas to be decided upon is whether the scheduler is
- * also the place to manage the stack spaces. It certainly could
- * reconcile parallel executions by inspection of the stack.
- *
- * Upon starting the scheduler decisions, we should (regularly)
- * refresh our notion on the availability of resources.
- * This is kept around in a global structure and is the basis for
- * micro scheduling decisions.
+ * @f run_pipeline
+ * @+ Morsel-driven pipeline execution
+ * The pipeline optimizer (opt_pipeline.c) moves chains of selects,
+ * projections, calculations and aggregates over one piece of a table
+ * into MAL blocks kept with the plan, and calls each of them with
+ * @example
+ *	(X_10:lng, X_11:int) := pipeline.run(0:int, 16384:int, "cco", X_3, X_4, C_5);
+ * @end example
+ * The first arguments are the index of the block in the plan, the
+ * number of rows in a morsel, and how each input is to be cut into
+ * morsels: 'c' for columns sliced by position, 'o' for candidate lists
+ * sliced by the oids of those positions, and 's' for scalars passed as
+ * is.
+ *
+ * The block is run over one morsel after the other, each on a stack of
+ * its own, such that the slices and the intermediates derived from them
+ * stay in the cache.  The pieces of a table are run in parallel by the
+ * dataflow scheduler, the morsels of a piece are not.  The aggregates
+ * returned by the block for each morsel are combined into those of the
+ * piece: counts and sums are added, minima and maxima compared, nils
+ * skipped.  When the columns of a piece do not line up, or a candidate
+ * list is not a sorted list of their oids, the block is run once over
+ * the whole piece.
  */
 
 #include "monetdb_config.h"
 #include "run_pipeline.h"
-#include "mal_interpreter.h"	/* for showErrors() */
 #include "opt_prelude.h"
-#include "opt_macro.h"
 
-/*
- * The implementation approach of the scheduler aligns with that of the
- * optimizer. We look for specific scheduler module calls and act accordingly.
- * The result should be a MAL block that can be executed by the corresponding
- * engine.
- */
-/*
- * The second example is derived from the SQL environment, which
- * produces two MAL functions: one (already) stored in the query cache
- * and a program to be executed in the client record.
- * The latter lives only for the duration of the call and need
- * not be safeguarded. Thus, we immediately call the scheduler
- * to expand the code from the query cache, propagating the
- * actual parameters.
- * The SQL specific scheduler is called to bind the table
- * columns and to make statistics known as properties.
- * This creates a situation where a cost-based optimizer could
- * step in and re-arrange the plan, which is ignored for now.
- * @example
- * function sql_cache.qry01(int A1, bit A2);
- * 	t1:= sql.bind("schema","tables",0,0);
- * 	...
- * end qry01;
- *
- * function main();
- * 	scheduler.inline("sql_cache","qry01");
- * 	scheduler.sqlbind();
- * 	sql_cache.qry01(12,false);
- * @end example
- *
- * These scheduler interventions are called for by the SQL compiler.
- * It may have flagged the cached version as a high potential for
- * dynamic optimization, something that is not known at the MAL level.
- * [The current optimizer also generates a factory, that should be
- * done here and upon explicit request]
- */
-#if 0
-str
-RUNinline(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
+#define PIPE_ADD	0
+#define PIPE_MIN	1
+#define PIPE_MAX	2
+
+/* how the aggregate v of a morsel combines with those of the others */
+static int
+PIPEcombiner(MalBlkPtr pb, int v)
 {
-	Symbol qc;
-	str modnme = getVarConstant(mb, getArg(p, 1)).val.sval;
-	str fcnnme = getVarConstant(mb, getArg(p, 2)).val.sval;
+	int i;
+	InstrPtr p;
 
-	(void) stk;
-	(void) p;
-	qc = findSymbol(cntxt ->nspace, getName(modnme),
-			putName(fcnnme));
+	for (i = 1; i < pb->stop; i++) {
+		p = getInstrPtr(pb, i);
+		if (p->retc == 1 && getArg(p, 0) == v && getModuleId(p) == aggrRef) {
+			if (getFunctionId(p) == minRef)
+				return PIPE_MIN;
+			if (getFunctionId(p) == maxRef)
+				return PIPE_MAX;
+			return PIPE_ADD;
+		}
+	}
+	return -1;
+}
 
-	if (qc)
-		MACROprocessor(cntxt, mb, qc);
+static str
+PIPEcombine(ValPtr acc, ValPtr v, int op)
+{
+	ValRecord r;
+	int c;
 
+	if (VALisnil(v))
+		return MAL_SUCCEED;
+	if (!VALisnil(acc)) {
+		if (op == PIPE_ADD) {
+			r.vtype = acc->vtype;
+			if (VARcalcadd(&r, acc, v, 1) != GDK_SUCCEED)
+				throw(MAL, "pipeline.run", GDK_EXCEPTION);
+			*acc = r;
+			return MAL_SUCCEED;
+		}
+		c = ATOMcmp(acc->vtype, VALptr(v), VALptr(acc));
+		if ((op == PIPE_MIN && c >= 0) || (op == PIPE_MAX && c <= 0))
+			return MAL_SUCCEED;
+	}
+	/* take over the value, the morsel stack is cleared next */
+	VALclear(acc);
+	*acc = *v;
+	v->vtype = TYPE_int;
+	v->val.ival = int_nil;
 	return MAL_SUCCEED;
 }
-#endif
 
-/*
- * @-
- * The SQL scheduler is presented merely as an example. The real one
- * is located in  the SQL libraries for it needs specific information.
- */
-#if 0
-str
-RUNsqlbind(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
+/* whether candidate list s is a sorted list of oids of the cnt rows
+ * starting at base */
+static int
+PIPEcovered(BAT *s, oid base, BUN cnt)
 {
-	int i;
+	oid lo, hi;
+
+	if (BATcount(s) == 0)
+		return 1;
+	if (BATtdense(s)) {
+		lo = s->tseqbase;
+		hi = s->tseqbase + BATcount(s) - 1;
+	} else if (s->ttype == TYPE_oid && s->tsorted) {
+		lo = *(oid *) Tloc(s, 0);
+		hi = *(oid *) Tloc(s, BATcount(s) - 1);
+	} else
+		return 0;
+	return lo >= base && hi < base + cnt;
+}
+
+/* run the pipeline over the rows [lo,hi) of the piece */
+static str
+PIPEmorsel(Client cntxt, MalBlkPtr pb, MalStkPtr stk, InstrPtr pci, str kinds, BAT **b, oid base, BUN lo, BUN hi, int whole, ValPtr acc, int *op)
+{
+	InstrPtr sig = getInstrPtr(pb, 0);
+	int k, first = pci->retc + 3, n = pci->argc - first;
+	MalStkPtr ps;
+	ValPtr v;
+	BAT *s;
+	BUN l, h;
+	oid o;
 	str msg = MAL_SUCCEED;
-	Symbol sqlbind = findSymbol(cntxt ->nspace, getName("sql"), getName("bind"));
-	MALfcn f = NULL;
-
-	if (sqlbind )
-		f = getSignature(sqlbind)->fcn;
-
-	if ( f )
-	for (i = 0; i < mb->stop; i++) {
-		p = getInstrPtr(mb, i);
-		if (p->fcn == f) {
-			if ((msg = reenterMAL(cntxt, mb, i, i + 1, stk)))
-				break;
-			/* fetch the BAT properties and turn off this instruction */
-			p->token = NOOPsymbol;
+
+	ps = prepareMALstack(pb, pb->vsize);
+	if (ps == NULL)
+		throw(MAL, "pipeline.run", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	/* keep the morsels of concurrent runs of the plan apart in the
+	 * query queue */
+	ps->up = stk;
+	for (k = 0; k < n && msg == MAL_SUCCEED; k++) {
+		v = &ps->stk[getArg(sig, sig->retc + k)];
+		if (kinds[k] == 's') {
+			if (VALcopy(v, &stk->stk[getArg(pci, first + k)]) == NULL)
+				msg = createException(MAL, "pipeline.run", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+			continue;
+		}
+		if (whole) {
+			l = 0;
+			h = BATcount(b[k]);
+		} else if (kinds[k] == 'c') {
+			l = lo;
+			h = hi;
+		} else {
+			o = base + lo;
+			l = SORTfndfirst(b[k], &o);
+			o = base + hi;
+			h = SORTfndfirst(b[k], &o);
 		}
+		if ((s = BATslice(b[k], l, h)) == NULL) {
+			msg = createException(MAL, "pipeline.run", GDK_EXCEPTION);
+			continue;
+		}
+		v->vtype = TYPE_bat;
+		v->val.bval = s->batCacheid;
+		BBPkeepref(s->batCacheid);
 	}
-#ifdef DEBUG_MAL_SCHEDULER
-	fprintf(stderr, "scheduler.sqlbind results\n");
-	fprintFunction(stderr, mb, stk, LIST_MAL_ALL);
-#endif
+	if (msg == MAL_SUCCEED)
+		msg = runMALsequence(cntxt, pb, 1, 0, ps, 0, 0);
+	for (k = 0; k < sig->retc && msg == MAL_SUCCEED; k++)
+		msg = PIPEcombine(acc + k, &ps->stk[getArg(sig, k)], op[k]);
+	garbageCollector(cntxt, pb, ps, TRUE);
+	freeStack(ps);
 	return msg;
 }
+
+str
+PIPELINErun(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	int blk = *getArgReference_int(stk, pci, pci->retc);
+	int size = *getArgReference_int(stk, pci, pci->retc + 1);
+	str kinds = *getArgReference_str(stk, pci, pci->retc + 2);
+	int k, whole = 0, first = pci->retc + 3, n = pci->argc - first, *op = NULL;
+	BAT **b = NULL;
+	oid base = 0;
+	BUN cnt = BUN_NONE, lo, hi;
+	ValPtr acc = NULL;
+	MalBlkPtr pb;
+	InstrPtr sig;
+	str msg = MAL_SUCCEED;
+
+	if (blk < 0 || blk >= mb->npipelines)
+		throw(MAL, "pipeline.run", ILLEGAL_ARGUMENT " unknown pipeline");
+	pb = mb->pipelines[blk];
+	sig = getInstrPtr(pb, 0);
+	if (sig->retc != pci->retc || sig->argc - sig->retc != n || (int) strlen(kinds) != n)
+		throw(MAL, "pipeline.run", ILLEGAL_ARGUMENT " arguments do not match the pipeline");
+
+	b = (BAT **) GDKzalloc(sizeof(BAT *) * (n + 1));
+	acc = (ValPtr) GDKzalloc(sizeof(ValRecord) * pci->retc);
+	op = (int *) GDKmalloc(sizeof(int) * pci->retc);
+	if (b == NULL || acc == NULL || op == NULL) {
+		msg = createException(MAL, "pipeline.run", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+	for (k = 0; k < pci->retc; k++) {
+		VALinit(acc + k, getArgGDKType(mb, pci, k), ATOMnilptr(getArgGDKType(mb, pci, k)));
+		if ((op[k] = PIPEcombiner(pb, getArg(sig, k))) < 0) {
+			msg = createException(MAL, "pipeline.run", ILLEGAL_ARGUMENT " pipeline result is not an aggregate");
+			goto wrapup;
+		}
+	}
+
+	/* the columns determine the rows of the piece */
+	for (k = 0; k < n; k++) {
+		if (kinds[k] == 's')
+			continue;
+		if ((b[k] = BATdescriptor(*getArgReference_bat(stk, pci, first + k))) == NULL) {
+			msg = createException(MAL, "pipeline.run", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+			goto wrapup;
+		}
+		if (kinds[k] != 'c')
+			continue;
+		if (cnt == BUN_NONE) {
+			base = b[k]->hseqbase;
+			cnt = BATcount(b[k]);
+		} else if (b[k]->hseqbase != base || BATcount(b[k]) != cnt)
+			whole = 1;
+	}
+	if (cnt == BUN_NONE || size <= 0 || cnt <= (BUN) size)
+		whole = 1;
+	for (k = 0; k < n && !whole; k++)
+		if (kinds[k] == 'o' && !PIPEcovered(b[k], base, cnt))
+			whole = 1;
+#ifdef DEBUG_RUN_PIPELINE
+	fprintf(stderr, "#pipeline.run %d rows " BUNFMT " morsel %d%s\n", blk, cnt, size, whole ? " whole" : "");
 #endif
 
+	for (lo = 0; msg == MAL_SUCCEED; lo = hi) {
+		hi = whole || cnt - lo <= (BUN) size ? cnt : lo + size;
+		msg = PIPEmorsel(cntxt, pb, stk, pci, kinds, b, base, lo, hi, whole, acc, op);
+		if (whole || hi >= cnt)
+			break;
+	}
+	if (msg == MAL_SUCCEED)
+		for (k = 0; k < pci->retc; k++) {
+			/* hand the combined aggregates over to the plan */
+			stk->stk[getArg(pci, k)] = acc[k];
+			acc[k].vtype = TYPE_int;
+		}
+
+wrapup:
+	for (k = 0; b && k < n; k++)
+		if (b[k])
+			BBPunfix(b[k]->batCacheid);
+	if (acc)
+		for (k = 0; k < pci->retc; k++)
+			VALclear(acc + k);
+	GDKfree(b);
+	GDKfree(acc);
+	GDKfree(op);
+	return msg;
+}
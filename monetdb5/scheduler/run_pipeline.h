@@ -6,27 +6,15 @@
  * Copyright 1997 - July 2008 CWI, August 2008 - 2017 MonetDB B.V.
  */
 
-#ifndef _MAL_SCHEDULER
-#define _MAL_SCHEDULER
+#ifndef _RUN_PIPELINE
+#define _RUN_PIPELINE
 #include "mal.h"
+#include "mal_interpreter.h"
 #include "mal_instruction.h"
 #include "mal_client.h"
 
-#define DEBUG_MAL_SCHEDULER
+/* #define DEBUG_RUN_PIPELINE */
 
-#ifdef HAVE_SYS_TIMES_H
-# include <sys/times.h>
-#endif
+mal_export str PIPELINErun(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 
-#ifdef HAVE_SYS_RESOURCE_H
-#include <sys/resource.h>
-#endif
-
-struct {
-	/* rusage memused; */
-	int cpuload;		/* hard to get */
-} runtime;
-
-mal_export str MALpipeline(Client c);
-
-#endif /* MAL_SCEDULER */
+#endif /* _RUN_PIPELINE */
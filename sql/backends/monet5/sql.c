@@ -152,6 +152,7 @@ sqlcleanup(mvc *c, int err)
 	}
 	/* some statements dynamically disable caching */
 	c->sym = NULL;
+	c->views = NULL;
 	if (c->sa)
 		c->sa = sa_reset(c->sa);
 	if (err >0)
@@ -2642,6 +2643,10 @@ mvc_import_table_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
  * Non-simple types require each line to contain a valid ascii representation
  * of the text terminate by a new-line. These strings are passed to the corresponding
  * atom conversion routines to fill the column.
+ * Alternatively, a file can be a self-describing column file (see
+ * BATattach), which also supports strings and foreign nil values.  The
+ * attached BATs are transient: their values are copied when they are
+ * appended to the table.
  */
 str
 mvc_bin_import_table_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
@@ -2713,7 +2718,8 @@ mvc_bin_import_table_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pc
 		if (strcmp(fname, str_nil) == 0) {
 			// no filename for this column, skip for now because we potentially don't know the count yet
 			continue;
-		} else if (tpe < TYPE_str || tpe == TYPE_date || tpe == TYPE_daytime || tpe == TYPE_timestamp) {
+		} else if (tpe < TYPE_str || tpe == TYPE_date || tpe == TYPE_daytime || tpe == TYPE_timestamp ||
+				   (tpe == TYPE_str && BATcolumnfile(fname))) {
 			c = BATattach(col->type.type->localtype, fname, TRANSIENT);
 			if (c == NULL)
 				throw(SQL, "sql", SQLSTATE(42000) "Failed to attach file %s", fname);
@@ -3492,6 +3498,156 @@ dump_opt_stats(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	return MAL_SUCCEED;
 }
 
+str
+dump_plan_cache(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	static const char *names[] = {
+		"entries", "size", "hits", "misses", "invalidations", "evictions"
+	};
+	lng vals[6];
+	BAT *stat, *value;
+	bat *rstat = getArgReference_bat(stk, pci, 0);
+	bat *rvalue = getArgReference_bat(stk, pci, 1);
+	int i;
+
+	(void) cntxt;
+	(void) mb;
+	qc_shared_stats(&vals[0], &vals[1], &vals[2], &vals[3], &vals[4], &vals[5]);
+	stat = COLnew(0, TYPE_str, 6, TRANSIENT);
+	value = COLnew(0, TYPE_lng, 6, TRANSIENT);
+	if (stat == NULL || value == NULL) {
+		BBPreclaim(stat);
+		BBPreclaim(value);
+		throw(SQL, "sql.dump_plan_cache", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	for (i = 0; i < 6; i++) {
+		if (BUNappend(stat, names[i], FALSE) != GDK_SUCCEED ||
+		    BUNappend(value, &vals[i], FALSE) != GDK_SUCCEED) {
+			BBPreclaim(stat);
+			BBPreclaim(value);
+			throw(SQL, "sql.dump_plan_cache", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		}
+	}
+	*rstat = stat->batCacheid;
+	*rvalue = value->batCacheid;
+	BBPkeepref(*rstat);
+	BBPkeepref(*rvalue);
+	return MAL_SUCCEED;
+}
+
+str
+dump_result_cache(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	static const char *names[] = {
+		"entries", "size", "hits", "misses", "invalidations", "evictions"
+	};
+	lng vals[6];
+	BAT *stat, *value;
+	bat *rstat = getArgReference_bat(stk, pci, 0);
+	bat *rvalue = getArgReference_bat(stk, pci, 1);
+	int i;
+
+	(void) cntxt;
+	(void) mb;
+	mvc_result_cache_stats(&vals[0], &vals[1], &vals[2], &vals[3], &vals[4], &vals[5]);
+	stat = COLnew(0, TYPE_str, 6, TRANSIENT);
+	value = COLnew(0, TYPE_lng, 6, TRANSIENT);
+	if (stat == NULL || value == NULL) {
+		BBPreclaim(stat);
+		BBPreclaim(value);
+		throw(SQL, "sql.dump_result_cache", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	for (i = 0; i < 6; i++) {
+		if (BUNappend(stat, names[i], FALSE) != GDK_SUCCEED ||
+		    BUNappend(value, &vals[i], FALSE) != GDK_SUCCEED) {
+			BBPreclaim(stat);
+			BBPreclaim(value);
+			throw(SQL, "sql.dump_result_cache", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		}
+	}
+	*rstat = stat->batCacheid;
+	*rvalue = value->batCacheid;
+	BBPkeepref(*rstat);
+	BBPkeepref(*rvalue);
+	return MAL_SUCCEED;
+}
+
+str
+dump_commit_stats(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	static const char *names[] = {
+		"commits", "syncs", "async_commits", "max_group", "sync_usec"
+	};
+	lng vals[5] = {0, 0, 0, 0, 0};
+	BAT *stat, *value;
+	bat *rstat = getArgReference_bat(stk, pci, 0);
+	bat *rvalue = getArgReference_bat(stk, pci, 1);
+	int i;
+
+	(void) cntxt;
+	(void) mb;
+	if (logger_funcs.log_commit_stats)
+		logger_funcs.log_commit_stats(&vals[0], &vals[1], &vals[2], &vals[3], &vals[4]);
+	stat = COLnew(0, TYPE_str, 5, TRANSIENT);
+	value = COLnew(0, TYPE_lng, 5, TRANSIENT);
+	if (stat == NULL || value == NULL) {
+		BBPreclaim(stat);
+		BBPreclaim(value);
+		throw(SQL, "sql.dump_commit_stats", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	for (i = 0; i < 5; i++) {
+		if (BUNappend(stat, names[i], FALSE) != GDK_SUCCEED ||
+		    BUNappend(value, &vals[i], FALSE) != GDK_SUCCEED) {
+			BBPreclaim(stat);
+			BBPreclaim(value);
+			throw(SQL, "sql.dump_commit_stats", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		}
+	}
+	*rstat = stat->batCacheid;
+	*rvalue = value->batCacheid;
+	BBPkeepref(*rstat);
+	BBPkeepref(*rvalue);
+	return MAL_SUCCEED;
+}
+
+str
+dump_checkpoint_stats(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	static const char *names[] = {
+		"checkpoints", "deferred", "last_changes", "pending_changes",
+		"lag_ms", "wait_usec", "max_wait_usec", "flush_usec"
+	};
+	lng vals[8];
+	BAT *stat, *value;
+	bat *rstat = getArgReference_bat(stk, pci, 0);
+	bat *rvalue = getArgReference_bat(stk, pci, 1);
+	int i;
+
+	(void) cntxt;
+	(void) mb;
+	store_checkpoint_stats(&vals[0], &vals[1], &vals[2], &vals[3], &vals[4], &vals[5], &vals[6], &vals[7]);
+	stat = COLnew(0, TYPE_str, 8, TRANSIENT);
+	value = COLnew(0, TYPE_lng, 8, TRANSIENT);
+	if (stat == NULL || value == NULL) {
+		BBPreclaim(stat);
+		BBPreclaim(value);
+		throw(SQL, "sql.dump_checkpoint_stats", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	for (i = 0; i < 8; i++) {
+		if (BUNappend(stat, names[i], FALSE) != GDK_SUCCEED ||
+		    BUNappend(value, &vals[i], FALSE) != GDK_SUCCEED) {
+			BBPreclaim(stat);
+			BBPreclaim(value);
+			throw(SQL, "sql.dump_checkpoint_stats", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		}
+	}
+	*rstat = stat->batCacheid;
+	*rvalue = value->batCacheid;
+	BBPkeepref(*rstat);
+	BBPkeepref(*rvalue);
+	return MAL_SUCCEED;
+}
+
 /* str dump_opt_stats(int *r); */
 str
 dump_trace(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
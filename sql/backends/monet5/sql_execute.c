@@ -335,6 +335,17 @@ SQLrun(Client c, backend *be, mvc *m)
 			break;
 		}
 	}
+	// serve the result from the result cache when possible
+	if (mc) {
+		switch (mvc_result_cache_probe(be, mb)) {
+		case 1:
+			freeMalBlk(mb);
+			return MAL_SUCCEED;
+		case -1:
+			freeMalBlk(mb);
+			throw(SQL, "sql.resultcache", SQLSTATE(45000) "Result set construction failed");
+		}
+	}
 	// JIT optimize the SQL query using all current information
 	// This include template constants, BAT sizes.
 	if( m->emod & mod_debug)
@@ -342,6 +353,7 @@ SQLrun(Client c, backend *be, mvc *m)
 	msg = SQLoptimizeQuery(c, mb);
 	if( msg != MAL_SUCCEED){
 		// freeMalBlk(mb);
+		mvc_result_cache_done(be, 0);
 		return msg;
 	}
 	mb->keephistory = FALSE;
@@ -349,12 +361,19 @@ SQLrun(Client c, backend *be, mvc *m)
 	if (mb->errors){
 		// freeMalBlk(mb);
 		// mal block might be so broken free causes segfault
+		mvc_result_cache_done(be, 0);
 		return msg;
 	}
 
 	if (m->emod & mod_explain) {
-		if (c->curprg->def)
+		if (c->curprg->def) {
+			int i;
+
 			printFunction(c->fdout, mb, 0, LIST_MAL_NAME | LIST_MAL_VALUE  | LIST_MAL_TYPE |  LIST_MAL_MAPI);
+			/* and the blocks run by pipeline.run */
+			for (i = 0; i < mb->npipelines; i++)
+				printFunction(c->fdout, mb->pipelines[i], 0, LIST_MAL_NAME | LIST_MAL_VALUE  | LIST_MAL_TYPE |  LIST_MAL_MAPI);
+		}
 	} else if( m->emod & mod_debug) {
 		msg = runMALDebugger(c, mb);
 	} else {
@@ -366,6 +385,7 @@ SQLrun(Client c, backend *be, mvc *m)
 			msg = runMAL(c, mb, 0, 0);
 		}
 	}
+	mvc_result_cache_done(be, msg == MAL_SUCCEED);
 
 	// release the resources
 	freeMalBlk(mb);
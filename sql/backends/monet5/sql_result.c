@@ -18,6 +18,8 @@
 #include <bat/res_table.h>
 #include <bat/bat_storage.h>
 #include <rel_exp.h>
+#include <opt_prelude.h>
+#include <opt_support.h>
 
 #ifndef HAVE_LLABS
 #define llabs(x)	((x) < 0 ? -(x) : (x))
@@ -1458,6 +1460,252 @@ eight_byte_align(char* ptr) {
 	return (char*) (((size_t) ptr + 7) & ~7);
 }
 
+/*
+ * When the client asked for column compression, each column of a
+ * protocol 10 result block starts with an eight byte tag holding its
+ * column_compression encoding, chosen from the values in the block:
+ *
+ * NONE:  the plain representation.
+ * RLE:   [lng nruns][nruns values][pad to 8][nruns int run lengths]
+ * FOR:   [lng base][lng width][nrows unsigned offsets of width bytes]
+ * DELTA: [lng first][lng width][nrows-1 unsigned differences of width
+ *        bytes] for ascending columns
+ * DICT:  [lng nentries][lng length][the distinct strings, each zero
+ *        terminated][pad to 8][nrows codes], codes are 1, 2 or 4
+ *        bytes wide depending on nentries
+ *
+ * An encoding is only used when it is smaller than the plain
+ * representation, and only between a little endian server and a
+ * little endian client, whose values need no byte swapping.  All
+ * encoded integers, and the values in the encodings, are therefore
+ * little endian.
+ */
+
+static size_t
+prot10_width(ulng range)
+{
+	if (range <= 0xFF)
+		return 1;
+	if (range <= 0xFFFF)
+		return 2;
+	if (range <= 0xFFFFFFFF)
+		return 4;
+	return 8;
+}
+
+static lng
+prot10_getint(const char *p, size_t w)
+{
+	switch (w) {
+	case 1: return *(const bte *) p;
+	case 2: return *(const sht *) p;
+	case 4: return *(const int *) p;
+	default: return *(const lng *) p;
+	}
+}
+
+static void
+prot10_putuint(char *p, size_t w, ulng v)
+{
+	switch (w) {
+	case 1: *(unsigned char *) p = (unsigned char) v; break;
+	case 2: *(unsigned short *) p = (unsigned short) v; break;
+	case 4: *(unsigned int *) p = (unsigned int) v; break;
+	default: *(ulng *) p = v; break;
+	}
+}
+
+/* Encode the n fixed width (w) values at src into dst, return the
+ * size of the encoding or 0 if none beats the plain size n * w.
+ * Frame of reference and delta encoding are only considered for
+ * integral values. */
+static size_t
+prot10_encode_fixed(const char *src, size_t n, size_t w, int integral, char *dst, int *enc)
+{
+	size_t i, nruns = 1, best = n * w, sz, fw = w, dw = w;
+	int sorted = 1;
+	lng min, max, prev, v;
+	ulng maxdelta = 0;
+
+	*enc = COLUMN_COMPRESSION_NONE;
+	if (n < 2)
+		return 0;
+	integral &= w <= sizeof(lng);
+	min = max = prev = integral ? prot10_getint(src, w) : 0;
+	for (i = 1; i < n; i++) {
+		if (memcmp(src + (i - 1) * w, src + i * w, w) != 0)
+			nruns++;
+		if (integral) {
+			v = prot10_getint(src + i * w, w);
+			if (v < min)
+				min = v;
+			else if (v > max)
+				max = v;
+			if (v < prev)
+				sorted = 0;
+			else if ((ulng) v - (ulng) prev > maxdelta)
+				maxdelta = (ulng) v - (ulng) prev;
+			prev = v;
+		}
+	}
+	sz = sizeof(lng) + ((nruns * w + 7) & ~7) + nruns * sizeof(int);
+	if (sz < best) {
+		best = sz;
+		*enc = COLUMN_COMPRESSION_RLE;
+	}
+	if (integral) {
+		fw = prot10_width((ulng) max - (ulng) min);
+		sz = 2 * sizeof(lng) + n * fw;
+		if (fw < w && sz < best) {
+			best = sz;
+			*enc = COLUMN_COMPRESSION_FOR;
+		}
+		if (sorted) {
+			dw = prot10_width(maxdelta);
+			sz = 2 * sizeof(lng) + (n - 1) * dw;
+			if (dw < w && sz < best) {
+				best = sz;
+				*enc = COLUMN_COMPRESSION_DELTA;
+			}
+		}
+	}
+
+	switch (*enc) {
+	case COLUMN_COMPRESSION_RLE: {
+		char *vals = dst + sizeof(lng);
+		int *lens = (int *) (dst + sizeof(lng) + ((nruns * w + 7) & ~7));
+		size_t r = 0;
+
+		*(lng *) dst = (lng) nruns;
+		memcpy(vals, src, w);
+		lens[0] = 1;
+		for (i = 1; i < n; i++) {
+			if (memcmp(src + (i - 1) * w, src + i * w, w) != 0) {
+				r++;
+				memcpy(vals + r * w, src + i * w, w);
+				lens[r] = 0;
+			}
+			lens[r]++;
+		}
+		assert(r + 1 == nruns);
+		break;
+	}
+	case COLUMN_COMPRESSION_FOR: {
+		char *vals = dst + 2 * sizeof(lng);
+
+		((lng *) dst)[0] = min;
+		((lng *) dst)[1] = (lng) fw;
+		for (i = 0; i < n; i++)
+			prot10_putuint(vals + i * fw, fw, (ulng) prot10_getint(src + i * w, w) - (ulng) min);
+		break;
+	}
+	case COLUMN_COMPRESSION_DELTA: {
+		char *vals = dst + 2 * sizeof(lng);
+
+		prev = prot10_getint(src, w);
+		((lng *) dst)[0] = prev;
+		((lng *) dst)[1] = (lng) dw;
+		for (i = 1; i < n; i++) {
+			v = prot10_getint(src + i * w, w);
+			prot10_putuint(vals + (i - 1) * dw, dw, (ulng) v - (ulng) prev);
+			prev = v;
+		}
+		break;
+	}
+	default:
+		return 0;
+	}
+	return best;
+}
+
+/* Dictionary encode the n zero terminated strings (len bytes) at src
+ * into dst, return the size of the encoding or 0 if it does not beat
+ * the plain size. */
+static size_t
+prot10_encode_dict(const char *src, size_t len, size_t n, char *dst, int *enc)
+{
+	size_t i, mask, ndict = 0, dictlen = 0, cw, sz = 0;
+	int *hash = NULL, *codes = NULL;
+	const char **dict = NULL, *p;
+	char *o;
+
+	*enc = COLUMN_COMPRESSION_NONE;
+	if (n < 2)
+		return 0;
+	for (mask = 1; mask < 2 * n; mask <<= 1)
+		;
+	hash = GDKmalloc(mask * sizeof(int));
+	codes = GDKmalloc(n * sizeof(int));
+	dict = GDKmalloc((n / 2 + 1) * sizeof(const char *));
+	if (hash == NULL || codes == NULL || dict == NULL)
+		goto bailout;
+	memset(hash, 0xFF, mask * sizeof(int));
+	mask--;
+	for (i = 0, p = src; i < n; i++) {
+		size_t l = strlen(p), h = 0, j;
+
+		for (j = 0; j < l; j++)
+			h = h * 31 + (unsigned char) p[j];
+		for (h &= mask; hash[h] >= 0; h = (h + 1) & mask)
+			if (strcmp(dict[hash[h]], p) == 0)
+				break;
+		if (hash[h] < 0) {
+			if (ndict == n / 2) {
+				/* too many distinct values */
+				goto bailout;
+			}
+			hash[h] = (int) ndict;
+			dict[ndict++] = p;
+			dictlen += l + 1;
+		}
+		codes[i] = hash[h];
+		p += l + 1;
+	}
+	assert((size_t) (p - src) == len);
+	cw = ndict <= 0xFF ? 1 : ndict <= 0xFFFF ? 2 : 4;
+	sz = 2 * sizeof(lng) + ((dictlen + 7) & ~7) + n * cw;
+	if (sz >= sizeof(lng) + len) {
+		sz = 0;
+		goto bailout;
+	}
+	((lng *) dst)[0] = (lng) ndict;
+	((lng *) dst)[1] = (lng) dictlen;
+	o = dst + 2 * sizeof(lng);
+	for (i = 0; i < ndict; i++)
+		o = mystpcpy(o, dict[i]) + 1;
+	o = dst + 2 * sizeof(lng) + ((dictlen + 7) & ~7);
+	for (i = 0; i < n; i++)
+		prot10_putuint(o + i * cw, cw, (ulng) codes[i]);
+	*enc = COLUMN_COMPRESSION_DICT;
+  bailout:
+	GDKfree(hash);
+	GDKfree(codes);
+	GDKfree(dict);
+	return sz;
+}
+
+/* The plain representation of a column of n values ends at end, right
+ * after its tag at hdr; replace it by its best encoding and return the
+ * new end of the column. */
+static char *
+prot10_encode(char *hdr, char *end, size_t n, int tpe, char *encbuf)
+{
+	char *data = hdr + sizeof(lng);
+	size_t sz;
+	int enc;
+
+	if (tpe == TYPE_str)
+		sz = prot10_encode_dict(data + sizeof(lng), (size_t) *(lng *) data, n, encbuf, &enc);
+	else
+		sz = prot10_encode_fixed(data, n, (size_t) ATOMsize(tpe), tpe != TYPE_flt && tpe != TYPE_dbl, encbuf, &enc);
+	*(lng *) hdr = (lng) enc;
+	if (enc == COLUMN_COMPRESSION_NONE)
+		return end;
+	assert(data + sz <= end);
+	memcpy(data, encbuf, sz);
+	return data + sz;
+}
+
 static int
 mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN offset, BUN nr) {
 	lng count = 0;
@@ -1473,6 +1721,14 @@ mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN off
 	char *result = NULL;
 	size_t length = 0;
 	int initial_transfer = 1;
+#ifdef WORDS_BIGENDIAN
+	/* the encodings are little endian */
+	int colcomp = 0;
+#else
+	/* the client must be little endian too */
+	int colcomp = bs2_colcomp(s) == COLUMN_COMPRESSION_AUTO && mnstr_byteorder(s) == 1234;
+#endif
+	char *encbuf = NULL;
 
 	(void) order; // FIXME: respect explicitly ordered output
 
@@ -1480,6 +1736,10 @@ mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN off
 	if (!iterators) {
 		return -1;
 	}
+	if (colcomp && (encbuf = GDKmalloc(bsize)) == NULL) {
+		GDKfree(iterators);
+		return -1;
+	}
 
 	// ensure the buffer is currently empty
 	assert(bs2_buffer(s).pos == 0);
@@ -1499,6 +1759,7 @@ mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN off
 				BBPunfix(iterators[i].b->batCacheid);
 			}
 			GDKfree(iterators);
+			GDKfree(encbuf);
 			return -1;
 		}
 		mtype = b->ttype;
@@ -1532,6 +1793,9 @@ mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN off
 		// every varsized member has an 8-byte header indicating the length of the header in the block
 		// subtract this from the amount of bytes left
 		bytes_left -= length_prefixed * sizeof(lng);
+		// and with column compression every column has an 8-byte encoding tag
+		if (colcomp)
+			bytes_left -= t->nr_cols * sizeof(lng);
 
 		if (varsized == 0) {
 			// no varsized elements, so we can immediately compute the amount of elements
@@ -1589,6 +1853,14 @@ mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN off
 					fres = -1;
 					goto cleanup;
 				}
+				if (colcomp) {
+					char *nbuf = GDKrealloc(encbuf, (size_t) new_size);
+					if (nbuf == NULL) {
+						fres = -1;
+						goto cleanup;
+					}
+					encbuf = nbuf;
+				}
 				buf = bs2_buffer(s).buf;
 				bsize = (size_t) new_size;
 			}
@@ -1617,7 +1889,15 @@ mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN off
 			res_col *c = t->cols + i;
 			int mtype = iterators[i].b->ttype;
 			int convert_to_string = !type_supports_binary_transfer(c->type.type);
+			char *colhdr = NULL;
+			int enctype = TYPE_void;
 			buf = eight_byte_align(buf);
+			if (colcomp) {
+				// leave room for the encoding tag
+				colhdr = buf;
+				*(lng *) colhdr = COLUMN_COMPRESSION_NONE;
+				buf += sizeof(lng);
+			}
 			if (ATOMvarsized(mtype) || convert_to_string) {
 				if (c->type.type->eclass == EC_BLOB) {
 					// transfer blobs as [lng][data] combination
@@ -1673,6 +1953,7 @@ mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN off
 						assert(buf - bs2_buffer(s).buf <= (lng) bsize);
 					}
 					*((lng*)startbuf) = mnstr_swap_lng(s, buf - (startbuf + sizeof(lng)));
+					enctype = TYPE_str;
 				}
 			} else {
 				size_t atom_size = ATOMsize(mtype);
@@ -1749,7 +2030,10 @@ mvc_export_table_prot10(backend *b, stream *s, res_table *t, BAT *order, BUN off
 					}
 				}
 				buf += (row - srow) * atom_size;
+				enctype = c->type.type->eclass == EC_TIMESTAMP || c->type.type->eclass == EC_DATE ? TYPE_lng : ATOMstorage(mtype);
 			}
+			if (colcomp && enctype != TYPE_void)
+				buf = prot10_encode(colhdr, buf, row - srow, enctype, encbuf);
 		}
 
 		assert(buf >= bs2_buffer(s).buf);
@@ -1776,6 +2060,7 @@ cleanup:
 	if (result) {
 		GDKfree(result);
 	}
+	GDKfree(encbuf);
 	if (mnstr_errnr(s))
 		return -1;
 	return fres;
@@ -2462,6 +2747,8 @@ mvc_export_file(backend *b, stream *s, res_table *t)
 	return res;
 }
 
+static void rc_collect(backend *be, res_table *t);
+
 int
 mvc_export_result(backend *b, stream *s, int res_id)
 {
@@ -2481,6 +2768,8 @@ mvc_export_result(backend *b, stream *s, int res_id)
 	}
 	/* we shouldn't have anything else but Q_TABLE here */
 	assert(t->query_type == Q_TABLE);
+	if (b->rc)
+		rc_collect(b, t);
 	if (t->tsep)
 		return mvc_export_file(b, s, t);
 
@@ -2604,3 +2893,528 @@ mvc_result_value(mvc *m, const char *tn, const char *name, const char *typename,
 	/* return 0 on success, non-zero on failure */
 	return res_col_create(m->session->tr, m->results, tn, name, typename, digits, scale, mtype, p) == NULL;
 }
+
+/*
+ * The result cache
+ *
+ * The results of read-only queries whose template is shared between
+ * the clients (see sql_qc.c) can be kept in a server wide cache, keyed
+ * on the shared template and the values of its parameters.  For every
+ * table the plan reads, the cache entry records the commit timestamp
+ * (base.wtime) of the global version of the table when the result was
+ * made.  A cached result is only handed out as long as those
+ * timestamps are unchanged, and only to transactions that have not
+ * made changes of their own and that see the latest committed state.
+ * Plans that call unsafe or volatile functions (rand, current_time,
+ * sequences, session variables, remote tables, ...) are never cached.
+ *
+ * The cache is bounded by sql_resultcache_size (MiB, 0 disables it).
+ * An entry is charged for its result columns and for the shared
+ * template it keeps alive, also after the template has been dropped
+ * from the plan cache.  Whenever a result is added, the entries whose
+ * tables changed are dropped, and then the least recently used ones
+ * until it fits.
+ */
+
+typedef struct rc_table {
+	sqlid sid;		/* schema of a table read by the plan */
+	sqlid tid;		/* and the table itself */
+	int wtime;		/* its commit timestamp */
+} rc_table;
+
+typedef struct rc_entry {
+	struct rc_entry *next;	/* the cached results in LRU order */
+	struct rc_entry *prev;
+	sq *plan;		/* the shared template (referenced) */
+	int schema_number;	/* catalog version */
+	sql_allocator *sa;	/* for the parameter values */
+	atom **args;		/* the parameter values */
+	int argc;
+	rc_table *tables;	/* the tables read by the plan */
+	int ntables;
+	int nr_cols;		/* -1: result can not be cached */
+	res_col *cols;		/* copies of the result columns */
+	size_t size;		/* memory footprint of the columns and the template */
+} rc_entry;
+
+static MT_Lock rc_lock MT_LOCK_INITIALIZER("rc_lock");
+static rc_entry *rc_list = NULL;	/* most recently used first */
+static rc_entry *rc_last = NULL;	/* least recently used */
+static size_t rc_size = 0, rc_maxsize = 0;
+static lng rc_hits = 0, rc_misses = 0, rc_invalidations = 0, rc_evictions = 0;
+
+static void
+rc_destroy(rc_entry *e)
+{
+	int i;
+
+	if (e->cols) {
+		for (i = 0; i < e->nr_cols; i++) {
+			res_col *c = e->cols + i;
+
+			if (c->b)
+				BBPrelease(c->b);
+			_DELETE(c->tn);
+			_DELETE(c->name);
+		}
+		_DELETE(e->cols);
+	}
+	_DELETE(e->tables);
+	if (e->sa)
+		sa_destroy(e->sa);
+	if (e->plan)
+		qc_release_shared(e->plan);
+	_DELETE(e);
+}
+
+/* the list functions are called with rc_lock held */
+static void
+rc_unlink(rc_entry *e)
+{
+	if (e->prev)
+		e->prev->next = e->next;
+	else
+		rc_list = e->next;
+	if (e->next)
+		e->next->prev = e->prev;
+	else
+		rc_last = e->prev;
+	e->next = e->prev = NULL;
+}
+
+static void
+rc_push(rc_entry *e)
+{
+	e->prev = NULL;
+	e->next = rc_list;
+	if (rc_list)
+		rc_list->prev = e;
+	else
+		rc_last = e;
+	rc_list = e;
+}
+
+void
+mvc_result_cache_init(size_t maxsize)
+{
+#ifdef NEED_MT_LOCK_INIT
+	MT_lock_init(&rc_lock, "rc_lock");
+#endif
+	rc_maxsize = maxsize;
+}
+
+void
+mvc_result_cache_destroy(void)
+{
+	rc_entry *e, *n;
+
+	MT_lock_set(&rc_lock);
+	e = rc_list;
+	rc_list = rc_last = NULL;
+	rc_size = 0;
+	MT_lock_unset(&rc_lock);
+	for (; e; e = n) {
+		n = e->next;
+		rc_destroy(e);
+	}
+}
+
+void
+mvc_result_cache_stats(lng *entries, lng *size, lng *hits, lng *misses, lng *invalidations, lng *evictions)
+{
+	rc_entry *e;
+
+	MT_lock_set(&rc_lock);
+	*entries = 0;
+	for (e = rc_list; e; e = e->next)
+		(*entries)++;
+	*size = (lng) rc_size;
+	*hits = rc_hits;
+	*misses = rc_misses;
+	*invalidations = rc_invalidations;
+	*evictions = rc_evictions;
+	MT_lock_unset(&rc_lock);
+}
+
+/* Is any implementation of mod.fcn marked unsafe? */
+static int
+rc_unsafe_symbol(Client c, const char *mod, const char *fcn)
+{
+	Symbol s;
+
+	for (s = findSymbol(c->usermodule, (str) mod, (str) fcn); s; s = s->peer)
+		if (idcmp(s->name, fcn) == 0 && s->def->unsafeProp)
+			return 1;
+	return 0;
+}
+
+/* Is the result of this instruction the same each time it is
+ * executed on the same data? */
+static int
+rc_stable_instruction(Client c, MalBlkPtr mb, InstrPtr p)
+{
+	const char *mod = getModuleId(p), *fcn = getFunctionId(p);
+
+	if (mod == NULL || fcn == NULL)
+		return 1;
+	if (isUnsafeFunction(p) || rc_unsafe_symbol(c, mod, fcn))
+		return 0;
+	if (mod == malRef && (fcn == multiplexRef || fcn == manifoldRef)) {
+		/* judge the function that is applied */
+		if (p->argc <= p->retc + 1 ||
+		    !isVarConstant(mb, getArg(p, p->retc)) ||
+		    !isVarConstant(mb, getArg(p, p->retc + 1)))
+			return 0;
+		mod = putName(getVarConstant(mb, getArg(p, p->retc)).val.sval);
+		fcn = putName(getVarConstant(mb, getArg(p, p->retc + 1)).val.sval);
+		if (findSymbol(c->usermodule, (str) mod, (str) fcn) == NULL ||
+		    rc_unsafe_symbol(c, mod, fcn))
+			return 0;
+	}
+	if (mod == userRef || mod == remoteRef || mod == mapiRef ||
+	    mod == sqlcatalogRef || mod == ioRef || mod == streamsRef ||
+	    mod == bstreamRef || mod == pyapiRef || mod == pyapimapRef ||
+	    mod == pyapi3Ref || mod == pyapi3mapRef || mod == rapiRef ||
+	    mod == oltpRef || mod == wlcRef || mod == wlrRef)
+		return 0;
+	if (mod == alarmRef || mod == profilerRef ||
+	    strcmp(mod, "uuid") == 0 || strcmp(mod, "clients") == 0 ||
+	    strcmp(mod, "sysmon") == 0)
+		return 0;
+	if ((mod == mmathRef || mod == batmmathRef) &&
+	    (strcmp(fcn, "rand") == 0 || strcmp(fcn, "sqlrand") == 0))
+		return 0;
+	if ((mod == mtimeRef || mod == batmtimeRef) &&
+	    (strncmp(fcn, "current_", 8) == 0 || strncmp(fcn, "local", 5) == 0))
+		return 0;
+	if (mod == sqlRef || mod == batsqlRef)
+		return fcn == mvcRef || fcn == bindRef || fcn == bindidxRef ||
+			fcn == tidRef || fcn == deltaRef || fcn == subdeltaRef ||
+			fcn == projectdeltaRef || fcn == resultSetRef ||
+			fcn == singleRef || fcn == zero_or_oneRef;
+	return 1;
+}
+
+/* Find the tables read by the plan mb.  Returns 0 if the result of the
+ * plan can not be cached. */
+static int
+rc_plan_tables(backend *be, MalBlkPtr mb, rc_entry *e)
+{
+	mvc *m = be->mvc;
+	int i, j, results = 0;
+
+	for (i = 1; i < mb->stop; i++) {
+		InstrPtr p = getInstrPtr(mb, i);
+		sql_schema *s;
+		sql_table *t;
+		const char *sname, *tname;
+
+		if (p->token == ENDsymbol)
+			break;
+		if (!rc_stable_instruction(be->client, mb, p))
+			return 0;
+		if (getModuleId(p) != sqlRef)
+			continue;
+		if (getFunctionId(p) == resultSetRef) {
+			results++;
+			continue;
+		}
+		if (getFunctionId(p) != bindRef && getFunctionId(p) != bindidxRef &&
+		    getFunctionId(p) != tidRef)
+			continue;
+		if (p->argc < p->retc + 3 ||
+		    !isVarConstant(mb, getArg(p, p->retc + 1)) ||
+		    !isVarConstant(mb, getArg(p, p->retc + 2)))
+			return 0;
+		sname = getVarConstant(mb, getArg(p, p->retc + 1)).val.sval;
+		tname = getVarConstant(mb, getArg(p, p->retc + 2)).val.sval;
+		if ((s = mvc_bind_schema(m, sname)) == NULL ||
+		    (t = mvc_bind_table(m, s, tname)) == NULL ||
+		    !isTable(t) || isTempTable(t))
+			return 0;
+		for (j = 0; j < e->ntables; j++)
+			if (e->tables[j].tid == t->base.id)
+				break;
+		if (j < e->ntables)
+			continue;
+		if ((e->ntables & 7) == 0) {
+			rc_table *tables = RENEW_ARRAY(rc_table, e->tables, e->ntables + 8);
+
+			if (tables == NULL)
+				return 0;
+			e->tables = tables;
+		}
+		e->tables[e->ntables].sid = s->base.id;
+		e->tables[e->ntables].tid = t->base.id;
+		e->tables[e->ntables].wtime = 0;
+		e->ntables++;
+	}
+	/* a single result set, and no access to data outside tables */
+	return results == 1 && e->ntables > 0;
+}
+
+/* Look up the commit timestamps of the tables of e in the global
+ * transaction.  If record is set, they are stored in e, otherwise
+ * they are compared with the stored ones.  Returns -1 if the
+ * transaction tr has changes of its own or does not see the latest
+ * committed state, 0 if a table changed since it was recorded, and 1
+ * otherwise. */
+static int
+rc_current(rc_entry *e, int record)
+{
+	int i;
+
+	for (i = 0; i < e->ntables; i++) {
+		sql_schema *s = find_sql_schema_id(gtrans, e->tables[i].sid);
+		sql_table *t = s ? find_sql_table_id(s, e->tables[i].tid) : NULL;
+
+		if (t == NULL)
+			return 0;
+		if (record)
+			e->tables[i].wtime = t->base.wtime;
+		else if (e->tables[i].wtime != t->base.wtime)
+			return 0;
+	}
+	return 1;
+}
+
+static int
+rc_timestamps(sql_trans *tr, rc_entry *e, int record)
+{
+	int ok;
+
+	store_lock();
+	if (tr->wtime != 0 || tr->schema_updates || tr->stime != gtrans->wtime) {
+		store_unlock();
+		return -1;
+	}
+	ok = rc_current(e, record);
+	store_unlock();
+	return ok;
+}
+
+static int
+rc_match(rc_entry *e, sq *plan, int schema_number, atom **args, int argc)
+{
+	int i;
+
+	if (e->plan != plan || e->schema_number != schema_number ||
+	    e->argc != argc)
+		return 0;
+	for (i = 0; i < argc; i++)
+		if (e->args[i]->tpe.digits != args[i]->tpe.digits ||
+		    e->args[i]->tpe.scale != args[i]->tpe.scale ||
+		    atom_cmp(e->args[i], args[i]) != 0)
+			return 0;
+	return 1;
+}
+
+/*
+ * Called before the query template in mb is executed.  If the result
+ * is in the cache and still valid, it is sent to the client and 1 is
+ * returned.  Otherwise, if the result can be cached, the backend is
+ * prepared to collect it while the query runs (see
+ * mvc_result_cache_done).
+ */
+int
+mvc_result_cache_probe(backend *be, MalBlkPtr mb)
+{
+	mvc *m = be->mvc;
+	cq *q = be->q;
+	rc_entry *e, *stale = NULL;
+	int i, res_id = -1;
+
+	be->rc = NULL;
+	if (rc_maxsize == 0 || q == NULL || q->shared == NULL ||
+	    q->type != Q_TABLE || m->emode != m_normal ||
+	    (m->emod & (mod_debug | mod_trace | mod_explain)) ||
+	    be->output_format == OFMT_NONE || m->argc != q->paramlen)
+		return 0;
+
+	MT_lock_set(&rc_lock);
+	for (e = rc_list; e != NULL; e = e->next) {
+		if (!rc_match(e, q->shared, m->session->tr->schema_number, m->args, m->argc))
+			continue;
+		if ((i = rc_timestamps(m->session->tr, e, 0)) <= 0) {
+			if (i == 0) {
+				/* the data changed */
+				rc_unlink(e);
+				rc_size -= e->size;
+				rc_invalidations++;
+				stale = e;
+			}
+			e = NULL;
+			break;
+		}
+		/* move to the front and build a result table for it */
+		rc_unlink(e);
+		rc_push(e);
+		for (i = 0; i < e->nr_cols; i++) {
+			res_col *c = e->cols + i;
+			BAT *b = BATdescriptor(c->b);
+
+			if (b == NULL) {
+				res_id = -1;
+				break;
+			}
+			if (i == 0)
+				res_id = mvc_result_table(m, mb->tag, e->nr_cols, Q_TABLE, b);
+			if (res_id < 0 ||
+			    mvc_result_column(m, c->tn, c->name, c->type.type->sqlname,
+					      c->type.digits, c->type.scale, b))
+				res_id = -1;
+			BBPunfix(b->batCacheid);
+			if (res_id < 0)
+				break;
+		}
+		if (res_id >= 0)
+			rc_hits++;
+		break;
+	}
+	MT_lock_unset(&rc_lock);
+	if (stale)
+		rc_destroy(stale);
+
+	if (e) {
+		if (res_id >= 0 && mvc_export_result(be, be->client->fdout, res_id) >= 0)
+			return 1;
+		/* the result is still in m->results, it is cleaned up
+		 * with the others */
+		return -1;
+	}
+
+	/* prepare to collect the result */
+	if ((e = ZNEW(rc_entry)) == NULL)
+		return 0;
+	if ((e->sa = sa_create()) == NULL ||
+	    (m->argc && (e->args = SA_NEW_ARRAY(e->sa, atom *, m->argc)) == NULL) ||
+	    !rc_plan_tables(be, mb, e) ||
+	    rc_timestamps(m->session->tr, e, 1) <= 0) {
+		rc_destroy(e);
+		return 0;
+	}
+	for (i = 0; i < m->argc; i++) {
+		if ((e->args[i] = atom_dup(e->sa, m->args[i])) == NULL) {
+			rc_destroy(e);
+			return 0;
+		}
+	}
+	e->argc = m->argc;
+	e->schema_number = m->session->tr->schema_number;
+	e->plan = q->shared;
+	qc_retain_shared(e->plan);
+	e->size = e->plan->size;
+	be->rc = e;
+	MT_lock_set(&rc_lock);
+	rc_misses++;
+	MT_lock_unset(&rc_lock);
+	return 0;
+}
+
+/* keep a copy of the columns of result table t for the result cache */
+static void
+rc_collect(backend *be, res_table *t)
+{
+	rc_entry *e = be->rc;
+	size_t size = 0;
+	int i;
+
+	if (e->cols || e->nr_cols < 0 || t->tsep) {
+		/* more than one result, or an export to a file */
+		e->nr_cols = -1;
+		return;
+	}
+	for (i = 0; i < t->nr_cols; i++) {
+		BAT *b = BBPquickdesc(t->cols[i].b, 0);
+
+		if (b == NULL) {
+			e->nr_cols = -1;
+			return;
+		}
+		size += (size_t) BATcount(b) * b->twidth;
+		if (b->tvheap)
+			size += b->tvheap->free;
+	}
+	if (size > rc_maxsize / 4 ||
+	    (e->cols = NEW_ARRAY(res_col, t->nr_cols)) == NULL) {
+		e->nr_cols = -1;
+		return;
+	}
+	memset(e->cols, 0, t->nr_cols * sizeof(res_col));
+	e->nr_cols = t->nr_cols;
+	for (i = 0; i < t->nr_cols; i++) {
+		res_col *c = t->cols + i, *n = e->cols + i;
+		BAT *b, *cb;
+
+		n->type = c->type;
+		n->mtype = TYPE_bat;
+		n->tn = _STRDUP(c->tn);
+		n->name = _STRDUP(c->name);
+		if (n->tn == NULL || n->name == NULL ||
+		    (b = BATdescriptor(c->b)) == NULL) {
+			e->nr_cols = -1;
+			return;
+		}
+		cb = COLcopy(b, b->ttype, TRUE, TRANSIENT);
+		BBPunfix(b->batCacheid);
+		if (cb == NULL) {
+			GDKclrerr();
+			e->nr_cols = -1;
+			return;
+		}
+		e->size += cb->theap.size + (cb->tvheap ? cb->tvheap->size : 0);
+		n->b = cb->batCacheid;
+		BBPretain(n->b);
+		BBPunfix(n->b);
+	}
+}
+
+/*
+ * Called after the query prepared by mvc_result_cache_probe has been
+ * executed.  The collected result is added to the cache if the query
+ * succeeded and none of its tables changed in the mean time.
+ */
+void
+mvc_result_cache_done(backend *be, int ok)
+{
+	rc_entry *e = be->rc, *drop = NULL, *d, *n;
+
+	if (e == NULL)
+		return;
+	be->rc = NULL;
+	if (!ok || e->cols == NULL || e->nr_cols < 0 || e->size > rc_maxsize ||
+	    rc_timestamps(be->mvc->session->tr, e, 0) <= 0) {
+		rc_destroy(e);
+		return;
+	}
+	MT_lock_set(&rc_lock);
+	/* drop the results whose tables changed */
+	store_lock();
+	for (d = rc_list; d; d = n) {
+		n = d->next;
+		if (!rc_current(d, 0)) {
+			rc_unlink(d);
+			rc_size -= d->size;
+			rc_invalidations++;
+			d->next = drop;
+			drop = d;
+		}
+	}
+	store_unlock();
+	/* and the least recently used ones until e fits */
+	while (rc_last && rc_size + e->size > rc_maxsize) {
+		d = rc_last;
+		rc_unlink(d);
+		rc_size -= d->size;
+		rc_evictions++;
+		d->next = drop;
+		drop = d;
+	}
+	rc_push(e);
+	rc_size += e->size;
+	MT_lock_unset(&rc_lock);
+	for (; drop; drop = e) {
+		e = drop->next;
+		rc_destroy(drop);
+	}
+}
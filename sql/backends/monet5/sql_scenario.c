@@ -21,6 +21,7 @@
 #include "sql_scenario.h"
 #include "sql_result.h"
 #include "sql_gencode.h"
+#include "rel_bin.h"
 #include "sql_optimizer.h"
 #include "sql_assert.h"
 #include "sql_execute.h"
@@ -83,6 +84,12 @@ monet5_freecode(int clientid, backend_code code, backend_stack stk, int nr, char
 #endif
 }
 
+static void
+monet5_freesharedcode(backend_code code)
+{
+	freeSymbol((Symbol) code);
+}
+
 str
 SQLsession(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 {
@@ -200,6 +207,8 @@ SQLexit(Client c)
 	(void) c;		/* not used */
 	MT_lock_set(&sql_contextLock);
 	if (SQLinitialized) {
+		mvc_result_cache_destroy();
+		qc_destroy_shared();
 		mvc_exit();
 		SQLinitialized = FALSE;
 	}
@@ -248,8 +257,11 @@ SQLinit(void)
 	memset((char *) &be_funcs, 0, sizeof(backend_functions));
 	be_funcs.fstack = &monet5_freestack;
 	be_funcs.fcode = &monet5_freecode;
+	be_funcs.fscode = &monet5_freesharedcode;
 	be_funcs.fresolve_function = &monet5_resolve_function;
 	monet5_user_init(&be_funcs);
+	qc_init_shared((size_t) GDKgetenv_int("sql_plancache_size", DEFAULT_PLANCACHESIZE) << 20);
+	mvc_result_cache_init((size_t) GDKgetenv_int("sql_resultcache_size", 0) << 20);
 
 	msg = MTIMEtimezone(&tz, &gmt);
 	if (msg)
@@ -938,6 +950,188 @@ cachable(mvc *m, sql_rel *r)
 	return 1;
 }
 
+/*
+ * Query templates are shared with other clients, unless they refer to
+ * objects local to this client: temporary tables, or SQL functions
+ * compiled into the client's module.
+ */
+static int
+rel_shareable(sql_rel *r)
+{
+	if (r == NULL)
+		return 1;
+	if (THRhighwater())
+		return 0;
+	switch (r->op) {
+	case op_basetable: {
+		sql_table *t = r->l;
+
+		if (t == NULL && r->r)
+			t = ((sql_column *) r->r)->t;
+		return t == NULL ||
+			(t->persistence != SQL_LOCAL_TEMP &&
+			 t->persistence != SQL_DECLARED_TABLE);
+	}
+	case op_join:
+	case op_left:
+	case op_right:
+	case op_full:
+	case op_semi:
+	case op_anti:
+	case op_union:
+	case op_except:
+	case op_inter:
+	case op_insert:
+	case op_update:
+	case op_delete:
+		return rel_shareable(r->l) && rel_shareable(r->r);
+	case op_project:
+	case op_select:
+	case op_groupby:
+	case op_topn:
+	case op_sample:
+		return rel_shareable(r->l);
+	default:
+		return 0;
+	}
+}
+
+/*
+ * The shared plans are optimized with the pipeline of the server.
+ * Clients that use another pipeline, or that debug, trace or explain
+ * their queries, neither use nor share them.
+ */
+static int
+SQLsharepipe(mvc *m)
+{
+	char *pipe = GDKgetenv("sql_optimizer");
+
+	if (pipe == NULL)
+		pipe = "default_pipe";
+	return (m->emod & (mod_debug | mod_trace | mod_explain)) == 0 &&
+		strcmp(getSQLoptimizer(m), pipe) == 0;
+}
+
+static int
+SQLshareable(mvc *m, cq *q)
+{
+	MalBlkPtr mb = ((Symbol) q->code)->def;
+	int i;
+
+	if (*m->errstr || m->emode != m_normal ||
+	    (q->type != Q_TABLE && q->type != Q_UPDATE) ||
+	    m->session->tr->schema_updates || !SQLsharepipe(m) ||
+	    !rel_shareable(q->rel))
+		return 0;
+	for (i = 1; i < mb->stop; i++)
+		if (getModuleId(getInstrPtr(mb, i)) == userRef)
+			return 0;
+	return 1;
+}
+
+/*
+ * The catalog objects the plan of q depends on: the tables, columns
+ * and functions it uses, the views it was expanded from, the schemas
+ * the names were looked up in, and the tables that hold the privileges
+ * that were checked.
+ */
+static list *
+SQLplandeps(mvc *m, cq *q, list *views)
+{
+	list *deps = rel_dependencies(q->sa, q->rel);
+	sql_schema *sys = mvc_bind_schema(m, "sys");
+	sql_table *t;
+
+	if (deps == NULL || sys == NULL)
+		return NULL;
+	list_merge(deps, views, (fdup) NULL);
+	list_append(deps, &m->session->schema->base.id);
+	list_append(deps, &sys->base.id);
+	if ((t = mvc_bind_table(m, sys, "privileges")) != NULL)
+		list_append(deps, &t->base.id);
+	if ((t = mvc_bind_table(m, sys, "user_role")) != NULL)
+		list_append(deps, &t->base.id);
+	return deps;
+}
+
+/* hand an optimized copy of the template of q to the shared cache */
+static void
+SQLshareQuery(Client c, mvc *m, cq *q, list *views)
+{
+	MalBlkPtr mb;
+	Symbol s;
+	list *deps;
+	str msg;
+
+	if ((deps = SQLplandeps(m, q, views)) == NULL ||
+	    (s = newSymbol(q->name, FUNCTIONsymbol)) == NULL)
+		return;
+	freeMalBlk(s->def);
+	if ((s->def = copyMalBlk(((Symbol) q->code)->def)) == NULL) {
+		freeSymbol(s);
+		return;
+	}
+	/* like a prepared statement, the plan is optimized for any
+	 * values of the parameters */
+	mb = s->def;
+	chkProgram(c->usermodule, mb);
+	if (mb->errors || (msg = SQLoptimizeFunction(c, mb)) != MAL_SUCCEED) {
+		if (!mb->errors)
+			freeException(msg);
+		freeSymbol(s);
+		return;
+	}
+	qc_share(q, (backend_code) s,
+		 (size_t) mb->stop * (sizeof(InstrRecord) + mb->maxarg * sizeof(int)) +
+		 (size_t) mb->vtop * sizeof(VarRecord),
+		 deps, m->session->schema->base.id, m->session->tr->schema_number,
+		 m->user_id, m->role_id);
+}
+
+/* add a copy of the shared template s to the client's cache and module */
+static cq *
+SQLsharedQuery(Client c, mvc *m, sq *s)
+{
+	char qname[IDLENGTH];
+	char *q, *escaped_q;
+	Symbol sym;
+	cq *n;
+
+	/* qc_insert_shared takes the id */
+	(void) snprintf(qname, IDLENGTH, "s%d_%d", m->qc->id, m->qc->clientid);
+	if ((q = query_cleaned(QUERY(m->scanner))) == NULL) {
+		qc_release_shared(s);
+		return NULL;
+	}
+	escaped_q = sql_escape_str(q);
+	GDKfree(q);
+	if (escaped_q == NULL) {
+		qc_release_shared(s);
+		return NULL;
+	}
+	if ((sym = newSymbol(qname, FUNCTIONsymbol)) == NULL) {
+		_DELETE(escaped_q);
+		qc_release_shared(s);
+		return NULL;
+	}
+	freeMalBlk(sym->def);
+	if ((sym->def = copyMalBlk(((Symbol) s->code)->def)) == NULL) {
+		freeSymbol(sym);
+		_DELETE(escaped_q);
+		qc_release_shared(s);
+		return NULL;
+	}
+	setFunctionId(getInstrPtr(sym->def, 0), sym->name);
+	if ((n = qc_insert_shared(m->qc, s, sym->name, escaped_q)) == NULL) {
+		freeSymbol(sym);
+		_DELETE(escaped_q);
+		return NULL;
+	}
+	insertSymbol(c->usermodule, sym);
+	n->code = (backend_code) sym;
+	return n;
+}
+
 /*
  * The core part of the SQL interface, parse the query and
  * store away the template (non)optimized code in the query cache
@@ -955,6 +1149,7 @@ SQLparser(Client c)
 	int oldvtop, oldstop;
 	int pstatus = 0;
 	int err = 0, opt = 0;
+	sq *shared;
 
 	be = (backend *) c->sqlcontext;
 	if (be == 0) {
@@ -1111,13 +1306,25 @@ SQLparser(Client c)
 			goto finalize;
 		}
 		scanner_query_processed(&(m->scanner));
-	} else if (caching(m) && cachable(m, NULL) && m->emode != m_prepare && (be->q = qc_match(m->qc, m->sym, m->args, m->argc, m->scanner.key ^ m->session->schema->base.id)) != NULL) {
+	} else if (caching(m) && cachable(m, NULL) && m->emode != m_prepare && (be->q = qc_match(m->qc, m->sym, m->args, m->argc, m->scanner.key ^ m->session->schema->base.id, SQLsharepipe(m))) != NULL) {
 		/* query template was found in the query cache */
 		scanner_query_processed(&(m->scanner));
+	} else if (caching(m) && cachable(m, NULL) && m->emode == m_normal && SQLsharepipe(m) && (shared = qc_match_shared(m->sym, m->args, m->argc, m->scanner.key ^ m->session->schema->base.id, m->session->schema->base.id, m->session->tr->schema_number, m->user_id, m->role_id)) != NULL) {
+		/* query template was compiled by another client */
+		if ((be->q = SQLsharedQuery(c, m, shared)) == NULL) {
+			err = 1;
+			msg = createException(PARSE, "SQLparser", MAL_MALLOC_FAIL);
+		}
+		scanner_query_processed(&(m->scanner));
 	} else {
 		sql_rel *r;
+		list *views;
 
+		/* collect the views the plan uses, for the shared cache */
+		m->views = sa_list(m->sa);
 		r = sql_symbol2relation(m, m->sym);
+		views = m->views;
+		m->views = NULL;
 
 		if (!r || (err = mvc_status(m) && m->type != Q_TRANS && *m->errstr)) {
 			if (strlen(m->errstr) > 6 && m->errstr[5] == '!')
@@ -1184,6 +1391,8 @@ SQLparser(Client c)
 			m->sym = NULL;
 			/* register name in the namespace */
 			be->q->name = putName(be->q->name);
+			if (!err && SQLshareable(m, be->q))
+				SQLshareQuery(c, m, be->q, views);
 		}
 	}
 	if (err)
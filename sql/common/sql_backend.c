@@ -42,6 +42,13 @@ backend_freecode(int clientid, backend_code code, backend_stack stk, int nr, cha
 		be_funcs.fcode(clientid, code, stk, nr, name);
 }
 
+void
+backend_freesharedcode(backend_code code)
+{
+	if (be_funcs.fscode != NULL)
+		be_funcs.fscode(code);
+}
+
 char *
 backend_create_user(ptr mvc, char *user, char *passwd, char enc, char *fullname, sqlid defschemid, sqlid grantor)
 {
@@ -909,6 +909,8 @@ table_ref(mvc *sql, sql_rel *rel, symbol *tableref, int lateral)
 				rel = rel_basetable(sql, t, tname);
 			else
 				rel = rel_parse(sql, t->s, t->query, m_instantiate);
+			if (sql->views)
+				list_append(sql->views, &t->base.id);
 
 			if (!rel)
 				return NULL;
@@ -45,10 +45,16 @@ mvc_init(int debug, store_type store, int ro, int su, backend_stack stk)
 	 * 0 by default - keeps only the current WAL file. */
 	log_settings.keep_persisted_log_files = GDKgetenv_int("gdk_keep_persisted_log_files", 0);
 
+	/* Get and pass on how long (ms) a checkpoint may hold back new
+	 * transactions (quiesce barrier) while the active ones finish.
+	 * -1 by default: wait for all sessions to go idle by themselves. */
+	log_settings.checkpoint_wait = GDKgetenv_int("gdk_checkpoint_wait", -1);
+
 	mvc_debug = debug&4;
 	if (mvc_debug) {
 		fprintf(stderr, "#mvc_init logdir %s\n", log_settings.logdir);
 		fprintf(stderr, "#mvc_init keep_persisted_log_files %d\n", log_settings.keep_persisted_log_files);
+		fprintf(stderr, "#mvc_init checkpoint_wait %d\n", log_settings.checkpoint_wait);
 		if (log_settings.shared_logdir != NULL) {
 			fprintf(stderr, "#mvc_init shared_logdir %s\n", log_settings.shared_logdir);
 		}
@@ -230,10 +236,13 @@ void
 mvc_trans(mvc *m)
 {
 	int schema_changed = 0, err = m->session->status;
+	lng ticket;
 	assert(!m->session->active);	/* can only start a new transaction */
 
+	store_checkpoint_wait();
 	store_lock();
 	schema_changed = sql_trans_begin(m->session);
+	ticket = store_commit_ticket();
 	if (m->qc && (schema_changed || m->qc->nr > m->cache || err)){
 		if (schema_changed || err) {
 			int seqnr = m->qc->id;
@@ -245,6 +254,9 @@ mvc_trans(mvc *m)
 		}
 	}
 	store_unlock();
+	/* do not act on commits whose log record is not yet on disk */
+	if (store_commit_wait(ticket) != LOG_OK)
+		GDKfatal("write-ahead log sync failure");
 }
 
 static sql_trans *
@@ -298,6 +310,7 @@ mvc_commit(mvc *m, int chain, const char *name)
 {
 	sql_trans *cur, *tr = m->session->tr, *ctr;
 	int ok = SQL_OK;//, wait = 0;
+	lng ticket = 0;
 
 	assert(tr);
 	assert(m->session->active);	/* only commit an active transaction */
@@ -376,7 +389,7 @@ build up the hash (not copied in the trans dup)) */
 	 * */
 	/* validation phase */
 	if (sql_trans_validate(tr)) {
-		if ((ok = sql_trans_commit(tr)) != SQL_OK) {
+		if ((ok = sql_trans_commit_nosync(tr, &ticket)) != SQL_OK) {
 			char *msg = sql_message(SQLSTATE(40000) "COMMIT: transaction commit failed (perhaps your disk is full?) exiting (kernel error: %s)", GDKerrbuf);
 			GDKfatal("%s", msg);
 			_DELETE(msg);
@@ -392,6 +405,12 @@ build up the hash (not copied in the trans dup)) */
 	if (chain) 
 		sql_trans_begin(m->session);
 	store_unlock();
+	/* wait for the log outside the store lock (group commit) */
+	if (store_commit_sync(ticket) != LOG_OK) {
+		char *msg = sql_message(SQLSTATE(40000) "COMMIT: transaction commit failed (perhaps your disk is full?) exiting (kernel error: %s)", GDKerrbuf);
+		GDKfatal("%s", msg);
+		_DELETE(msg);
+	}
 	m->type = Q_TRANS;
 	if (mvc_debug)
 		fprintf(stderr, "#mvc_commit %s done\n", (name) ? name : "");
@@ -98,6 +98,7 @@ typedef struct mvc {
 	int argc;
 	int argmax;
 	struct symbol *sym;
+	list *views;		/* ids of the views used by the query, if set */
 	int no_mitosis;		/* run query without mitosis */
 
 	int user_id;
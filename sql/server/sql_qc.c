@@ -34,6 +34,18 @@
  *
  * The optimization/processing cost should be kept around and the re-use of
  * a cache entry.
+ *
+ * Next to the per client caches, there is a cache of optimized query
+ * plans shared between all clients.  When a client compiles a cachable
+ * query, the parse tree and an optimized copy of the template code are
+ * handed over to the shared cache, so that other clients that issue
+ * the same query (with parameters of the same types) can run a copy
+ * of the plan instead of compiling and optimizing it again.  A shared
+ * plan is only used by clients with the same user, role and current
+ * schema, and only as long as none of the catalog objects it uses
+ * (tables, functions, the schema, the privileges) has changed since it
+ * was made; plans found to be stale are dropped.  The shared cache is
+ * bounded in size; the least recently used plans are dropped first.
  */
 
 #include "monetdb_config.h"
@@ -42,6 +54,36 @@
 #include "sql_mvc.h"
 #include "sql_atom.h"
 
+static MT_Lock qc_lock MT_LOCK_INITIALIZER("qc_lock");
+static sq *qc_shared = NULL;	/* most recently used first */
+static sq *qc_shared_last = NULL;	/* least recently used */
+static size_t qc_shared_size = 0, qc_shared_maxsize = 0;
+static lng qc_shared_hits = 0, qc_shared_misses = 0, qc_shared_invalidations = 0, qc_shared_evictions = 0;
+
+void
+qc_release_shared(sq *s)
+{
+	int refs;
+
+	MT_lock_set(&qc_lock);
+	refs = --s->refs;
+	MT_lock_unset(&qc_lock);
+	if (refs == 0) {
+		backend_freesharedcode(s->code);
+		sa_destroy(s->sa);
+		_DELETE(s);
+	}
+}
+
+/* take an extra reference to the shared template s */
+void
+qc_retain_shared(sq *s)
+{
+	MT_lock_set(&qc_lock);
+	s->refs++;
+	MT_lock_unset(&qc_lock);
+}
+
 qc *
 qc_create(int clientid, int seqnr)
 {
@@ -65,6 +107,8 @@ cq_delete(int clientid, cq *q)
 		backend_freestack(clientid, q->stk);
 	if (q->codestring)
 		_DELETE(q->codestring);
+	if (q->shared)
+		qc_release_shared(q->shared);
 
 	/* params and name are allocated using sa, ie need to be delete last */
 	if (q->sa) 
@@ -221,13 +265,16 @@ qc_find(qc *cache, int id)
 	return NULL;
 }
 
+/* Entries that use a shared plan are only matched when shared is set,
+ * i.e. when the client uses the optimizer pipeline of the shared
+ * plans. */
 cq *
-qc_match(qc *cache, symbol *s, atom **params, int  plen, int key)
+qc_match(qc *cache, symbol *s, atom **params, int  plen, int key, int shared)
 {
 	cq *q;
 
 	for (q = cache->q; q; q = q->next) {
-		if (q->key == key) {
+		if (q->key == key && (shared || q->shared == NULL)) {
 			if (q->paramlen == plen && param_list_cmp(q->params, params, plen, q->type) == 0 && symbol_cmp(q->s, s) == 0) {
 				q->count++;
 				return q;
@@ -273,6 +320,7 @@ qc_insert(qc *cache, sql_allocator *sa, sql_rel *r, char *qname,  symbol *s, ato
 	n->key = key;
 	n->codestring = cmd;
 	n->count = 1;
+	n->shared = NULL;
 	namelen = 5 + ((n->id+7)>>3) + ((cache->clientid+7)>>3);
 	n->name = sa_alloc(sa, namelen);
 	if(!n->name) {
@@ -302,3 +350,247 @@ qc_size(qc *cache)
 {
 	return cache->nr;
 }
+
+void
+qc_init_shared(size_t maxsize)
+{
+#ifdef NEED_MT_LOCK_INIT
+	MT_lock_init(&qc_lock, "qc_lock");
+#endif
+	qc_shared_maxsize = maxsize;
+}
+
+void
+qc_destroy_shared(void)
+{
+	sq *s, *n;
+
+	MT_lock_set(&qc_lock);
+	s = qc_shared;
+	qc_shared = qc_shared_last = NULL;
+	qc_shared_size = 0;
+	MT_lock_unset(&qc_lock);
+	for (; s; s = n) {
+		n = s->next;
+		qc_release_shared(s);
+	}
+}
+
+void
+qc_shared_stats(lng *entries, lng *size, lng *hits, lng *misses, lng *invalidations, lng *evictions)
+{
+	sq *s;
+
+	MT_lock_set(&qc_lock);
+	*entries = 0;
+	for (s = qc_shared; s; s = s->next)
+		(*entries)++;
+	*size = (lng) qc_shared_size;
+	*hits = qc_shared_hits;
+	*misses = qc_shared_misses;
+	*invalidations = qc_shared_invalidations;
+	*evictions = qc_shared_evictions;
+	MT_lock_unset(&qc_lock);
+}
+
+/* the list functions below are called with the lock held */
+static void
+sq_unlink(sq *s)
+{
+	if (s->prev)
+		s->prev->next = s->next;
+	else
+		qc_shared = s->next;
+	if (s->next)
+		s->next->prev = s->prev;
+	else
+		qc_shared_last = s->prev;
+	s->next = s->prev = NULL;
+	qc_shared_size -= s->size;
+}
+
+static void
+sq_push(sq *s)
+{
+	s->prev = NULL;
+	s->next = qc_shared;
+	if (qc_shared)
+		qc_shared->prev = s;
+	else
+		qc_shared_last = s;
+	qc_shared = s;
+	qc_shared_size += s->size;
+}
+
+/* Unlink the least recently used plans until size more bytes fit.
+ * Returns the unlinked plans, chained through next. */
+static sq *
+qc_evict(size_t size)
+{
+	sq *s, *drop = NULL;
+
+	while (qc_shared_last && qc_shared_size + size > qc_shared_maxsize) {
+		s = qc_shared_last;
+		sq_unlink(s);
+		s->next = drop;
+		drop = s;
+		qc_shared_evictions++;
+	}
+	return drop;
+}
+
+static void
+qc_drop(sq *drop)
+{
+	sq *s;
+
+	for (; drop; drop = s) {
+		s = drop->next;
+		qc_release_shared(drop);
+	}
+}
+
+/* Hand the parse tree of client cache entry q over to the shared cache,
+ * together with the optimized plan code.  The plan uses the catalog
+ * objects whose ids are in deps; it is not shared when any of them
+ * changed after the start of the client's transaction
+ * (schema_number). */
+void
+qc_share(cq *q, backend_code code, size_t codesize, list *deps, int schema, int schema_number, int user_id, int role_id)
+{
+	sq *s, *drop;
+	size_t size = sa_size(q->sa) + codesize;
+	int i = 0, version = 0;
+	node *n;
+
+	if (size > qc_shared_maxsize || (s = MNEW(sq)) == NULL) {
+		backend_freesharedcode(code);
+		return;
+	}
+	s->ndeps = list_length(deps);
+	if ((s->deps = SA_NEW_ARRAY(q->sa, sq_dep, s->ndeps)) == NULL && s->ndeps) {
+		backend_freesharedcode(code);
+		_DELETE(s);
+		return;
+	}
+	for (n = deps->h; n; n = n->next, i++) {
+		s->deps[i].id = *(sqlid *) n->data;
+		s->deps[i].version = store_schema_version(s->deps[i].id);
+		if (s->deps[i].version > schema_number) {
+			/* changed by a later transaction */
+			backend_freesharedcode(code);
+			_DELETE(s);
+			return;
+		}
+		if (s->deps[i].version > version)
+			version = s->deps[i].version;
+	}
+	s->type = q->type;
+	s->sa = q->sa;
+	s->s = q->s;
+	s->params = q->params;
+	s->paramlen = q->paramlen;
+	s->code = code;
+	s->key = q->key;
+	s->schema = schema;
+	s->version = version;
+	s->user_id = user_id;
+	s->role_id = role_id;
+	s->size = size;
+	s->refs = 2;		/* the list and q */
+	/* the parse tree is owned by the shared plan from now on */
+	q->sa = NULL;
+	q->rel = NULL;
+	q->shared = s;
+
+	MT_lock_set(&qc_lock);
+	drop = qc_evict(size);
+	sq_push(s);
+	MT_lock_unset(&qc_lock);
+	qc_drop(drop);
+}
+
+/* is every object used by s still at the version s was made for? */
+static int
+sq_valid(sq *s)
+{
+	int i;
+
+	for (i = 0; i < s->ndeps; i++)
+		if (store_schema_version(s->deps[i].id) != s->deps[i].version)
+			return 0;
+	return 1;
+}
+
+sq *
+qc_match_shared(symbol *sym, atom **params, int plen, int key, int schema, int schema_number, int user_id, int role_id)
+{
+	sq *s, *n, *drop = NULL;
+
+	MT_lock_set(&qc_lock);
+	for (s = qc_shared; s; s = n) {
+		n = s->next;
+		if (s->key == key && s->schema == schema &&
+		    s->user_id == user_id && s->role_id == role_id &&
+		    s->paramlen == plen &&
+		    param_list_cmp(s->params, params, plen, s->type) == 0 &&
+		    symbol_cmp(s->s, sym) == 0) {
+			if (!sq_valid(s)) {
+				/* the catalog changed underneath */
+				sq_unlink(s);
+				s->next = drop;
+				drop = s;
+				qc_shared_invalidations++;
+				continue;
+			}
+			/* a transaction that started before the plan
+			 * was made may not see the objects it uses */
+			if (s->version > schema_number)
+				continue;
+			/* move to the front */
+			sq_unlink(s);
+			sq_push(s);
+			s->refs++;
+			break;
+		}
+	}
+	if (s)
+		qc_shared_hits++;
+	else
+		qc_shared_misses++;
+	MT_lock_unset(&qc_lock);
+	qc_drop(drop);
+	return s;
+}
+
+/* Add an entry for the shared template s (taking over the reference to
+ * it) to the client cache.  The name must be kept alive by the caller. */
+cq *
+qc_insert_shared(qc *cache, sq *s, char *qname, char *cmd)
+{
+	cq *n = MNEW(cq);
+
+	if (n == NULL) {
+		qc_release_shared(s);
+		return NULL;
+	}
+	n->id = cache->id++;
+	cache->nr++;
+
+	n->sa = NULL;
+	n->rel = NULL;
+	n->s = s->s;
+	n->params = s->params;
+	n->paramlen = s->paramlen;
+	n->next = cache->q;
+	n->stk = 0;
+	n->code = NULL;
+	n->type = s->type;
+	n->key = s->key;
+	n->codestring = cmd;
+	n->count = 1;
+	n->shared = s;
+	n->name = qname;
+	cache->q = n;
+	return n;
+}
@@ -15,6 +15,35 @@
 #include <sql_backend.h>
 
 #define DEFAULT_CACHESIZE 100
+#define DEFAULT_PLANCACHESIZE 64	/* MiB for the shared query plans */
+
+/* a catalog object used by a shared plan */
+typedef struct sq_dep {
+	sqlid id;		/* the object */
+	int version;		/* its schema version when the plan was made */
+} sq_dep;
+
+/* an optimized query plan shared between the clients */
+typedef struct sq {
+	struct sq *next;	/* the shared plans in LRU order */
+	struct sq *prev;
+	int type;		/* sql_query_t: Q_PARSE,Q_SCHEMA,.. */
+	sql_allocator *sa;	/* the symbols are allocated from this sa */
+	symbol *s;		/* the SQL parse tree */
+	sql_subtype *params;	/* parameter types */
+	int paramlen;		/* number of parameters */
+	backend_code code;	/* the optimized plan */
+	int key;		/* the hash key for the query text */
+	int schema;		/* id of the current schema */
+	sq_dep *deps;		/* the objects the plan uses */
+	int ndeps;
+	int version;		/* the highest version of those */
+	int user_id;		/* privileges were checked for this user */
+	int role_id;		/* and role */
+	size_t size;		/* (estimated) memory footprint */
+	int refs;		/* references by the list, client caches and cached results */
+} sq;
+
 typedef struct cq {
 	struct cq *next;	/* link them into a queue */
 	int type;		/* sql_query_t: Q_PARSE,Q_SCHEMA,.. */
@@ -30,6 +59,7 @@ typedef struct cq {
 	char *codestring;	/* keep code in string form to aid debugging */
 	char *name;		/* name of cache query */
 	int count;		/* number of times the query is matched */
+	sq *shared;		/* the shared template this query uses, if any */
 } cq;
 
 typedef struct qc {
@@ -43,12 +73,21 @@ extern qc *qc_create(int clientid, int seqnr);
 extern void qc_destroy(qc *cache);
 extern void qc_clean(qc *cache);
 extern cq *qc_find(qc *cache, int id);
-extern cq *qc_match(qc *cache, symbol *s, atom **params, int plen, int key);
+extern cq *qc_match(qc *cache, symbol *s, atom **params, int plen, int key, int shared);
 extern cq *qc_insert(qc *cache, sql_allocator *sa, sql_rel *r, char *qname, symbol *s, atom **params, int paramlen, int key, int type, char *codedstr);
 extern void qc_delete(qc *cache, cq *q);
 extern int qc_size(qc *cache);
 extern int qc_isaquerytemplate(char *nme);
 extern int qc_isapreparedquerytemplate(char *nme);
 
+extern void qc_init_shared(size_t maxsize);
+extern void qc_destroy_shared(void);
+extern void qc_share(cq *q, backend_code code, size_t codesize, list *deps, int schema, int schema_number, int user_id, int role_id);
+extern sq *qc_match_shared(symbol *s, atom **params, int plen, int key, int schema, int schema_number, int user_id, int role_id);
+extern cq *qc_insert_shared(qc *cache, sq *s, char *qname, char *cmd);
+extern void qc_retain_shared(sq *s);
+extern void qc_release_shared(sq *s);
+extern void qc_shared_stats(lng *entries, lng *size, lng *hits, lng *misses, lng *invalidations, lng *evictions);
+
 #endif /*_SQL_QC_H_*/
 
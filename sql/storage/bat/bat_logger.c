@@ -221,7 +221,23 @@ bl_destroy(void)
 
 	bat_logger = NULL;
 	if (l) {
+		/* asynchronous commits may not have been synced yet;
+		 * wait for a sync in progress and sync the rest */
+		MT_lock_set(&l->sync_lock);
+		while (l->syncing) {
+			l->waiters++;
+			MT_lock_unset(&l->sync_lock);
+			MT_sema_down(&l->sync_wait);
+			MT_lock_set(&l->sync_lock);
+		}
+		if (l->synced < l->written && mnstr_fsync(l->log))
+			fprintf(stderr, "!ERROR: bl_destroy: sync failed\n");
+		l->synced = l->written;
 		close_stream(l->log);
+		l->log = NULL;
+		MT_lock_unset(&l->sync_lock);
+		MT_sema_destroy(&l->sync_wait);
+		MT_lock_destroy(&l->sync_lock);
 		GDKfree(l->fn);
 		GDKfree(l->dir);
 		GDKfree(l->local_dir);
@@ -330,6 +346,44 @@ bl_tend(void)
 	return log_tend(bat_logger) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
 }
 
+static int
+bl_tend_nosync(lng *ticket)
+{
+	return log_tend_nosync(bat_logger, ticket) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
+}
+
+static int
+bl_tsync(lng ticket)
+{
+	return log_tsync(bat_logger, ticket) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
+}
+
+static int
+bl_tsync_pending(void)
+{
+	if (bat_logger == NULL)
+		return LOG_OK;
+	return log_tsync_pending(bat_logger) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
+}
+
+static lng
+bl_tlast(void)
+{
+	return log_tlast(bat_logger);
+}
+
+static int
+bl_twait(lng ticket)
+{
+	return log_twait(bat_logger, ticket) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
+}
+
+static void
+bl_commit_stats(lng *commits, lng *syncs, lng *async, lng *maxgroup, lng *syncusec)
+{
+	logger_commit_stats(bat_logger, commits, syncs, async, maxgroup, syncusec);
+}
+
 static int 
 bl_sequence(int seq, lng id)
 {
@@ -354,6 +408,12 @@ bat_logger_init( logger_functions *lf )
 	lf->log_isnew = bl_log_isnew;
 	lf->log_tstart = bl_tstart;
 	lf->log_tend = bl_tend;
+	lf->log_tend_nosync = bl_tend_nosync;
+	lf->log_tsync = bl_tsync;
+	lf->log_tsync_pending = bl_tsync_pending;
+	lf->log_tlast = bl_tlast;
+	lf->log_twait = bl_twait;
+	lf->log_commit_stats = bl_commit_stats;
 	lf->log_sequence = bl_sequence;
 }
 
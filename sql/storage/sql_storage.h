@@ -289,6 +289,12 @@ typedef int (*logger_reload_fptr) (void);
 typedef int (*log_isnew_fptr)(void);
 typedef int (*log_tstart_fptr) (void);
 typedef int (*log_tend_fptr) (void);
+typedef int (*log_tend_nosync_fptr) (lng *ticket);
+typedef int (*log_tsync_fptr) (lng ticket);
+typedef int (*log_tsync_pending_fptr) (void);
+typedef lng (*log_tlast_fptr) (void);
+typedef int (*log_twait_fptr) (lng ticket);
+typedef void (*log_commit_stats_fptr) (lng *commits, lng *syncs, lng *async, lng *maxgroup, lng *syncusec);
 typedef int (*log_sequence_fptr) (int seq, lng id);
 
 typedef struct logger_functions {
@@ -308,6 +314,12 @@ typedef struct logger_functions {
 	log_isnew_fptr log_isnew;
 	log_tstart_fptr log_tstart;
 	log_tend_fptr log_tend;
+	log_tend_nosync_fptr log_tend_nosync;
+	log_tsync_fptr log_tsync;
+	log_tsync_pending_fptr log_tsync_pending;
+	log_tlast_fptr log_tlast;
+	log_twait_fptr log_twait;
+	log_commit_stats_fptr log_commit_stats;
 	log_sequence_fptr log_sequence;
 } logger_functions;
 
@@ -330,16 +342,23 @@ extern void store_exit(void);
 extern void store_apply_deltas(void);
 extern void store_flush_log(void);
 extern void store_manager(void);
+extern void store_checkpoint_wait(void);
+extern void store_checkpoint_stats(lng *checkpoints, lng *deferred, lng *changes, lng *pending, lng *lag_ms, lng *wait_usec, lng *max_wait, lng *flush_usec);
 extern void idle_manager(void);
 
 extern void store_lock(void);
 extern void store_unlock(void);
 extern int store_next_oid(void);
+extern int store_schema_version(sqlid id);
 
 extern sql_trans *sql_trans_create(backend_stack stk, sql_trans *parent, const char *name);
 extern sql_trans *sql_trans_destroy(sql_trans *tr);
 extern int sql_trans_validate(sql_trans *tr);
 extern int sql_trans_commit(sql_trans *tr);
+extern int sql_trans_commit_nosync(sql_trans *tr, lng *ticket);
+extern int store_commit_sync(lng ticket);
+extern lng store_commit_ticket(void);
+extern int store_commit_wait(lng ticket);
 
 extern sql_type *sql_trans_create_type(sql_trans *tr, sql_schema * s, const char *sqlname, int digits, int scale, int radix, const char *impl);
 extern int sql_trans_drop_type(sql_trans *tr, sql_schema * s, int id, int drop_action);
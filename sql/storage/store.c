@@ -37,6 +37,21 @@ int store_initialized = 0;
 static int keep_persisted_log_files = 0;
 static int create_shared_logger = 0;
 static int shared_drift_threshold = -1;
+static int checkpoint_wait = -1;
+
+/* checkpoint state; while the quiesce barrier is up, sessions wait on
+ * checkpoint_sema before starting a new transaction (protected by
+ * bs_lock) */
+static int checkpoint_barrier = 0;
+static int checkpoint_waiters = 0;
+static MT_Sema checkpoint_sema;
+static lng nr_checkpoints = 0;
+static lng nr_deferred = 0;
+static lng last_checkpoint = 0;	/* GDKusec() at the end of the last one */
+static lng last_changes = 0;
+static lng last_wait_usec = 0;
+static lng max_wait_usec = 0;
+static lng last_flush_usec = 0;
 
 backend_stack backend_stk;
 
@@ -1363,6 +1378,138 @@ store_schema_number(void)
 	return schema_number;
 }
 
+/* The schema number of the last committed schema change of each
+ * catalog object (schema, table, function, sequence or type) that was
+ * changed since the server started.  Shared query plans record these
+ * for the objects they use, to find out whether they are still valid. */
+typedef struct schema_version {
+	struct schema_version *next;
+	sqlid id;
+	int version;
+} schema_version;
+
+#define SV_HASH 1024
+static schema_version *schema_versions[SV_HASH];
+static MT_Lock sv_lock MT_LOCK_INITIALIZER("sv_lock");
+
+static void
+schema_version_set(sqlid id, int version)
+{
+	schema_version **vp = &schema_versions[id & (SV_HASH - 1)], *v;
+
+	for (v = *vp; v; v = v->next) {
+		if (v->id == id) {
+			v->version = version;
+			return;
+		}
+	}
+	if ((v = MNEW(schema_version)) == NULL)
+		return;
+	v->id = id;
+	v->version = version;
+	v->next = *vp;
+	*vp = v;
+}
+
+int
+store_schema_version(sqlid id)
+{
+	schema_version *v;
+	int version = 0;
+
+	MT_lock_set(&sv_lock);
+	for (v = schema_versions[id & (SV_HASH - 1)]; v; v = v->next) {
+		if (v->id == id) {
+			version = v->version;
+			break;
+		}
+	}
+	MT_lock_unset(&sv_lock);
+	return version;
+}
+
+/* Record the members of cs that were created, changed or dropped.
+ * Returns whether any were created or dropped. */
+static int
+schema_versions_set(changeset *cs, int version)
+{
+	node *n;
+	int names = 0;
+
+	if (cs->set) {
+		for (n = cs->set->h; n; n = n->next) {
+			sql_base *b = n->data;
+
+			if (n == cs->nelm)
+				names = 1;
+			if (b->wtime)
+				schema_version_set(b->id, version);
+		}
+	}
+	if (cs->dset) {
+		for (n = cs->dset->h; n; n = n->next) {
+			sql_base *b = n->data;
+
+			schema_version_set(b->id, version);
+			names = 1;
+		}
+	}
+	return names;
+}
+
+static void
+schema_versions_schema(sql_schema *s, int version)
+{
+	int names = 0;
+
+	names |= schema_versions_set(&s->tables, version);
+	names |= schema_versions_set(&s->funcs, version);
+	names |= schema_versions_set(&s->seqs, version);
+	names |= schema_versions_set(&s->types, version);
+	/* names are looked up in the schema, so a new object may hide
+	 * another one */
+	if (names || s->base.flag == TR_NEW)
+		schema_version_set(s->base.id, version);
+}
+
+/* record the schema changes of tr, which are committed as version */
+static void
+schema_versions_record(sql_trans *tr, int version)
+{
+	node *n;
+
+	MT_lock_set(&sv_lock);
+	if (tr->schemas.set)
+		for (n = tr->schemas.set->h; n; n = n->next)
+			schema_versions_schema(n->data, version);
+	if (tr->schemas.dset) {
+		for (n = tr->schemas.dset->h; n; n = n->next) {
+			sql_schema *s = n->data;
+
+			schema_versions_schema(s, version);
+			schema_version_set(s->base.id, version);
+		}
+	}
+	MT_lock_unset(&sv_lock);
+}
+
+static void
+schema_versions_destroy(void)
+{
+	schema_version *v, *n;
+	int i;
+
+	MT_lock_set(&sv_lock);
+	for (i = 0; i < SV_HASH; i++) {
+		for (v = schema_versions[i]; v; v = n) {
+			n = v->next;
+			_DELETE(v);
+		}
+		schema_versions[i] = NULL;
+	}
+	MT_lock_unset(&sv_lock);
+}
+
 static int
 store_load(void) {
 	int first = 1;
@@ -1573,10 +1720,15 @@ store_init(int debug, store_type store, int readonly, int singleuser, logger_set
 	/* get the set keep_persisted_log_files
 	 * we will need it later when calling logger_cleanup */
 	keep_persisted_log_files = log_settings->keep_persisted_log_files;
+	/* get the set checkpoint_wait
+	 * we will need it later in store_manager */
+	checkpoint_wait = log_settings->checkpoint_wait;
 
 #ifdef NEED_MT_LOCK_INIT
 	MT_lock_init(&bs_lock, "SQL_bs_lock");
+	MT_lock_init(&sv_lock, "SQL_sv_lock");
 #endif
+	MT_sema_init(&checkpoint_sema, 0, "checkpoint_sema");
 	MT_lock_set(&bs_lock);
 
 	/* check if all parameters for a shared log are set */
@@ -1618,6 +1770,7 @@ store_init(int debug, store_type store, int readonly, int singleuser, logger_set
 }
 
 static int logging = 0;
+static int tsyncing = 0;	/* a manager syncs asynchronous commits */
 
 void
 store_exit(void)
@@ -1628,7 +1781,7 @@ store_exit(void)
 	fprintf(stderr, "#store exit locked\n");
 #endif
 	/* busy wait till the logmanager is ready */
-	while (logging) {
+	while (logging || tsyncing) {
 		MT_lock_unset(&bs_lock);
 		MT_sleep_ms(100);
 		MT_lock_set(&bs_lock);
@@ -1656,6 +1809,7 @@ store_exit(void)
 		sql_trans_destroy(gtrans);
 		gtrans = NULL;
 	}
+	schema_versions_destroy();
 #ifdef STORE_DEBUG
 	fprintf(stderr, "#store exit unlocked\n");
 #endif
@@ -1732,6 +1886,107 @@ store_vacuum( sql_trans *tr )
 	return 0;
 }
 
+/* Lower the quiesce barrier and let the waiting sessions go, called
+ * locked */
+static void
+store_checkpoint_release(void)
+{
+	checkpoint_barrier = 0;
+	while (checkpoint_waiters > 0) {
+		checkpoint_waiters--;
+		MT_sema_up(&checkpoint_sema);
+	}
+}
+
+/* Raise the quiesce barrier, called locked, so that no new
+ * transactions start while the active ones finish.  If they have not
+ * finished after checkpoint_wait ms (a long running or
+ * idle-in-transaction session), the barrier is lowered again and the
+ * checkpoint waits for an idle moment as it does without the barrier.
+ * Returns 0 when the server is exiting, in which case the lock is
+ * released. */
+static int
+store_checkpoint_drain(int sleeptime)
+{
+	int waited = 0;
+
+	checkpoint_barrier = 1;
+	while (store_nr_active) {
+		MT_lock_unset(&bs_lock);
+		if (GDKexiting()) {
+			MT_lock_set(&bs_lock);
+			store_checkpoint_release();
+			MT_lock_unset(&bs_lock);
+			return 0;
+		}
+		MT_sleep_ms(sleeptime);
+		waited += sleeptime;
+		MT_lock_set(&bs_lock);
+		if (checkpoint_barrier && waited >= checkpoint_wait) {
+			store_checkpoint_release();
+			nr_deferred++;
+		}
+	}
+	/* keep the barrier up until the deltas are flushed */
+	checkpoint_barrier = 1;
+	return 1;
+}
+
+/* Called, unlocked, before a session starts a new transaction */
+void
+store_checkpoint_wait(void)
+{
+	MT_lock_set(&bs_lock);
+	while (checkpoint_barrier && !GDKexiting()) {
+		checkpoint_waiters++;
+		MT_lock_unset(&bs_lock);
+		MT_sema_down(&checkpoint_sema);
+		MT_lock_set(&bs_lock);
+	}
+	MT_lock_unset(&bs_lock);
+}
+
+void
+store_checkpoint_stats(lng *checkpoints, lng *deferred, lng *changes, lng *pending, lng *lag_ms, lng *wait_usec, lng *max_wait, lng *flush_usec)
+{
+	MT_lock_set(&bs_lock);
+	*checkpoints = nr_checkpoints;
+	*deferred = nr_deferred;
+	*changes = last_changes;
+	*pending = logger_funcs.changes ? logger_funcs.changes() : 0;
+	*lag_ms = last_checkpoint ? (GDKusec() - last_checkpoint) / 1000 : 0;
+	*wait_usec = last_wait_usec;
+	*max_wait = max_wait_usec;
+	*flush_usec = last_flush_usec;
+	MT_lock_unset(&bs_lock);
+}
+
+/* Bound the loss window of asynchronous commits.  Called, unlocked,
+ * by both the store and the idle manager, so that a long checkpoint
+ * does not hold up the sync.  The sync itself runs without bs_lock;
+ * tsyncing keeps store_exit from destroying the logger meanwhile. */
+static void
+store_sync_pending(void)
+{
+	int res;
+
+	if (!logger_funcs.log_tsync_pending)
+		return;
+	MT_lock_set(&bs_lock);
+	if (GDKexiting()) {
+		MT_lock_unset(&bs_lock);
+		return;
+	}
+	tsyncing++;
+	MT_lock_unset(&bs_lock);
+	res = logger_funcs.log_tsync_pending();
+	MT_lock_set(&bs_lock);
+	tsyncing--;
+	MT_lock_unset(&bs_lock);
+	if (res != LOG_OK)
+		GDKfatal("write-ahead log sync failure");
+}
+
 void
 store_manager(void)
 {
@@ -1742,11 +1997,13 @@ store_manager(void)
 		int res = LOG_OK;
 		int t;
 		lng shared_transactions_drift = -1;
+		lng start, changes;
 
 		for (t = timeout; t > 0 && !need_flush; t -= sleeptime) {
 			MT_sleep_ms(sleeptime);
 			if (GDKexiting())
 				return;
+			store_sync_pending();
 		}
 		/* check if we have a shared logger as well */
 		if (create_shared_logger) {
@@ -1770,13 +2027,25 @@ store_manager(void)
             		continue;
         	}
 		need_flush = 0;
-        	while (store_nr_active) { /* find a moment to flush */
-            		MT_lock_unset(&bs_lock);
-			if (GDKexiting())
+		start = GDKusec();
+		if (checkpoint_wait >= 0 && store_nr_active) {
+			/* hold back new transactions, so the active
+			 * ones finish, instead of waiting for a moment
+			 * where all sessions happen to be idle */
+			if (!store_checkpoint_drain(sleeptime))
 				return;
-            		MT_sleep_ms(sleeptime);
-            		MT_lock_set(&bs_lock);
-        	}
+		} else {
+			while (store_nr_active) { /* find a moment to flush */
+				MT_lock_unset(&bs_lock);
+				if (GDKexiting())
+					return;
+				MT_sleep_ms(sleeptime);
+				MT_lock_set(&bs_lock);
+			}
+		}
+		last_wait_usec = GDKusec() - start;
+		if (last_wait_usec > max_wait_usec)
+			max_wait_usec = last_wait_usec;
 
 		if (create_shared_logger) {
 			/* (re)load data from shared write-ahead log */
@@ -1802,12 +2071,17 @@ store_manager(void)
 		}
 
 		logging = 1;
+		start = GDKusec();
+		changes = logger_funcs.changes();
 		/* make sure we reset all transactions on re-activation */
 		gtrans->wstime = timestamp();
 		if (store_funcs.gtrans_update) {
 			store_funcs.gtrans_update(gtrans);
 		}
 		res = logger_funcs.restart();
+		/* the deltas are in the persistent bats, new transactions
+		 * need not wait for the log cleanup */
+		store_checkpoint_release();
 
 		MT_lock_unset(&bs_lock);
 		if (logging && res == LOG_OK) {
@@ -1816,6 +2090,10 @@ store_manager(void)
 
 		MT_lock_set(&bs_lock);
 		logging = 0;
+		nr_checkpoints++;
+		last_changes = changes;
+		last_checkpoint = GDKusec();
+		last_flush_usec = last_checkpoint - start;
 		MT_lock_unset(&bs_lock);
 
 		if (res != LOG_OK)
@@ -1837,9 +2115,10 @@ idle_manager(void)
 			MT_sleep_ms(sleeptime);
 			if (GDKexiting())
 				return;
+			store_sync_pending();
 		}
 		MT_lock_set(&bs_lock);
-		if (store_nr_active || GDKexiting() || !store_needs_vacuum(gtrans)) {
+		if (store_nr_active || checkpoint_barrier || GDKexiting() || !store_needs_vacuum(gtrans)) {
 			MT_lock_unset(&bs_lock);
 			continue;
 		}
@@ -3142,6 +3421,8 @@ rollforward_trans(sql_trans *tr, int mode)
 		tr->parent->wtime = tr->wtime;
 		tr->parent->schema_updates = tr->schema_updates;
 	}
+	if (mode == R_APPLY && tr->parent == gtrans && tr->schema_updates)
+		schema_versions_record(tr, schema_number + 1);
 
 	if (ok == LOG_OK)
 		ok = rollforward_changeset_updates(tr, &tr->schemas, &tr->parent->schemas, (sql_base *) tr->parent, (rfufunc) &rollforward_update_schema, (rfcfunc) &rollforward_create_schema, (rfdfunc) &rollforward_drop_schema, (dupfunc) &schema_dup, mode);
@@ -3510,8 +3791,8 @@ catalog_corrupt( sql_trans *tr )
 }
 #endif /*CAT_DEBUG*/
 
-int
-sql_trans_commit(sql_trans *tr)
+static int
+sql_trans_commit_(sql_trans *tr, lng *ticket)
 {
 	int ok = LOG_OK;
 
@@ -3529,7 +3810,9 @@ sql_trans_commit(sql_trans *tr)
 		if (ok == LOG_OK && prev_oid != store_oid)
 			ok = logger_funcs.log_sequence(OBJ_SID, store_oid);
 		prev_oid = store_oid;
-		if (ok == LOG_OK)
+		if (ok == LOG_OK && ticket && logger_funcs.log_tend_nosync)
+			ok = logger_funcs.log_tend_nosync(ticket);
+		else if (ok == LOG_OK)
 			ok = logger_funcs.log_tend();
 		tr->schema_number = store_schema_number();
 	}
@@ -3543,6 +3826,53 @@ sql_trans_commit(sql_trans *tr)
 	return (ok==LOG_OK)?SQL_OK:SQL_ERR;
 }
 
+int
+sql_trans_commit(sql_trans *tr)
+{
+	return sql_trans_commit_(tr, NULL);
+}
+
+/* Commit without waiting for the write-ahead log to reach the disk.
+ * The caller passes the ticket to store_commit_sync after releasing
+ * the store lock, so that concurrent commits can share a sync. */
+int
+sql_trans_commit_nosync(sql_trans *tr, lng *ticket)
+{
+	*ticket = 0;
+	return sql_trans_commit_(tr, ticket);
+}
+
+int
+store_commit_sync(lng ticket)
+{
+	if (ticket == 0 || !logger_funcs.log_tsync)
+		return LOG_OK;
+	return logger_funcs.log_tsync(ticket);
+}
+
+/* The ticket of the last committed transaction, called locked.  With
+ * group commit, a commit is visible to new transactions as soon as the
+ * store lock is released, before its log record is on disk; a new
+ * transaction passes this ticket to store_commit_wait so that it does
+ * not act on changes that a crash could still undo.  With asynchronous
+ * commit (gdk_async_commit) it only waits if the last sync is older
+ * than that setting, so recent commits may still be lost. */
+lng
+store_commit_ticket(void)
+{
+	if (!logger_funcs.log_tlast)
+		return 0;
+	return logger_funcs.log_tlast();
+}
+
+int
+store_commit_wait(lng ticket)
+{
+	if (ticket == 0 || !logger_funcs.log_twait)
+		return LOG_OK;
+	return logger_funcs.log_twait(ticket);
+}
+
 
 static void
 sql_trans_drop_all_dependencies(sql_trans *tr, sql_schema *s, int id, short type)
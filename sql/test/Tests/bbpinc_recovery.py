@@ -0,0 +1,87 @@
+import os, sys, time, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# A subcommit rewrites BBP.inc, or BBP.dir and BBP.inc when the two are
+# merged, after moving the committed copies to BACKUP/SUBCOMMIT.  A
+# crash before the commit completes leaves a torn file behind, and the
+# restart must go back to the saved copies.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-bbpinc'
+bat = os.path.join(dbfarm, dbname, 'bat')
+
+if os.path.exists(os.path.join(dbfarm, dbname)):
+    shutil.rmtree(os.path.join(dbfarm, dbname))
+
+def client(queries):
+    c = process.client('sql',
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+def run(queries):
+    s = process.server(stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    for q in queries:
+        if q is None:
+            # give the store manager time to checkpoint
+            time.sleep(3)
+        else:
+            client(q)
+    s.communicate()
+
+def crash(merge):
+    # After a commit the committed BBP.inc is saved in BACKUP, and so is
+    # BBP.dir when the next subcommit merges the two.  The subcommit
+    # moves them to BACKUP/SUBCOMMIT and then writes the new BBP.inc, or
+    # BBP.dir when merging: simulate a crash halfway that.
+    bak = os.path.join(bat, 'BACKUP')
+    sub = os.path.join(bak, 'SUBCOMMIT')
+    os.mkdir(sub)
+    saved = ['BBP.dir', 'BBP.inc'] if merge else ['BBP.inc']
+    for f in saved:
+        if os.path.exists(os.path.join(bak, f)):
+            os.rename(os.path.join(bak, f), os.path.join(sub, f))
+        else:
+            os.rename(os.path.join(bat, f), os.path.join(sub, f))
+    data = open(os.path.join(sub, saved[0])).read()
+    # the header and part of the first entry
+    open(os.path.join(bat, saved[0]), 'w').write(data[:data.index('\n', data.index('BBPsize')) + 20])
+
+check = 'select count(*), sum(i), max(s) from bbpinc;\n'
+
+run(['create table bbpinc (i int, s varchar(10));\n',
+     'insert into bbpinc values (1, \'a\'), (2, \'b\');\n',
+     'call sys.flush_log();\n',
+     None,
+     'insert into bbpinc values (3, \'c\');\n',
+     'call sys.flush_log();\n',
+     None,
+     check])
+
+for i in range(3):
+    crash(i == 1)
+    run([check,
+         'insert into bbpinc values (%d, \'%s\');\n' % (i + 4, chr(ord('d') + i)),
+         'call sys.flush_log();\n',
+         None,
+         check])
+
+run(['drop table bbpinc;\n'])
+
+shutil.rmtree(os.path.join(dbfarm, dbname))
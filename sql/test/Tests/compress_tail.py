@@ -0,0 +1,101 @@
+import os, sys, time, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# The encoded copy of a read-only column replaces its tail on disk, and
+# the tail is decoded when the column is loaded again after a restart.
+# The columns are then updated and the changes are merged into the
+# columns, which saves their tail again, and they are queried after
+# another restart.  The results are the same as those of
+# the uncompressed columns of the baseline.  The bat directory and the
+# --algorithms trace of the server tell which columns were replaced by
+# their encoded copy and decoded again.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-cmprtail'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def server():
+    return process.server(args = ['--algorithms'],
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname)
+
+def client(queries):
+    c = process.client('sql',
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+def files():
+    # the encoded copies on disk, and those of them with a tail file
+    cmpr = tail = 0
+    for d, dirs, fs in os.walk(os.path.join(dbpath, 'bat')):
+        for f in fs:
+            if f.endswith('.tcompress'):
+                cmpr += 1
+                b = f[:-len('.tcompress')]
+                if b + '.tail' in fs or b + '.tail.new' in fs:
+                    tail += 1
+    return cmpr, tail
+
+def stop(s):
+    out, err = s.communicate()
+    return err.splitlines()
+
+check = '''set optimizer = 'sequential_pipe';
+select count(*), sum(a), sum(b), sum(c), min(a), max(b) from ct;
+select count(*), sum(b) from ct where a between 100 and 199;
+select count(*), sum(a) from ct where c = 17;
+select a, b, c from ct where b in (5, 123456, 299999) order by b;
+select c, count(*), sum(a) from ct where c < 3 group by c order by c;
+'''
+
+s = server()
+client('''create table ct (a int, b bigint, c int);
+insert into ct select cast(value % 1000 as int), value, cast(value / 1000 as int) from generate_series(cast(0 as bigint), 300000);
+''')
+client(check)
+trace = stop(s)
+cmpr, tail = files()
+print 'columns encoded:', len([l for l in trace if l.startswith('#BATcompress(') and '#300000)' in l]) > 0
+print 'encoded copies on disk:', cmpr > 0
+print 'encoded copies next to a tail:', tail
+
+s = server()
+client(check)
+client('''update ct set a = a + 1 where c = 17;
+delete from ct where c = 3;
+insert into ct values (7, 300001, 300);
+call sys.flush_log();
+''')
+# give the store manager time to merge the changes
+time.sleep(3)
+client(check)
+trace = stop(s)
+print 'tails decoded:', len([l for l in trace if l.startswith('#BATload(') and l.find('): decoded tail') > 0]) > 0
+
+s = server()
+client(check)
+client('drop table ct;\n')
+trace = stop(s)
+cmpr, tail = files()
+print 'encoded copies next to a tail:', tail
+
+shutil.rmtree(dbpath)
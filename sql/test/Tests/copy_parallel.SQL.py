@@ -0,0 +1,89 @@
+import os, sys
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# A large input is split into records by several threads, each scanning
+# a byte range of the buffer.  The file below has quoted fields that
+# contain the field and record separators, escaped quotes and
+# backslashes, so a range may well start inside a quoted field or just
+# after a backslash.  The loaded values are compared with those
+# computed here from the rows that were written.
+
+TSTTRGDIR = os.environ['TSTTRGDIR']
+
+def row(i):
+    k = i % 7
+    if k == 0:
+        return 'row %d' % i
+    if k == 1:
+        return 'a,b,%d' % i
+    if k == 2:
+        return 'line %d\nand %d' % (i, i + 1)
+    if k == 3:
+        return 'say "hi" %d' % i
+    if k == 4:
+        return 'back\\slash %d' % i
+    if k == 5:
+        return 'x' * (i % 50)
+    return 'end %d!!\n"' % i
+
+def field(s):
+    return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+def write(name, rsep, n):
+    f = open(os.path.join(TSTTRGDIR, name), 'wb')
+    for i in range(n):
+        f.write('%d,%s,%d%s' % (i, field(row(i)), i % 1000, rsep))
+    f.close()
+
+def expect(lo, hi):
+    rows = [row(i) for i in range(lo, hi)]
+    return (hi - lo, sum(range(lo, hi)),
+            sum([len(s) for s in rows]),
+            sum([i % 1000 for i in range(lo, hi)]),
+            len([s for s in rows if '\n' in s]),
+            len([s for s in rows if '"' in s]))
+
+n = 300000
+write('copy_parallel1.csv', '\n', n)
+write('copy_parallel2.csv', '!!\n', n)
+
+def path(name):
+    return os.path.join(TSTTRGDIR, name).replace('\\', r'\\')
+
+check = '''select count(*), sum(id), sum(length(s)), sum(v), sum(case when s like '%%\\n%%' then 1 else 0 end), sum(case when s like '%%"%%' then 1 else 0 end) from %s;
+'''
+
+c = process.client('sql', args = ['-fcsv'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE)
+out, err = c.communicate('''
+create table cp1 (id bigint, s varchar(100), v int);
+create table cp2 (id bigint, s varchar(100), v int);
+create table cp3 (id bigint, s varchar(100), v int);
+copy into cp1 from '%s' using delimiters ',', '\\n', '"';
+copy into cp2 from '%s' using delimiters ',', '!!\\n', '"';
+copy offset 1001 into cp3 from '%s' using delimiters ',', '\\n', '"';
+''' % (path('copy_parallel1.csv'), path('copy_parallel2.csv'),
+       path('copy_parallel1.csv')) +
+    check % 'cp1' + check % 'cp2' + check % 'cp3' + '''
+drop table cp1;
+drop table cp2;
+drop table cp3;
+''')
+sys.stderr.write(err)
+
+res = [tuple([int(x) for x in l.split(',')])
+       for l in out.splitlines() if l[:1].isdigit() and ',' in l]
+exp = [expect(0, n), expect(0, n), expect(1000, n)]
+for r, e in zip(res, exp):
+    print r == e, r
+if len(res) != len(exp):
+    print 'missing results'
+    sys.stdout.write(out)
+
+for name in ('copy_parallel1.csv', 'copy_parallel2.csv'):
+    os.remove(os.path.join(TSTTRGDIR, name))
@@ -0,0 +1,52 @@
+import sys
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# Mitosis splits the scans below in many pieces, whose consumers the
+# dataflow workers place in their own queues and steal from each other.
+# Several clients run them at the same time, and every result is
+# compared with the one of the sequential pipe, which does not use the
+# dataflow scheduler at all.
+
+def client(queries):
+    c = process.client('sql',
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE)
+    c.stdin.write(queries)
+    c.stdin.close()
+    return c
+
+def done(c):
+    out, err = c.communicate()
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+done(client('''
+create table dfl (g int, k int, v bigint);
+insert into dfl select cast(value % 1000 as int), cast(value % 37 as int), value from generate_series(cast(0 as bigint), 2000000);
+create table dfk (k int, w int);
+insert into dfk select value, value * 3 % 10 from generate_series(cast(0 as int), 37);
+set optimizer = 'sequential_pipe';
+create table dfl_ref as select g, count(*) as c, sum(v) as s, min(v) as mn, max(v) as mx from dfl group by g with data;
+create table dfj_ref as select w, count(*) as c, sum(v) as s from dfl join dfk on dfl.k = dfk.k where dfl.v % 3 = 1 group by w with data;
+'''))
+
+check = '''
+select count(*), sum(v), min(v), max(v) from dfl;
+select count(*) from (select g, count(*), sum(v), min(v), max(v) from dfl group by g except select * from dfl_ref) as x;
+select count(*) from (select w, count(*), sum(v) from dfl join dfk on dfl.k = dfk.k where dfl.v % 3 = 1 group by w except select * from dfj_ref) as x;
+'''
+
+clts = [client(check * 3) for i in range(4)]
+for c in clts:
+    done(c)
+
+done(client('''
+drop table dfl;
+drop table dfk;
+drop table dfl_ref;
+drop table dfj_ref;
+'''))
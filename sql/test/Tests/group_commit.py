@@ -0,0 +1,96 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# Concurrent commits share write-ahead log syncs (gdk_group_commit),
+# or sync one by one without it, or skip the sync shortly after the
+# last one (gdk_async_commit).  In all cases every commit that was
+# acknowledged before mserver5 is killed is there after the restart.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-groupcommit'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def server(args = []):
+    # no timeout, since we kill mserver5, not the inbetween Mtimeout
+    return process.server(args = args,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname,
+                          notimeout = True)
+
+def newclient():
+    return process.client('sql',
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname)
+
+def client(queries):
+    out, err = newclient().communicate(queries)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+def inserts(nclients, n, first):
+    # nclients sessions that each commit n inserts, all at once, each
+    # into a table of its own so that they do not conflict
+    clts = [newclient() for c in range(nclients)]
+    for c in range(nclients):
+        clts[c].stdin.write(''.join(['insert into gc%d values (%d, %d);\n' % (first + c, first + c, i) for i in range(n)]))
+        clts[c].stdin.close()
+    for c in clts:
+        out, err = c.communicate()
+        sys.stderr.write(err)
+
+def crash(s):
+    s.kill()
+    s.communicate()
+
+stats = '''select c.value >= %d as commits, s.value %s c.value as syncs, g.value %s as max_group, a.value > 0 as async
+  from commit_stats() c, commit_stats() s, commit_stats() g, commit_stats() a
+ where c.stat = 'commits' and s.stat = 'syncs' and g.stat = 'max_group' and a.stat = 'async_commits';
+'''
+check = 'select count(*), count(distinct c), sum(i) from gc;\n'
+
+# group commit: concurrent commits share syncs
+s = server()
+client(''.join(['create table gc%d (c int, i int);\n' % c for c in range(11)]) +
+       'create view gc as ' + ' union all '.join(['select * from gc%d' % c for c in range(11)]) + ''';
+create function commit_stats() returns table (stat string, value bigint) external name sql.dump_commit_stats;
+''')
+inserts(8, 100, 0)
+client(check + stats % (800, '<', '> 1'))
+crash(s)
+
+# without group commit every commit syncs by itself
+s = server(['--set', 'gdk_group_commit=0'])
+client(check)
+inserts(2, 50, 8)
+client(check + stats % (100, '=', '= 1'))
+crash(s)
+
+# asynchronous commits do not wait for a sync just after the last one
+s = server(['--set', 'gdk_async_commit=1000'])
+client(check)
+inserts(1, 100, 10)
+client(check + stats % (100, '<', '<= 100'))
+crash(s)
+
+s = server()
+client(check + 'drop function commit_stats;\ndrop view gc;\n' +
+       ''.join(['drop table gc%d;\n' % c for c in range(11)]))
+s.communicate()
+
+shutil.rmtree(dbpath)
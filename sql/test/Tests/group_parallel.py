@@ -0,0 +1,72 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# Grouped counts, sums, minima, maxima and averages over a large input
+# with few groups are computed in parallel ranges whose private tables
+# are merged.  Without mitosis the groups come from a single BATgroup
+# over the whole table.  The results must be those of a server with a
+# single thread, which aggregates sequentially.  The parallel ranges are
+# read from the algorithm debug output of the server.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-group_parallel'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def server(threads):
+    return process.server(args = ['--set', 'gdk_nr_threads=%d' % threads,
+                                  '--debug=2097152'],
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname)
+
+def client(queries):
+    c = process.client('sql', args = ['-fcsv'],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stderr.write(err)
+    return out
+
+# aggregates over a single grouping of the whole table, with nils in
+# both the groups and the values, and over a selection
+queries = '''set optimizer = 'sequential_pipe';
+select g, count(v), count(*), sum(v), min(v), max(v), avg(v) from gp group by g order by g limit 8;
+select count(*), sum(c), sum(s), min(mi), max(ma) from (select g, count(v) as c, sum(v) as s, min(v) as mi, max(v) as ma from gp group by g) x;
+select g, sum(v), avg(v) from gp where v % 3 = 1 group by g order by g limit 5;
+select g, min(s), max(s) from gp group by g order by g limit 5;
+'''
+
+s = server(1)
+client('''create table gp (g int, v int, s varchar(10));
+insert into gp select case when value % 997 = 0 then null else value % 500 end,
+    case when value % 13 = 0 then null else value - 600000 end,
+    cast(value % 7919 as varchar(10))
+  from generate_series(cast(0 as int), 1200000);
+''')
+alone = client(queries)
+print alone
+out, err = s.communicate()
+
+s = server(4)
+parallel = client(queries)
+client('drop table gp;\n')
+out, err = s.communicate()
+print 'parallel:', '#paraggrinit' in err
+print 'same as sequential:', parallel == alone
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,68 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# When the hash table for grouping does not fit in the memory the query
+# may still use, BATgroup partitions its input and groups one partition
+# at a time.  The server is restarted with a query_memory budget far
+# below what the grouping below needs, and the results must be those
+# of the server without a budget, which groups in one go.  The
+# partitioning is read from the algorithm debug output of the server.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-group_spill'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def server(args):
+    return process.server(args = ['--set', 'gdk_nr_threads=2'] + args,
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname)
+
+def client(queries):
+    c = process.client('sql', args = ['-fcsv'],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stderr.write(err)
+    return out
+
+# a single grouping over the whole table, on one and on two columns,
+# with nils
+queries = '''set optimizer = 'sequential_pipe';
+select count(*), sum(c), sum(s), min(mi), max(ma) from (select a, count(*) as c, sum(b) as s, min(b) as mi, max(b) as ma from gs group by a) x;
+select a, count(*), sum(b) from gs group by a order by a limit 5;
+select count(*), sum(c) from (select a, b % 7 as k, count(*) as c from gs group by a, k) x;
+select count(*) from (select distinct a from gs) x;
+'''
+
+s = server([])
+client('''create table gs (a int, b int);
+insert into gs select case when value % 1009 = 0 then null else value % 150001 end, value from generate_series(cast(0 as int), 600000);
+''')
+alone = client(queries)
+print alone
+out, err = s.communicate()
+
+s = server(['--set', 'query_memory=1000000', '--debug=2097152'])
+spilled = client(queries)
+client('drop table gs;\n')
+out, err = s.communicate()
+print 'partitioned:', 'partitioned spill' in err
+print 'same as without budget:', spilled == alone
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,69 @@
+import os, sys, time, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# Grouping a large persistent column without a hash table starts
+# building one in the background, which the groupings and selects
+# that follow pick up through the views on the column.  The column is
+# then updated, and the results must stay correct.  The --algorithms
+# trace of the server tells when the hash table was built and used.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-hashbg'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def client(queries):
+    c = process.client('sql',
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+# without mitosis the groupings see the whole column
+check = '''set optimizer = 'sequential_pipe';
+select count(*), sum(c), min(c), max(c) from (select k, count(*) as c from hb group by k) as x;
+select count(*), sum(v) from hb where k = 3;
+select count(*), sum(v) from hb where k = 7;
+select count(*), sum(v) from hb where k = 1003;
+'''
+
+s = process.server(args = ['--algorithms', '--set', 'gdk_nr_threads=4'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+client('''create table hb (k int, v bigint);
+insert into hb select cast(value % 1000 as int), value from generate_series(cast(0 as bigint), 2000000);
+''')
+client(check)
+# give the background build time to finish
+time.sleep(3)
+client(check)
+client('''update hb set k = k + 1000 where v % 1000 = 3;
+insert into hb select 7, value from generate_series(cast(2000000 as bigint), 2001000);
+delete from hb where k = 9;
+''')
+client(check)
+client('drop table hb;\n')
+out, err = s.communicate()
+
+trace = err.splitlines()
+print 'background build started:', len([l for l in trace if l.startswith('#BAThashbackground: start building hash on ')]) > 0
+print 'background build finished:', len([l for l in trace if l.startswith('#BAThashbackground: built hash on ')]) > 0
+print 'grouping used the hash table:', len([l for l in trace if l.startswith('#BATgroup(b=') and '#2000000[int]' in l and l.endswith('use existing hash table')]) > 0
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,115 @@
+import os, sys, glob, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# Packed write-ahead log records (gdk_log_compress) are replayed after a
+# crash, also by a server that does not write them, and a packed record
+# that is cut off or damaged ends the replay just before it.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-logpacked'
+dbpath = os.path.join(dbfarm, dbname)
+saved = dbpath + '-saved'
+
+for d in (dbpath, saved):
+    if os.path.exists(d):
+        shutil.rmtree(d)
+
+def server(compress):
+    # no timeout, since we kill mserver5, not the inbetween Mtimeout
+    return process.server(args = ['--set', 'gdk_log_compress=%d' % compress],
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname,
+                          notimeout = True)
+
+def client(queries):
+    c = process.client('sql',
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+def crash(s):
+    s.kill()
+    out, err = s.communicate()
+    return err
+
+def stop(s):
+    out, err = s.communicate()
+    return err
+
+def lastlog():
+    logs = glob.glob(os.path.join(dbpath, 'sql_logs', 'sql', 'log.*'))
+    return max(logs, key = lambda f: int(f[f.rindex('.') + 1:]))
+
+def damage(how):
+    f = lastlog()
+    data = open(f, 'rb').read().rstrip('\0')
+    # well into the first block of the packed insert into t
+    pos = len(data) * 2 / 5
+    if how == 'cut':
+        data = data[:pos]
+    else:
+        data = data[:pos] + chr(ord(data[pos]) ^ 0x55) + data[pos + 1:]
+    open(f, 'wb').write(data)
+
+checkt = 'select count(*), sum(i), count(s), max(s) from t;\n'
+check = checkt + 'select * from u order by a;\n'
+
+# plain records
+s = server(0)
+client('''create table t (i bigint, s varchar(20));
+insert into t values (1, 'one'), (2, 'two'), (3, null);
+''')
+crash(s)
+
+# replay the plain records, and add packed records of several blocks,
+# next to the plain records of the catalog
+s = server(1)
+client(checkt)
+client('''create table u (a int, b varchar(10));
+insert into u values (1, 'a'), (2, null), (3, 'c');
+update u set b = 'b' where a = 2;
+insert into t select value * 7919 % 1000003, 'v' || cast(value as varchar(10)) from generate_series(cast(0 as bigint), 200000);
+update t set s = 'upd' where i < 100;
+''')
+client(check)
+crash(s)
+shutil.copytree(dbpath, saved)
+
+# replay all of it with a server that writes plain records
+s = server(0)
+client(check)
+stop(s)
+
+# the packed insert is cut off in the middle of a block
+shutil.rmtree(dbpath)
+shutil.copytree(saved, dbpath)
+damage('cut')
+s = server(1)
+client(check)
+stop(s)
+
+# a byte of the packed insert is changed, so its checksum fails
+shutil.rmtree(dbpath)
+shutil.copytree(saved, dbpath)
+damage('flip')
+s = server(1)
+client(check)
+print 'checksum mismatch reported:', 'checksum mismatch' in stop(s)
+
+shutil.rmtree(dbpath)
+shutil.rmtree(saved)
@@ -0,0 +1,91 @@
+import os, sys, glob, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# The write-ahead log is replayed in batches of changes that are
+# applied by several threads while the next batch is read.  Fill the
+# log with more changes than fit in one batch, with updates, deletes,
+# inserts and a new table in between, crash, and check the replayed
+# tables.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-replay'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def server():
+    # no timeout, since we kill mserver5, not the inbetween Mtimeout
+    return process.server(args = ['--set', 'gdk_nr_threads=4'],
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname,
+                          notimeout = True)
+
+def newclient():
+    return process.client('sql',
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname)
+
+def client(queries):
+    out, err = newclient().communicate(queries)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+def logsize():
+    size = 0
+    for f in glob.glob(os.path.join(dbpath, 'sql_logs', 'sql', 'log.*')):
+        size += len(open(f, 'rb').read().rstrip('\0'))
+    return size
+
+check = '''select count(*), sum(a), sum(b), count(s), max(s) from r;
+select count(*), sum(x) from r2;
+'''
+
+s = server()
+client('''create table r (a bigint, b int, s varchar(20));
+insert into r select value, cast(value % 1000 as int), 's' || cast(value % 5000 as varchar(10)) from generate_series(cast(0 as bigint), 1000000);
+''')
+s.communicate()
+
+s = server()
+# a transaction that stays open keeps the store manager from
+# checkpointing, and makes the commit log its changes instead of
+# writing the bats directly
+holder = newclient()
+holder.stdin.write('start transaction;\nselect 1;\n')
+holder.stdin.flush()
+holder.stdout.readline()
+client('''start transaction;
+update r set b = -b where a % 3 = 0;
+update r set s = 'u' || s where a % 5 = 0;
+create table r2 (x bigint);
+insert into r2 select a * 2 from r where b < 0;
+delete from r where a % 7 = 0;
+insert into r select value, 1, null from generate_series(cast(2000000 as bigint), 3000000);
+insert into r2 select value from generate_series(cast(0 as bigint), 1000000);
+commit;
+''')
+# more than the 4M values of a replay batch, of 4 bytes or more each
+print 'changes are in the log:', logsize() > 16 * 1024 * 1024
+s.kill()
+s.communicate()
+holder.communicate()
+
+s = server()
+client(check + 'drop table r;\ndrop table r2;\n')
+s.communicate()
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,73 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# With gdk_mem_budget set well below what a single query uses, queries
+# that start while others hold more than the budget are queued instead
+# of failing.  All concurrent runs must complete with the results of a
+# run on its own, and the memory charged to a query is visible through
+# sysmon.memory().
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-memory_budget'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def client(lang, queries):
+    c = process.client(lang, args = ['-fcsv'] if lang == 'sql' else [],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stderr.write(err)
+    return out
+
+query = 'select count(*), sum(x) from (select distinct a * 2 as x from m) s;\n'
+
+s = process.server(args = ['--set', 'gdk_mem_budget=4000000',
+                           '--set', 'gdk_nr_threads=4'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+client('sql', '''create table m (a int, b int);
+insert into m select value, value % 1000 from generate_series(cast(0 as int), 1000000);
+''')
+alone = client('sql', query)
+print alone
+clients = []
+for i in range(4):
+    c = process.client('sql', args = ['-fcsv'],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    clients.append(c)
+outs = []
+for c in clients:
+    out, err = c.communicate(query * 3)
+    sys.stderr.write(err)
+    outs.append(out)
+print 'concurrent runs as alone:', outs == [alone * 3] * 4
+out = client('mal', '''(t, u, p, g) := sysmon.memory();
+n := aggr.count(t);
+io.print(n);
+ge := batcalc.>=(p, u);
+io.print(ge);
+''')
+print out
+client('sql', 'drop table m;\n')
+out, err = s.communicate()
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,73 @@
+import os, sys, shutil, re
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# With mito_feedback set, the packs of a split table report the work of
+# each piece, and pieces too cheap to be worth scheduling lead to fewer
+# pieces when the next query on the table is optimized.  The advice is
+# saved in the database directory, so a restarted server splits the
+# table the same way.  The server is forced to split even the small
+# table below, in as many pieces as it has threads, which are all far
+# too cheap.  The number of pieces is read from the plans.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-mitosis_feedback'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def server():
+    return process.server(args = ['--set', 'mito_feedback=yes',
+                                  '--set', 'gdk_nr_threads=4'],
+                          stdin = process.PIPE,
+                          stdout = process.PIPE,
+                          stderr = process.PIPE,
+                          dbname = dbname)
+
+def client(queries):
+    c = process.client('sql', args = ['-fcsv'],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stderr.write(err)
+    return out
+
+query = 'select count(*), sum(v) from mf where v < %d;\n'
+
+# the number of partitioned binds of the column
+def pieces():
+    out = client('explain ' + query % 7)
+    return len([l for l in out.splitlines()
+                if re.search(r'sql\.bind\(.*"v"+:str, 0:int, \d+:int, \d+:int\)', l)])
+
+s = server()
+client('''create table mf (v int);
+insert into mf select value from generate_series(cast(0 as int), 20000);
+''')
+before = pieces()
+print 'split:', before > 1
+for i in range(3):
+    print client(query % (i * 10 + 10)).strip()
+after = pieces()
+print 'fewer pieces:', after < before
+out, err = s.communicate()
+print 'statistics saved:', os.path.exists(os.path.join(dbpath, 'mitosis_stats'))
+
+s = server()
+print 'same pieces after restart:', pieces() == after
+print client(query % 40).strip()
+client('drop table mf;\n')
+out, err = s.communicate()
+
+shutil.rmtree(dbpath)
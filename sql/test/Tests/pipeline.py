@@ -0,0 +1,75 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# Under the pipeline pipe the selects, projections and aggregates over
+# each piece of a table are fused into pipelines that are run over
+# morsels of the piece.  The morsel size is made small enough for the
+# pieces below to be cut in many morsels, whose aggregates must add up
+# to those computed without pipelines, also with nils in the columns,
+# with empty selections and with deleted rows in the candidate lists.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-pipeline'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def client(queries):
+    c = process.client('sql', args = ['-fcsv'],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stderr.write(err)
+    return out
+
+queries = [
+    'select sum(a * 2), count(*), max(c), min(b) from p where b < 50 and a > 1000;',
+    'select sum(a + b) from p where a between 10 and 90000;',
+    'select count(b), min(s), max(s) from p where a > 5000 and c < 30000.0;',
+    'select sum(a), min(b), count(*) from p where a < 0;',
+]
+
+# the results, without the echo of the set statement
+def run(pipe):
+    out = client(''.join(["set optimizer = '%s';\n" % pipe] + [q + '\n' for q in queries]))
+    return '\n'.join([l for l in out.splitlines() if not l.startswith('#')])
+
+def compare():
+    out = run('pipeline_pipe')
+    print out
+    print 'same as sequential:', out == run('sequential_pipe')
+
+s = process.server(args = ['--set', 'morsel_size=4',
+                           '--set', 'gdk_nr_threads=4'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+client('''create table p (a int, b int, c double, s varchar(10));
+insert into p select value,
+    case when value % 13 = 0 then null else value % 100 end,
+    value * 0.5,
+    case when value % 17 = 0 then null else cast(value % 1000 as varchar(10)) end
+  from generate_series(cast(0 as int), 100000);
+''')
+out = client("set optimizer = 'pipeline_pipe';\nexplain " + queries[0] + '\n')
+print 'pipelined:', 'pipeline.run(' in out
+compare()
+client('delete from p where a % 7 = 0;\n')
+compare()
+client('drop table p;\n')
+out, err = s.communicate()
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,62 @@
+import sys
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# A query compiled by one client is optimized and shared with the other
+# clients, who run a copy of the plan with their own parameter values.
+# A shared plan is dropped when one of the tables it uses changes, but
+# not when other tables do.  Clients that use another optimizer pipeline
+# do not use the shared plans.
+
+def client(queries):
+    c = process.client('sql', args = ['-fcsv'],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE)
+    out, err = c.communicate(queries)
+    sys.stderr.write(err)
+    return out
+
+def stats():
+    out = client('select * from plan_cache();\n')
+    return dict([(l.split(',')[0], int(l.split(',')[1]))
+                 for l in out.splitlines() if ',' in l])
+
+query = 'select count(*), sum(i) from pc_a where i > %d;\n'
+
+def run(what, value, pipe = ''):
+    before = stats()
+    out = client(pipe + query % value)
+    after = stats()
+    res = [l for l in out.splitlines() if l[:1].isdigit()]
+    print what, ' '.join(res), \
+          'hits', after['hits'] - before['hits'], \
+          'invalidations', after['invalidations'] - before['invalidations']
+
+client('''
+create function plan_cache() returns table (stat string, value bigint) external name sql.dump_plan_cache;
+create table pc_a (i int);
+create table pc_b (i int);
+insert into pc_a select value from generate_series(cast(0 as int), 1000);
+insert into pc_b values (1);
+''')
+
+run('compile:', 10)
+run('shared:', 500)
+run('shared:', 990)
+client('alter table pc_b add column j int;\n')
+run('other table changed:', 0)
+client('alter table pc_a add column j int;\n')
+run('table changed:', 100)
+run('shared again:', 200)
+client('insert into pc_a values (2000, 1);\n')
+run('data changed:', 999)
+run('sequential pipe:', 999, "set optimizer = 'sequential_pipe';\n")
+
+client('''
+drop table pc_a;
+drop table pc_b;
+drop function plan_cache;
+''')
@@ -0,0 +1,101 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# With sql_resultcache_size set, the result of a read-only query is
+# kept and handed out again to the next client that runs the same
+# query with the same parameter values, as long as the tables it reads
+# did not change.  Changes to other tables keep the result valid.  A
+# user without the privileges to read the table, or with another role,
+# never gets the result cached for another user or role.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-result_cache'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def client(queries, user = 'monetdb', passwd = 'monetdb', lang = 'sql'):
+    c = process.client(lang, args = ['-fcsv'] if lang == 'sql' else [],
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname,
+                       user = user, passwd = passwd)
+    out, err = c.communicate(queries)
+    return out, err
+
+def stats():
+    out, err = client('(s, v) := sql.dump_result_cache();\nio.print(s, v);\n', lang = 'mal')
+    return dict([(l.split(',')[1].strip().strip('"'), int(l.split(',')[2].strip(' ]')))
+                 for l in out.splitlines() if l.startswith('[')])
+
+query = 'select count(*), sum(i) from sys.rc_a where i > %d;\n'
+
+def run(what, value, user = 'monetdb', passwd = 'monetdb', pre = ''):
+    before = stats()
+    out, err = client(pre + query % value, user, passwd)
+    after = stats()
+    res = [l for l in out.splitlines() if l[:1].isdigit()]
+    if err:
+        res.append('error' + err[err.index(':'):].splitlines()[0])
+    print what, ' '.join(res), \
+          'hits', after['hits'] - before['hits'], \
+          'misses', after['misses'] - before['misses'], \
+          'invalidations', after['invalidations'] - before['invalidations']
+
+s = process.server(args = ['--set', 'sql_resultcache_size=16'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+out, err = client('''create table rc_a (i int);
+create table rc_b (i int);
+insert into rc_a select value from generate_series(cast(0 as int), 1000);
+insert into rc_b values (1);
+create user rc_user with password 'rc' name 'result cache user' schema sys;
+create user rc_other with password 'rc' name 'other user' schema sys;
+create role rc_reader;
+grant select on rc_a to rc_user;
+grant select on rc_a to rc_reader;
+grant rc_reader to rc_other;
+''')
+sys.stderr.write(err)
+
+run('miss:', 10)
+run('hit:', 10)
+run('other value:', 500)
+run('hit:', 500)
+client('insert into rc_b values (2);\n')
+run('other table changed:', 10)
+client('insert into rc_a values (2000);\n')
+run('after insert:', 10)
+run('hit:', 10)
+client('delete from rc_a where i < 100;\n')
+run('after delete:', 10)
+run('user:', 10, 'rc_user', 'rc')
+run('user hit:', 10, 'rc_user', 'rc')
+run('no privilege:', 10, 'rc_other', 'rc')
+run('role:', 10, 'rc_other', 'rc', 'set role rc_reader;\n')
+run('role hit:', 10, 'rc_other', 'rc', 'set role rc_reader;\n')
+print 'entries:', stats()['entries']
+
+out, err = client('''drop user rc_user;
+drop user rc_other;
+drop role rc_reader;
+drop table rc_a;
+drop table rc_b;
+''')
+sys.stderr.write(err)
+out, err = s.communicate()
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,78 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# Range selects and LIKE prefix patterns on a persistent string
+# column use its imprints, equality selects and other patterns do
+# not.  Every query is also written in a way the selects cannot
+# handle, and the results must be the same.  The --algorithms trace of
+# the server tells which selects used the imprints.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-strimps'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def client(queries):
+    c = process.client('sql',
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+s = process.server(args = ['--algorithms'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+client('''create table countries (i int, c varchar(20));
+insert into countries values (0, 'Belgium'), (1, 'Denmark'), (2, 'France'), (3, 'Germany'), (4, 'Georgia'), (5, 'Greece'), (6, 'Iceland'), (7, 'Ireland'), (8, 'Netherlands'), (9, 'Norway'), (10, 'Portugal'), (11, 'Spain'), (12, null);
+create table strimps (c varchar(20), v int);
+insert into strimps select c, cast(value as int) from generate_series(cast(0 as int), 200000) as s, countries where countries.i = s.value * 7 % 13;
+''')
+# without mitosis every select sees the whole column; the queries
+# come in pairs, the second of which gives the same result
+# without a select on the column
+client('''set optimizer = 'sequential_pipe';
+select count(*), sum(v) from strimps where c = 'Greece';
+select count(*), sum(v) from strimps where c || '' = 'Greece';
+select count(*), sum(v) from strimps where c between 'Denmark' and 'Greece';
+select count(*), sum(v) from strimps where c || '' between 'Denmark' and 'Greece';
+select count(*), sum(v) from strimps where c > 'Iceland' and c < 'Portugal';
+select count(*), sum(v) from strimps where c || '' > 'Iceland' and c || '' < 'Portugal';
+select count(*), sum(v) from strimps where c like 'Ge%';
+select count(*), sum(v) from strimps where substring(c, 1, 2) = 'Ge';
+select count(*), sum(v) from strimps where c like 'N%';
+select count(*), sum(v) from strimps where substring(c, 1, 1) = 'N';
+select count(*), sum(v) from strimps where c like 'G_r%';
+select count(*), sum(v) from strimps where c = 'Germany';
+select count(*), sum(v) from strimps where c like '%land%';
+select count(*), sum(v) from strimps where c in ('Iceland', 'Ireland', 'Netherlands');
+select count(*), sum(v) from strimps where c not like 'Ge%';
+select count(*), sum(v) from strimps where substring(c, 1, 2) <> 'Ge';
+select count(*), sum(v) from strimps where c ilike 'ge%';
+select count(*), sum(v) from strimps where substring(c, 1, 2) = 'Ge';
+drop table strimps;
+drop table countries;
+''')
+out, err = s.communicate()
+
+# which selects on the strings used the imprints
+for l in err.splitlines():
+    if l.startswith('#BATselect(b=') and '#200000,' in l:
+        print l.split('): ')[1]
+
+shutil.rmtree(dbpath)
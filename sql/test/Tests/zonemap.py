@@ -0,0 +1,82 @@
+import os, sys, shutil
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+# A persistent column that is clustered but not sorted gets a zone map,
+# which appends extend instead of discarding.  Selects and range joins
+# on the column use the zone map; their results are compared with those
+# of the same queries on an expression of the column, which are
+# evaluated without it.  The --algorithms trace of the server tells
+# when the zone map was used.
+
+dbfarm = os.getenv('GDK_DBFARM')
+tstdb = os.getenv('TSTDB')
+
+if not tstdb or not dbfarm:
+    print 'No TSTDB or GDK_DBFARM in environment'
+    sys.exit(1)
+
+dbname = tstdb + '-zonemap'
+dbpath = os.path.join(dbfarm, dbname)
+
+if os.path.exists(dbpath):
+    shutil.rmtree(dbpath)
+
+def client(queries):
+    c = process.client('sql',
+                       stdin = process.PIPE,
+                       stdout = process.PIPE,
+                       stderr = process.PIPE,
+                       dbname = dbname)
+    out, err = c.communicate(queries)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+def load(lo, hi):
+    return 'insert into zm select value + value * 7919 %% 1000, cast(value %% 13 as int) from generate_series(cast(%d as bigint), %d);\n' % (lo, hi)
+
+# every predicate is asked on the column and on an expression of it;
+# without mitosis the selects see the whole column
+check = '''set optimizer = 'sequential_pipe';
+select count(*), sum(t), sum(k) from zm where t between 100000 and 150000;
+select count(*), sum(t), sum(k) from zm where t + 0 between 100000 and 150000;
+select count(*), sum(t), sum(k) from zm where t >= 995000;
+select count(*), sum(t), sum(k) from zm where t + 0 >= 995000;
+select count(*), sum(t), sum(k) from zm where t < 2000;
+select count(*), sum(t), sum(k) from zm where t + 0 < 2000;
+select count(*), sum(k) from zm where t = 123456;
+select count(*), sum(k) from zm where t + 0 = 123456;
+select count(*), sum(zm.t), sum(w.id) from zm join w on zm.t between w.lo and w.hi;
+select count(*), sum(zm.t), sum(w.id) from zm join w on zm.t + 0 between w.lo and w.hi;
+'''
+
+# selects on columns with an encoded copy scan that instead, so the
+# columns are not encoded here
+s = process.server(args = ['--algorithms', '--set', 'gdk_compress=no'],
+                   stdin = process.PIPE,
+                   stdout = process.PIPE,
+                   stderr = process.PIPE,
+                   dbname = dbname)
+client('''create table zm (t bigint, k int);
+create table w (id int, lo bigint, hi bigint);
+insert into w values (1, 5000, 5100), (2, 300000, 301000), (3, 750000, 750010), (4, 1100000, 1100500);
+''' + load(0, 500000))
+client(check)
+# the appends extend the zone map
+client(load(500000, 800000) + load(800000, 1200000))
+client(check)
+# an update in place widens the zones it touches
+client('update zm set t = 123456 where t = 7000;\n')
+client(check)
+client('''drop table zm;
+drop table w;
+''')
+out, err = s.communicate()
+
+trace = err.splitlines()
+print 'zone map created:', len([l for l in trace if l.startswith('#BATzonemap(')]) > 0
+print 'select used the zone map:', len([l for l in trace if l.startswith('#BATselect(b=') and 'zone map select:' in l and '#1200000,' in l]) > 0
+
+shutil.rmtree(dbpath)
@@ -0,0 +1,82 @@
+import os, sys, struct
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+dst = os.environ['TSTTRGDIR']
+
+# column file layout, see BATattach in gdk/gdk_bat.c
+HDRSIZE = 15 * 8
+ALIGN = 65536                   # page aligned for any page size
+LNGNIL = -(1 << 63)
+STRNIL = b'\x80'
+
+def colfile(name, tpe, width, fmt, values, nilrep=None, strings=None,
+            aligned=False, reserved=0):
+    if strings is not None:
+        heap = bytearray(reserved)
+        offsets = []
+        for v in strings:
+            offsets.append(len(heap))
+            heap += (STRNIL if v is None else v.encode('utf-8')) + b'\0'
+        values = offsets
+    tail = struct.pack('=%d%s' % (len(values), fmt), *values)
+    toff = ALIGN if aligned else HDRSIZE
+    voff = vlen = 0
+    if strings is not None:
+        voff = toff + len(tail)
+        if aligned:
+            voff = (voff + ALIGN - 1) // ALIGN * ALIGN
+        vlen = len(heap)
+    hdr = b'MonetCol' + struct.pack('=qq', 0x0102030405060708, 1)
+    hdr += tpe.encode('ascii').ljust(16, b'\0')
+    hdr += struct.pack('=qqq', len(values), width, nilrep is not None)
+    hdr += struct.pack('=' + fmt, nilrep or 0).ljust(16, b'\0')
+    hdr += struct.pack('=qqqqq', toff, len(tail), voff, vlen, reserved)
+    data = bytearray(hdr)
+    data += b'\0' * (toff - len(data)) + tail
+    if strings is not None:
+        data += b'\0' * (voff - len(data)) + heap
+    fn = os.path.join(dst, name)
+    f = open(fn, 'wb')
+    f.write(bytes(data))
+    f.close()
+    return fn
+
+strs = ['a', 'bb', None, 'ccc', 'a']
+files = [
+    # int with a foreign nil (-1), translated
+    colfile('colf_i', 'int', 4, 'i', [1, -1, 3, -1, 5], nilrep=-1),
+    # bigint with MonetDB's nil, read straight into the column
+    colfile('colf_b', 'lng', 8, 'q', [10, LNGNIL, 30, 40, 50], aligned=True),
+    # strings with 4 byte offsets and no reserved space, appended
+    colfile('colf_s', 'str', 4, 'I', None, strings=strs),
+    # strings laid out like a string heap, read straight into it
+    colfile('colf_t', 'str', 8, 'Q', None, strings=strs, aligned=True,
+            reserved=1024 * 8),
+]
+wrong = colfile('colf_w', 'int', 4, 'i', [1, 2, 3, 4, 5])
+
+def quote(fn):
+    return "'%s'" % fn.replace('\\', '\\\\')
+
+clt = process.client('sql',
+                     stdin = process.PIPE,
+                     stdout = process.PIPE,
+                     stderr = process.PIPE,
+                     interactive = False,
+                     echo = False)
+clt.stdin.write('create table colf (i int, b bigint, s varchar(10), t clob);\n')
+clt.stdin.write('copy binary into colf from %s;\n' % ', '.join(map(quote, files)))
+clt.stdin.write('select * from colf;\n')
+clt.stdin.write('select count(*), count(i), cast(sum(i) as bigint), count(b), sum(b), count(s), count(t) from colf;\n')
+clt.stdin.write('select i, s from colf where s = t and s = \'a\';\n')
+clt.stdin.write('create table colf2 (b bigint);\n')
+clt.stdin.write('copy binary into colf2 from %s;\n' % quote(wrong))
+clt.stdin.write('drop table colf;\n')
+clt.stdin.write('drop table colf2;\n')
+out, err = clt.communicate()
+# normalize output
+sys.stdout.write(out.replace(os.environ['TSTTRGBASE'].replace('\\', '\\\\'),'${TSTTRGBASE}').replace('\\\\','/'))
+sys.stderr.write(err.replace(os.environ['TSTTRGBASE'].replace('\\', '\\\\'),'${TSTTRGBASE}').replace('\\\\','/'))
@@ -0,0 +1,3 @@
+#!/bin/sh
+
+Mlog -x "colcomp $MAPIPORT $TSTDB \"select cast(value as int) as id, 'name' || cast(value % 100 as varchar(3)) as name, timestamp '2017-01-01 00:00:00' + cast(value as bigint) * interval '1' second as ts, cast(value / 1000 as double) as d, cast(value * 1000 as bigint) as b from generate_series(cast(0 as int), 200000)\""